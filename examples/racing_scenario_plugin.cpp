@@ -0,0 +1,84 @@
+/*
+ * Racing scenario compiled as a plugin. Build it against the Robogen sources
+ * and the build directory (for robogen.pb.h), for example on Linux:
+ *
+ *   g++ -shared -fPIC -I../src -I../build racing_scenario_plugin.cpp \
+ *       -o racing_scenario_plugin.so
+ *
+ * then set "scenario=racing_scenario_plugin.so" in the simulator
+ * configuration file. The plugin is loaded from the same path by the servers.
+ */
+#include <limits>
+#include <vector>
+#include "config/RobogenConfig.h"
+#include "config/StartPositionConfig.h"
+#include "scenario/ScenarioPlugin.h"
+#include "Robot.h"
+#include "Models.h"
+
+using namespace robogen;
+
+class RacingScenarioPlugin: public Scenario {
+
+public:
+
+	RacingScenarioPlugin(boost::shared_ptr<RobogenConfig> robogenConfig) :
+			Scenario(robogenConfig), curTrial_(0) {
+	}
+
+	virtual bool setupSimulation() {
+		startPosition_.push_back(
+				this->getCurrentStartPosition()->getPosition());
+		return true;
+	}
+
+	virtual bool afterSimulationStep() {
+		return true;
+	}
+
+	virtual bool endSimulation() {
+		// distance of the closest part of the robot to its start position
+		double minDistance = std::numeric_limits<double>::max();
+		const std::vector<boost::shared_ptr<Model> >& bodyParts =
+				this->getRobot()->getBodyParts();
+		for (unsigned int i = 0; i < bodyParts.size(); ++i) {
+			osg::Vec2 curBodyPos(bodyParts[i]->getRootPosition().x(),
+					bodyParts[i]->getRootPosition().y());
+			osg::Vec2 curDistance = startPosition_.back() - curBodyPos;
+			if (curDistance.length() < minDistance) {
+				minDistance = curDistance.length();
+			}
+		}
+		distances_.push_back(minDistance);
+		curTrial_++;
+		this->setStartingPosition(curTrial_);
+		return true;
+	}
+
+	virtual double getFitness() {
+		double fitness = 1000000;
+		for (unsigned int i = 0; i < distances_.size(); ++i) {
+			if (distances_[i] < fitness)
+				fitness = distances_[i];
+		}
+		return fitness;
+	}
+
+	virtual bool remainingTrials() {
+		return curTrial_ < this->getRobogenConfig()->getStartingPos(
+				)->getStartPosition().size();
+	}
+
+	virtual int getCurTrial() const {
+		return curTrial_;
+	}
+
+private:
+
+	std::vector<osg::Vec2> startPosition_;
+	std::vector<double> distances_;
+	unsigned int curTrial_;
+
+};
+
+ROBOGEN_SCENARIO_PLUGIN(RacingScenarioPlugin)
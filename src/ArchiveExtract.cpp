@@ -0,0 +1,141 @@
+/*
+ * @(#) ArchiveExtract.cpp   1.0   Oct 19, 2026
+ *
+ * The ROBOGEN Framework
+ * Copyright © 2013-2016
+ *
+ * Laboratory of Intelligent Systems, EPFL
+ *
+ * This file is part of the ROBOGEN Framework.
+ *
+ * The ROBOGEN Framework is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License (GPL)
+ * as published by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @(#) $Id$
+ */
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "evolution/engine/RobotArchive.h"
+#include "utils/json2pb/json2pb.h"
+#include "Robogen.h"
+#include "robogen.pb.h"
+
+using namespace robogen;
+
+void printUsage(char *argv[]) {
+	std::cout << std::endl << "USAGE: " << std::endl << "      "
+			<< std::string(argv[0])
+			<< " <LOG_DIRECTORY, STRING> <GENERATION, INTEGER> "
+			<< "[<GUY, INTEGER|best>] [<OPTIONS>]" << std::endl
+			<< std::endl << "WHERE: " << std::endl
+			<< "      <LOG_DIRECTORY> is the output directory of an evolution "
+			<< "run with --save-all." << std::endl << std::endl
+			<< "      <GENERATION> is the generation to extract robots from."
+			<< std::endl << std::endl
+			<< "      <GUY> is the position of the robot in the population, "
+			<< "from 1, or best for" << std::endl
+			<< "          the best robot of the generation. All robots of the "
+			<< "generation are" << std::endl
+			<< "          extracted if omitted." << std::endl << std::endl
+			<< "OPTIONS: " << std::endl
+			<< "      --output <DIRECTORY>" << std::endl
+			<< "          Directory to write the robot files to, "
+			<< "Generation-<GENERATION>-Guy-<GUY>.json" << std::endl
+			<< "          (Default is the current directory)." << std::endl
+			<< std::endl;
+}
+
+int main(int argc, char *argv[]) {
+
+	GOOGLE_PROTOBUF_VERIFY_VERSION;
+
+	if (argc < 3) {
+		printUsage(argv);
+		exitRobogen(EXIT_FAILURE);
+	}
+
+	std::string logDirectory = argv[1];
+	unsigned int generation = std::atoi(argv[2]);
+	std::string guy = "";
+	std::string outputDirectory = ".";
+	for (int currentArg = 3; currentArg < argc; currentArg++) {
+		if (std::string("--output").compare(argv[currentArg]) == 0) {
+			if (++currentArg == argc) {
+				printUsage(argv);
+				exitRobogen(EXIT_FAILURE);
+			}
+			outputDirectory = argv[currentArg];
+		} else if (guy == "") {
+			guy = argv[currentArg];
+		} else {
+			printUsage(argv);
+			exitRobogen(EXIT_FAILURE);
+		}
+	}
+
+	std::vector<RobotArchiveEntry> index;
+	if (!RobotArchive::readIndex(logDirectory, index)) {
+		exitRobogen(EXIT_FAILURE);
+	}
+
+	// entries of the generation, and of the best guy if asked for
+	std::vector<RobotArchiveEntry> entries;
+	for (unsigned int i = 0; i < index.size(); ++i) {
+		if (index[i].generation != generation) {
+			continue;
+		}
+		if (guy == "best") {
+			if (entries.empty()) {
+				entries.push_back(index[i]);
+			} else if (index[i].fitness > entries[0].fitness) {
+				entries[0] = index[i];
+			}
+		} else if (guy == "" ||
+				index[i].guy == (unsigned int) std::atoi(guy.c_str())) {
+			entries.push_back(index[i]);
+		}
+	}
+	if (entries.empty()) {
+		std::cerr << "No such robot in the archive of " << logDirectory
+				<< std::endl;
+		exitRobogen(EXIT_FAILURE);
+	}
+
+	for (unsigned int i = 0; i < entries.size(); ++i) {
+		robogenMessage::ArchivedRobot robot;
+		if (!RobotArchive::read(logDirectory, entries[i], robot)) {
+			exitRobogen(EXIT_FAILURE);
+		}
+
+		std::stringstream ss;
+		ss << outputDirectory << "/Generation-" << robot.generation()
+				<< "-Guy-" << robot.guy() << ".json";
+		std::ofstream robotFile(ss.str().c_str(),
+				std::ios::out | std::ios::trunc);
+		robotFile << pb2json(robot.robot());
+		robotFile.close();
+		if (!robotFile) {
+			std::cerr << "Can't write " << ss.str() << std::endl;
+			exitRobogen(EXIT_FAILURE);
+		}
+		std::cout << ss.str() << " (fitness " << robot.fitness() << ")"
+				<< std::endl;
+	}
+
+	exitRobogen(EXIT_SUCCESS);
+}
@@ -0,0 +1,569 @@
+/*
+ * @(#) BatchEval.cpp   1.0   Oct 19, 2026
+ *
+ * The ROBOGEN Framework
+ * Copyright © 2013-2016
+ *
+ * Laboratory of Intelligent Systems, EPFL
+ *
+ * This file is part of the ROBOGEN Framework.
+ *
+ * The ROBOGEN Framework is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License (GPL)
+ * as published by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @(#) $Id$
+ */
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "config/ConfigurationReader.h"
+#include "config/RobogenConfig.h"
+#include "evolution/engine/RobotArchive.h"
+#include "evolution/representation/RobotRepresentation.h"
+#include "scenario/Scenario.h"
+#include "scenario/ScenarioFactory.h"
+#include "viewer/BinaryLog.h"
+#include "Robogen.h"
+#include "robogen.pb.h"
+#include "Simulator.h"
+
+#ifndef WIN32
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#ifdef QT5_ENABLED
+#include <QCoreApplication>
+#endif
+
+using namespace robogen;
+
+// ODE World
+dWorldID odeWorld;
+
+// Container for collisions
+dJointGroupID odeContactGroup;
+
+/**
+ * A robot to evaluate and the name it is reported with
+ */
+struct BatchRobot {
+	std::string name;
+	robogenMessage::Robot robot;
+};
+
+enum BatchStatus {
+	BATCH_PENDING = 0,
+	BATCH_DONE,
+	BATCH_FAILED
+};
+
+/**
+ * Results of all robots, shared by the worker processes: the status of each
+ * robot, and its fitness, evaluation time and fitness after each trial
+ */
+struct BatchTable {
+	unsigned int *next;
+	unsigned char *status;
+	double *values;
+	unsigned int numRobots;
+	unsigned int numColumns;
+};
+
+void printUsage(char *argv[]) {
+	std::cout << std::endl << "USAGE: " << std::endl << "      "
+			<< std::string(argv[0])
+			<< " <CONFIGURATION_FILE, STRING> <ROBOTS, STRING>... "
+			<< "[<OPTIONS>]" << std::endl
+			<< std::endl << "WHERE: " << std::endl
+			<< "      <CONFIGURATION_FILE> is the simulator configuration "
+			<< "to evaluate the robots with." << std::endl << std::endl
+			<< "      <ROBOTS> are robot files (.json, .txt or .dat), "
+			<< "directories of robot" << std::endl
+			<< "          files, or output directories of evolution runs "
+			<< "with --save-all, whose" << std::endl
+			<< "          archived individuals are all evaluated."
+			<< std::endl << std::endl
+			<< "OPTIONS: " << std::endl
+			<< "      --output <FILE>" << std::endl
+			<< "          CSV file to write the results to, one row per "
+			<< "robot: robot, status," << std::endl
+			<< "          fitness, evaluation time in seconds, then the "
+			<< "fitness the scenario" << std::endl
+			<< "          reports after each trial, aggregated over the "
+			<< "trials so far" << std::endl
+			<< "          (Default is batchEval.csv)."
+			<< std::endl << std::endl
+			<< "      --binary <FILE>" << std::endl
+			<< "          Also write the results as a binary log (see "
+			<< "robogen-log-convert), one" << std::endl
+			<< "          row per robot: its position in the CSV from 0, "
+			<< "then the same values," << std::endl
+			<< "          NaN if the evaluation failed." << std::endl
+			<< std::endl
+			<< "      --generation <N, INTEGER>" << std::endl
+			<< "          Only evaluate the individuals of generation <N> "
+			<< "of archives." << std::endl << std::endl
+			<< "      --jobs <N, INTEGER>" << std::endl
+			<< "          Number of robots evaluated in parallel, each in a "
+			<< "process of its own" << std::endl
+			<< "          (Default is the number of cores)." << std::endl
+			<< std::endl
+			<< "      --seed <A, INTEGER>" << std::endl
+			<< "          Seed the random number generator of the noisy "
+			<< "evaluation of the robot" << std::endl
+			<< "          at position <I> with A + <I> (Default is 0)."
+			<< std::endl << std::endl;
+}
+
+bool isRobotFile(const boost::filesystem::path &path) {
+	std::string extension = path.extension().string();
+	return extension == ".json" || extension == ".txt" ||
+			extension == ".dat";
+}
+
+bool addRobotFile(const std::string &fileName,
+		std::vector<BatchRobot> &robots) {
+	BatchRobot robot;
+	robot.name = fileName;
+	if (!RobotRepresentation::createRobotMessageFromFile(robot.robot,
+			fileName)) {
+		return false;
+	}
+	robots.push_back(robot);
+	return true;
+}
+
+/**
+ * Adds a robot file, the robot files of a directory, or the archived
+ * individuals of an evolution run
+ */
+bool addRobots(const std::string &input, int generation,
+		std::vector<BatchRobot> &robots) {
+
+	boost::filesystem::path path(input);
+	if (!boost::filesystem::is_directory(path)) {
+		if (!boost::filesystem::exists(path)) {
+			std::cerr << "No such robot file or directory: " << input
+					<< std::endl;
+			return false;
+		}
+		return addRobotFile(input, robots);
+	}
+
+	if (boost::filesystem::exists(path / ROBOT_ARCHIVE_INDEX_FILE)) {
+		std::vector<RobotArchiveEntry> index;
+		if (!RobotArchive::readIndex(input, index)) {
+			return false;
+		}
+		for (unsigned int i = 0; i < index.size(); ++i) {
+			if (generation >= 0 &&
+					index[i].generation != (unsigned int) generation) {
+				continue;
+			}
+			robogenMessage::ArchivedRobot archived;
+			if (!RobotArchive::read(input, index[i], archived)) {
+				return false;
+			}
+			std::stringstream ss;
+			ss << input << "/Generation-" << archived.generation()
+					<< "-Guy-" << archived.guy();
+			BatchRobot robot;
+			robot.name = ss.str();
+			robot.robot = archived.robot();
+			robots.push_back(robot);
+		}
+		return true;
+	}
+
+	// robot files of the directory, by name
+	std::vector<std::string> fileNames;
+	for (boost::filesystem::directory_iterator it(path);
+			it != boost::filesystem::directory_iterator(); ++it) {
+		if (boost::filesystem::is_regular_file(it->path()) &&
+				isRobotFile(it->path())) {
+			fileNames.push_back(it->path().string());
+		}
+	}
+	std::sort(fileNames.begin(), fileNames.end());
+	for (unsigned int i = 0; i < fileNames.size(); ++i) {
+		if (!addRobotFile(fileNames[i], robots)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Runs the trials of a robot one at a time, to report the fitness after each.
+ * That is the scenario's aggregate over the trials run so far, not the
+ * fitness of the trial alone.
+ * @param values fitness, evaluation time, then fitness after each trial
+ * @return false if the simulation failed
+ */
+bool evaluate(const BatchRobot &robot,
+		boost::shared_ptr<RobogenConfig> configuration, int seed,
+		double *values, unsigned int numTrials) {
+
+	boost::posix_time::ptime start =
+			boost::posix_time::microsec_clock::universal_time();
+
+	boost::shared_ptr<Scenario> scenario = ScenarioFactory::createScenario(
+			configuration);
+	if (scenario == NULL) {
+		return false;
+	}
+
+	boost::random::mt19937 rng;
+	rng.seed(seed);
+	boost::shared_ptr<FileViewerLog> log;
+
+	double fitness = 0;
+	for (unsigned int i = 0; i < numTrials; ++i) {
+		values[2 + i] = std::numeric_limits<double>::quiet_NaN();
+	}
+	for (unsigned int i = 0; i < numTrials && scenario->remainingTrials();
+			++i) {
+		unsigned int simulationResult = runSimulations(scenario,
+				configuration, robot.robot, NULL, rng, true, log);
+		if (simulationResult == SIMULATION_FAILURE) {
+			return false;
+		}
+		if (simulationResult == CONSTRAINT_VIOLATED) {
+			fitness = MIN_FITNESS;
+			values[2 + i] = fitness;
+			break;
+		}
+		fitness = scenario->getFitness();
+		values[2 + i] = fitness;
+	}
+
+	boost::posix_time::time_duration elapsed =
+			boost::posix_time::microsec_clock::universal_time() - start;
+	values[0] = fitness;
+	values[1] = elapsed.total_microseconds() / 1e6;
+	return true;
+}
+
+/**
+ * Evaluates robots until none is left, taking the next one from the table
+ */
+void work(const std::vector<BatchRobot> &robots,
+		boost::shared_ptr<RobogenConfig> configuration, int seed,
+		BatchTable &table) {
+	unsigned int numTrials = table.numColumns - 2;
+	while (true) {
+#ifdef WIN32
+		unsigned int i = (*table.next)++;
+#else
+		unsigned int i = __sync_fetch_and_add(table.next, 1);
+#endif
+		if (i >= table.numRobots) {
+			return;
+		}
+		bool success = evaluate(robots[i], configuration, seed + i,
+				&table.values[i * table.numColumns], numTrials);
+		table.status[i] = success ? BATCH_DONE : BATCH_FAILED;
+		if (!success) {
+			std::cerr << "Cannot evaluate " << robots[i].name << std::endl;
+		}
+	}
+}
+
+#ifndef WIN32
+/**
+ * Evaluates the robots in numJobs worker processes. The simulator keeps ODE
+ * in global variables, so robots can't be evaluated by threads.
+ * @return false if no worker could be started
+ */
+bool runWorkers(const std::vector<BatchRobot> &robots,
+		boost::shared_ptr<RobogenConfig> configuration, int seed,
+		BatchTable &table, unsigned int numJobs) {
+
+	std::vector<pid_t> workers;
+	for (unsigned int i = 0; i < numJobs; ++i) {
+		pid_t pid = fork();
+		if (pid < 0) {
+			std::cerr << "Cannot start worker process" << std::endl;
+			break;
+		}
+		if (pid == 0) {
+			// the simulator reports its progress on std::cout
+			std::ofstream devNull("/dev/null");
+			std::cout.rdbuf(devNull.rdbuf());
+			work(robots, configuration, seed, table);
+			std::cout.flush();
+			_exit(EXIT_SUCCESS);
+		}
+		workers.push_back(pid);
+	}
+	if (workers.empty()) {
+		return false;
+	}
+
+	unsigned int reported = 0;
+	while (!workers.empty()) {
+		boost::this_thread::sleep(boost::posix_time::milliseconds(200));
+		for (unsigned int i = 0; i < workers.size(); ) {
+			int status;
+			if (waitpid(workers[i], &status, WNOHANG) == workers[i]) {
+				if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+					std::cerr << "A worker process crashed" << std::endl;
+				}
+				workers.erase(workers.begin() + i);
+			} else {
+				++i;
+			}
+		}
+
+		unsigned int evaluated = 0;
+		for (unsigned int i = 0; i < table.numRobots; ++i) {
+			if (table.status[i] != BATCH_PENDING) {
+				++evaluated;
+			}
+		}
+		if (evaluated != reported) {
+			reported = evaluated;
+			std::cout << "\r" << evaluated << "/" << table.numRobots
+					<< " robots evaluated" << std::flush;
+		}
+	}
+	std::cout << std::endl;
+
+	return true;
+}
+#endif
+
+bool writeCSV(const std::string &fileName,
+		const std::vector<BatchRobot> &robots, const BatchTable &table) {
+	std::ofstream file(fileName.c_str(), std::ios::out | std::ios::trunc);
+	file << "robot,status,fitness,seconds";
+	for (unsigned int j = 2; j < table.numColumns; ++j) {
+		file << ",cumulative_after_trial_" << (j - 1);
+	}
+	file << '\n' << std::setprecision(10);
+	for (unsigned int i = 0; i < table.numRobots; ++i) {
+		// names may hold commas, and quotes, which are doubled
+		std::string name = robots[i].name;
+		for (std::string::size_type pos = name.find('"');
+				pos != std::string::npos; pos = name.find('"', pos + 2)) {
+			name.insert(pos, 1, '"');
+		}
+		file << '"' << name << '"';
+		if (table.status[i] != BATCH_DONE) {
+			file << ",failed";
+			for (unsigned int j = 0; j < table.numColumns; ++j) {
+				file << ',';
+			}
+		} else {
+			file << ",ok";
+			const double *values = &table.values[i * table.numColumns];
+			for (unsigned int j = 0; j < table.numColumns; ++j) {
+				file << ',';
+				if (!std::isnan(values[j])) {
+					file << values[j];
+				}
+			}
+		}
+		file << '\n';
+	}
+	file.close();
+	if (!file) {
+		std::cerr << "Can't write " << fileName << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool writeBinary(const std::string &fileName, const BatchTable &table) {
+	BinaryLog log;
+	if (!log.open(fileName, BinaryLog::FLOAT32, 1)) {
+		return false;
+	}
+	std::vector<float> row(table.numColumns + 1);
+	for (unsigned int i = 0; i < table.numRobots; ++i) {
+		row[0] = i;
+		for (unsigned int j = 0; j < table.numColumns; ++j) {
+			row[j + 1] = (table.status[i] == BATCH_DONE) ?
+					table.values[i * table.numColumns + j] :
+					std::numeric_limits<float>::quiet_NaN();
+		}
+		log.write(&row[0], row.size());
+	}
+	return log.close();
+}
+
+int main(int argc, char *argv[]) {
+
+	startRobogen();
+
+#ifdef QT5_ENABLED
+	QCoreApplication a(argc, argv);
+#endif
+
+	if (argc < 3) {
+		printUsage(argv);
+		exitRobogen(EXIT_FAILURE);
+	}
+
+	std::string outputFile = "batchEval.csv";
+	std::string binaryFile = "";
+	int generation = -1;
+	unsigned int numJobs = boost::thread::hardware_concurrency();
+	int seed = 0;
+	std::vector<std::string> inputs;
+	for (int currentArg = 2; currentArg < argc; currentArg++) {
+		std::string arg = argv[currentArg];
+		if (arg == "--help") {
+			printUsage(argv);
+			exitRobogen(EXIT_SUCCESS);
+		} else if (arg == "--output" || arg == "--binary" ||
+				arg == "--generation" || arg == "--jobs" || arg == "--seed") {
+			if (++currentArg == argc) {
+				std::cerr << "Must specify a value with option " << arg
+						<< "." << std::endl;
+				exitRobogen(EXIT_FAILURE);
+			}
+			std::stringstream ss(argv[currentArg]);
+			if (arg == "--output") {
+				outputFile = argv[currentArg];
+			} else if (arg == "--binary") {
+				binaryFile = argv[currentArg];
+			} else if (arg == "--generation") {
+				ss >> generation;
+			} else if (arg == "--jobs") {
+				ss >> numJobs;
+			} else {
+				ss >> seed;
+			}
+			if (ss.fail()) {
+				std::cerr << "Specified value \"" << argv[currentArg]
+						<< "\" of option " << arg << " is not an integer."
+						<< std::endl;
+				exitRobogen(EXIT_FAILURE);
+			}
+		} else {
+			inputs.push_back(arg);
+		}
+	}
+	if (numJobs == 0) {
+		numJobs = 1;
+	}
+
+	boost::shared_ptr<RobogenConfig> configuration =
+			ConfigurationReader::parseConfigurationFile(std::string(argv[1]));
+	if (configuration == NULL) {
+		std::cerr << "Problems parsing the configuration file. Quit."
+				<< std::endl;
+		exitRobogen(EXIT_FAILURE);
+	}
+
+	std::vector<BatchRobot> robots;
+	for (unsigned int i = 0; i < inputs.size(); ++i) {
+		if (!addRobots(inputs[i], generation, robots)) {
+			exitRobogen(EXIT_FAILURE);
+		}
+	}
+	if (robots.empty()) {
+		std::cerr << "No robot to evaluate." << std::endl;
+		exitRobogen(EXIT_FAILURE);
+	}
+
+	BatchTable table;
+	table.numRobots = robots.size();
+	table.numColumns = 2 +
+			configuration->getStartingPos()->getStartPosition().size();
+	numJobs = std::min(numJobs, table.numRobots);
+
+	std::cout << "Evaluating " << table.numRobots << " robots with "
+			<< numJobs << " jobs" << std::endl;
+
+	size_t tableSize = sizeof(unsigned int) +
+			table.numRobots * table.numColumns * sizeof(double) +
+			table.numRobots;
+
+#ifndef WIN32
+	// shared with the workers
+	void *memory = mmap(NULL, tableSize, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (memory == MAP_FAILED) {
+		std::cerr << "Cannot allocate the result table" << std::endl;
+		exitRobogen(EXIT_FAILURE);
+	}
+#else
+	std::vector<double> buffer(tableSize / sizeof(double) + 2);
+	void *memory = &buffer[0];
+#endif
+	// mapped and vector memory is aligned for doubles, which come first
+	table.values = static_cast<double *>(memory);
+	table.next = reinterpret_cast<unsigned int *>(
+			table.values + table.numRobots * table.numColumns);
+	table.status = reinterpret_cast<unsigned char *>(table.next + 1);
+	*table.next = 0;
+	std::fill(table.status, table.status + table.numRobots, BATCH_PENDING);
+
+	boost::posix_time::ptime start =
+			boost::posix_time::microsec_clock::universal_time();
+
+#ifndef WIN32
+	if (numJobs > 1) {
+		if (!runWorkers(robots, configuration, seed, table, numJobs)) {
+			exitRobogen(EXIT_FAILURE);
+		}
+	} else {
+		work(robots, configuration, seed, table);
+	}
+#else
+	// no fork, robots are evaluated one after the other
+	work(robots, configuration, seed, table);
+#endif
+
+	boost::posix_time::time_duration elapsed =
+			boost::posix_time::microsec_clock::universal_time() - start;
+
+	unsigned int numFailed = 0;
+	for (unsigned int i = 0; i < table.numRobots; ++i) {
+		if (table.status[i] != BATCH_DONE) {
+			++numFailed;
+		}
+	}
+
+	bool success = writeCSV(outputFile, robots, table) &&
+			(binaryFile.empty() || writeBinary(binaryFile, table));
+
+	std::cout << table.numRobots - numFailed << " robots evaluated in "
+			<< elapsed.total_milliseconds() / 1000.0 << " s, results in "
+			<< outputFile << std::endl;
+	if (numFailed > 0) {
+		std::cerr << numFailed << " robots could not be evaluated"
+				<< std::endl;
+	}
+
+#ifndef WIN32
+	munmap(memory, tableSize);
+#endif
+
+	exitRobogen((success && numFailed == 0) ? EXIT_SUCCESS : EXIT_FAILURE);
+}
@@ -27,6 +27,8 @@
  * @(#) $Id$
  */
 
+#include <algorithm>
+#include <sstream>
 #include <boost/shared_ptr.hpp>
 #include <boost/lexical_cast.hpp>
 #include "config/EvolverConfiguration.h"
@@ -48,7 +50,9 @@
 
 namespace robogen {
 void init(unsigned int seed, std::string outputDirectory,
-		std::string confFileName, bool overwrite, bool saveAll);
+		std::string confFileName, bool overwrite, bool saveAll,
+		std::string resumeDirectory = "");
+void initPopulation(unsigned int seed);
 
 void printUsage(char *argv[]) {
 	std::cout << std::endl << "USAGE: " << std::endl << "      "
@@ -71,7 +75,18 @@ void printUsage(char *argv[]) {
 			<< "directories with incrementing suffixes)." << std::endl
 			<< std::endl << "      --save-all" << std::endl
 			<< "          Save all individuals instead of just the generation"
-			<< "best." << std::endl << std::endl;
+			<< " best, to" << std::endl
+			<< "          Archive.dat in the output directory. Use "
+			<< "robogen-archive-extract" << std::endl
+			<< "          to get robot files from it." << std::endl << std::endl
+			<< "      --resume <DIRECTORY>" << std::endl
+			<< "          Resume the evolution from the last checkpoint saved"
+			<< " in the output" << std::endl
+			<< "          directory of an interrupted run, see "
+			<< "checkpointInterval. Its output" << std::endl
+			<< "          is written to that directory (<OUTPUT_DIRECTORY> is "
+			<< "ignored) and the" << std::endl
+			<< "          seed of the run is used." << std::endl << std::endl;
 
 }
 
@@ -94,6 +109,10 @@ bool neat;
 boost::shared_ptr<Selector> selector;
 boost::shared_ptr<Mutator> mutator;
 unsigned int generation;
+// generation of the population the run starts from: 1, or the generation of
+// the checkpoint it resumes from
+unsigned int firstGeneration;
+unsigned int evolutionSeed;
 boost::random::mt19937 rng;
 
 std::vector<Socket*> sockets;
@@ -127,6 +146,7 @@ void parseArgsThenInit(int argc, char* argv[]) {
 
 	bool overwrite = false;
 	bool saveAll = false;
+	std::string resumeDirectory;
 	int currentArg = 4;
 	for (; currentArg < argc; currentArg++) {
 		if (std::string("--help").compare(argv[currentArg]) == 0) {
@@ -137,6 +157,9 @@ void parseArgsThenInit(int argc, char* argv[]) {
 			overwrite = true;
 		} else if (std::string("--save-all").compare(argv[currentArg]) == 0) {
 			saveAll = true;
+		} else if (std::string("--resume").compare(argv[currentArg]) == 0
+				&& currentArg + 1 < argc) {
+			resumeDirectory = std::string(argv[++currentArg]);
 		} else {
 			std::cerr << std::endl << "Invalid option: " << argv[currentArg]
 							 << std::endl << std::endl;
@@ -146,16 +169,37 @@ void parseArgsThenInit(int argc, char* argv[]) {
 
 	}
 
-	init(seed, outputDirectory, confFileName, overwrite, saveAll);
+	init(seed, outputDirectory, confFileName, overwrite, saveAll,
+			resumeDirectory);
 
 }
 
 void init(unsigned int seed, std::string outputDirectory,
-		std::string confFileName, bool overwrite, bool saveAll) {
+		std::string confFileName, bool overwrite, bool saveAll,
+		std::string resumeDirectory) {
 
 	// Seed random number generator
 
 	rng.seed(seed);
+	evolutionSeed = seed;
+
+	bool resume = (resumeDirectory.compare("") != 0);
+	robogenMessage::EvolverCheckpoint checkpoint;
+	if (resume) {
+		if (!EvolverLog::loadCheckpoint(resumeDirectory, checkpoint)) {
+			std::cerr << "Problems reading the checkpoint to resume from. "
+					<< "Quit." << std::endl;
+			exitRobogen(EXIT_FAILURE);
+		}
+		if (checkpoint.seed() != seed) {
+			std::cout << "Resuming the evolution with its seed "
+					<< checkpoint.seed() << " instead of " << seed
+					<< std::endl;
+		}
+		evolutionSeed = checkpoint.seed();
+		std::istringstream rngStream(checkpoint.rng());
+		rngStream >> rng;
+	}
 
 	conf.reset(new EvolverConfiguration());
 	if (!conf->init(confFileName)) {
@@ -187,7 +231,15 @@ void init(unsigned int seed, std::string outputDirectory,
 	mutator.reset(new Mutator(conf, rng));
 	log.reset(new EvolverLog());
 	try {
-		if (!log->init(conf, robotConf, outputDirectory, overwrite, saveAll)) {
+		if (resume) {
+			if (!log->resume(resumeDirectory, checkpoint.generation(),
+					saveAll)) {
+				std::cerr << "Error resuming evolver log. Aborting."
+						<< std::endl;
+				exitRobogen(EXIT_FAILURE);
+			}
+		} else if (!log->init(conf, robotConf, outputDirectory, overwrite,
+				saveAll)) {
 			std::cerr << "Error creating evolver log. Aborting." << std::endl;
 			exitRobogen(EXIT_FAILURE);
 		}
@@ -199,6 +251,90 @@ void init(unsigned int seed, std::string outputDirectory,
 		exitRobogen(EXIT_FAILURE);
 	}
 
+	neat = (conf->evolutionaryAlgorithm == EvolverConfiguration::HYPER_NEAT);
+
+	if (resume) {
+		// ---------------------------------------
+		// restore population from checkpoint
+		// ---------------------------------------
+
+		std::vector<boost::shared_ptr<RobotRepresentation> > individuals;
+		for (int i = 0; i < checkpoint.individual_size(); i++) {
+			boost::shared_ptr<RobotRepresentation> robot(
+					new RobotRepresentation());
+			if (!robot->init(checkpoint.individual(i))) {
+				std::cerr << "Failed restoring individual " << i
+						<< " from checkpoint" << std::endl;
+				exitRobogen(EXIT_FAILURE);
+			}
+			individuals.push_back(robot);
+		}
+		population.reset(new Population());
+		if (!population->init(individuals)) {
+			std::cerr << "Error when restoring population!" << std::endl;
+			exitRobogen(EXIT_FAILURE);
+		}
+
+		if (neat) {
+			if (!checkpoint.has_neat()) {
+				std::cerr << "The checkpoint has no NEAT state." << std::endl;
+				exitRobogen(EXIT_FAILURE);
+			}
+			try {
+				neatContainer.reset(new NeatContainer(conf, population,
+						checkpoint.neat()));
+			} catch (std::exception& e) {
+				std::cerr << e.what() << std::endl;
+				exitRobogen(EXIT_FAILURE);
+			}
+		}
+	} else {
+		initPopulation(seed);
+	}
+
+	// ---------------------------------------
+	// open sockets for communication with simulator processes
+	// ---------------------------------------
+#ifndef EMSCRIPTEN
+	sockets.resize(conf->sockets.size());
+	for (unsigned int i = 0; i < conf->sockets.size(); i++) {
+		sockets[i] = new TcpSocket;
+#ifndef FAKEROBOTREPRESENTATION_H // do not bother with sockets when using
+		// benchmark
+		if (!sockets[i]->open(conf->sockets[i].first,
+				conf->sockets[i].second)) {
+			std::cerr << "Could not open connection to simulator" << std::endl;
+			exitRobogen(EXIT_FAILURE);
+		}
+#endif
+	}
+#endif
+
+	// ---------------------------------------
+	// run evolution TODO stopping criterion
+	// ---------------------------------------
+
+	if (resume) {
+		// the population of the checkpoint is evaluated already
+		generation = firstGeneration = checkpoint.generation();
+		std::cout << "Resuming evolution from generation " << generation
+				<< std::endl;
+		return;
+	}
+
+	if(neat) {
+		if(!neatContainer->fillPopulationWeights(population)) {
+			std::cerr << "Filling weights from NEAT failed." << std::endl;
+			exitRobogen(EXIT_FAILURE);
+		}
+	}
+
+	generation = firstGeneration = 1;
+	population->evaluate(robotConf, sockets, generation);
+}
+
+void initPopulation(unsigned int seed) {
+
 	// ---------------------------------------
 	// parse robot from file & initialize population
 	// ---------------------------------------
@@ -227,10 +363,9 @@ void init(unsigned int seed, std::string outputDirectory,
 		}
 	}
 
-	neat = (conf->evolutionaryAlgorithm == EvolverConfiguration::HYPER_NEAT);
 	population.reset(new Population());
 	if (!population->init(referenceBot, conf->mu, mutator, growBodies,
-			(!(conf->useBrainSeed || neat)) ) ) {
+			(!(conf->useBrainSeed || neat)), seed, conf->evolverThreads) ) {
 		std::cerr << "Error when initializing population!" << std::endl;
 		exitRobogen(EXIT_FAILURE);
 	}
@@ -238,38 +373,6 @@ void init(unsigned int seed, std::string outputDirectory,
 	if (neat) {
 		neatContainer.reset(new NeatContainer(conf, population, seed, rng));
 	}
-
-	// ---------------------------------------
-	// open sockets for communication with simulator processes
-	// ---------------------------------------
-#ifndef EMSCRIPTEN
-	sockets.resize(conf->sockets.size());
-	for (unsigned int i = 0; i < conf->sockets.size(); i++) {
-		sockets[i] = new TcpSocket;
-#ifndef FAKEROBOTREPRESENTATION_H // do not bother with sockets when using
-		// benchmark
-		if (!sockets[i]->open(conf->sockets[i].first,
-				conf->sockets[i].second)) {
-			std::cerr << "Could not open connection to simulator" << std::endl;
-			exitRobogen(EXIT_FAILURE);
-		}
-#endif
-	}
-#endif
-
-	// ---------------------------------------
-	// run evolution TODO stopping criterion
-	// ---------------------------------------
-
-	if(neat) {
-		if(!neatContainer->fillPopulationWeights(population)) {
-			std::cerr << "Filling weights from NEAT failed." << std::endl;
-			exitRobogen(EXIT_FAILURE);
-		}
-	}
-
-	generation = 1;
-	population->evaluate(robotConf, sockets);
 }
 
 void mainEvolutionLoop();
@@ -295,8 +398,29 @@ void postEvaluateStd() {
 	mainEvolutionLoop();
 }
 
+void saveCheckpoint() {
+	robogenMessage::EvolverCheckpoint checkpoint;
+	checkpoint.set_generation(generation);
+	checkpoint.set_seed(evolutionSeed);
+	std::ostringstream rngStream;
+	rngStream << rng;
+	checkpoint.set_rng(rngStream.str());
+	for (unsigned int i = 0; i < population->size(); i++) {
+		*(checkpoint.add_individual()) = population->at(i)->serializeState();
+	}
+	if (neat) {
+		*(checkpoint.mutable_neat()) =
+				neatContainer->serializeState(population);
+	}
+	// evolution goes on without the checkpoint
+	if (!log->saveCheckpoint(checkpoint)) {
+		std::cerr << "Failed saving checkpoint of generation " << generation
+				<< std::endl;
+	}
+}
+
 void triggerPostEvaluate() {
-	if (generation == 1) {
+	if (generation == firstGeneration) {
 		mainEvolutionLoop();
 	} else {
 		if (neat) {
@@ -322,6 +446,11 @@ void mainEvolutionLoop() {
 		exitRobogen(EXIT_FAILURE);
 	}
 
+	if (conf->checkpointInterval > 0 &&
+			generation % conf->checkpointInterval == 0) {
+		saveCheckpoint();
+	}
+
 	generation++;
 
 
@@ -337,12 +466,19 @@ void mainEvolutionLoop() {
 						<< std::endl;
 				exitRobogen(EXIT_FAILURE);
 			}
-			population->evaluate(robotConf, sockets);
+			population->evaluate(robotConf, sockets, generation);
 
 		} else {
 			selector->initPopulation(population);
-			unsigned int numOffspring = 0;
-			while (numOffspring < conf->lambda) {
+
+			// select all parents first, then create the offspring in
+			// parallel
+			unsigned int offspringPerPair = mutator->getOffspringPerPair();
+			unsigned int numPairs = (conf->lambda + offspringPerPair - 1) /
+					offspringPerPair;
+			std::vector<std::pair<boost::shared_ptr<RobotRepresentation>,
+					boost::shared_ptr<RobotRepresentation> > > selections;
+			while (selections.size() < numPairs) {
 
 				std::pair<boost::shared_ptr<RobotRepresentation>,
 						boost::shared_ptr<RobotRepresentation> > selection;
@@ -364,21 +500,18 @@ void mainEvolutionLoop() {
 					tries++;
 				} while (selection.first == selection.second);
 
-				std::vector<boost::shared_ptr<RobotRepresentation> > offspring
-					= mutator->createOffspring(selection.first,
-											   selection.second);
-
-				// no crossover, or can fit both new individuals
-				if ( (numOffspring + offspring.size()) <= conf->lambda ) {
-					children.insert(children.end(), offspring.begin(),
-													offspring.end() );
-					numOffspring += offspring.size();
-				} else { // crossover, but can only fit one
-					children.push_back(offspring[0]);
-					numOffspring++;
-				}
+				selections.push_back(selection);
 			}
-			children.evaluate(robotConf, sockets);
+
+			std::vector<boost::shared_ptr<RobotRepresentation> > offspring
+				= mutator->createOffspring(selections, evolutionSeed,
+						generation);
+
+			// with crossover, the last pair may not fit entirely
+			children.insert(children.end(), offspring.begin(),
+					offspring.begin() + std::min<size_t>(offspring.size(),
+							conf->lambda));
+			children.evaluate(robotConf, sockets, generation);
 		}
 #ifndef EMSCRIPTEN
 		triggerPostEvaluate();
@@ -414,6 +547,8 @@ triggerPostEvaluate();
 for (unsigned int i = 0; i < conf->sockets.size(); i++) {
 	delete sockets[i];
 }
+// write the rest of the archive
+robogen::log.reset();
 exitRobogen(EXIT_SUCCESS);
 }
 #else
@@ -0,0 +1,140 @@
+/*
+ * @(#) LogConvert.cpp   1.0   Oct 19, 2026
+ *
+ * The ROBOGEN Framework
+ * Copyright © 2013-2016
+ *
+ * Laboratory of Intelligent Systems, EPFL
+ *
+ * This file is part of the ROBOGEN Framework.
+ *
+ * The ROBOGEN Framework is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License (GPL)
+ * as published by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @(#) $Id$
+ */
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <boost/filesystem.hpp>
+
+#include "viewer/BinaryLog.h"
+#include "viewer/WebGLReplay.h"
+#include "Robogen.h"
+
+// as written by FileViewerLog
+#define LOG_COL_WIDTH 12
+
+using namespace robogen;
+
+void printUsage(char *argv[]) {
+	std::cout << std::endl << "USAGE: " << std::endl << "      "
+			<< std::string(argv[0]) << " <LOG_DIRECTORY, STRING>" << std::endl
+			<< std::endl << "WHERE: " << std::endl
+			<< "      <LOG_DIRECTORY> is the output directory of "
+			<< "robogen-file-viewer run with" << std::endl
+			<< "          --binary-log. trajectoryLog.bin, sensorLog.bin, "
+			<< "motorLog.bin and" << std::endl
+			<< "          stateLog.bin are converted to the text files "
+			<< "trajectoryLog.txt," << std::endl
+			<< "          sensorLog.txt, motorLog.txt and stateLog.txt. "
+			<< "The binary WebGL replay webGL.bin "
+			<< "of" << std::endl
+			<< "          --webgl-binary is converted to webGL.json."
+			<< std::endl << std::endl;
+}
+
+/**
+ * Converts a binary log to the text format of FileViewerLog
+ * @param trajectory the trajectory log separates columns without padding
+ */
+bool convert(const std::string &directory, const std::string &name,
+		bool trajectory) {
+	std::string binaryPath = directory + "/" + name + ".bin";
+	if (!boost::filesystem::exists(binaryPath)) {
+		return true;
+	}
+
+	BinaryLog::Header header;
+	std::vector<std::vector<float> > rows;
+	if (!BinaryLog::read(binaryPath, header, rows)) {
+		return false;
+	}
+
+	std::string textPath = directory + "/" + name + ".txt";
+	std::ofstream text(textPath.c_str(), std::ios::out | std::ios::trunc);
+	for (unsigned int i = 0; i < rows.size(); ++i) {
+		if (trajectory) {
+			text << std::setw(LOG_COL_WIDTH) << rows[i][0] << " "
+					<< rows[i][1] << '\n';
+		} else {
+			for (unsigned int j = 0; j < rows[i].size(); ++j) {
+				text << std::setw(LOG_COL_WIDTH) << rows[i][j] << " ";
+			}
+			text << '\n';
+		}
+	}
+	text.close();
+	if (!text) {
+		std::cerr << "Can't write " << textPath << std::endl;
+		return false;
+	}
+
+	std::cout << textPath << ": " << rows.size() << " rows";
+	if (header.decimation > 1) {
+		std::cout << ", one every " << header.decimation << " steps";
+	}
+	if (header.encoding == BinaryLog::FLOAT16) {
+		std::cout << ", half precision";
+	}
+	std::cout << std::endl;
+	return true;
+}
+
+/**
+ * Converts a binary WebGL replay to the JSON one
+ */
+bool convertWebGL(const std::string &directory) {
+	std::string binaryPath = directory + "/webGL.bin";
+	if (!boost::filesystem::exists(binaryPath)) {
+		return true;
+	}
+	std::string jsonPath = directory + "/webGL.json";
+	if (!WebGLReplay::convertToJSON(binaryPath, jsonPath)) {
+		return false;
+	}
+	std::cout << jsonPath << std::endl;
+	return true;
+}
+
+int main(int argc, char *argv[]) {
+
+	if (argc != 2) {
+		printUsage(argv);
+		exitRobogen(EXIT_FAILURE);
+	}
+
+	std::string directory = argv[1];
+	if (!convert(directory, "trajectoryLog", true) ||
+			!convert(directory, "sensorLog", false) ||
+			!convert(directory, "motorLog", false) ||
+			!convert(directory, "stateLog", false) ||
+			!convertWebGL(directory)) {
+		exitRobogen(EXIT_FAILURE);
+	}
+
+	exitRobogen(EXIT_SUCCESS);
+}
@@ -27,6 +27,7 @@
  * @(#) $Id$
  */
 #include <iostream>
+#include <sstream>
 
 #include "config/ConfigurationReader.h"
 #include "config/RobogenConfig.h"
@@ -79,11 +80,22 @@ int main(int argc, char* argv[]) {
 
 	bool visualize = false;	
 	bool startPaused = false;
+	std::string stateLogDirectory = "";
 	for (int currentArg=2; currentArg<argc; currentArg++) {
 		if (std::string(argv[currentArg]).compare("--visualization") == 0) {
 			visualize = true;
 		} else if (std::string(argv[currentArg]).compare("--pause") == 0) {
 			startPaused = true;
+		} else if (std::string(argv[currentArg]).compare("--state-log")
+				== 0) {
+			// state logs of the evaluated robots, for robogen-file-viewer
+			// --replay
+			if (++currentArg == argc) {
+				std::cerr << "Must specify a directory with option "
+						<< "--state-log." << std::endl;
+				exitRobogen(EXIT_FAILURE);
+			}
+			stateLogDirectory = argv[currentArg];
 		}
 	}
 
@@ -106,6 +118,10 @@ int main(int argc, char* argv[]) {
 	boost::random::mt19937 rng;
 	rng.seed(port);
 
+	// names the state logs of requests that don't say which individual
+	// they evaluate
+	unsigned int evaluationCount = 0;
+
 #ifdef QT5_ENABLED
 	QCoreApplication a(argc, argv);
 #endif
@@ -179,9 +195,29 @@ int main(int argc, char* argv[]) {
 						viewer = new Viewer(startPaused);
 					}
 
+					// one state log directory per trial,
+					// Generation-<G>_Individual-<I>, then with _1, _2, ...
+					boost::shared_ptr<FileViewerLog> log;
+					if (!stateLogDirectory.empty()) {
+						std::stringstream ss;
+						ss << stateLogDirectory << "/";
+						if (packet.getMessage()->has_generation() &&
+								packet.getMessage()->has_individual()) {
+							ss << "Generation-"
+									<< packet.getMessage()->generation()
+									<< "_Individual-"
+									<< packet.getMessage()->individual();
+						} else {
+							ss << "Port-" << port << "_Evaluation-"
+									<< evaluationCount;
+						}
+						log.reset(new FileViewerLog(ss.str()));
+					}
+					evaluationCount++;
+
 					unsigned int simulationResult = runSimulations(scenario,
 							configuration, packet.getMessage()->robot(),
-							viewer, rng);
+							viewer, rng, false, log);
 
 					if(viewer != NULL) {
 						delete viewer;
@@ -208,7 +208,8 @@ unsigned int runSimulations(boost::shared_ptr<Scenario> scenario,
         boost::shared_ptr<WebGLLogger> webGLlogger;
         if (log && log->isWriteWebGL()) {
         	webGLlogger.reset(new WebGLLogger(log->getWebGLFileName(),
-        										scenario));
+        										scenario, 120.0,
+        										log->isWriteWebGLBinary()));
         }
 
 
@@ -410,6 +411,7 @@ unsigned int runSimulations(boost::shared_ptr<Scenario> scenario,
 				log->logPosition(
 					scenario->getRobot(
 							)->getCoreComponent()->getRootPosition());
+				log->logState(t, robot, env);
 			}
 
 			if(webGLlogger) {
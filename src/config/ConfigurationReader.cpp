@@ -43,6 +43,7 @@
 #include "config/StartPositionConfig.h"
 #include "config/TerrainConfig.h"
 #include "config/LightSourcesConfig.h"
+#include "scenario/ScenarioPlugin.h"
 
 #include "utils/RobogenUtils.h"
 
@@ -74,7 +75,8 @@ boost::shared_ptr<RobogenConfig> ConfigurationReader::parseConfigurationFile(
 			("scenario",
 					boost::program_options::value<std::string>(),
 					"Experiment scenario: (racing, chasing, "
-					"or a provided js file)")
+					"a provided js file, or a compiled scenario plugin "
+					"(.so, .dylib or .dll))")
 			("timeStep", boost::program_options::value<float>(),
 					"Time step duration (s)")
 			("nTimeSteps", boost::program_options::value<unsigned int>(),
@@ -96,6 +98,31 @@ boost::shared_ptr<RobogenConfig> ConfigurationReader::parseConfigurationFile(
 					"Terrain length")
 			("terrainFriction",boost::program_options::value<float>(),
 					"Terrain Friction Coefficient")
+			("terrainCollision",
+					boost::program_options::value<std::string>(),
+					"Collision model of rugged terrain: heightfield "\
+					"(default) or trimesh")
+			("terrainGenerator",
+					boost::program_options::value<std::string>(),
+					"Generator of rugged terrain, instead of "\
+					"terrainHeightField: fractal, steps, slope or rubble")
+			("terrainSeed",
+					boost::program_options::value<unsigned int>(),
+					"Seed of the terrain generator (default 0)")
+			("terrainSeedPerTrial",
+					boost::program_options::value<bool>(),
+					"Generate a terrain for each trial, seeded with "\
+					"terrainSeed plus the index of its starting position "\
+					"(default true), rather than the same one for all")
+			("terrainResolution",
+					boost::program_options::value<unsigned int>(),
+					"Number of generated height samples along each side "\
+					"of the terrain (default 129)")
+			("terrainFeatureSize",
+					boost::program_options::value<float>(),
+					"Size of the generated terrain features: noise "\
+					"wavelength, step length or rock diameter (default "\
+					"0.25)")
 			("startPositionConfigFile",
 					boost::program_options::value<std::string>(),
 					"Start Positions Configuration File")
@@ -223,9 +250,11 @@ boost::shared_ptr<RobogenConfig> ConfigurationReader::parseConfigurationFile(
 			std::string terrainHeightField;
 			float terrainHeight;
 
-			if (!vm.count("terrainHeightField")) {
-				std::cerr << "Undefined 'terrainHeightField' parameter in '"
-						<< fileName << "'" << std::endl;
+			if (!vm.count("terrainHeightField") &&
+					!vm.count("terrainGenerator")) {
+				std::cerr << "Undefined 'terrainHeightField' or "
+						<< "'terrainGenerator' parameter in '" << fileName
+						<< "'" << std::endl;
 				return boost::shared_ptr<RobogenConfig>();
 			}
 
@@ -235,16 +264,93 @@ boost::shared_ptr<RobogenConfig> ConfigurationReader::parseConfigurationFile(
 				return boost::shared_ptr<RobogenConfig>();
 			}
 
-			terrainHeightField = vm["terrainHeightField"].as<std::string>();
-			makeAbsolute(terrainHeightField, filePath);
+			terrainHeight = vm["terrainHeight"].as<float>();
 
+			bool terrainTrimesh = false;
+			if (vm.count("terrainCollision")) {
+				std::string terrainCollision =
+						vm["terrainCollision"].as<std::string>();
+				if (terrainCollision.compare("trimesh") == 0) {
+					terrainTrimesh = true;
+				} else if (terrainCollision.compare("heightfield") != 0) {
+					std::cerr << "Unknown value of 'terrainCollision' "
+							<< "parameter in '" << fileName << "'"
+							<< std::endl;
+					return boost::shared_ptr<RobogenConfig>();
+				}
+			}
 
+			if (vm.count("terrainGenerator")) {
+
+				std::string generatorName =
+						vm["terrainGenerator"].as<std::string>();
+				TerrainConfig::TerrainGenerator generator;
+				if (generatorName.compare("fractal") == 0) {
+					generator = TerrainConfig::FRACTAL;
+				} else if (generatorName.compare("steps") == 0) {
+					generator = TerrainConfig::STEPS;
+				} else if (generatorName.compare("slope") == 0) {
+					generator = TerrainConfig::SLOPE;
+				} else if (generatorName.compare("rubble") == 0) {
+					generator = TerrainConfig::RUBBLE;
+				} else {
+					std::cerr << "Unknown value of 'terrainGenerator' "
+							<< "parameter in '" << fileName << "'"
+							<< std::endl;
+					return boost::shared_ptr<RobogenConfig>();
+				}
+
+				unsigned int terrainSeed = 0;
+				if (vm.count("terrainSeed")) {
+					terrainSeed = vm["terrainSeed"].as<unsigned int>();
+				}
+
+				bool terrainSeedPerTrial = true;
+				if (vm.count("terrainSeedPerTrial")) {
+					terrainSeedPerTrial =
+							vm["terrainSeedPerTrial"].as<bool>();
+				}
+
+				unsigned int terrainResolution = 129;
+				if (vm.count("terrainResolution")) {
+					terrainResolution =
+							vm["terrainResolution"].as<unsigned int>();
+				}
+				if (terrainResolution < 2) {
+					std::cerr << "'terrainResolution' must be at least 2 in '"
+							<< fileName << "'" << std::endl;
+					return boost::shared_ptr<RobogenConfig>();
+				}
+
+				float terrainFeatureSize = 0.25;
+				if (vm.count("terrainFeatureSize")) {
+					terrainFeatureSize =
+							vm["terrainFeatureSize"].as<float>();
+				}
+				if (terrainFeatureSize <= 0) {
+					std::cerr << "'terrainFeatureSize' must be positive in '"
+							<< fileName << "'" << std::endl;
+					return boost::shared_ptr<RobogenConfig>();
+				}
+
+				terrain.reset(
+						new TerrainConfig(generator, terrainSeed,
+								terrainResolution, terrainFeatureSize,
+								terrainLength, terrainWidth, terrainHeight,
+								terrainFriction, terrainTrimesh,
+								terrainSeedPerTrial));
 
-			terrainHeight = vm["terrainHeight"].as<float>();
+			} else {
+
+				terrainHeightField =
+						vm["terrainHeightField"].as<std::string>();
+				makeAbsolute(terrainHeightField, filePath);
 
-			terrain.reset(
-					new TerrainConfig(terrainHeightField, terrainLength,
-							terrainWidth, terrainHeight, terrainFriction));
+				terrain.reset(
+						new TerrainConfig(terrainHeightField, terrainLength,
+								terrainWidth, terrainHeight, terrainFriction,
+								terrainTrimesh));
+			}
 
 		} else {
 			std::cerr << "Unknown value of 'terrainType' parameter in '" << fileName
@@ -335,6 +441,8 @@ boost::shared_ptr<RobogenConfig> ConfigurationReader::parseConfigurationFile(
 					boost::filesystem::absolute(scenarioFilePath,
 							filePath.parent_path());
 			scenarioFile = absolutePath.string();
+		} else {
+			scenarioFile = scenario;
 		}
 		if(boost::filesystem::path(scenarioFile).extension().string().compare(".js")
 				== 0) {
@@ -352,6 +460,14 @@ boost::shared_ptr<RobogenConfig> ConfigurationReader::parseConfigurationFile(
 			std::stringstream buffer;
 			buffer << file.rdbuf();
 			scenario = buffer.str();
+		} else if (ScenarioPlugin::isPlugin(scenarioFile)) {
+			if (!boost::filesystem::exists(scenarioFile)) {
+				std::cerr << "Cannot find scenario plugin: '" << scenarioFile
+						<< "'" << std::endl;
+				return boost::shared_ptr<RobogenConfig>();
+			}
+			// servers load the plugin from the same path
+			scenario = scenarioFile;
 		} else {
 			std::cerr << "Invalid 'scenario' parameter" << std::endl;
 			return boost::shared_ptr<RobogenConfig>();
@@ -742,13 +858,28 @@ boost::shared_ptr<RobogenConfig> ConfigurationReader::parseRobogenMessage(
 		terrain.reset(new TerrainConfig(simulatorConf.terrainlength(),
 					simulatorConf.terrainwidth(),
 					simulatorConf.terrainfriction()));
+	} else if(simulatorConf.terraintype() == TerrainConfig::ROUGH &&
+			simulatorConf.terraingenerator() != TerrainConfig::NO_GENERATOR) {
+		terrain.reset(new TerrainConfig(
+							static_cast<TerrainConfig::TerrainGenerator>(
+									simulatorConf.terraingenerator()),
+							simulatorConf.terrainseed(),
+							simulatorConf.terrainresolution(),
+							simulatorConf.terrainfeaturesize(),
+							simulatorConf.terrainlength(),
+							simulatorConf.terrainwidth(),
+							simulatorConf.terrainheight(),
+							simulatorConf.terrainfriction(),
+							simulatorConf.terraintrimesh(),
+							simulatorConf.terrainseedpertrial()));
 	} else if(simulatorConf.terraintype() == TerrainConfig::ROUGH) {
 		terrain.reset(new TerrainConfig(
 							simulatorConf.terrainheightfieldfilename(),
 							simulatorConf.terrainlength(),
 							simulatorConf.terrainwidth(),
 							simulatorConf.terrainheight(),
-							simulatorConf.terrainfriction()));
+							simulatorConf.terrainfriction(),
+							simulatorConf.terraintrimesh()));
 	}
 
 	// Decode simulator configuration
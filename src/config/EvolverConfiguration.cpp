@@ -34,6 +34,7 @@
 #include <boost/filesystem.hpp>
 
 #include "config/EvolverConfiguration.h"
+#include "evolution/engine/BodyVerifier.h"
 #include "PartList.h"
 
 namespace robogen {
@@ -84,6 +85,8 @@ bool EvolverConfiguration::init(std::string configFileName) {
 	memset(bodyOperatorProbability, 0, sizeof(bodyOperatorProbability));
 	maxBodyMutationAttempts = 100; //seems like a reasonable default
 	maxBodyParts = 100000; //some unreasonably large value if max not set
+	evolverThreads = 0; // one per hardware thread
+	checkpointInterval = 0; // no checkpoints
 	// boost-parse options
 	boost::program_options::options_description desc(
 			"Allowed options for Evolution Config File");
@@ -235,6 +238,17 @@ bool EvolverConfiguration::init(std::string configFileName) {
 		("bodyParamSigma", boost::program_options::value<double>(
 				&bodyParamSigma),
 				"Sigma of body param mutation (all params in [0,1])")
+		("bodyVerifier", boost::program_options::value<std::string>(),
+				"Body verification: ode (default), geometric or cross-check")
+		("evolverThreads",
+				boost::program_options::value<unsigned int>(&evolverThreads),
+				"Number of threads used to create offspring "
+				"(default: 0, one per hardware thread)")
+		("checkpointInterval",
+				boost::program_options::value<unsigned int>(
+						&checkpointInterval),
+				"Save a checkpoint to resume evolution from every that many "
+				"generations (default: 0, never)")
 		;
 	// generate body operator probability options from contraptions in header
 	for (unsigned i=0; i<NUM_BODY_OPERATORS; ++i){
@@ -390,6 +404,22 @@ bool EvolverConfiguration::init(std::string configFileName) {
 	}
 
 
+	// parse body verifier
+	if (vm.count("bodyVerifier") == 0 ||
+			vm["bodyVerifier"].as<std::string>() == "ode") {
+		bodyVerificationMode = BodyVerifier::ODE_VERIFICATION;
+	} else if (vm["bodyVerifier"].as<std::string>() == "geometric") {
+		bodyVerificationMode = BodyVerifier::GEOMETRIC_VERIFICATION;
+	} else if (vm["bodyVerifier"].as<std::string>() == "cross-check") {
+		bodyVerificationMode = BodyVerifier::CROSS_CHECK_VERIFICATION;
+	} else {
+		std::cerr << "Specified body verifier \"" <<
+				vm["bodyVerifier"].as<std::string>() <<
+				"\" unknown. Options are \"ode\", \"geometric\" or "
+				"\"cross-check\"" << std::endl;
+		return false;
+	}
+
 	// parse sockets. The used regex is not super-restrictive, but we count
 	// on the TcpSocket to find the error... else:
 	// http://www.regular-expressions.info/examples.html
@@ -652,6 +682,8 @@ bool EvolverConfiguration::init(std::string configFileName) {
 			neatParams.ActivationFunction_UnsignedSine_Prob = 0.0;
 			neatParams.ActivationFunction_Linear_Prob = 1.0;
 
+			neatParams.NumThreads = evolverThreads;
+
 
 			if ( neatParamsFile.compare("") != 0 ) {
 				const boost::filesystem::path neatParamsFilePath(
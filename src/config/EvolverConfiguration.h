@@ -248,6 +248,23 @@ typedef struct EvolverConfiguration {
 	 */
 	unsigned int maxBodyParts;
 
+	/**
+	 * Body verification back end, one of BodyVerifier::verificationModes
+	 */
+	int bodyVerificationMode;
+
+	/**
+	 * Number of threads used by the evolver itself, e.g. to create
+	 * offspring. 0 means one per hardware thread.
+	 */
+	unsigned int evolverThreads;
+
+	/**
+	 * Number of generations between two checkpoints of the evolution,
+	 * which can be resumed from the last one. 0 means no checkpoints.
+	 */
+	unsigned int checkpointInterval;
+
 	/**
 	 * Minimum number of body parts in individuals in the initial population
 	 */
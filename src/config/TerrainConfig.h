@@ -47,6 +47,18 @@ public:
 			ROUGH
 	};
 
+	/**
+	 * Generators of rough terrain, which otherwise comes from a height map
+	 * file
+	 */
+	enum TerrainGenerator {
+			NO_GENERATOR,
+			FRACTAL,	// fractal Perlin noise
+			STEPS,		// stairs going up along the length
+			SLOPE,		// slope going up along the length
+			RUBBLE		// randomly scattered rocks
+	};
+
 	/**
 	 * Initializes an empty terrain
 	 *
@@ -54,7 +66,8 @@ public:
 	 */
 	TerrainConfig(float friction) :
 			type_(EMPTY), length_(0), width_(0), height_(0),
-			friction_(friction) {
+			friction_(friction), trimesh_(false), generator_(NO_GENERATOR),
+			seed_(0), resolution_(0), featureSize_(0), seedPerTrial_(false) {
 
 	}
 
@@ -68,7 +81,8 @@ public:
 	 */
 	TerrainConfig(float length, float width, float friction) :
 			type_(FLAT), length_(length), width_(width), height_(0),
-			friction_(friction) {
+			friction_(friction), trimesh_(false), generator_(NO_GENERATOR),
+			seed_(0), resolution_(0), featureSize_(0), seedPerTrial_(false) {
 
 	}
 
@@ -79,12 +93,41 @@ public:
 	 * @param length
 	 * @param width
 	 * @param height
+	 * @param trimesh collide with a trimesh rather than an ODE heightfield
 	 */
 	TerrainConfig(const std::string& heightFieldFileName, float length,
-			float width, float height, float friction) :
+			float width, float height, float friction, bool trimesh = false) :
 				type_(ROUGH), heightFieldFileName_(heightFieldFileName),
 				length_(length), width_(width), height_(height),
-				friction_(friction) {
+				friction_(friction), trimesh_(trimesh),
+				generator_(NO_GENERATOR), seed_(0), resolution_(0),
+				featureSize_(0), seedPerTrial_(false) {
+
+	}
+
+	/**
+	 * Initializes a rough terrain generated in memory
+	 *
+	 * @param generator
+	 * @param seed seed of the random generators
+	 * @param resolution number of height samples along each side
+	 * @param featureSize size of the terrain features: noise wavelength,
+	 * step length or rock diameter
+	 * @param length
+	 * @param width
+	 * @param height
+	 * @param trimesh collide with a trimesh rather than an ODE heightfield
+	 * @param seedPerTrial generate each trial a terrain of its own, seeded
+	 * with seed plus the index of the starting position of the trial
+	 */
+	TerrainConfig(TerrainGenerator generator, unsigned int seed,
+			unsigned int resolution, float featureSize, float length,
+			float width, float height, float friction, bool trimesh = false,
+			bool seedPerTrial = true) :
+				type_(ROUGH), length_(length), width_(width),
+				height_(height), friction_(friction), trimesh_(trimesh),
+				generator_(generator), seed_(seed), resolution_(resolution),
+				featureSize_(featureSize), seedPerTrial_(seedPerTrial) {
 
 	}
 
@@ -139,6 +182,58 @@ public:
 		return friction_;
 	}
 
+	/**
+	 * @return true if a rough terrain collides as a trimesh, false if it is
+	 * an ODE heightfield
+	 */
+	bool isTrimesh() {
+		return trimesh_;
+	}
+
+	/**
+	 * @return the generator of a rough terrain, NO_GENERATOR if it comes
+	 * from the height field file
+	 */
+	TerrainGenerator getGenerator() {
+		return generator_;
+	}
+
+	/**
+	 * @return the seed of the terrain generator
+	 */
+	unsigned int getSeed() {
+		return seed_;
+	}
+
+	/**
+	 * @return the seed of the terrain generated for the trial starting at a
+	 * starting position
+	 */
+	unsigned int getSeed(unsigned int startPosition) {
+		return seedPerTrial_ ? seed_ + startPosition : seed_;
+	}
+
+	/**
+	 * @return true if each trial gets a terrain of its own
+	 */
+	bool isSeedPerTrial() {
+		return seedPerTrial_;
+	}
+
+	/**
+	 * @return the number of generated height samples along each side
+	 */
+	unsigned int getResolution() {
+		return resolution_;
+	}
+
+	/**
+	 * @return the size of the generated terrain features
+	 */
+	float getFeatureSize() {
+		return featureSize_;
+	}
+
 	void serialize(robogenMessage::SimulatorConf &message) {
 		message.set_terraintype(type_);
 		message.set_terrainheightfieldfilename(heightFieldFileName_);
@@ -146,6 +241,12 @@ public:
 		message.set_terrainwidth(width_);
 		message.set_terrainheight(height_);
 		message.set_terrainfriction(friction_);
+		message.set_terraintrimesh(trimesh_);
+		message.set_terraingenerator(generator_);
+		message.set_terrainseed(seed_);
+		message.set_terrainresolution(resolution_);
+		message.set_terrainfeaturesize(featureSize_);
+		message.set_terrainseedpertrial(seedPerTrial_);
 	}
 
 private:
@@ -180,6 +281,20 @@ private:
 	 */
 	float friction_;
 
+	/**
+	 * Rough terrain collides as a trimesh
+	 */
+	bool trimesh_;
+
+	/**
+	 * Generator of rough terrain and its parameters
+	 */
+	TerrainGenerator generator_;
+	unsigned int seed_;
+	unsigned int resolution_;
+	float featureSize_;
+	bool seedPerTrial_;
+
 };
 
 }
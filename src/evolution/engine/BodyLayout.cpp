@@ -0,0 +1,1007 @@
+/*
+ * @(#) BodyLayout.cpp   1.0   Oct 19, 2026
+ *
+ * The ROBOGEN Framework
+ * Copyright © 2013-2016
+ *
+ * Laboratory of Intelligent Systems, EPFL
+ *
+ * This file is part of the ROBOGEN Framework.
+ *
+ * The ROBOGEN Framework is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License (GPL)
+ * as published by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @(#) $Id$
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <boost/thread/mutex.hpp>
+
+#include "evolution/engine/BodyLayout.h"
+#include "utils/RobogenUtils.h"
+#include "Models.h"
+#include "PartList.h"
+
+namespace robogen {
+
+const float BodyLayout::WHEEL_SEPARATION = 0.005;
+
+// ---------------------------------------------------------------------------
+// PartGeometry
+// ---------------------------------------------------------------------------
+
+namespace {
+
+typedef std::pair<std::string, std::vector<double> > PartGeometryKey;
+
+typedef std::map<PartGeometryKey, boost::shared_ptr<const PartGeometry> >
+	PartGeometryCache;
+
+PartGeometryCache partGeometryCache;
+boost::mutex partGeometryCacheMutex;
+
+}
+
+PartGeometry::PartGeometry(const std::string &type) : type_(type) {
+
+}
+
+bool PartGeometry::isSupported(const std::string &type) {
+	return robogen::isCore(type) || type == PART_TYPE_FIXED_BRICK
+			|| type == PART_TYPE_ACTIVE_HINGE
+			|| type == PART_TYPE_PASSIVE_HINGE
+			|| type == PART_TYPE_PARAM_JOINT
+			|| type == PART_TYPE_LIGHT_SENSOR
+#ifdef ALLOW_ROTATIONAL_COMPONENTS
+			|| type == PART_TYPE_ROTATOR
+			|| type == PART_TYPE_ACTIVE_WHEEL
+			|| type == PART_TYPE_ACTIVE_WHEG
+			|| type == PART_TYPE_PASSIVE_WHEEL
+#endif
+#ifdef IR_SENSORS_ENABLED
+			|| type == PART_TYPE_IR_SENSOR
+#endif
+			;
+}
+
+boost::shared_ptr<const PartGeometry> PartGeometry::get(
+		const std::string &type, const std::vector<double> &params) {
+
+	if (!isSupported(type)) {
+		return boost::shared_ptr<const PartGeometry>();
+	}
+
+	// convert parameters from [0,1] to their valid range, exactly as
+	// PartRepresentation::addSubtreeToBodyMessage does
+	std::vector<double> paramValues(params.size());
+	for (unsigned int i = 0; i < params.size(); ++i) {
+		std::pair<double, double> ranges = PART_TYPE_PARAM_RANGE_MAP.at(
+				std::make_pair(type, i));
+		paramValues[i] = (fabs(ranges.first - ranges.second) < 1e-6)
+								? ranges.first
+								: (params[i] * (ranges.second - ranges.first))
+								  + ranges.first;
+	}
+
+	PartGeometryKey key(type, paramValues);
+	boost::mutex::scoped_lock lock(partGeometryCacheMutex);
+	PartGeometryCache::iterator it = partGeometryCache.find(key);
+	if (it != partGeometryCache.end()) {
+		return it->second;
+	}
+
+	boost::shared_ptr<PartGeometry> geometry(new PartGeometry(type));
+	if (!geometry->build(paramValues)) {
+		return boost::shared_ptr<const PartGeometry>();
+	}
+	partGeometryCache[key] = geometry;
+	return geometry;
+}
+
+const SlotFrame &PartGeometry::getSlot(unsigned int i) const {
+	if (i >= slots_.size()) {
+		return slots_.back();
+	}
+	return slots_[i];
+}
+
+bool PartGeometry::isCoreComponentModel() const {
+	return robogen::isCore(type_) || type_ == PART_TYPE_FIXED_BRICK;
+}
+
+bool PartGeometry::isCore() const {
+	return robogen::isCore(type_);
+}
+
+bool PartGeometry::isParametricBrick() const {
+	return type_ == PART_TYPE_PARAM_JOINT;
+}
+
+void PartGeometry::addBox(const osg::Vec3 &pos, float lengthX, float lengthY,
+		float lengthZ, const osg::Quat &attitude) {
+	GeometricPrimitive box;
+	box.shape = GeometricPrimitive::BOX;
+	box.position = pos;
+	box.attitude = attitude;
+	box.halfExtents = osg::Vec3(lengthX / 2, lengthY / 2, lengthZ / 2);
+	box.radius = 0;
+	box.halfLength = 0;
+	primitives_.push_back(box);
+}
+
+void PartGeometry::addCylinder(const osg::Vec3 &pos, int direction,
+		float radius, float height) {
+	// same convention as Model::addCylinder
+	osg::Quat rotateCylinder;
+	if (direction == 1) {
+		rotateCylinder.makeRotate(osg::inDegrees(90.0), osg::Vec3(0, 1, 0));
+	} else if (direction == 2) {
+		rotateCylinder.makeRotate(osg::inDegrees(90.0), osg::Vec3(1, 0, 0));
+	}
+	GeometricPrimitive cylinder;
+	cylinder.shape = GeometricPrimitive::CYLINDER;
+	cylinder.position = pos;
+	cylinder.attitude = rotateCylinder;
+	cylinder.radius = radius;
+	cylinder.halfLength = height / 2;
+	primitives_.push_back(cylinder);
+}
+
+void PartGeometry::addSlot(const osg::Vec3 &position, const osg::Vec3 &axis,
+		const osg::Vec3 &orientation) {
+	SlotFrame slot;
+	slot.position = position;
+	slot.axis = axis;
+	slot.orientation = orientation;
+	slots_.push_back(slot);
+}
+
+/**
+ * Mirrors the initModel() and getSlot*() implementations of the models
+ */
+bool PartGeometry::build(const std::vector<double> &paramValues) {
+
+	if (isCoreComponentModel()) {
+
+		const float width = CoreComponentModel::WIDTH;
+		addBox(osg::Vec3(0, 0, 0), width, width, CoreComponentModel::HEIGHT);
+
+		const float offset = width / 2 - CoreComponentModel::SLOT_THICKNESS;
+		// LEFT_FACE_SLOT, RIGHT_FACE_SLOT, FRONT_FACE_SLOT, BACK_FACE_SLOT
+		addSlot(osg::Vec3(-1, 0, 0) * offset, osg::Vec3(-1, 0, 0),
+				osg::Vec3(0, 1, 0));
+		addSlot(osg::Vec3(1, 0, 0) * offset, osg::Vec3(1, 0, 0),
+				osg::Vec3(0, 1, 0));
+		addSlot(osg::Vec3(0, -1, 0) * offset, osg::Vec3(0, -1, 0),
+				osg::Vec3(0, 0, 1));
+		addSlot(osg::Vec3(0, 1, 0) * offset, osg::Vec3(0, 1, 0),
+				osg::Vec3(0, 0, 1));
+
+	} else if (type_ == PART_TYPE_ACTIVE_HINGE) {
+
+		const float slotThickness = ActiveHingeModel::SLOT_THICKNESS;
+		addBox(osg::Vec3(0, 0, 0), slotThickness,
+				ActiveHingeModel::SLOT_WIDTH, ActiveHingeModel::SLOT_WIDTH);
+
+		dReal xFrame = ActiveHingeModel::FRAME_LENGTH / 2 + slotThickness / 2;
+		addBox(osg::Vec3(xFrame, ActiveHingeModel::SERVO_POSITION_OFFSET, 0),
+				ActiveHingeModel::FRAME_LENGTH, ActiveHingeModel::FRAME_WIDTH,
+				ActiveHingeModel::FRAME_HEIGHT);
+
+		dReal xServo = xFrame + (ActiveHingeModel::FRAME_ROTATION_OFFSET
+				- (ActiveHingeModel::FRAME_LENGTH / 2))
+				+ ActiveHingeModel::SERVO_ROTATION_OFFSET
+				- ActiveHingeModel::SERVO_LENGTH / 2;
+		addBox(osg::Vec3(xServo, ActiveHingeModel::SERVO_POSITION_OFFSET, 0),
+				ActiveHingeModel::SERVO_LENGTH, ActiveHingeModel::SERVO_WIDTH,
+				ActiveHingeModel::SERVO_HEIGHT);
+
+		dReal xTail = xServo + ActiveHingeModel::SERVO_LENGTH / 2
+				+ slotThickness / 2;
+		addBox(osg::Vec3(xTail, 0, 0), slotThickness,
+				ActiveHingeModel::SLOT_WIDTH, ActiveHingeModel::SLOT_WIDTH);
+
+		addSlot(osg::Vec3(-slotThickness / 2, 0, 0), osg::Vec3(-1, 0, 0),
+				osg::Vec3(0, 1, 0));
+		addSlot(osg::Vec3(xTail + slotThickness / 2, 0, 0),
+				osg::Vec3(1, 0, 0), osg::Vec3(0, 1, 0));
+
+	} else if (type_ == PART_TYPE_PASSIVE_HINGE) {
+
+		const float slotThickness = HingeModel::SLOT_THICKNESS;
+		const float partLength = HingeModel::CONNNECTION_PART_LENGTH;
+		addBox(osg::Vec3(0, 0, 0), slotThickness, HingeModel::SLOT_WIDTH,
+				HingeModel::SLOT_WIDTH);
+
+		dReal xPartA = slotThickness / 2 + partLength / 2;
+		addBox(osg::Vec3(xPartA, 0, 0), partLength,
+				HingeModel::CONNECTION_PART_THICKNESS,
+				HingeModel::CONNECTION_PART_HEIGHT);
+
+		dReal xPartB = xPartA + (partLength / 2 - (partLength
+				- HingeModel::CONNECTION_ROTATION_OFFSET)) * 2;
+		addBox(osg::Vec3(xPartB, 0, 0), partLength,
+				HingeModel::CONNECTION_PART_THICKNESS,
+				HingeModel::CONNECTION_PART_HEIGHT);
+
+		dReal xTail = xPartB + partLength / 2 + slotThickness / 2;
+		addBox(osg::Vec3(xTail, 0, 0), slotThickness, HingeModel::SLOT_WIDTH,
+				HingeModel::SLOT_WIDTH);
+
+		addSlot(osg::Vec3(-slotThickness / 2, 0, 0), osg::Vec3(-1, 0, 0),
+				osg::Vec3(0, 1, 0));
+		addSlot(osg::Vec3(xTail + slotThickness / 2, 0, 0),
+				osg::Vec3(1, 0, 0), osg::Vec3(0, 1, 0));
+
+	} else if (type_ == PART_TYPE_PARAM_JOINT) {
+
+		if (paramValues.size() != 3) {
+			return false;
+		}
+		// same float conversions as ParametricBrickModel's constructor
+		const float connectionPartLength = (float) paramValues[0]
+				+ ParametricBrickModel::CYLINDER_RADIUS;
+		const float angleA = paramValues[1];
+		const float angleB = paramValues[2];
+		const float slotThickness = ParametricBrickModel::SLOT_THICKNESS;
+		const float barLength = ParametricBrickModel::FIXED_BAR_LENGTH;
+
+		addBox(osg::Vec3(0, 0, 0), slotThickness,
+				ParametricBrickModel::SLOT_WIDTH,
+				ParametricBrickModel::SLOT_WIDTH);
+
+		osg::Vec3 fixedBarPosition(slotThickness / 2. + barLength / 2., 0, 0);
+		addBox(fixedBarPosition, barLength,
+				ParametricBrickModel::CONNECTION_PART_WIDTH,
+				ParametricBrickModel::CONNECTION_PART_THICKNESS);
+
+		osg::Vec3 cylinderPosition(fixedBarPosition.x() + barLength / 2.,
+				0, 0);
+		addCylinder(cylinderPosition, 2, ParametricBrickModel::CYLINDER_RADIUS,
+				ParametricBrickModel::CONNECTION_PART_WIDTH);
+
+		osg::Quat rotationA;
+		rotationA.makeRotate(osg::DegreesToRadians(angleA),
+				osg::Vec3(0, 1, 0));
+		osg::Vec3 connectionPartPosition = cylinderPosition + rotationA *
+				osg::Vec3(connectionPartLength / 2., 0, 0);
+		addBox(connectionPartPosition, connectionPartLength,
+				ParametricBrickModel::CONNECTION_PART_WIDTH,
+				ParametricBrickModel::CONNECTION_PART_THICKNESS, rotationA);
+
+		osg::Quat rotationB;
+		rotationB.makeRotate(osg::DegreesToRadians(angleB),
+				osg::Vec3(1, 0, 0));
+		rotationB = rotationB * rotationA;
+		osg::Vec3 slotBPosition = connectionPartPosition + rotationB *
+				osg::Vec3(connectionPartLength / 2 + slotThickness / 2, 0, 0);
+		addBox(slotBPosition, slotThickness, ParametricBrickModel::SLOT_WIDTH,
+				ParametricBrickModel::SLOT_WIDTH, rotationB);
+
+		addSlot(osg::Vec3(-slotThickness / 2, 0, 0), osg::Vec3(-1, 0, 0),
+				osg::Vec3(0, 1, 0));
+		osg::Vec3 slotBAxis = rotationB * osg::Vec3(1, 0, 0);
+		addSlot(slotBPosition + slotBAxis * (slotThickness / 2), slotBAxis,
+				rotationB * osg::Vec3(0, 1, 0));
+
+#ifdef ALLOW_ROTATIONAL_COMPONENTS
+	} else if (type_ == PART_TYPE_ROTATOR) {
+
+		const float slotThickness = RotateJointModel::SLOT_THICKNESS;
+		addBox(osg::Vec3(0, 0, 0), slotThickness,
+				RotateJointModel::SLOT_WIDTH, RotateJointModel::SLOT_WIDTH);
+
+		dReal xServo = RotateJointModel::SERVO_LENGTH / 2 + slotThickness / 2;
+		addBox(osg::Vec3(xServo, 0, 0), RotateJointModel::SERVO_LENGTH,
+				RotateJointModel::SERVO_WIDTH, RotateJointModel::SERVO_HEIGHT);
+
+		dReal xJointConnection = xServo + RotateJointModel::SERVO_LENGTH / 2
+				- RotateJointModel::JOINT_CONNECTION_THICKNESS / 2;
+		addBox(osg::Vec3(xJointConnection, 0, 0),
+				RotateJointModel::JOINT_CONNECTION_THICKNESS,
+				RotateJointModel::JOINT_CONNECTION_WIDTH,
+				RotateJointModel::JOINT_CONNECTION_WIDTH);
+
+		addSlot(osg::Vec3(-slotThickness / 2, 0, 0), osg::Vec3(-1, 0, 0),
+				osg::Vec3(0, 1, 0));
+		addSlot(osg::Vec3(xJointConnection
+				+ RotateJointModel::JOINT_CONNECTION_THICKNESS / 2, 0, 0),
+				osg::Vec3(1, 0, 0), osg::Vec3(0, 1, 0));
+
+	} else if (type_ == PART_TYPE_ACTIVE_WHEEL) {
+
+		if (paramValues.size() != 1) {
+			return false;
+		}
+		const float radius = paramValues[0];
+		const float slotThickness = ActiveWheelModel::SLOT_THICKNESS;
+		addBox(osg::Vec3(0, 0, 0), slotThickness,
+				ActiveWheelModel::SLOT_WIDTH, ActiveWheelModel::SLOT_WIDTH);
+
+		dReal xServo = ActiveWheelModel::SERVO_LENGTH / 2 + slotThickness / 2;
+		addBox(osg::Vec3(xServo, 0, 0), ActiveWheelModel::SERVO_LENGTH,
+				ActiveWheelModel::SERVO_WIDTH, ActiveWheelModel::SERVO_HEIGHT);
+
+		dReal xWheel = xServo + ActiveWheelModel::SERVO_LENGTH / 2
+				- ActiveWheelModel::WHEEL_ATTACHMENT_THICKNESS
+				- ActiveWheelModel::WHEEL_THICKNESS / 2;
+		addCylinder(osg::Vec3(xWheel, 0, 0), 1, radius,
+				ActiveWheelModel::WHEEL_THICKNESS);
+
+		addSlot(osg::Vec3(-slotThickness / 2, 0, 0), osg::Vec3(-1, 0, 0),
+				osg::Vec3(0, 1, 0));
+
+	} else if (type_ == PART_TYPE_ACTIVE_WHEG) {
+
+		if (paramValues.size() != 1) {
+			return false;
+		}
+		const float radius = paramValues[0];
+		const float slotThickness = ActiveWhegModel::SLOT_THICKNESS;
+		addBox(osg::Vec3(0, 0, 0), slotThickness,
+				ActiveWhegModel::SLOT_WIDTH, ActiveWhegModel::SLOT_WIDTH);
+
+		dReal xServo = ActiveWhegModel::SERVO_LENGTH / 2 + slotThickness / 2;
+		addBox(osg::Vec3(xServo, 0, 0), ActiveWhegModel::SERVO_LENGTH,
+				ActiveWhegModel::SERVO_WIDTH, ActiveWhegModel::SERVO_HEIGHT);
+
+		dReal whegBaseRadius = ActiveWhegModel::WHEG_BASE_RADIUS
+				* radius / 0.03;
+		dReal xWheg = xServo + ActiveWhegModel::SERVO_LENGTH / 2
+				- ActiveWhegModel::WHEG_ATTACHMENT_THICKNESS
+				- ActiveWhegModel::WHEG_THICKNESS / 2;
+		addCylinder(osg::Vec3(xWheg, 0, 0), 1, whegBaseRadius,
+				ActiveWhegModel::WHEG_THICKNESS);
+
+		const float spokeRotations[] = { 60, 180, 300 };
+		for (unsigned int i = 0; i < 3; ++i) {
+			osg::Quat rotation;
+			rotation.makeRotate(osg::inDegrees(spokeRotations[i]),
+					osg::Vec3(1, 0, 0));
+			osg::Vec3 position(xWheg, 0, 0);
+			position += osg::Vec3(0,
+					(whegBaseRadius + radius / 2)
+						* std::cos(osg::inDegrees(90.0 + spokeRotations[i])),
+					(whegBaseRadius + radius / 2)
+						* std::sin(osg::inDegrees(90.0 + spokeRotations[i])));
+			addBox(position, ActiveWhegModel::WHEG_THICKNESS,
+					ActiveWhegModel::WHEG_WIDTH, radius, rotation);
+		}
+
+		addSlot(osg::Vec3(-slotThickness / 2, 0, 0), osg::Vec3(-1, 0, 0),
+				osg::Vec3(0, 1, 0));
+
+	} else if (type_ == PART_TYPE_PASSIVE_WHEEL) {
+
+		if (paramValues.size() != 1) {
+			return false;
+		}
+		const float radius = paramValues[0];
+		const float slotThickness = PassiveWheelModel::SLOT_THICKNESS;
+		addBox(osg::Vec3(0, 0, 0), slotThickness,
+				PassiveWheelModel::SLOT_WIDTH, PassiveWheelModel::SLOT_WIDTH);
+
+		dReal xAxel = slotThickness / 2 + PassiveWheelModel::AXEL_LENGTH / 2;
+		addCylinder(osg::Vec3(xAxel, 0, 0), 1, PassiveWheelModel::AXEL_RADIUS,
+				PassiveWheelModel::AXEL_LENGTH);
+
+		dReal xWheel = slotThickness / 2
+				+ PassiveWheelModel::WHEEL_AXEL_OFFSET;
+		addCylinder(osg::Vec3(xWheel, 0, 0), 1, radius,
+				PassiveWheelModel::WHEEL_THICKNESS);
+
+		addSlot(osg::Vec3(-slotThickness / 2, 0, 0), osg::Vec3(-1, 0, 0),
+				osg::Vec3(0, 1, 0));
+#endif
+	} else if (type_ == PART_TYPE_LIGHT_SENSOR) {
+
+		const float baseThickness = LightSensorModel::SENSOR_BASE_THICKNESS;
+		addBox(osg::Vec3(0, 0, 0), baseThickness,
+				LightSensorModel::SENSOR_BASE_WIDTH,
+				LightSensorModel::SENSOR_BASE_WIDTH);
+		addBox(osg::Vec3(baseThickness / 2.0
+				+ LightSensorModel::SENSOR_PLATFORM_THICKNESS / 2.0, 0, 0),
+				LightSensorModel::SENSOR_PLATFORM_THICKNESS,
+				LightSensorModel::SENSOR_PLATFORM_WIDTH,
+				LightSensorModel::SENSOR_PLATFORM_WIDTH);
+		addCylinder(osg::Vec3(baseThickness / 2.0
+				+ LightSensorModel::SENSOR_PLATFORM_THICKNESS
+				+ LightSensorModel::SENSOR_CYLINDER_HEIGHT / 2.0, 0, 0), 1,
+				LightSensorModel::SENSOR_CYLINDER_RADIUS,
+				LightSensorModel::SENSOR_CYLINDER_HEIGHT);
+
+		addSlot(osg::Vec3(-baseThickness / 2, 0, 0), osg::Vec3(-1, 0, 0),
+				osg::Vec3(0, 1, 0));
+
+#ifdef IR_SENSORS_ENABLED
+	} else if (type_ == PART_TYPE_IR_SENSOR) {
+
+		const float baseThickness = IrSensorModel::SENSOR_BASE_THICKNESS;
+		addBox(osg::Vec3(0, 0, 0), baseThickness,
+				IrSensorModel::SENSOR_BASE_WIDTH,
+				IrSensorModel::SENSOR_BASE_WIDTH);
+		addBox(osg::Vec3(baseThickness / 2.0
+				+ IrSensorModel::SENSOR_PLATFORM_THICKNESS / 2.0, 0, 0),
+				IrSensorModel::SENSOR_PLATFORM_THICKNESS,
+				IrSensorModel::SENSOR_PLATFORM_WIDTH,
+				IrSensorModel::SENSOR_PLATFORM_HEIGHT);
+
+		addSlot(osg::Vec3(-baseThickness / 2, 0, 0), osg::Vec3(-1, 0, 0),
+				osg::Vec3(0, 1, 0));
+#endif
+	} else {
+		return false;
+	}
+
+	return true;
+}
+
+// ---------------------------------------------------------------------------
+// Overlap tests
+// ---------------------------------------------------------------------------
+
+namespace {
+
+/**
+ * Primitive in world coordinates, with its axis aligned bounding box
+ */
+struct WorldPrimitive {
+	GeometricPrimitive::Shape shape;
+	osg::Vec3 center;
+	// local x, y, z axes in world coordinates (z is the cylinder axis)
+	osg::Vec3 axes[3];
+	osg::Vec3 halfExtents;
+	float radius;
+	float halfLength;
+	int part;
+	osg::Vec3 min;
+	osg::Vec3 max;
+};
+
+void computeBounds(WorldPrimitive &p) {
+	osg::Vec3 extent;
+	for (unsigned int k = 0; k < 3; ++k) {
+		if (p.shape == GeometricPrimitive::BOX) {
+			extent[k] = p.halfExtents[0] * fabs(p.axes[0][k])
+					+ p.halfExtents[1] * fabs(p.axes[1][k])
+					+ p.halfExtents[2] * fabs(p.axes[2][k]);
+		} else {
+			double u = p.axes[2][k];
+			extent[k] = p.halfLength * fabs(u)
+					+ p.radius * sqrt(std::max(0., 1. - u * u));
+		}
+	}
+	p.min = p.center - extent;
+	p.max = p.center + extent;
+}
+
+inline bool boundsOverlap(const osg::Vec3 &minA, const osg::Vec3 &maxA,
+		const osg::Vec3 &minB, const osg::Vec3 &maxB) {
+	return !(minA.x() > maxB.x() || minB.x() > maxA.x() ||
+			minA.y() > maxB.y() || minB.y() > maxA.y() ||
+			minA.z() > maxB.z() || minB.z() > maxA.z());
+}
+
+double projectedRadius(const WorldPrimitive &p, const osg::Vec3 &n,
+		float radiusInflation) {
+	if (p.shape == GeometricPrimitive::BOX) {
+		return p.halfExtents[0] * fabs(n * p.axes[0])
+				+ p.halfExtents[1] * fabs(n * p.axes[1])
+				+ p.halfExtents[2] * fabs(n * p.axes[2]);
+	}
+	double d = fabs(n * p.axes[2]);
+	return p.halfLength * d + (p.radius + radiusInflation)
+			* sqrt(std::max(0., 1. - d * d));
+}
+
+/**
+ * @return true if n is a separating axis. Touching primitives are not
+ * separated, as with ODE's collision functions.
+ */
+bool separatedAlong(osg::Vec3 n, const WorldPrimitive &a, float inflationA,
+		const WorldPrimitive &b, float inflationB) {
+	if (n.length2() < 1e-12) {
+		return false;
+	}
+	n.normalize();
+	double distance = fabs((b.center - a.center) * n);
+	return distance > projectedRadius(a, n, inflationA)
+			+ projectedRadius(b, n, inflationB);
+}
+
+/**
+ * Separating axis test. Exact for box pairs; for pairs involving cylinders
+ * only a finite set of candidate axes is tested, so the test is conservative:
+ * it may report an intersection for primitives which are very close, but
+ * never misses one.
+ */
+bool overlap(const WorldPrimitive &a, float inflationA,
+		const WorldPrimitive &b, float inflationB) {
+
+	std::vector<osg::Vec3> axes;
+	osg::Vec3 d = b.center - a.center;
+
+	if (a.shape == GeometricPrimitive::BOX) {
+		axes.insert(axes.end(), a.axes, a.axes + 3);
+	} else {
+		axes.push_back(a.axes[2]);
+		axes.push_back(d - a.axes[2] * (d * a.axes[2]));
+	}
+	if (b.shape == GeometricPrimitive::BOX) {
+		axes.insert(axes.end(), b.axes, b.axes + 3);
+	} else {
+		axes.push_back(b.axes[2]);
+		axes.push_back(d - b.axes[2] * (d * b.axes[2]));
+	}
+	for (unsigned int i = 0; i < 3; ++i) {
+		if (a.shape == GeometricPrimitive::CYLINDER && i != 2) {
+			continue;
+		}
+		for (unsigned int j = 0; j < 3; ++j) {
+			if (b.shape == GeometricPrimitive::CYLINDER && j != 2) {
+				continue;
+			}
+			axes.push_back(a.axes[i] ^ b.axes[j]);
+		}
+	}
+	if (a.shape == GeometricPrimitive::CYLINDER
+			|| b.shape == GeometricPrimitive::CYLINDER) {
+		axes.push_back(d);
+	}
+
+	for (unsigned int i = 0; i < axes.size(); ++i) {
+		if (separatedAlong(axes[i], a, inflationA, b, inflationB)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Bounding volume hierarchy over the primitives of a body
+ */
+class PrimitiveTree {
+
+public:
+
+	PrimitiveTree(const std::vector<WorldPrimitive> &primitives) :
+			primitives_(primitives) {
+		order_.resize(primitives.size());
+		for (unsigned int i = 0; i < order_.size(); ++i) {
+			order_[i] = i;
+		}
+		if (!order_.empty()) {
+			build(0, order_.size());
+		}
+	}
+
+	/**
+	 * Collects the primitives whose bounding box overlaps the given one
+	 */
+	void query(const osg::Vec3 &min, const osg::Vec3 &max,
+			std::vector<unsigned int> &result) const {
+		if (nodes_.empty()) {
+			return;
+		}
+		std::vector<unsigned int> stack(1, 0);
+		while (!stack.empty()) {
+			const Node &node = nodes_[stack.back()];
+			stack.pop_back();
+			if (!boundsOverlap(min, max, node.min, node.max)) {
+				continue;
+			}
+			if (node.left < 0) {
+				for (unsigned int i = node.first; i < node.first + node.count;
+						++i) {
+					if (boundsOverlap(min, max, primitives_[order_[i]].min,
+							primitives_[order_[i]].max)) {
+						result.push_back(order_[i]);
+					}
+				}
+			} else {
+				stack.push_back(node.left);
+				stack.push_back(node.right);
+			}
+		}
+	}
+
+private:
+
+	struct Node {
+		osg::Vec3 min;
+		osg::Vec3 max;
+		int left;
+		int right;
+		unsigned int first;
+		unsigned int count;
+	};
+
+	struct CenterLess {
+		CenterLess(const std::vector<WorldPrimitive> &primitives, int axis) :
+				primitives_(primitives), axis_(axis) {
+		}
+		bool operator()(unsigned int a, unsigned int b) const {
+			return primitives_[a].center[axis_] < primitives_[b].center[axis_];
+		}
+		const std::vector<WorldPrimitive> &primitives_;
+		int axis_;
+	};
+
+	static const unsigned int LEAF_SIZE = 4;
+
+	int build(unsigned int first, unsigned int count) {
+		int index = nodes_.size();
+		nodes_.push_back(Node());
+		Node node;
+		node.min = primitives_[order_[first]].min;
+		node.max = primitives_[order_[first]].max;
+		for (unsigned int i = first + 1; i < first + count; ++i) {
+			for (unsigned int k = 0; k < 3; ++k) {
+				node.min[k] = std::min(node.min[k],
+						primitives_[order_[i]].min[k]);
+				node.max[k] = std::max(node.max[k],
+						primitives_[order_[i]].max[k]);
+			}
+		}
+		node.first = first;
+		node.count = count;
+		node.left = -1;
+		node.right = -1;
+		if (count > LEAF_SIZE) {
+			// median split along the longest extent
+			osg::Vec3 extent = node.max - node.min;
+			int axis = 0;
+			if (extent[1] > extent[axis]) {
+				axis = 1;
+			}
+			if (extent[2] > extent[axis]) {
+				axis = 2;
+			}
+			unsigned int half = count / 2;
+			std::nth_element(order_.begin() + first,
+					order_.begin() + first + half,
+					order_.begin() + first + count,
+					CenterLess(primitives_, axis));
+			node.left = build(first, half);
+			node.right = build(first + half, count - half);
+		}
+		nodes_[index] = node;
+		return index;
+	}
+
+	const std::vector<WorldPrimitive> &primitives_;
+
+	std::vector<unsigned int> order_;
+
+	std::vector<Node> nodes_;
+
+};
+
+void setOrientationToParentSlot(PartPlacement &part, int orientation) {
+	int deltaOrientation = orientation - part.orientationToParentSlot;
+	part.orientationToParentSlot = orientation;
+	part.orientationToRoot = modulo(part.orientationToRoot +
+			deltaOrientation, 4);
+}
+
+void setParentOrientation(PartPlacement &part, int orientation) {
+	part.orientationToRoot = modulo(part.orientationToParentSlot +
+			orientation, 4);
+}
+
+}
+
+// ---------------------------------------------------------------------------
+// BodyLayout
+// ---------------------------------------------------------------------------
+
+BodyLayout::BodyLayout() {
+
+}
+
+BodyLayout::~BodyLayout() {
+
+}
+
+bool BodyLayout::init(const RobotRepresentation &robot) {
+
+	placements_.clear();
+	index_.clear();
+
+	const RobotRepresentation::IdPartMap &body = robot.getBody();
+	boost::shared_ptr<PartRepresentation> root;
+	for (RobotRepresentation::IdPartMap::const_iterator it = body.begin();
+			it != body.end(); ++it) {
+		boost::shared_ptr<PartRepresentation> part = it->second.lock();
+		if (part && part->getParent() == NULL) {
+			root = part;
+			break;
+		}
+	}
+	if (!root) {
+		return false;
+	}
+
+	// breadth first, as Robot::reconnect: parents are always placed before
+	// their children
+	std::vector<std::pair<boost::shared_ptr<PartRepresentation>,
+		std::pair<int, unsigned int> > > queue;
+	queue.push_back(std::make_pair(root, std::make_pair(-1, 0u)));
+	for (unsigned int q = 0; q < queue.size(); ++q) {
+		boost::shared_ptr<PartRepresentation> part = queue[q].first;
+
+		PartPlacement placement;
+		placement.id = part->getId();
+		placement.parent = queue[q].second.first;
+		placement.params = part->getParams();
+		placement.geometry = PartGeometry::get(part->getType(),
+				placement.params);
+		if (!placement.geometry) {
+			return false;
+		}
+		// as RobogenUtils::createModel
+		placement.orientationToParentSlot = 0;
+		placement.orientationToRoot = 0;
+		setOrientationToParentSlot(placement, part->getOrientation());
+
+		index_[placement.id] = placements_.size();
+		placements_.push_back(placement);
+		if (placement.parent >= 0) {
+			this->place(placements_.size() - 1, queue[q].second.second);
+		}
+
+		for (unsigned int i = 0; i < part->getArity(); ++i) {
+			if (part->getChild(i)) {
+				// slot numbering as PartRepresentation::addSubtreeToBodyMessage
+				unsigned int slot = isCore(part->getType()) ? i : i + 1;
+				queue.push_back(std::make_pair(part->getChild(i),
+						std::make_pair((int) placements_.size() - 1, slot)));
+			}
+		}
+	}
+	return true;
+}
+
+int BodyLayout::find(const std::string &id) const {
+	std::map<std::string, int>::const_iterator it = index_.find(id);
+	if (it == index_.end()) {
+		return -1;
+	}
+	return it->second;
+}
+
+/**
+ * Same computation as RobogenUtils::connect, applied to poses instead of ODE
+ * bodies. The child part starts with identity attitude.
+ */
+void BodyLayout::place(unsigned int child, unsigned int parentSlot) {
+
+	PartPlacement &a = placements_[child];
+	PartPlacement &b = placements_[a.parent];
+	const PartGeometry &geometryA = *a.geometry;
+	const PartGeometry &geometryB = *b.geometry;
+
+#ifdef ENFORCE_PLANAR
+	if (geometryB.isCoreComponentModel()) {
+		if (geometryB.isCore()) {
+			setOrientationToParentSlot(b, 0);
+		}
+		if (parentSlot == CoreComponentModel::LEFT_FACE_SLOT) {
+			setParentOrientation(a, modulo((b.orientationToRoot + 2), 4));
+		} else if (parentSlot == CoreComponentModel::RIGHT_FACE_SLOT) {
+			setParentOrientation(a, b.orientationToRoot);
+		} else if (parentSlot == CoreComponentModel::FRONT_FACE_SLOT) {
+			setParentOrientation(a, modulo((b.orientationToRoot + 3), 4));
+		} else if (parentSlot == CoreComponentModel::BACK_FACE_SLOT) {
+			setParentOrientation(a, modulo((b.orientationToRoot + 3), 4));
+		}
+	} else {
+		setParentOrientation(a, b.orientationToRoot);
+	}
+	if (geometryA.isCoreComponentModel()) {
+		setOrientationToParentSlot(a, modulo((a.orientationToParentSlot
+				+ (4 - a.orientationToRoot)), 4));
+	} else if (geometryA.isParametricBrick()) {
+		setOrientationToParentSlot(a, modulo((a.orientationToParentSlot + 1
+				+ (4 - a.orientationToRoot)), 4));
+	}
+#endif
+	float orientation = 90. * a.orientationToParentSlot;
+
+	const SlotFrame &slotA = geometryA.getSlot(0);
+	const SlotFrame &slotB = geometryB.getSlot(parentSlot);
+
+	// 1) align the slot axes
+	osg::Vec3 bSlotAxis = b.attitude * slotB.axis;
+	a.attitude.makeRotate(slotA.axis, -bSlotAxis);
+	a.position = osg::Vec3(0, 0, 0);
+
+	// 2) translate the child so the slots touch
+	osg::Vec3 bSlotPos = b.position + b.attitude * slotB.position;
+	osg::Vec3 aSlotPos = a.position + a.attitude * slotA.position;
+	if (geometryA.isCoreComponentModel() && geometryB.isCoreComponentModel()) {
+		aSlotPos += (a.attitude * slotA.axis) *
+				(2 * CoreComponentModel::SLOT_THICKNESS);
+	}
+	a.position += bSlotPos - aSlotPos;
+
+	// 3) rotate about the slot axis to align the slot orientations
+	osg::Vec3 bSlotOrientation = b.attitude * slotB.orientation;
+	osg::Vec3 aSlotOrientation = a.attitude * slotA.orientation;
+	osg::Vec3 aSlotAxis = a.attitude * slotA.axis;
+	double angle;
+	osg::Vec3 rotAxis;
+	osg::Quat alignRot;
+	alignRot.makeRotate(aSlotOrientation, bSlotOrientation);
+	alignRot.getRotate(angle, rotAxis);
+	if (RobogenUtils::areAxisParallel(aSlotAxis, -rotAxis)) {
+		angle *= -1;
+	}
+	osg::Quat slotAlignRotation;
+	slotAlignRotation.makeRotate(angle, aSlotAxis);
+
+	// ...and apply the orientation to the parent slot
+	if (fabs(orientation) > 1e-6) {
+		osg::Quat rotOrientationQuat;
+		rotOrientationQuat.makeRotate(osg::inDegrees(orientation), aSlotAxis);
+		a.attitude *= slotAlignRotation * rotOrientationQuat;
+	} else {
+		a.attitude *= slotAlignRotation;
+	}
+}
+
+void BodyLayout::markChanged(const BodyLayout &reference,
+		std::vector<bool> &changed) const {
+
+	const double epsilon = RobogenUtils::EPSILON_2;
+	changed.assign(placements_.size(), true);
+	for (unsigned int i = 0; i < placements_.size(); ++i) {
+		const PartPlacement &part = placements_[i];
+		int j = reference.find(part.id);
+		if (j < 0) {
+			continue;
+		}
+		const PartPlacement &old = reference.placements_[j];
+		if (part.geometry != old.geometry || part.params != old.params) {
+			continue;
+		}
+		if ((part.parent < 0) != (old.parent < 0) || (part.parent >= 0 &&
+				placements_[part.parent].id !=
+						reference.placements_[old.parent].id)) {
+			continue;
+		}
+		if ((part.position - old.position).length() > epsilon) {
+			continue;
+		}
+		bool sameAttitude = true;
+		for (unsigned int k = 0; k < 4; ++k) {
+			if (fabs(part.attitude[k] - old.attitude[k]) > epsilon) {
+				sameAttitude = false;
+			}
+		}
+		changed[i] = !sameAttitude;
+	}
+}
+
+bool BodyLayout::checkSelfIntersections(
+		std::vector<std::pair<std::string, std::string> > &offending,
+		const BodyLayout *reference) const {
+
+	std::vector<bool> active;
+	if (reference) {
+		this->markChanged(*reference, active);
+	} else {
+		active.assign(placements_.size(), true);
+	}
+
+	// place all primitives in world coordinates
+	std::vector<WorldPrimitive> primitives;
+	for (unsigned int i = 0; i < placements_.size(); ++i) {
+		const PartPlacement &part = placements_[i];
+		const std::vector<GeometricPrimitive> &local =
+				part.geometry->getPrimitives();
+		for (unsigned int j = 0; j < local.size(); ++j) {
+			WorldPrimitive p;
+			p.shape = local[j].shape;
+			p.center = part.position + part.attitude * local[j].position;
+			osg::Quat attitude = local[j].attitude * part.attitude;
+			p.axes[0] = attitude * osg::Vec3(1, 0, 0);
+			p.axes[1] = attitude * osg::Vec3(0, 1, 0);
+			p.axes[2] = attitude * osg::Vec3(0, 0, 1);
+			p.halfExtents = local[j].halfExtents;
+			p.radius = local[j].radius;
+			p.halfLength = local[j].halfLength;
+			p.part = i;
+			computeBounds(p);
+			primitives.push_back(p);
+		}
+	}
+
+	PrimitiveTree tree(primitives);
+	std::set<std::pair<int, int> > offendingParts;
+	std::vector<bool> nearCylinder(primitives.size(), false);
+	std::vector<unsigned int> candidates;
+
+	for (unsigned int i = 0; i < primitives.size(); ++i) {
+		const WorldPrimitive &a = primitives[i];
+		if (!active[a.part]) {
+			continue;
+		}
+		candidates.clear();
+		tree.query(a.min, a.max, candidates);
+		for (unsigned int c = 0; c < candidates.size(); ++c) {
+			unsigned int j = candidates[c];
+			const WorldPrimitive &b = primitives[j];
+			// each pair of active parts only once
+			if (active[b.part] && j <= i) {
+				continue;
+			}
+			if (a.part == b.part || placements_[a.part].parent == b.part ||
+					placements_[b.part].parent == a.part) {
+				continue;
+			}
+			if (a.shape == GeometricPrimitive::CYLINDER &&
+					b.shape == GeometricPrimitive::CYLINDER) {
+				nearCylinder[i] = true;
+				nearCylinder[j] = true;
+			}
+			if (overlap(a, 0, b, 0)) {
+				offendingParts.insert(std::make_pair(std::min(a.part, b.part),
+						std::max(a.part, b.part)));
+			}
+		}
+	}
+
+	// as the ODE verifier: if wheels come close to each other, check again
+	// with those wheels grown by the required separation
+	if (offendingParts.empty()) {
+		osg::Vec3 margin(2 * WHEEL_SEPARATION, 2 * WHEEL_SEPARATION,
+				2 * WHEEL_SEPARATION);
+		for (unsigned int i = 0; i < primitives.size(); ++i) {
+			if (!nearCylinder[i]) {
+				continue;
+			}
+			const WorldPrimitive &a = primitives[i];
+			candidates.clear();
+			tree.query(a.min - margin, a.max + margin, candidates);
+			for (unsigned int c = 0; c < candidates.size(); ++c) {
+				unsigned int j = candidates[c];
+				const WorldPrimitive &b = primitives[j];
+				if (nearCylinder[j] && j <= i) {
+					continue;
+				}
+				if (a.part == b.part || placements_[a.part].parent == b.part ||
+						placements_[b.part].parent == a.part) {
+					continue;
+				}
+				if (overlap(a, WHEEL_SEPARATION, b,
+						nearCylinder[j] ? WHEEL_SEPARATION : 0)) {
+					offendingParts.insert(std::make_pair(
+							std::min(a.part, b.part),
+							std::max(a.part, b.part)));
+				}
+			}
+		}
+	}
+
+	for (std::set<std::pair<int, int> >::iterator it = offendingParts.begin();
+			it != offendingParts.end(); ++it) {
+		offending.push_back(std::make_pair(placements_[it->first].id,
+				placements_[it->second].id));
+	}
+	return offendingParts.empty();
+}
+
+} /* namespace robogen */
@@ -0,0 +1,254 @@
+/*
+ * @(#) BodyLayout.h   1.0   Oct 19, 2026
+ *
+ * The ROBOGEN Framework
+ * Copyright © 2013-2016
+ *
+ * Laboratory of Intelligent Systems, EPFL
+ *
+ * This file is part of the ROBOGEN Framework.
+ *
+ * The ROBOGEN Framework is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License (GPL)
+ * as published by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @(#) $Id$
+ */
+
+#ifndef BODYLAYOUT_H_
+#define BODYLAYOUT_H_
+
+#include <map>
+#include <string>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include <osg/Vec3>
+#include <osg/Quat>
+
+#include "evolution/representation/RobotRepresentation.h"
+
+namespace robogen {
+
+/**
+ * Collision primitive of a body part. Expressed in the frame of the part's
+ * root body when stored in a PartGeometry, in world coordinates once placed.
+ */
+struct GeometricPrimitive {
+
+	enum Shape {
+		BOX, CYLINDER
+	};
+
+	Shape shape;
+
+	osg::Vec3 position;
+
+	osg::Quat attitude;
+
+	/**
+	 * Half side lengths along the local axes (boxes only)
+	 */
+	osg::Vec3 halfExtents;
+
+	/**
+	 * Radius and half length along the local z axis (cylinders only),
+	 * following the ODE convention.
+	 */
+	float radius;
+	float halfLength;
+
+};
+
+/**
+ * Slot of a body part, with the same semantics as Model::getSlotPosition(),
+ * Model::getSlotAxis() and Model::getSlotOrientation().
+ */
+struct SlotFrame {
+	osg::Vec3 position;
+	osg::Vec3 axis;
+	osg::Vec3 orientation;
+};
+
+/**
+ * Rest geometry of a body part, i.e. what the corresponding Model builds in
+ * initModel() with all joints at zero, without needing an ODE world.
+ * Instances are cached per (type, parameters) and shared read-only.
+ */
+class PartGeometry {
+
+public:
+
+	/**
+	 * @param type part type, one of the PART_TYPE_* strings
+	 * @param params part parameters normalized to [0,1], as stored in
+	 * PartRepresentation
+	 * @return the cached geometry, or an empty pointer if the type is not
+	 * supported
+	 */
+	static boost::shared_ptr<const PartGeometry> get(const std::string &type,
+			const std::vector<double> &params);
+
+	/**
+	 * @return true if the geometry of the given part type is known
+	 */
+	static bool isSupported(const std::string &type);
+
+	inline const std::string &getType() const {
+		return type_;
+	}
+
+	inline const std::vector<GeometricPrimitive> &getPrimitives() const {
+		return primitives_;
+	}
+
+	/**
+	 * @return the requested slot. Parts whose models ignore the slot index
+	 * (e.g. wheels) return their only slot.
+	 */
+	const SlotFrame &getSlot(unsigned int i) const;
+
+	/**
+	 * @return true if the part is modelled by a CoreComponentModel
+	 * (core component or fixed brick)
+	 */
+	bool isCoreComponentModel() const;
+
+	/**
+	 * @return true if the part is the core component
+	 */
+	bool isCore() const;
+
+	/**
+	 * @return true if the part is a parametric brick
+	 */
+	bool isParametricBrick() const;
+
+private:
+
+	PartGeometry(const std::string &type);
+
+	bool build(const std::vector<double> &paramValues);
+
+	void addBox(const osg::Vec3 &pos, float lengthX, float lengthY,
+			float lengthZ, const osg::Quat &attitude = osg::Quat());
+
+	void addCylinder(const osg::Vec3 &pos, int direction, float radius,
+			float height);
+
+	void addSlot(const osg::Vec3 &position, const osg::Vec3 &axis,
+			const osg::Vec3 &orientation);
+
+	std::string type_;
+
+	std::vector<GeometricPrimitive> primitives_;
+
+	std::vector<SlotFrame> slots_;
+
+};
+
+/**
+ * World placement of a single body part
+ */
+struct PartPlacement {
+
+	std::string id;
+
+	/**
+	 * Index of the parent placement, -1 for the root
+	 */
+	int parent;
+
+	boost::shared_ptr<const PartGeometry> geometry;
+
+	/**
+	 * Pose of the root body of the part
+	 */
+	osg::Vec3 position;
+	osg::Quat attitude;
+
+	/**
+	 * Orientation bookkeeping mirroring Model, needed to enforce planarity
+	 */
+	int orientationToParentSlot;
+	int orientationToRoot;
+
+	/**
+	 * Parameters the geometry was built from, used to detect changes
+	 */
+	std::vector<double> params;
+
+};
+
+/**
+ * Computes analytically where every part of a robot body ends up when the
+ * robot is assembled, using the same slot geometry as RobogenUtils::connect,
+ * and checks the assembled body for self intersections with OBB/cylinder
+ * overlap tests accelerated by a bounding volume hierarchy.
+ */
+class BodyLayout {
+
+public:
+
+	BodyLayout();
+
+	virtual ~BodyLayout();
+
+	/**
+	 * Lays out the body of the given robot
+	 * @return false if the body contains a part whose geometry is unknown
+	 */
+	bool init(const RobotRepresentation &robot);
+
+	inline const std::vector<PartPlacement> &getPlacements() const {
+		return placements_;
+	}
+
+	/**
+	 * @return index of the placement of the given part, -1 if not found
+	 */
+	int find(const std::string &id) const;
+
+	/**
+	 * Finds pairs of intersecting parts. As in the ODE based verification,
+	 * parts are never considered to intersect with their parent or children.
+	 * @param offending filled with the ids of the intersecting parts
+	 * @param reference optional layout of a body known to be valid from which
+	 * this one was derived. If given, only parts that were added or moved with
+	 * respect to it are checked against the rest of the body.
+	 * @return true if no intersections were found
+	 */
+	bool checkSelfIntersections(
+			std::vector<std::pair<std::string, std::string> > &offending,
+			const BodyLayout *reference = NULL) const;
+
+	/**
+	 * Minimum separation enforced between wheels. Matches the legacy
+	 * WHEEL_SEPARATION of the ODE based verifier.
+	 */
+	static const float WHEEL_SEPARATION;
+
+private:
+
+	void place(unsigned int child, unsigned int parentSlot);
+
+	void markChanged(const BodyLayout &reference,
+			std::vector<bool> &changed) const;
+
+	std::vector<PartPlacement> placements_;
+
+	std::map<std::string, int> index_;
+
+};
+
+} /* namespace robogen */
+
+#endif /* BODYLAYOUT_H_ */
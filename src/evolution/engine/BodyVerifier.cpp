@@ -6,6 +6,9 @@
  */
 
 #include "evolution/engine/BodyVerifier.h"
+#include "evolution/engine/BodyLayout.h"
+#include "arduino/ArduinoNNConfiguration.h"
+#include "PartList.h"
 #include "Robot.h"
 #include "utils/RobogenUtils.h"
 #include "model/Model.h"
@@ -17,6 +20,8 @@ namespace robogen {
 
 //std::vector<dGeomID> BodyVerifier::cylinders;
 
+boost::mutex BodyVerifier::odeMutex;
+
 BodyVerifier::BodyVerifier() {
 
 }
@@ -58,10 +63,156 @@ void BodyVerifier::collisionCallback(void *data, dGeomID o1, dGeomID o2) {
 	}
 }
 
-bool BodyVerifier::verify(const RobotRepresentation &robotRep, int &errorCode,
+bool BodyVerifier::verify(const RobotRepresentation &robot, int &errorCode,
+		std::vector<std::pair<std::string, std::string> > &affectedBodyParts,
+		bool printErrors, int mode, const BodyLayout *reference,
+		BodyLayout *layout) {
+
+	if (mode == GEOMETRIC_VERIFICATION) {
+		return verifyGeometric(robot, errorCode, affectedBodyParts,
+				printErrors, reference, layout);
+	} else if (mode == CROSS_CHECK_VERIFICATION) {
+		int geometricErrorCode;
+		std::vector<std::pair<std::string, std::string> > geometricParts;
+		bool geometricResult = verifyGeometric(robot, geometricErrorCode,
+				geometricParts, false, reference, layout);
+		bool odeResult = verifyOde(robot, errorCode, affectedBodyParts,
+				printErrors);
+		if (geometricResult != odeResult) {
+			std::cerr << "Body verifiers disagree: ODE says "
+					<< (odeResult ? "valid" : "invalid")
+					<< ", geometric says "
+					<< (geometricResult ? "valid" : "invalid") << std::endl;
+		} else if (!odeResult && geometricErrorCode != errorCode) {
+			std::cerr << "Body verifiers disagree: ODE gives error code "
+					<< errorCode << ", geometric gives "
+					<< geometricErrorCode << std::endl;
+		}
+		return odeResult;
+	}
+	if (layout != NULL) {
+		*layout = BodyLayout();
+	}
+	return verifyOde(robot, errorCode, affectedBodyParts, printErrors);
+}
+
+bool BodyVerifier::checkArduinoConstraints(const RobotRepresentation &robot,
+		bool printErrors, bool checkPwmPins) {
+
+	int numDigitalPins = 0, numAnalogPins = 0, numPwmPins = 0;
+	const RobotRepresentation::IdPartMap &body = robot.getBody();
+	for (RobotRepresentation::IdPartMap::const_iterator it = body.begin();
+			it != body.end(); ++it) {
+		const std::string &type = it->second.lock()->getType();
+		if (type == PART_TYPE_LIGHT_SENSOR) {
+			numAnalogPins++;
+#ifdef IR_SENSORS_ENABLED
+		} else if (type == PART_TYPE_IR_SENSOR) {
+			numAnalogPins++;
+#endif
+#ifdef TOUCH_SENSORS_ENABLED
+		} else if (type == PART_TYPE_TOUCH_SENSOR) {
+			// one touch sensor per side
+			numDigitalPins += 2;
+#endif
+		} else if (type == PART_TYPE_ACTIVE_HINGE) {
+			// servo motor
+			numDigitalPins++;
+#ifdef ALLOW_ROTATIONAL_COMPONENTS
+		} else if (type == PART_TYPE_ROTATOR ||
+				type == PART_TYPE_ACTIVE_WHEEL ||
+				type == PART_TYPE_ACTIVE_WHEG) {
+			// rotation motor
+			numDigitalPins++;
+			numPwmPins++;
+#endif
+		}
+	}
+
+	if (numAnalogPins > MAX_ANALOG_PINS) {
+		if (printErrors) {
+			std::cerr << "The number of analog pins required ("
+				<< numAnalogPins
+				<< ") is greater than the maximum allowed one ("
+				<< MAX_ANALOG_PINS << ")" << std::endl;
+		}
+		return false;
+	}
+	if (numDigitalPins > MAX_DIGITAL_PINS + (MAX_ANALOG_PINS - numAnalogPins)) {
+		if (printErrors) {
+			std::cerr << "The number of digital pins required ("
+				<< numDigitalPins
+				<< ") is greater than the number available ("
+				<< MAX_DIGITAL_PINS + (MAX_ANALOG_PINS - numAnalogPins)
+				<< ")" << std::endl;
+		}
+		return false;
+	}
+	if (checkPwmPins && (numPwmPins + 1) > MAX_PWM_PINS) {
+		// need 1 for the neutral signal
+		if (printErrors) {
+			std::cerr << "The number of PWM pins required ("
+					<< (numPwmPins + 1)
+					<< ") is greater than the number available ("
+					<< MAX_PWM_PINS
+					<< ")" << std::endl;
+		}
+		return false;
+	}
+	return true;
+}
+
+bool BodyVerifier::verifyGeometric(const RobotRepresentation &robot,
+		int &errorCode,
+		std::vector<std::pair<std::string, std::string> > &affectedBodyParts,
+		bool printErrors, const BodyLayout *reference,
+		BodyLayout *robotLayout) {
+
+	BodyLayout localLayout;
+	BodyLayout &layout = robotLayout != NULL ? *robotLayout : localLayout;
+	if (!layout.init(robot)) {
+		// parts without a known geometry: let ODE build them
+		layout = BodyLayout();
+		return verifyOde(robot, errorCode, affectedBodyParts, printErrors);
+	}
+
+	if (!isCore(layout.getPlacements()[0].geometry->getType())) {
+		if (printErrors) {
+			std::cout << "Robot has no core component!" << std::endl;
+		}
+		errorCode = MISSING_CORE_COMPONENT;
+		return false;
+	}
+
+	if (!checkArduinoConstraints(robot, printErrors, printErrors)) {
+		errorCode = ARDUINO_CONSTRAINTS_EXCESS;
+		return false;
+	}
+
+	bool incremental = reference != NULL &&
+			!reference->getPlacements().empty();
+	if (!layout.checkSelfIntersections(affectedBodyParts,
+			incremental ? reference : NULL)) {
+		if (printErrors) {
+			for (unsigned int i = 0; i < affectedBodyParts.size(); ++i) {
+				std::cout << affectedBodyParts[i].first << " is colliding with "
+						<< affectedBodyParts[i].second << std::endl;
+			}
+			std::cout << "self intersection!" << std::endl;
+		}
+		errorCode = SELF_INTERSECTION;
+		return false;
+	}
+	return true;
+}
+
+bool BodyVerifier::verifyOde(const RobotRepresentation &robotRep,
+		int &errorCode,
 		std::vector<std::pair<std::string, std::string> > &affectedBodyParts,
 		bool printErrors) {
 
+	boost::mutex::scoped_lock lock(odeMutex);
+
 	bool success = true;
 	errorCode = INTERNAL_ERROR;
 
@@ -91,6 +242,9 @@ bool BodyVerifier::verify(const RobotRepresentation &robotRep, int &errorCode,
 			std::cout << "Problem when initializing robot in body verifier!"
 					<< std::endl;
 		}
+		if (!checkArduinoConstraints(robotRep, false, printErrors)) {
+			errorCode = ARDUINO_CONSTRAINTS_EXCESS;
+		}
 		success = false;
 	}
 	boost::shared_ptr<CollisionData> collisionData(new CollisionData());
@@ -185,7 +339,7 @@ bool BodyVerifier::verify(const RobotRepresentation &robotRep, int &errorCode,
 				dGeomCylinderGetParams(collisionData->cylinders[i],
 						&radius, &length);
 				dGeomCylinderSetParams(collisionData->cylinders[i],
-						radius + WHEEL_SEPARATION, length);
+						radius + BodyLayout::WHEEL_SEPARATION, length);
 			}
 			dSpaceCollide(odeSpace, (void *) collisionData.get(), collisionCallback);
 			if ( collisionData->offendingBodies.size() ) {
@@ -227,13 +381,13 @@ bool BodyVerifier::verify(const RobotRepresentation &robotRep, int &errorCode,
 	return success;
 }
 
-bool BodyVerifier::fixRobotBody(RobotRepresentation &robot) {
+bool BodyVerifier::fixRobotBody(RobotRepresentation &robot, int mode) {
 	bool changed = false;
 	while (true) {
 		// check velidity of body
 		int errorCode;
 		std::vector<std::pair<std::string, std::string> > offenders;
-		if (!BodyVerifier::verify(robot, errorCode, offenders)) {
+		if (!BodyVerifier::verify(robot, errorCode, offenders, true, mode)) {
 			// TODO treat other cases: Arduino constraints, missing core
 			if (errorCode == BodyVerifier::SELF_INTERSECTION) {
 				std::cerr << "Robot body has following intersection pairs:"
@@ -276,6 +430,10 @@ bool BodyVerifier::fixRobotBody(RobotRepresentation &robot) {
 						<< std::endl;
 				return false;
 			}
+			if (errorCode != BodyVerifier::SELF_INTERSECTION) {
+				// trimming intersections won't help, don't loop forever
+				return false;
+			}
 		} else {
 			break;
 		}
@@ -9,6 +9,7 @@
 #define BODYVERIFIER_H_
 
 #include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
 
 #include "Robogen.h"
 #include "config/ConfigurationReader.h"
@@ -39,10 +40,10 @@
 
 // includes pasted from FileViewer.cpp for the sake of please just work
 
-#define WHEEL_SEPARATION 0.005
-
 namespace robogen {
 
+class BodyLayout;
+
 /**
  * The body verifier class takes care of the verification of a given body
  * design in the evolver. It borrows from simulator code to build a robot
@@ -61,6 +62,25 @@ public:
 		SELF_INTERSECTION
 	};
 
+	/**
+	 * verification back ends
+	 */
+	enum verificationModes{
+		/**
+		 * Analytic layout of the body and OBB/cylinder overlap tests,
+		 * does not need ODE
+		 */
+		GEOMETRIC_VERIFICATION,
+		/**
+		 * Builds the robot in an ODE world and runs its collision detection
+		 */
+		ODE_VERIFICATION,
+		/**
+		 * Runs both and reports disagreements, returns the ODE result
+		 */
+		CROSS_CHECK_VERIFICATION
+	};
+
 	/**
 	 * ODE collision callback which identifies intersecting body parts
 	 */
@@ -72,11 +92,20 @@ public:
 	 * @param errorCode if error, corresponding errorCode from errorCodes
 	 * @param affectedBodyParts if error, identifiers of affected body parts
 	 * @param print errors, if true print out errors to screen
+	 * @param mode one of verificationModes
+	 * @param reference optional layout of a robot known to be valid from
+	 * which robot was derived (e.g. before mutation). The geometric
+	 * verification then only checks added or moved parts for intersections.
+	 * An empty layout is ignored.
+	 * @param layout optional, receives the layout of robot, to be passed as
+	 * reference when verifying bodies derived from it. Left empty if robot
+	 * was not laid out (ODE verification or parts of unknown geometry).
 	 * @return true if robot valid, false otherwise
 	 */
 	static bool verify(const RobotRepresentation &robot, int &errorCode,
 			std::vector<std::pair<std::string,std::string> >&affectedBodyParts,
-			bool printErrors=true);
+			bool printErrors=true, int mode=ODE_VERIFICATION,
+			const BodyLayout *reference=NULL, BodyLayout *layout=NULL);
 
 	/**
 	 * Suggested routine for handling a robot body with potential
@@ -86,8 +115,19 @@ public:
 	 * the problem where one part is in the subtree of the other per definition.
 	 * Other routines can be implemented using verify().
 	 * @param robot robot to be treated
+	 * @param mode one of verificationModes
+	 * @return true if the body was changed, false if it was valid or could
+	 * not be fixed
+	 */
+	static bool fixRobotBody(RobotRepresentation &robot,
+			int mode=ODE_VERIFICATION);
+
+	/**
+	 * ODE initialization and teardown are global, so the evolver threads
+	 * building robots in throwaway ODE worlds (ODE verification, substrate
+	 * coordinates) hold this while they use ODE
 	 */
-	static bool fixRobotBody(RobotRepresentation &robot);
+	static boost::mutex odeMutex;
 
 private:
 	/**
@@ -97,6 +137,24 @@ private:
 
 	virtual ~BodyVerifier();
 
+	static bool verifyOde(const RobotRepresentation &robot, int &errorCode,
+			std::vector<std::pair<std::string,std::string> >&affectedBodyParts,
+			bool printErrors);
+
+	static bool verifyGeometric(const RobotRepresentation &robot,
+			int &errorCode,
+			std::vector<std::pair<std::string,std::string> >&affectedBodyParts,
+			bool printErrors, const BodyLayout *reference,
+			BodyLayout *robotLayout);
+
+	/**
+	 * Counts the arduino pins required by the body, as Robot::decodeBody
+	 * @param checkPwmPins decodeBody only rejects too many PWM pins when it
+	 * prints errors, pass its printInitErrors to give the same verdict
+	 */
+	static bool checkArduinoConstraints(const RobotRepresentation &robot,
+			bool printErrors, bool checkPwmPins);
+
 	struct CollisionData {
 		std::vector<std::pair<dBodyID, dBodyID> > offendingBodies;
 		std::vector<dGeomID> cylinders;
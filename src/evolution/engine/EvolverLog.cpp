@@ -26,6 +26,8 @@
  * @(#) $Id$
  */
 #include <iostream>
+#include <sstream>
+#include <vector>
 #define BOOST_NO_CXX11_SCOPED_ENUMS
 #include <boost/filesystem.hpp>
 #undef BOOST_NO_CXX11_SCOPED_ENUMS
@@ -41,6 +43,7 @@ namespace robogen {
 
 #define BAS_LOG_FILE "BestAvgStd.txt"
 #define GENERATION_BEST_PREFIX "GenerationBest-"
+#define CHECKPOINT_FILE "checkpoint.dat"
 
 EvolverLog::EvolverLog(){
 }
@@ -117,12 +120,102 @@ bool EvolverLog::init(boost::shared_ptr<EvolverConfiguration> conf,
 	// copy scenario file if using scripted scenario
 	copyConfFile(robotConf->getScenarioFile());
 
+	if (saveAll_ && !archive_.open(logPath_)) {
+		return false;
+	}
+
+	return true;
+}
+
+bool EvolverLog::resume(const std::string& logDirectory,
+		unsigned int generation, bool saveAll) {
 
+	saveAll_ = saveAll;
+	logPath_ = logDirectory;
 
+	// keep the lines before the checkpoint, whose generation is logged again
+	std::string basLogPath = logPath_ + "/" + BAS_LOG_FILE;
+	std::vector<std::string> lines;
+	{
+		std::ifstream basLog(basLogPath.c_str());
+		std::string line;
+		while (std::getline(basLog, line)) {
+			std::istringstream lineStream(line);
+			unsigned int lineGeneration;
+			if ((lineStream >> lineGeneration) &&
+					lineGeneration < generation) {
+				lines.push_back(line);
+			}
+		}
+	}
+
+	bestAvgStd_.open(basLogPath.c_str());
+	if (!bestAvgStd_.is_open()){
+		std::cout << "Can't open Best/Average/STD log file" << std::endl;
+		return false;
+	}
+	for (unsigned int i = 0; i < lines.size(); i++) {
+		bestAvgStd_ << lines[i] << std::endl;
+	}
+
+	if (saveAll_ && !archive_.open(logPath_, generation)) {
+		return false;
+	}
 
 	return true;
 }
 
+bool EvolverLog::saveCheckpoint(
+		const robogenMessage::EvolverCheckpoint &checkpoint) {
+
+	// the archive must hold the generations before the checkpoint
+	if (saveAll_ && !archive_.flush()) {
+		return false;
+	}
+
+	std::string checkpointPath = logPath_ + "/" + CHECKPOINT_FILE;
+	std::string tempPath = checkpointPath + ".tmp";
+	{
+		std::ofstream checkpointFile(tempPath.c_str(),
+				std::ios::out | std::ios::trunc | std::ios::binary);
+		if (!checkpointFile.is_open() ||
+				!checkpoint.SerializeToOstream(&checkpointFile)) {
+			std::cout << "Can't write checkpoint file " << tempPath
+					<< std::endl;
+			return false;
+		}
+	}
+
+	// an interruption while writing leaves the previous checkpoint intact
+	boost::system::error_code errorCode;
+	boost::filesystem::rename(tempPath, checkpointPath, errorCode);
+	if (errorCode) {
+		std::cout << "Can't replace checkpoint file " << checkpointPath
+				<< ": " << errorCode.message() << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool EvolverLog::loadCheckpoint(const std::string& logDirectory,
+		robogenMessage::EvolverCheckpoint &checkpoint) {
+
+	std::string checkpointPath = logDirectory + "/" + CHECKPOINT_FILE;
+	std::ifstream checkpointFile(checkpointPath.c_str(),
+			std::ios::in | std::ios::binary);
+	if (!checkpointFile.is_open()) {
+		std::cout << "Can't open checkpoint file " << checkpointPath
+				<< std::endl;
+		return false;
+	}
+	if (!checkpoint.ParseFromIstream(&checkpointFile)) {
+		std::cout << "Can't read checkpoint file " << checkpointPath
+				<< std::endl;
+		return false;
+	}
+	return true;
+}
+
 EvolverLog::~EvolverLog() {
 }
 
@@ -172,13 +265,10 @@ bool EvolverLog::logGeneration(int generation, Population &population) {
 	}
 
 
-	if(saveAll_) {
-		for(unsigned int i = 0; i<population.size(); ++i) {
-			std::stringstream ss;
-			ss << logPath_ + "/Generation-" << generation << "-Guy-" << (i+1)
-					<< ".json";
-			saveRobotJson(population[i], ss.str());
-		}
+	if(saveAll_ && !archive_.append(generation, population)) {
+		std::cout << "Can't save all individuals of generation "
+				<< generation << std::endl;
+		return false;
 	}
 
 
@@ -31,6 +31,7 @@
 
 #include <fstream>
 #include "evolution/engine/Population.h"
+#include "evolution/engine/RobotArchive.h"
 #include "config/EvolverConfiguration.h"
 #include "config/RobogenConfig.h"
 
@@ -52,8 +53,8 @@ public:
 	 * @param logDirectory name of directory to write logs to
 	 * @param overwrite set true to overwrite output directory instead of
 	 * 			creating new one with incrementing suffix
-	 * @param saveAll set true to save all individuals instead of just the
-	 * 			best of each generation
+	 * @param saveAll set true to also save all individuals, to the robot
+	 * 			archive, instead of just the best of each generation
 	 * @return true if successful
 	 */
 	bool init(boost::shared_ptr<EvolverConfiguration> conf,
@@ -61,11 +62,44 @@ public:
 			const std::string& logDirectory, bool overwrite = false,
 			bool saveAll = false);
 
+	/**
+	 * Resumes logging into the directory of an interrupted evolution. The
+	 * lines of BestAvgStd.txt from the generation of the checkpoint the
+	 * evolution resumes from on are dropped, as that generation is logged
+	 * again, and so are its records in the robot archive. The configuration
+	 * files are not copied again.
+	 * @param logDirectory directory the interrupted evolution logged to
+	 * @param generation generation of the checkpoint
+	 * @param saveAll set true to also save all individuals, to the robot
+	 * 			archive, instead of just the best of each generation
+	 * @return true if successful
+	 */
+	bool resume(const std::string& logDirectory, unsigned int generation,
+			bool saveAll = false);
+
+	/**
+	 * Saves a checkpoint to checkpoint.dat in the log directory, replacing
+	 * the previous one only once it is completely written. Waits until the
+	 * robot archive is written up to the checkpoint.
+	 * @return true if successful
+	 */
+	bool saveCheckpoint(const robogenMessage::EvolverCheckpoint &checkpoint);
+
+	/**
+	 * Reads the checkpoint saved in a log directory.
+	 * @param logDirectory log directory of the evolution to resume
+	 * @param checkpoint message to fill
+	 * @return true if successful
+	 */
+	static bool loadCheckpoint(const std::string& logDirectory,
+			robogenMessage::EvolverCheckpoint &checkpoint);
+
 	virtual ~EvolverLog();
 
 	/**
 	 * Logs an evaluated population, writing into BestAvgStd.txt and writing
-	 * the best individual to file.
+	 * the best individual to file. With saveAll, the whole population is
+	 * queued for the robot archive.
 	 * @param generation number of current generation
 	 * @param population Population to be checkpointed. Non-const on purpose,
 	 * as population->best() calls population->sort()
@@ -86,6 +120,10 @@ private:
 	 * the best of each generation).
 	 */
 	bool saveAll_;
+	/**
+	 * Archive of all individuals, when saving all of them
+	 */
+	RobotArchive archive_;
 
 	/**
 	 * Helper utility to back up the various configuration files
@@ -47,17 +47,24 @@ IndividualContainer::~IndividualContainer() {
 	// TODO Auto-generated destructor stub
 }
 
+/**
+ * Individuals to be evaluated, with their index in the container
+ */
+typedef std::queue<std::pair<unsigned int,
+		boost::shared_ptr<RobotRepresentation> > > IndividualQueue;
+
 /**
  * Thread function assigned to a socket
  * @param indiQueue queue of Individuals to be evaluated
  * @param queueMutex mutex for access to queue
  * @param socket socket to simulator
  * @param confFile simulator configuration file to be used for evaluations
+ * @param generation sent with the index of the individual, if not 0
  */
 void evaluationThread(
-		std::queue<boost::shared_ptr<RobotRepresentation> >& indiQueue,
+		IndividualQueue& indiQueue,
 		boost::mutex& queueMutex, Socket& socket,
-		boost::shared_ptr<RobogenConfig> robotConf) {
+		boost::shared_ptr<RobogenConfig> robotConf, unsigned int generation) {
 
 	while (true) {
 
@@ -66,26 +73,27 @@ void evaluationThread(
 			return;
 		}
 
-		boost::shared_ptr<RobotRepresentation> current = indiQueue.front();
+		IndividualQueue::value_type current = indiQueue.front();
 		indiQueue.pop();
 		std::cout << "." << std::flush;
 		lock.unlock();
 
-		current->evaluate(&socket, robotConf);
+		current.second->evaluate(&socket, robotConf, generation,
+				current.first);
 
 	}
 
 }
 
 void IndividualContainer::evaluate(boost::shared_ptr<RobogenConfig> robotConf,
-		std::vector<Socket*> &sockets) {
+		std::vector<Socket*> &sockets, unsigned int generation) {
 
 	// 1. Create mutexed queue of Individual pointers
-	std::queue<boost::shared_ptr<RobotRepresentation> > indiQueue;
+	IndividualQueue indiQueue;
 	boost::mutex queueMutex;
 	for (unsigned int i = 0; i < this->size(); i++) {
 		if (!this->at(i)->isEvaluated()) {
-			indiQueue.push(this->at(i));
+			indiQueue.push(std::make_pair(i, this->at(i)));
 		}
 	}
 	std::cout << indiQueue.size() << " individuals queued for evaluation."
@@ -98,9 +106,11 @@ void IndividualContainer::evaluate(boost::shared_ptr<RobogenConfig> robotConf,
 	while (!indiQueue.empty()){
 		++sent;
 		FakeJSSocket socket;
-		boost::shared_ptr<RobotRepresentation> currentRobot = indiQueue.front();
+		boost::shared_ptr<RobotRepresentation> currentRobot =
+				indiQueue.front().second;
+		currentRobot->evaluate(&socket, robotConf, generation,
+				indiQueue.front().first);
 		indiQueue.pop();
-		currentRobot->evaluate(&socket, robotConf);
 		int ptrToIndividual = (int) currentRobot.get();
 		if (!firstIndividual) {
 			message += ",";
@@ -135,7 +145,7 @@ void IndividualContainer::evaluate(boost::shared_ptr<RobogenConfig> robotConf,
 	for (unsigned int i = 0; i < sockets.size(); i++) {
 		evaluators.add_thread(
 				new boost::thread(evaluationThread, boost::ref(indiQueue), boost::ref(queueMutex),
-						boost::ref(*sockets[i]), robotConf));
+						boost::ref(*sockets[i]), robotConf, generation));
 	}
 
 	// 4. Join threads. Individuals are now evaluated.
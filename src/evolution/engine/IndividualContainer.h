@@ -50,8 +50,11 @@ public:
 	 * order the population by fitness.
 	 * @param robotConfig the robot configuration
 	 * @param sockets a vector of Socket pointers. On each should be a simulator
+	 * @param generation if not 0, sent to the simulators with the index of
+	 * each individual in this container to identify the evaluations
 	 */
-	void evaluate(boost::shared_ptr<RobogenConfig> robotConfig, std::vector<Socket*> &sockets);
+	void evaluate(boost::shared_ptr<RobogenConfig> robotConfig, std::vector<Socket*> &sockets,
+			unsigned int generation = 0);
 
 	/**
 	 * Sorts individuals from best to worst.
@@ -74,8 +77,6 @@ protected:
 
 	bool evaluated_;
 
-private:
-
 	bool sorted_;
 
 };
@@ -28,9 +28,13 @@
  * @(#) $Id$
  */
 
+#include <boost/bind.hpp>
 #include <boost/random/uniform_int_distribution.hpp>
 #include <boost/random/uniform_01.hpp>
 #include "evolution/engine/Mutator.h"
+#include "evolution/engine/BodyLayout.h"
+#include "utils/ParallelFor.h"
+#include "utils/RandomStreams.h"
 #include "PartList.h"
 
 //#define DEBUG_MUTATE
@@ -85,9 +89,63 @@ Mutator::Mutator(boost::shared_ptr<EvolverConfiguration> conf,
 	}
 }
 
+Mutator::Mutator(const Mutator &other, boost::random::mt19937 &rng) :
+		conf_(other.conf_), rng_(rng), brainMutate_(other.brainMutate_),
+		normalDistribution_(other.normalDistribution_),
+		weightCrossover_(other.weightCrossover_),
+		subtreeRemovalDist_(other.subtreeRemovalDist_),
+		subtreeDuplicationDist_(other.subtreeDuplicationDist_),
+		subtreeSwapDist_(other.subtreeSwapDist_),
+		nodeInsertDist_(other.nodeInsertDist_),
+		nodeRemovalDist_(other.nodeRemovalDist_),
+		paramMutateDist_(other.paramMutateDist_),
+		oscillatorNeuronDist_(other.oscillatorNeuronDist_),
+		addHiddenNeuronDist_(other.addHiddenNeuronDist_) {
+}
+
 Mutator::~Mutator() {
 }
 
+unsigned int Mutator::getOffspringPerPair() const {
+	// see createOffspring()
+	return (conf_->evolutionMode == EvolverConfiguration::BRAIN_EVOLVER) ?
+			2 : 1;
+}
+
+void Mutator::createOffspringTask(
+		const std::vector<std::pair<boost::shared_ptr<RobotRepresentation>,
+			boost::shared_ptr<RobotRepresentation> > > &parents,
+		std::vector<std::vector<boost::shared_ptr<RobotRepresentation> > >
+			&offspring, unsigned int seed, unsigned int generation,
+		unsigned int i) const {
+
+	boost::random::mt19937 rng;
+	seedStream(rng, seed, generation, i);
+	Mutator mutator(*this, rng);
+	offspring[i] = mutator.createOffspring(parents[i].first,
+			parents[i].second);
+}
+
+std::vector<boost::shared_ptr<RobotRepresentation> > Mutator::createOffspring(
+		const std::vector<std::pair<boost::shared_ptr<RobotRepresentation>,
+			boost::shared_ptr<RobotRepresentation> > > &parents,
+		unsigned int seed, unsigned int generation) {
+
+	std::vector<std::vector<boost::shared_ptr<RobotRepresentation> > >
+		offspringPerPair(parents.size());
+	parallelFor(parents.size(), conf_->evolverThreads,
+			boost::bind(&Mutator::createOffspringTask, this,
+					boost::cref(parents), boost::ref(offspringPerPair),
+					seed, generation, _1));
+
+	std::vector<boost::shared_ptr<RobotRepresentation> > offspring;
+	for (unsigned int i = 0; i < offspringPerPair.size(); ++i) {
+		offspring.insert(offspring.end(), offspringPerPair[i].begin(),
+				offspringPerPair[i].end());
+	}
+	return offspring;
+}
+
 std::vector<boost::shared_ptr<RobotRepresentation> > Mutator::createOffspring(
 			boost::shared_ptr<RobotRepresentation> parent1,
 			boost::shared_ptr<RobotRepresentation> parent2) {
@@ -120,6 +178,10 @@ void Mutator::growBodyRandomly(boost::shared_ptr<RobotRepresentation>& robot) {
 			conf_->maxNumInitialParts);
 	unsigned int numPartsToAdd = dist(rng_);
 
+	// once a body has passed verification here, later checks only need to
+	// look at the parts that changed, its layout is kept for them
+	BodyLayout robotLayout;
+
 	for (unsigned int i = 0; i < numPartsToAdd; i++) {
 		bool success = false;
 
@@ -132,11 +194,15 @@ void Mutator::growBodyRandomly(boost::shared_ptr<RobotRepresentation>& robot) {
 			int errorCode;
 
 			std::vector<std::pair<std::string, std::string> > affectedBodyParts;
+			BodyLayout newLayout;
 			if (success
 					&& BodyVerifier::verify(*newBot.get(), errorCode,
-							affectedBodyParts, PRINT_ERRORS)) {
+							affectedBodyParts, PRINT_ERRORS,
+							conf_->bodyVerificationMode, &robotLayout,
+							&newLayout)) {
 				robot = newBot;
 				robot->setDirty();
+				robotLayout = newLayout;
 				break;
 			}
 		}
@@ -380,6 +446,8 @@ bool Mutator::mutateBody(boost::shared_ptr<RobotRepresentation>& robot) {
 	std::cout << "mutating body" << std::endl;
 #endif
 	bool mutated = false;
+	// layout of the last verified body, empty until a mutation passed
+	BodyLayout robotLayout;
 	MutOpPair mutOpPairs[] = { std::make_pair(&Mutator::removeSubtree,
 			subtreeRemovalDist_), std::make_pair(&Mutator::duplicateSubtree,
 			subtreeDuplicationDist_), std::make_pair(&Mutator::swapSubtrees,
@@ -420,9 +488,12 @@ bool Mutator::mutateBody(boost::shared_ptr<RobotRepresentation>& robot) {
 
 				int errorCode;
 				std::vector<std::pair<std::string, std::string> > affectedBodyParts;
+				BodyLayout newLayout;
 				if (mutationSuccess
 						&& BodyVerifier::verify(*newBot.get(), errorCode,
-								affectedBodyParts, PRINT_ERRORS)) {
+								affectedBodyParts, PRINT_ERRORS,
+								conf_->bodyVerificationMode, &robotLayout,
+								&newLayout)) {
 
 					if (!newBot->check()) {
 						std::cout << "Consistency check failed in mutation operator " << i << std::endl;
@@ -430,6 +501,7 @@ bool Mutator::mutateBody(boost::shared_ptr<RobotRepresentation>& robot) {
 
 					robot = newBot;
 					robot->setDirty();
+					robotLayout = newLayout;
 					mutated = true;
 					break;
 
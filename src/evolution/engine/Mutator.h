@@ -56,6 +56,12 @@ public:
 	Mutator(boost::shared_ptr<EvolverConfiguration> conf,
 			boost::random::mt19937 &rng);
 
+	/**
+	 * Creates a mutator with the same settings as other, drawing from a
+	 * different random number generator
+	 */
+	Mutator(const Mutator &other, boost::random::mt19937 &rng);
+
 	virtual ~Mutator();
 
 	/**
@@ -66,11 +72,40 @@ public:
 			boost::shared_ptr<RobotRepresentation> parent2 =
 					boost::shared_ptr<RobotRepresentation>());
 
+	/**
+	 * Performs mutation and crossover on many pairs of robots, in parallel.
+	 * Reproduction event i draws from its own random stream derived from
+	 * (seed, generation, i), so the offspring do not depend on the number
+	 * of threads.
+	 * @param parents parent pairs, the second parent may be empty
+	 * @return offspring of all pairs, in order of the pairs
+	 */
+	std::vector<boost::shared_ptr<RobotRepresentation> > createOffspring(
+			const std::vector<std::pair<boost::shared_ptr<RobotRepresentation>,
+				boost::shared_ptr<RobotRepresentation> > > &parents,
+			unsigned int seed, unsigned int generation);
+
+	/**
+	 * @return number of robots created by createOffspring() from a pair of
+	 * parents
+	 */
+	unsigned int getOffspringPerPair() const;
+
 	void growBodyRandomly(boost::shared_ptr<RobotRepresentation>& robot);
 	void randomizeBrain(boost::shared_ptr<RobotRepresentation>& robot);
 
 private:
 
+	/**
+	 * Creates the offspring of parents[i] into offspring[i]
+	 */
+	void createOffspringTask(
+			const std::vector<std::pair<boost::shared_ptr<RobotRepresentation>,
+				boost::shared_ptr<RobotRepresentation> > > &parents,
+			std::vector<std::vector<boost::shared_ptr<RobotRepresentation> > >
+				&offspring, unsigned int seed, unsigned int generation,
+			unsigned int i) const;
+
 	/**
 	 * Mutates a single robot
 	 * @return true if robot has been modified
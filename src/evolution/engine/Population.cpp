@@ -31,6 +31,7 @@
 #include <algorithm>
 #include <queue>
 #include <math.h>
+#include <boost/bind.hpp>
 #include <boost/accumulators/accumulators.hpp>
 #include <boost/accumulators/statistics/stats.hpp>
 #include <boost/accumulators/statistics/mean.hpp>
@@ -39,6 +40,8 @@
 #include "robogen.pb.h"
 #include "utils/network/ProtobufPacket.h"
 #include "evolution/engine/BodyVerifier.h"
+#include "utils/ParallelFor.h"
+#include "utils/RandomStreams.h"
 
 namespace robogen {
 
@@ -47,30 +50,44 @@ Population::Population() :
 
 }
 
-bool Population::init(boost::shared_ptr<RobotRepresentation> robot, int popSize,
+void Population::initIndividual(boost::shared_ptr<RobotRepresentation> robot,
 		boost::shared_ptr<Mutator> mutator, bool growBodies,
-		bool randomizeBrains) {
+		bool randomizeBrains, unsigned int seed,
+		std::vector<boost::shared_ptr<RobotRepresentation> > &individuals,
+		unsigned int i) {
 
-	// fill population vector
-	for (int i = 0; i < popSize; i++) {
-
-		if (i == 0 || randomizeBrains) {
-			this->push_back(
-				boost::shared_ptr<RobotRepresentation>(
-						new RobotRepresentation(*robot.get())));
-
-			if (randomizeBrains) {
-				mutator->randomizeBrain(this->back());
-			}
-		} else { // i > 0 and !randomizeBrains, create mutated copy of seed
-			this->push_back( mutator->createOffspring(robot)[0] );
-		}
+	boost::random::mt19937 rng;
+	seedStream(rng, seed, 0, i);
+	Mutator individualMutator(*mutator.get(), rng);
 
-		if (growBodies) {
-			mutator->growBodyRandomly(this->back());
+	boost::shared_ptr<RobotRepresentation> individual;
+	if (i == 0 || randomizeBrains) {
+		individual.reset(new RobotRepresentation(*robot.get()));
+
+		if (randomizeBrains) {
+			individualMutator.randomizeBrain(individual);
 		}
-		//BodyVerifier::fixRobotBody(this->back());
+	} else { // i > 0 and !randomizeBrains, create mutated copy of seed
+		individual = individualMutator.createOffspring(robot)[0];
+	}
+
+	if (growBodies) {
+		individualMutator.growBodyRandomly(individual);
 	}
+	//BodyVerifier::fixRobotBody(individual);
+	individuals[i] = individual;
+}
+
+bool Population::init(boost::shared_ptr<RobotRepresentation> robot, int popSize,
+		boost::shared_ptr<Mutator> mutator, bool growBodies,
+		bool randomizeBrains, unsigned int seed, unsigned int numThreads) {
+
+	// fill population vector
+	std::vector<boost::shared_ptr<RobotRepresentation> > individuals(popSize);
+	parallelFor(popSize, numThreads, boost::bind(&Population::initIndividual,
+			robot, mutator, growBodies, randomizeBrains, seed,
+			boost::ref(individuals), _1));
+	this->insert(this->end(), individuals.begin(), individuals.end());
 	return true;
 }
 
@@ -100,6 +117,25 @@ bool Population::init(const IndividualContainer &origin, unsigned int popSize) {
 	return true;
 }
 
+bool Population::init(const std::vector<boost::shared_ptr<RobotRepresentation> >
+		&individuals) {
+
+	for (unsigned int i = 0; i < individuals.size(); i++) {
+		if (!individuals[i]->isEvaluated()) {
+			std::cout << "Trying to restore a population with non-evaluated "
+					"individuals!" << std::endl;
+			return false;
+		}
+		this->push_back(individuals[i]);
+	}
+
+	// sorting again could swap individuals of equal fitness
+	this->evaluated_ = true;
+	this->sorted_ = true;
+
+	return true;
+}
+
 Population::~Population() {
 }
 
@@ -59,16 +59,28 @@ public:
 	 * @param mutator Mutator for possibly growing bodies randomly
 	 * @param growBodies bool whether we should grow bodies or not
 	 * @param randomizeBrains bool whether we should randomize brains or not
+	 * @param seed seed of the evolution: individual i is created in parallel
+	 * from its own random stream (seed, 0, i)
+	 * @param numThreads number of threads, 0 for one per hardware thread
 	 */
 	bool init(boost::shared_ptr<RobotRepresentation> robot, int popSize,
 			boost::shared_ptr<Mutator> mutator, bool growBodies,
-			bool randomizeBrains);
+			bool randomizeBrains, unsigned int seed,
+			unsigned int numThreads = 0);
 
 	/**
 	 * Creates a population from the popSize best individuals of origin.
 	 */
 	bool init(const IndividualContainer &origin, unsigned int popSize);
 
+	/**
+	 * Restores a population saved in a checkpoint. The individuals must be
+	 * evaluated and are kept in their order, the order of the population
+	 * when it was saved after being sorted.
+	 */
+	bool init(const std::vector<boost::shared_ptr<RobotRepresentation> >
+			&individuals);
+
 	virtual ~Population();
 
 	/**
@@ -81,6 +93,17 @@ public:
 	 * Requires the population to be evaluated.
 	 */
 	bool getStat(double &best, double &average, double &stdev) const;
+
+private:
+
+	/**
+	 * Creates the i-th individual of the initial population
+	 */
+	static void initIndividual(boost::shared_ptr<RobotRepresentation> robot,
+			boost::shared_ptr<Mutator> mutator, bool growBodies,
+			bool randomizeBrains, unsigned int seed,
+			std::vector<boost::shared_ptr<RobotRepresentation> > &individuals,
+			unsigned int i);
 };
 
 } /* namespace robogen */
@@ -0,0 +1,289 @@
+/*
+ * @(#) RobotArchive.cpp   1.0   Oct 19, 2026
+ *
+ * The ROBOGEN Framework
+ * Copyright © 2013-2016
+ *
+ * Laboratory of Intelligent Systems, EPFL
+ *
+ * This file is part of the ROBOGEN Framework.
+ *
+ * The ROBOGEN Framework is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License (GPL)
+ * as published by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @(#) $Id$
+ */
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#define BOOST_NO_CXX11_SCOPED_ENUMS
+#include <boost/filesystem.hpp>
+#undef BOOST_NO_CXX11_SCOPED_ENUMS
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl.h>
+
+#include "evolution/engine/RobotArchive.h"
+#include "evolution/representation/RobotRepresentation.h"
+
+namespace robogen {
+
+RobotArchive::RobotArchive() :
+#ifndef EMSCRIPTEN
+		stop_(false),
+#endif
+		size_(0), failed_(false) {
+}
+
+RobotArchive::~RobotArchive() {
+	close();
+}
+
+bool RobotArchive::open(const std::string& directory,
+		unsigned int fromGeneration) {
+
+	close();
+
+	std::string archivePath = directory + "/" + ROBOT_ARCHIVE_FILE;
+	std::string indexPath = directory + "/" + ROBOT_ARCHIVE_INDEX_FILE;
+
+	// keep the records of the generations before the one to continue from
+	std::vector<RobotArchiveEntry> entries;
+	size_ = 0;
+	if (fromGeneration > 0 && boost::filesystem::exists(indexPath)) {
+		std::vector<RobotArchiveEntry> allEntries;
+		if (!readIndex(directory, allEntries)) {
+			return false;
+		}
+		// records are in generation order
+		for (unsigned int i = 0; i < allEntries.size() &&
+				allEntries[i].generation < fromGeneration; ++i) {
+			entries.push_back(allEntries[i]);
+			size_ = allEntries[i].offset + allEntries[i].size;
+		}
+		// also drops a record interrupted before being indexed
+		if (size_ > 0) {
+			boost::system::error_code errorCode;
+			boost::filesystem::resize_file(archivePath, size_, errorCode);
+			if (errorCode) {
+				std::cerr << "Can't truncate robot archive " << archivePath
+						<< ": " << errorCode.message() << std::endl;
+				return false;
+			}
+		}
+	}
+
+	archive_.open(archivePath.c_str(), std::ios::out | std::ios::binary |
+			(size_ > 0 ? std::ios::app : std::ios::trunc));
+	index_.open(indexPath.c_str(), std::ios::out | std::ios::trunc);
+	if (!archive_.is_open() || !index_.is_open()) {
+		std::cerr << "Can't open robot archive in " << directory << std::endl;
+		return false;
+	}
+	index_ << std::setprecision(std::numeric_limits<double>::digits10 + 2);
+	for (unsigned int i = 0; i < entries.size(); ++i) {
+		index_ << entries[i].generation << " " << entries[i].guy << " "
+				<< entries[i].fitness << " " << entries[i].offset << " "
+				<< entries[i].size << std::endl;
+	}
+	failed_ = false;
+
+#ifndef EMSCRIPTEN
+	stop_ = false;
+	writer_.reset(new boost::thread(&RobotArchive::writeLoop, this));
+#endif
+	return true;
+}
+
+bool RobotArchive::append(unsigned int generation, Population &population) {
+
+	// building the messages needs the individuals, which evolution changes
+	boost::shared_ptr<Batch> batch(new Batch(population.size()));
+	for (unsigned int i = 0; i < population.size(); ++i) {
+		robogenMessage::ArchivedRobot &record = batch->at(i);
+		record.set_generation(generation);
+		record.set_guy(i + 1);
+		record.set_fitness(population[i]->getFitness());
+		*record.mutable_robot() = population[i]->serialize();
+	}
+
+#ifndef EMSCRIPTEN
+	boost::mutex::scoped_lock lock(mutex_);
+	if (failed_) {
+		return false;
+	}
+	queue_.push_back(batch);
+	condition_.notify_all();
+	return true;
+#else
+	return write(*batch);
+#endif
+}
+
+bool RobotArchive::flush() {
+#ifndef EMSCRIPTEN
+	boost::mutex::scoped_lock lock(mutex_);
+	while (!queue_.empty()) {
+		condition_.wait(lock);
+	}
+#endif
+	return !failed_;
+}
+
+void RobotArchive::close() {
+#ifndef EMSCRIPTEN
+	if (writer_) {
+		{
+			boost::mutex::scoped_lock lock(mutex_);
+			stop_ = true;
+			condition_.notify_all();
+		}
+		writer_->join();
+		writer_.reset();
+	}
+#endif
+	if (archive_.is_open()) {
+		archive_.close();
+	}
+	if (index_.is_open()) {
+		index_.close();
+	}
+}
+
+#ifndef EMSCRIPTEN
+void RobotArchive::writeLoop() {
+	boost::mutex::scoped_lock lock(mutex_);
+	while (true) {
+		while (queue_.empty() && !stop_) {
+			condition_.wait(lock);
+		}
+		if (queue_.empty()) {
+			return;
+		}
+		boost::shared_ptr<Batch> batch = queue_.front();
+
+		lock.unlock();
+		bool success = write(*batch);
+		lock.lock();
+
+		queue_.pop_front();
+		if (!success) {
+			failed_ = true;
+		}
+		condition_.notify_all();
+	}
+}
+#endif
+
+bool RobotArchive::write(const Batch &batch) {
+
+	std::stringstream indexLines;
+	indexLines << std::setprecision(std::numeric_limits<double>::digits10 + 2);
+
+	std::string bytes;
+	for (unsigned int i = 0; i < batch.size(); ++i) {
+		const robogenMessage::ArchivedRobot &record = batch[i];
+		unsigned long long offset = size_;
+
+		bytes.clear();
+		google::protobuf::uint8 prefix[10];
+		google::protobuf::uint8 *prefixEnd = google::protobuf::io::
+				CodedOutputStream::WriteVarint32ToArray(record.ByteSize(),
+						prefix);
+		bytes.append(reinterpret_cast<char *>(prefix), prefixEnd - prefix);
+		record.AppendToString(&bytes);
+
+		archive_.write(bytes.data(), bytes.size());
+		size_ += bytes.size();
+
+		indexLines << record.generation() << " " << record.guy() << " "
+				<< record.fitness() << " " << offset << " " << bytes.size()
+				<< "\n";
+	}
+	archive_.flush();
+	if (!archive_.good()) {
+		std::cerr << "Can't write robot archive" << std::endl;
+		return false;
+	}
+
+	index_ << indexLines.str();
+	index_.flush();
+	if (!index_.good()) {
+		std::cerr << "Can't write robot archive index" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool RobotArchive::readIndex(const std::string& directory,
+		std::vector<RobotArchiveEntry> &entries) {
+
+	std::string indexPath = directory + "/" + ROBOT_ARCHIVE_INDEX_FILE;
+	std::ifstream indexFile(indexPath.c_str());
+	if (!indexFile.is_open()) {
+		std::cerr << "Can't open robot archive index " << indexPath
+				<< std::endl;
+		return false;
+	}
+
+	entries.clear();
+	RobotArchiveEntry entry;
+	while (indexFile >> entry.generation >> entry.guy >> entry.fitness
+			>> entry.offset >> entry.size) {
+		entries.push_back(entry);
+	}
+	if (!indexFile.eof()) {
+		std::cerr << "Can't read robot archive index " << indexPath
+				<< std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool RobotArchive::read(const std::string& directory,
+		const RobotArchiveEntry &entry, robogenMessage::ArchivedRobot &robot) {
+
+	std::string archivePath = directory + "/" + ROBOT_ARCHIVE_FILE;
+	std::ifstream archiveFile(archivePath.c_str(),
+			std::ios::in | std::ios::binary);
+	if (!archiveFile.is_open()) {
+		std::cerr << "Can't open robot archive " << archivePath << std::endl;
+		return false;
+	}
+	archiveFile.seekg(entry.offset);
+	if (!archiveFile.good()) {
+		std::cerr << "Can't read robot archive " << archivePath << " at "
+				<< entry.offset << std::endl;
+		return false;
+	}
+
+	google::protobuf::io::IstreamInputStream input(&archiveFile);
+	google::protobuf::io::CodedInputStream coded(&input);
+	google::protobuf::uint32 size;
+	if (!coded.ReadVarint32(&size)) {
+		std::cerr << "Can't read robot archive " << archivePath << " at "
+				<< entry.offset << std::endl;
+		return false;
+	}
+	google::protobuf::io::CodedInputStream::Limit limit = coded.PushLimit(size);
+	if (!robot.ParseFromCodedStream(&coded) ||
+			!coded.ConsumedEntireMessage()) {
+		std::cerr << "Can't read robot archive " << archivePath << " at "
+				<< entry.offset << std::endl;
+		return false;
+	}
+	coded.PopLimit(limit);
+	return true;
+}
+
+}
@@ -0,0 +1,172 @@
+/*
+ * @(#) RobotArchive.h   1.0   Oct 19, 2026
+ *
+ * The ROBOGEN Framework
+ * Copyright © 2013-2016
+ *
+ * Laboratory of Intelligent Systems, EPFL
+ *
+ * This file is part of the ROBOGEN Framework.
+ *
+ * The ROBOGEN Framework is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License (GPL)
+ * as published by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @(#) $Id$
+ */
+
+#ifndef ROBOTARCHIVE_H_
+#define ROBOTARCHIVE_H_
+
+#include <deque>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#ifndef EMSCRIPTEN
+#include <boost/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#endif
+
+#include "evolution/engine/Population.h"
+#include "robogen.pb.h"
+
+namespace robogen {
+
+#define ROBOT_ARCHIVE_FILE "Archive.dat"
+#define ROBOT_ARCHIVE_INDEX_FILE "ArchiveIndex.txt"
+
+/**
+ * Index entry of an archived individual
+ */
+struct RobotArchiveEntry {
+	unsigned int generation;
+	/**
+	 * Position of the individual in its population, from 1
+	 */
+	unsigned int guy;
+	double fitness;
+	/**
+	 * Position of the record in the archive file
+	 */
+	unsigned long long offset;
+	/**
+	 * Size of the record, including its size prefix
+	 */
+	unsigned int size;
+};
+
+/**
+ * Append-only archive of evaluated individuals.
+ *
+ * Archive.dat holds ArchivedRobot messages, each preceded by its size as a
+ * varint. ArchiveIndex.txt holds one line "generation guy fitness offset
+ * size" per record, written once the record itself is written, so the index
+ * never points past the end of the archive.
+ *
+ * Individuals are serialized to messages by the caller, the messages are
+ * encoded and written by a background thread.
+ */
+class RobotArchive {
+public:
+	RobotArchive();
+
+	/**
+	 * Writes whatever is still queued and closes the files
+	 */
+	virtual ~RobotArchive();
+
+	/**
+	 * Opens the archive of a log directory.
+	 * @param directory log directory
+	 * @param fromGeneration if not 0, the archive of an interrupted evolution
+	 * 			is continued: the records of this generation and of the
+	 * 			following ones are dropped. Otherwise the archive is emptied.
+	 * @return true if successful
+	 */
+	bool open(const std::string& directory, unsigned int fromGeneration = 0);
+
+	/**
+	 * Queues all individuals of an evaluated population for writing.
+	 * @return false if writing previous generations failed
+	 */
+	bool append(unsigned int generation, Population &population);
+
+	/**
+	 * Waits until all queued individuals are written.
+	 * @return false if writing failed
+	 */
+	bool flush();
+
+	/**
+	 * Writes whatever is still queued and closes the files
+	 */
+	void close();
+
+	/**
+	 * Reads the index of the archive of a log directory
+	 * @return true if successful
+	 */
+	static bool readIndex(const std::string& directory,
+			std::vector<RobotArchiveEntry> &entries);
+
+	/**
+	 * Reads one record of the archive of a log directory
+	 * @return true if successful
+	 */
+	static bool read(const std::string& directory,
+			const RobotArchiveEntry &entry,
+			robogenMessage::ArchivedRobot &robot);
+
+private:
+	typedef std::vector<robogenMessage::ArchivedRobot> Batch;
+
+	/**
+	 * Appends a batch to the files
+	 */
+	bool write(const Batch &batch);
+
+#ifndef EMSCRIPTEN
+	/**
+	 * Background thread writing the queued batches
+	 */
+	void writeLoop();
+
+	boost::shared_ptr<boost::thread> writer_;
+	boost::mutex mutex_;
+	boost::condition_variable condition_;
+
+	/**
+	 * Batches not written yet, the first one while it is being written
+	 */
+	std::deque<boost::shared_ptr<Batch> > queue_;
+	bool stop_;
+#endif
+
+	std::ofstream archive_;
+	std::ofstream index_;
+
+	/**
+	 * Size of the archive file
+	 */
+	unsigned long long size_;
+
+	/**
+	 * Whether writing failed
+	 */
+	bool failed_;
+};
+
+}
+
+#endif /* ROBOTARCHIVE_H_ */
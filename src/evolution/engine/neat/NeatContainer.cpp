@@ -27,14 +27,22 @@
  */
 
 #include <boost/random/uniform_int_distribution.hpp>
+#include <boost/bind.hpp>
 #include <algorithm>
+#include <cstdio>
+#include <sstream>
+#include <stdexcept>
 
 #include "evolution/engine/neat/NeatContainer.h"
+#include "utils/ParallelFor.h"
 
 //#define NEAT_CONTAINER_DEBUG
 
 namespace robogen {
 
+// Activations of the CPPN per query, enough for recurrent CPPNs to settle
+const unsigned int CPPN_ACTIVATION_STEPS = 10;
+
 NeatContainer::NeatContainer(boost::shared_ptr<EvolverConfiguration> &evoConf,
 		boost::shared_ptr<Population> &population, unsigned int seed,
 		boost::random::mt19937 &rng) :
@@ -61,25 +69,127 @@ NeatContainer::NeatContainer(boost::shared_ptr<EvolverConfiguration> &evoConf,
 
 }
 
+NeatContainer::NeatContainer(boost::shared_ptr<EvolverConfiguration> &evoConf,
+		boost::shared_ptr<Population> &population,
+		const robogenMessage::NeatState &state) : evoConf_(evoConf) {
+	std::istringstream populationStream(state.population());
+	try {
+		neatPopulation_.reset(new NEAT::Population(populationStream));
+	} catch (std::exception &) {
+		throw std::runtime_error("Could not read the NEAT population");
+	}
+	// the number of threads may differ from the interrupted run's
+	neatPopulation_->m_Parameters.NumThreads = evoConf->neatParams.NumThreads;
+
+	std::istringstream rngStream(state.rng());
+	rngStream >> rng_;
+
+	if (state.genomeid_size() != (int) population->size()) {
+		throw std::runtime_error("The NEAT state does not match the "
+				"population");
+	}
+	for (unsigned int k = 0; k < population->size(); k++) {
+		if (state.genomeid(k) < 0) {
+			continue;
+		}
+		unsigned int id = state.genomeid(k);
+		// the first genome with the id, like produceNextGeneration() maps
+		bool found = false;
+		for(unsigned int i=0; i < neatPopulation_->m_Species.size() && !found;
+				i++) {
+			for(unsigned int j=0;
+					j < neatPopulation_->m_Species[i].m_Individuals.size();
+					j++) {
+				if (neatPopulation_->m_Species[i].m_Individuals[j].GetID()
+						== id) {
+					neatIdToGenomeMap_[id] =
+							&neatPopulation_->m_Species[i].m_Individuals[j];
+					found = true;
+					break;
+				}
+			}
+		}
+		if (!found) {
+			throw std::runtime_error("The NEAT population does not contain "
+					"a genome of the population");
+		}
+		neatIdToRobotMap_[id] = population->at(k);
+	}
+	for (int k = 0; k < state.unmapped_size(); k++) {
+		unMappedRobots_.push_back(population->at(state.unmapped(k)));
+	}
+}
+
 NeatContainer::~NeatContainer() {
 }
 
+robogenMessage::NeatState NeatContainer::serializeState(
+		const boost::shared_ptr<Population> &population) const {
+	robogenMessage::NeatState state;
+
+	// the population saves itself to a file
+	FILE *file = std::tmpfile();
+	if (file) {
+		neatPopulation_->SaveState(file);
+		std::string populationState(std::ftell(file), '\0');
+		std::rewind(file);
+		if (std::fread(&populationState[0], 1, populationState.size(), file)
+				== populationState.size()) {
+			state.set_population(populationState);
+		}
+		std::fclose(file);
+	}
+	if (!state.has_population()) {
+		std::cerr << "Could not save the NEAT population state" << std::endl;
+	}
+
+	std::map<RobotRepresentation*, unsigned int> robotToId;
+	for(NeatIdToRobotMap::const_iterator i = neatIdToRobotMap_.begin();
+			i != neatIdToRobotMap_.end(); i++) {
+		robotToId[i->second.get()] = i->first;
+	}
+	std::map<RobotRepresentation*, unsigned int> robotToIndex;
+	for (unsigned int k = 0; k < population->size(); k++) {
+		RobotRepresentation *robot = population->at(k).get();
+		robotToIndex[robot] = k;
+		state.add_genomeid(robotToId.count(robot) ? robotToId[robot] : -1);
+	}
+	for (unsigned int k = 0; k < unMappedRobots_.size(); k++) {
+		state.add_unmapped(robotToIndex[unMappedRobots_[k].get()]);
+	}
+
+	std::ostringstream rngStream;
+	rngStream << rng_;
+	state.set_rng(rngStream.str());
+	return state;
+}
+
 bool NeatContainer::fillPopulationWeights(
 		boost::shared_ptr<Population> &population) {
 
+	std::vector<NEAT::Genome*> genomes;
+	std::vector<boost::shared_ptr<RobotRepresentation> > robots;
 	for(NeatIdToGenomeMap::iterator i = neatIdToGenomeMap_.begin();
 			i != neatIdToGenomeMap_.end(); i++) {
 		unsigned int id = i->first;
-		NEAT::Genome *genome = i->second;
 		if(neatIdToRobotMap_.count(id) == 0) {
 			std::cout << "No robot in map with id " << id << std::endl;
 			return false;
 		}
-		boost::shared_ptr<RobotRepresentation> robot = neatIdToRobotMap_[id];
-		if(!this->fillBrain(genome, robot)) {
+		genomes.push_back(i->second);
+		robots.push_back(neatIdToRobotMap_[id]);
+	}
+
+	// fill all brains in parallel, each task only touches its own robot
+	std::vector<char> success(robots.size(), false);
+	parallelFor(robots.size(), evoConf_->evolverThreads,
+			boost::bind(&NeatContainer::fillBrainTask, this,
+					boost::cref(genomes), boost::ref(robots),
+					boost::ref(success), _1));
+	for(unsigned int i = 0; i < success.size(); i++) {
+		if (!success[i]) {
 			return false;
 		}
-
 	}
 	return true;
 }
@@ -208,207 +318,134 @@ bool NeatContainer::produceNextGeneration(boost::shared_ptr<Population>
 	return this->fillPopulationWeights(population);
 }
 
-bool NeatContainer::fillBrain(NEAT::Genome *genome,
-		boost::shared_ptr<RobotRepresentation> &robotRepresentation) {
-
-	// Initialize ODE
-	dInitODE();
-	dWorldID odeWorld = dWorldCreate();
-	dWorldSetGravity(odeWorld, 0, 0, 0);
-	dSpaceID odeSpace = dHashSpaceCreate(0);
-
-	bool returnValue = false;
-
-	// code block to protect object for ODE cleanup
-	// use for loop so can break out of it -- hack, I know
-	for(unsigned int useless = 0; useless < 1; ++useless) {
-		NEAT::NeuralNetwork net;
-	    genome->BuildPhenotype(net);
-
-	    typedef std::map<std::string, boost::weak_ptr<NeuronRepresentation> >
-	    	NeuronMap;
-
-	    std::map<std::string, std::vector<double> > neuronToPositionMap;
-	    NeuronMap neuronMap;
-
-	    // FIRST NEED TO CREATE PHYSICAL ROBOT REP TO DETERMINE POSITIONS
-
-	    // parse robot message
-		robogenMessage::Robot robotMessage = robotRepresentation->serialize();
-		// parse robot
-		boost::shared_ptr<Robot> robot(new Robot);
-		if (!robot->init(odeWorld, odeSpace, robotMessage)) {
-			std::cout << "Problem when initializing robot in "
-					<< "NeatContainer::fillBrain!" << std::endl;
-			break;
-		}
-
-		RobotRepresentation::IdPartMap body = robotRepresentation->getBody();
-		boost::shared_ptr<NeuralNetworkRepresentation> brain =
-				robotRepresentation->getBrain();
-
-		// For each body part, get its position then create an entry for every
-		// neuron by adding a 4th coordinate that is the neurons ioID.
+void NeatContainer::fillBrainTask(const std::vector<NEAT::Genome*> &genomes,
+		std::vector<boost::shared_ptr<RobotRepresentation> > &robots,
+		std::vector<char> &success, unsigned int i) {
+	SubstrateCoordinates::NeuronCoordinates coordinates;
+	if (!substrateCoordinates_.getNeuronCoordinates(*robots[i], coordinates)) {
+		std::cout << "Problem when computing body part positions in "
+				<< "NeatContainer::fillBrain!" << std::endl;
+		success[i] = false;
+		return;
+	}
+	this->fillBrain(genomes[i], robots[i], coordinates);
+	success[i] = true;
+}
 
-#ifdef NEAT_CONTAINER_DEBUG
-		std::cout << "POSITIONS: " << std::endl;
-#endif
-		for(RobotRepresentation::IdPartMap::iterator i = body.begin();
-				i != body.end(); i++) {
-			std::string id = i->first;
-			boost::shared_ptr<PartRepresentation> part = i->second.lock();
-			std::vector<boost::weak_ptr<NeuronRepresentation> > neurons =
-					brain->getBodyPartNeurons(part->getId());
-			osg::Vec3 pos = robot->getBodyPart(id)->getRootPosition();
-
-			for (unsigned int j = 0; j<neurons.size(); j++) {
-				std::vector<double> position;
-				position.push_back(pos.x() * 10.0); //roughly something in [-1,1]
-				position.push_back(pos.y() * 10.0);
-				//position.push_back(pos.z());
-				float io = neurons[j].lock()->getIoPair().second;
-				position.push_back((io/10.0));
-				neuronToPositionMap[neurons[j].lock()->getId()] = position;
-				neuronMap[neurons[j].lock()->getId()] = neurons[j];
-#ifdef NEAT_CONTAINER_DEBUG
-				for(unsigned int cv = 0; cv<position.size(); cv++) {
-					std::cout << position[cv] << " ";
-				}
-				std::cout << std::endl;
-#endif
+void NeatContainer::fillBrain(NEAT::Genome *genome,
+		boost::shared_ptr<RobotRepresentation> &robotRepresentation,
+		const SubstrateCoordinates::NeuronCoordinates &positions) const {
+
+	NEAT::NeuralNetwork net;
+	genome->BuildPhenotype(net);
+
+	boost::shared_ptr<NeuralNetworkRepresentation> brain =
+			robotRepresentation->getBrain();
+
+	// Now go through all neurons and gather the queries for weights and params
+	// with the obtained coordinates: one per existing connection (i, j), and
+	// one per non-input neuron (i, -1) with 0 for the second set of coords
+	std::vector<std::vector<double> > inputs;
+	std::vector<std::pair<unsigned int, int> > queries;
+	for(unsigned int i = 0; i < positions.size(); i++) {
+		const std::vector<double> &positionI = positions[i].second;
+		boost::shared_ptr<NeuronRepresentation> neuronI = positions[i].first;
+		for(unsigned int j = 0; j < positions.size(); j++) {
+			const std::vector<double> &positionJ = positions[j].second;
+			boost::shared_ptr<NeuronRepresentation> neuronJ =
+					positions[j].first;
+
+			if (brain->connectionExists(neuronI->getId(), neuronJ->getId())) {
+				// only set weights on existing connections
+				std::vector<double> input(positionI);
+				input.insert(input.end(), positionJ.begin(), positionJ.end());
+				input.push_back(1.0); //bias
+				inputs.push_back(input);
+				queries.push_back(std::make_pair(i, (int) j));
 			}
-#ifdef NEAT_CONTAINER_DEBUG
-			std::cout << std::endl;
-#endif
-
-
+		}
 
+		if (neuronI->getLayer() != NeuronRepresentation::INPUT) {
+			// input neurons don't have params
+			std::vector<double> input(positionI);
+			input.resize(2 * positionI.size(), 0.0);
+			input.push_back(1.0); //bias
+			inputs.push_back(input);
+			queries.push_back(std::make_pair(i, -1));
 		}
+	}
 
-		// Now go through all neurons and query for weights and params with
-		// the obtained coordinates
-#ifdef NEAT_CONTAINER_DEBUG
-		std::cout << "**************************";
-#endif
-		for(NeuronMap::iterator i = neuronMap.begin(); i != neuronMap.end(); i++) {
-			std::vector<double> positionI = neuronToPositionMap[i->first];
-			boost::shared_ptr<NeuronRepresentation> neuronI = i->second.lock();
-			for(NeuronMap::iterator j = neuronMap.begin(); j != neuronMap.end();
-					j++) {
-				std::vector<double> positionJ = neuronToPositionMap[j->first];
-				boost::shared_ptr<NeuronRepresentation> neuronJ = j->second.lock();
-
-				if (brain->connectionExists(neuronI->getId(), neuronJ->getId())) {
-					// only set weights on existing connections
-					net.Flush();
-					std::vector<double> inputs;
-					for (unsigned int k = 0; k < positionI.size(); k++) {
-						inputs.push_back(positionI[k]);
-					}
-					for (unsigned int k = 0; k < positionJ.size(); k++) {
-						inputs.push_back(positionJ[k]);
-					}
-					inputs.push_back(1.0); //bias
+	std::vector<std::vector<double> > outputs;
+	net.ActivateBatch(inputs, CPPN_ACTIVATION_STEPS, outputs);
 
-#ifdef NEAT_CONTAINER_DEBUG
-					std::cout << "INPUTS: ";
-					for (unsigned int cv = 0; cv < inputs.size(); cv++) {
-						std::cout << inputs[cv] << " ";
-					}
-					std::cout << std::endl;
-#endif
-					net.Input(inputs);
-					for(int t=0; t<10; t++) {
-						net.Activate();
-					}
-					std::vector<double> outputs = net.Output();
+	for(unsigned int q = 0; q < queries.size(); q++) {
+		boost::shared_ptr<NeuronRepresentation> neuronI =
+				positions[queries[q].first].first;
 
 #ifdef NEAT_CONTAINER_DEBUG
-					std::cout << "OUTPUTS: ";
-					for (unsigned int cv = 0; cv < outputs.size(); cv++) {
-						std::cout << outputs[cv] << " ";
-					}
-					std::cout << std::endl;
+		std::cout << "INPUTS: ";
+		for (unsigned int cv = 0; cv < inputs[q].size(); cv++) {
+			std::cout << inputs[q][cv] << " ";
+		}
+		std::cout << std::endl;
+		std::cout << "OUTPUTS: ";
+		for (unsigned int cv = 0; cv < outputs[q].size(); cv++) {
+			std::cout << outputs[q][cv] << " ";
+		}
+		std::cout << std::endl;
 #endif
 
-					if (outputs[0] < 0.5) {
-						// if first output is under threshold,
-						// connection "does not exist" according to genome so set
-						// weight to 0
-						brain->setWeight(neuronI->getIoPair(),
-								neuronJ->getIoPair(), 0.0);
-					} else {
-						// otherwise use the second output
-						// translate from [0,1] to [min, max]
-						double weight = outputs[1] * (evoConf_->maxBrainWeight -
-								evoConf_->minBrainWeight) +
-								evoConf_->minBrainWeight;
-						brain->setWeight(neuronI->getIoPair(),
-								neuronJ->getIoPair(), weight);
-					}
-				}
+		if (queries[q].second != -1) {
+			boost::shared_ptr<NeuronRepresentation> neuronJ =
+					positions[queries[q].second].first;
+			if (outputs[q][0] < 0.5) {
+				// if first output is under threshold,
+				// connection "does not exist" according to genome so set
+				// weight to 0
+				brain->setWeight(neuronI->getIoPair(),
+						neuronJ->getIoPair(), 0.0);
+			} else {
+				// otherwise use the second output
+				// translate from [0,1] to [min, max]
+				double weight = outputs[q][1] * (evoConf_->maxBrainWeight -
+						evoConf_->minBrainWeight) +
+						evoConf_->minBrainWeight;
+				brain->setWeight(neuronI->getIoPair(),
+						neuronJ->getIoPair(), weight);
 			}
+			continue;
+		}
 
-			// now query for parameters
-			if (neuronI->getLayer() != NeuronRepresentation::INPUT) {
-				// input neurons don't have params
-				net.Flush();
-				std::vector<double> inputs;
-				for (unsigned int k = 0; k < positionI.size(); k++) {
-					inputs.push_back(positionI[k]);
-				}
-				for (unsigned int k = 0; k < positionI.size(); k++) {
-					inputs.push_back(0.0); // 0 for second set of coords
-				}
-				inputs.push_back(1.0); //bias
-				net.Input(inputs);
-				for(int t=0; t<10; t++) {
-					net.Activate();
-				}
-				std::vector<double> outputs = net.Output();
-				std::vector<double> params;
-				if(neuronI->getType() == NeuronRepresentation::SIGMOID ||
-						neuronI->getType() == NeuronRepresentation::CTRNN_SIGMOID){
-					// bias
-					params.push_back(outputs[2] * (evoConf_->maxBrainBias -
-							evoConf_->minBrainBias) + evoConf_->minBrainBias);
-					if(neuronI->getType() == NeuronRepresentation::CTRNN_SIGMOID) {
-						// tau
-						params.push_back(outputs[3] * (evoConf_->maxBrainTau -
-								evoConf_->minBrainTau) + evoConf_->minBrainTau);
-					}
-				} else if(neuronI->getType() == NeuronRepresentation::OSCILLATOR) {
-					// period
-					params.push_back( outputs[2] * (evoConf_->maxBrainPeriod -
-							evoConf_->minBrainPeriod) + evoConf_->minBrainPeriod);
-					// phase offset
-					params.push_back( outputs[3] * (evoConf_->maxBrainPhaseOffset -
-							evoConf_->minBrainPhaseOffset) +
-							evoConf_->minBrainPhaseOffset);
-					// amplitude
-					params.push_back( outputs[4] * (evoConf_->maxBrainAmplitude -
-							evoConf_->minBrainAmplitude) +
-							evoConf_->minBrainAmplitude);
-				} else {
-					std::cout << "INVALID TYPE ENCOUNTERED " << neuronI->getType()
-							<< std::endl;
-				}
-				neuronI->setParams(params);
+		// now the parameters
+		std::vector<double> params;
+		if(neuronI->getType() == NeuronRepresentation::SIGMOID ||
+				neuronI->getType() == NeuronRepresentation::CTRNN_SIGMOID){
+			// bias
+			params.push_back(outputs[q][2] * (evoConf_->maxBrainBias -
+					evoConf_->minBrainBias) + evoConf_->minBrainBias);
+			if(neuronI->getType() == NeuronRepresentation::CTRNN_SIGMOID) {
+				// tau
+				params.push_back(outputs[q][3] * (evoConf_->maxBrainTau -
+						evoConf_->minBrainTau) + evoConf_->minBrainTau);
 			}
+		} else if(neuronI->getType() == NeuronRepresentation::OSCILLATOR) {
+			// period
+			params.push_back( outputs[q][2] * (evoConf_->maxBrainPeriod -
+					evoConf_->minBrainPeriod) + evoConf_->minBrainPeriod);
+			// phase offset
+			params.push_back( outputs[q][3] * (evoConf_->maxBrainPhaseOffset -
+					evoConf_->minBrainPhaseOffset) +
+					evoConf_->minBrainPhaseOffset);
+			// amplitude
+			params.push_back( outputs[q][4] * (evoConf_->maxBrainAmplitude -
+					evoConf_->minBrainAmplitude) +
+					evoConf_->minBrainAmplitude);
+		} else {
+			std::cout << "INVALID TYPE ENCOUNTERED " << neuronI->getType()
+					<< std::endl;
 		}
-		returnValue = true;
+		neuronI->setParams(params);
 	}
-	// Destroy ODE space
-	dSpaceDestroy(odeSpace);
-
-	// Destroy ODE world
-	dWorldDestroy(odeWorld);
-
-	// Destroy the ODE engine
-	dCloseODE();
-
-	return returnValue;
-
 }
 
 
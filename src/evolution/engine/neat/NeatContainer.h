@@ -33,6 +33,7 @@
 #include "evolution/engine/Population.h"
 #include "evolution/neat/Population.h"
 #include "evolution/neat/Genome.h"
+#include "evolution/engine/neat/SubstrateCoordinates.h"
 
 namespace robogen {
 
@@ -45,16 +46,39 @@ public:
 	NeatContainer(boost::shared_ptr<EvolverConfiguration> &evoConf,
 			boost::shared_ptr<Population> &population, unsigned int seed,
 			boost::random::mt19937 &rng);
+
+	/**
+	 * Restores the container saved with serializeState() along with the
+	 * population it was saved with.
+	 * @throws std::runtime_error if the state does not match the population
+	 */
+	NeatContainer(boost::shared_ptr<EvolverConfiguration> &evoConf,
+			boost::shared_ptr<Population> &population,
+			const robogenMessage::NeatState &state);
+
 	virtual ~NeatContainer();
 
+	/**
+	 * @return the state of the NEAT population, of the random number
+	 * generator and which genome each individual of population comes from,
+	 * to be stored in a checkpoint
+	 */
+	robogenMessage::NeatState serializeState(
+			const boost::shared_ptr<Population> &population) const;
+
 	bool fillPopulationWeights(boost::shared_ptr<Population> &population);
 
 	bool produceNextGeneration(boost::shared_ptr<Population> &population);
 
 private:
 
-	bool fillBrain(NEAT::Genome *genome,
-			boost::shared_ptr<RobotRepresentation> &robotRepresentation);
+	void fillBrain(NEAT::Genome *genome,
+			boost::shared_ptr<RobotRepresentation> &robotRepresentation,
+			const SubstrateCoordinates::NeuronCoordinates &positions) const;
+
+	void fillBrainTask(const std::vector<NEAT::Genome*> &genomes,
+			std::vector<boost::shared_ptr<RobotRepresentation> > &robots,
+			std::vector<char> &success, unsigned int i);
 
 	typedef std::map<unsigned int, NEAT::Genome*> NeatIdToGenomeMap;
 	typedef std::map<unsigned int, boost::shared_ptr<RobotRepresentation> >
@@ -65,6 +89,7 @@ private:
 	std::vector< boost::shared_ptr<RobotRepresentation> > unMappedRobots_;
 	boost::shared_ptr<EvolverConfiguration> evoConf_;
 	boost::random::mt19937 rng_;
+	SubstrateCoordinates substrateCoordinates_;
 
 	void printCurrentIds();
 
@@ -0,0 +1,207 @@
+/*
+ * @(#) SubstrateCoordinates.cpp   1.0   Oct 19, 2026
+ *
+ * The ROBOGEN Framework
+ * Copyright © 2013-2016
+ *
+ * Laboratory of Intelligent Systems, EPFL
+ *
+ * This file is part of the ROBOGEN Framework.
+ *
+ * The ROBOGEN Framework is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License (GPL)
+ * as published by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @(#) $Id$
+ */
+
+#include "evolution/engine/neat/SubstrateCoordinates.h"
+#include "evolution/engine/BodyLayout.h"
+#include "evolution/engine/BodyVerifier.h"
+#include "Robot.h"
+
+namespace robogen {
+
+namespace {
+
+void appendPartKey(std::string &key,
+		boost::shared_ptr<PartRepresentation> part) {
+	key += part->getId();
+	key += '\0';
+	key += part->getType();
+	key += '\0';
+	unsigned int orientation = part->getOrientation();
+	key.append((const char*) &orientation, sizeof(orientation));
+	const std::vector<double> &params = part->getParams();
+	for (unsigned int i = 0; i < params.size(); ++i) {
+		key.append((const char*) &params[i], sizeof(double));
+	}
+	// one entry per slot, so the key also tells where children are attached
+	key += '(';
+	for (unsigned int i = 0; i < part->getArity(); ++i) {
+		if (part->getChild(i)) {
+			appendPartKey(key, part->getChild(i));
+		} else {
+			key += '-';
+		}
+	}
+	key += ')';
+}
+
+}
+
+SubstrateCoordinates::SubstrateCoordinates(unsigned int maxBodies) :
+		maxBodies_(maxBodies) {
+}
+
+SubstrateCoordinates::~SubstrateCoordinates() {
+}
+
+std::string SubstrateCoordinates::getBodyKey(
+		const RobotRepresentation &robot) {
+	std::string key;
+	const RobotRepresentation::IdPartMap &body = robot.getBody();
+	for (RobotRepresentation::IdPartMap::const_iterator it = body.begin();
+			it != body.end(); ++it) {
+		boost::shared_ptr<PartRepresentation> part = it->second.lock();
+		if (part && part->getParent() == NULL) {
+			appendPartKey(key, part);
+			break;
+		}
+	}
+	return key;
+}
+
+boost::shared_ptr<const SubstrateCoordinates::PartPositions>
+SubstrateCoordinates::getPartPositions(const RobotRepresentation &robot) {
+
+	std::string key = getBodyKey(robot);
+	{
+		boost::mutex::scoped_lock lock(cacheMutex_);
+		std::map<std::string, boost::shared_ptr<const PartPositions> >
+			::iterator it = cache_.find(key);
+		if (it != cache_.end()) {
+			return it->second;
+		}
+	}
+
+	boost::shared_ptr<PartPositions> positions(new PartPositions());
+	BodyLayout layout;
+	if (layout.init(robot)) {
+		const std::vector<PartPlacement> &placements = layout.getPlacements();
+		for (unsigned int i = 0; i < placements.size(); ++i) {
+			(*positions)[placements[i].id] = placements[i].position;
+		}
+	} else if (!getOdePartPositions(robot, *positions)) {
+		return boost::shared_ptr<const PartPositions>();
+	}
+
+	boost::mutex::scoped_lock lock(cacheMutex_);
+	if (cache_.size() >= maxBodies_) {
+		cache_.clear();
+	}
+	cache_[key] = positions;
+	return positions;
+}
+
+bool SubstrateCoordinates::getOdePartPositions(
+		const RobotRepresentation &robot, PartPositions &positions) {
+
+	boost::mutex::scoped_lock lock(BodyVerifier::odeMutex);
+
+	dInitODE();
+	dWorldID odeWorld = dWorldCreate();
+	dWorldSetGravity(odeWorld, 0, 0, 0);
+	dSpaceID odeSpace = dHashSpaceCreate(0);
+
+	bool success = false;
+	{
+		boost::shared_ptr<Robot> odeRobot(new Robot);
+		if (odeRobot->init(odeWorld, odeSpace, robot.serialize())) {
+			success = true;
+			const RobotRepresentation::IdPartMap &body = robot.getBody();
+			for (RobotRepresentation::IdPartMap::const_iterator it =
+					body.begin(); it != body.end(); ++it) {
+				boost::shared_ptr<Model> part = odeRobot->getBodyPart(
+						it->first);
+				if (!part) {
+					success = false;
+					break;
+				}
+				positions[it->first] = part->getRootPosition();
+			}
+		}
+	}
+
+	dSpaceDestroy(odeSpace);
+	dWorldDestroy(odeWorld);
+	dCloseODE();
+	return success;
+}
+
+bool SubstrateCoordinates::getNeuronCoordinates(RobotRepresentation &robot,
+		NeuronCoordinates &coordinates) {
+
+	boost::shared_ptr<const PartPositions> positions =
+			this->getPartPositions(robot);
+	if (!positions) {
+		return false;
+	}
+
+	typedef std::map<std::string, boost::shared_ptr<NeuronRepresentation> >
+		NeuronMap;
+	typedef std::map<std::string, std::vector<double> > NeuronPositionMap;
+	NeuronMap neuronMap;
+	NeuronPositionMap neuronToPositionMap;
+
+	const RobotRepresentation::IdPartMap &body = robot.getBody();
+	boost::shared_ptr<NeuralNetworkRepresentation> brain = robot.getBrain();
+
+	// For each body part, get its position then create an entry for every
+	// neuron by adding a 3rd coordinate that is the neurons ioID.
+	for (RobotRepresentation::IdPartMap::const_iterator i = body.begin();
+			i != body.end(); ++i) {
+		boost::shared_ptr<PartRepresentation> part = i->second.lock();
+		PartPositions::const_iterator pos = positions->find(i->first);
+		if (!part || pos == positions->end()) {
+			return false;
+		}
+		std::vector<boost::weak_ptr<NeuronRepresentation> > neurons =
+				brain->getBodyPartNeurons(part->getId());
+
+		for (unsigned int j = 0; j < neurons.size(); ++j) {
+			boost::shared_ptr<NeuronRepresentation> neuron = neurons[j].lock();
+			std::vector<double> position;
+			position.push_back(pos->second.x() * 10.0); //roughly in [-1,1]
+			position.push_back(pos->second.y() * 10.0);
+			float io = neuron->getIoPair().second;
+			position.push_back((io / 10.0));
+			neuronToPositionMap[neuron->getId()] = position;
+			neuronMap[neuron->getId()] = neuron;
+		}
+	}
+
+	coordinates.clear();
+	for (NeuronMap::iterator i = neuronMap.begin(); i != neuronMap.end();
+			++i) {
+		coordinates.push_back(std::make_pair(i->second,
+				neuronToPositionMap[i->first]));
+	}
+	return true;
+}
+
+unsigned int SubstrateCoordinates::getNumCachedBodies() {
+	boost::mutex::scoped_lock lock(cacheMutex_);
+	return cache_.size();
+}
+
+} /* namespace robogen */
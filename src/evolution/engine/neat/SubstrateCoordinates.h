@@ -0,0 +1,122 @@
+/*
+ * @(#) SubstrateCoordinates.h   1.0   Oct 19, 2026
+ *
+ * The ROBOGEN Framework
+ * Copyright © 2013-2016
+ *
+ * Laboratory of Intelligent Systems, EPFL
+ *
+ * This file is part of the ROBOGEN Framework.
+ *
+ * The ROBOGEN Framework is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License (GPL)
+ * as published by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @(#) $Id$
+ */
+
+#ifndef SUBSTRATECOORDINATES_H_
+#define SUBSTRATECOORDINATES_H_
+
+#include <map>
+#include <string>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <osg/Vec3>
+
+#include "evolution/representation/RobotRepresentation.h"
+
+namespace robogen {
+
+/**
+ * Provides the HyperNEAT substrate coordinates of the neurons of a robot,
+ * derived from where its body parts are once the robot is assembled.
+ *
+ * Part positions are computed analytically by BodyLayout, with the same slot
+ * geometry as RobogenUtils::connect and the root at the origin as in
+ * Robot::init, so no ODE world is needed. Bodies with parts BodyLayout
+ * doesn't know (touch sensors, cardans) are built in a throwaway ODE world
+ * instead, one at a time. Positions are memoised per body, which in brain
+ * evolution never changes.
+ */
+class SubstrateCoordinates {
+
+public:
+
+	/**
+	 * (neuron, CPPN coordinates) of the neurons of a robot, in neuron id order
+	 */
+	typedef std::vector<std::pair<boost::shared_ptr<NeuronRepresentation>,
+		std::vector<double> > > NeuronCoordinates;
+
+	/**
+	 * Root position of each part, by part id
+	 */
+	typedef std::map<std::string, osg::Vec3> PartPositions;
+
+	/**
+	 * @param maxBodies number of bodies whose part positions are kept
+	 */
+	SubstrateCoordinates(unsigned int maxBodies = 256);
+
+	virtual ~SubstrateCoordinates();
+
+	/**
+	 * Gets the coordinates of every neuron of the robot: the x and y position
+	 * of its body part, scaled to roughly [-1,1], and its io id / 10.
+	 * Safe to call from several threads.
+	 * @return false if the robot can't be built
+	 */
+	bool getNeuronCoordinates(RobotRepresentation &robot,
+			NeuronCoordinates &coordinates);
+
+	/**
+	 * @return the root position of every part of the robot, or an empty
+	 * pointer if the robot can't be built.
+	 * Safe to call from several threads.
+	 */
+	boost::shared_ptr<const PartPositions> getPartPositions(
+			const RobotRepresentation &robot);
+
+	/**
+	 * @return number of bodies whose part positions are memoised
+	 */
+	unsigned int getNumCachedBodies();
+
+private:
+
+	/**
+	 * @return a key identifying the body: ids, types, parameters,
+	 * orientations and attachment slots of all parts
+	 */
+	static std::string getBodyKey(const RobotRepresentation &robot);
+
+	/**
+	 * Builds the robot in a throwaway ODE world and reads the root position
+	 * of its parts, holding BodyVerifier::odeMutex
+	 * @return false if the robot can't be built
+	 */
+	static bool getOdePartPositions(const RobotRepresentation &robot,
+			PartPositions &positions);
+
+	unsigned int maxBodies_;
+
+	std::map<std::string, boost::shared_ptr<const PartPositions> > cache_;
+
+	boost::mutex cacheMutex_;
+
+};
+
+} /* namespace robogen */
+
+#endif /* SUBSTRATECOORDINATES_H_ */
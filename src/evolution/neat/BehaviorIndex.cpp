@@ -0,0 +1,191 @@
+///////////////////////////////////////////////////////////////////////////////////////////
+//    MultiNEAT - Python/C++ NeuroEvolution of Augmenting Topologies Library
+//
+//    Copyright (C) 2012 Peter Chervenski
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with this program.  If not, see < http://www.gnu.org/licenses/ >.
+//
+//    Contact info:
+//
+//    Peter Chervenski < spookey@abv.bg >
+//    Shane Ryan < shane.mcdonald.ryan@gmail.com >
+///////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+// File:        BehaviorIndex.cpp
+// Description: Implementation of the vantage point tree over the novelty
+//              search behavior archive.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+
+#include "BehaviorIndex.h"
+
+
+namespace NEAT
+{
+
+// The tree is rebuilt once the entries appended since the last build
+// outnumber this plus a fraction of the indexed ones
+const unsigned int MIN_UNINDEXED_BEHAVIORS = 64;
+const unsigned int UNINDEXED_BEHAVIORS_DIVISOR = 8;
+
+
+BehaviorIndex::BehaviorIndex()
+{
+    m_Root = -1;
+    m_NumIndexed = 0;
+}
+
+
+// Removes all entries
+void BehaviorIndex::Clear()
+{
+    m_Nodes.clear();
+    m_Root = -1;
+    m_NumIndexed = 0;
+}
+
+
+// Brings the index up to date with the archive
+void BehaviorIndex::Update(std::vector<PhenotypeBehavior>& a_Archive, PhenotypeBehavior* a_Metric)
+{
+    // the archive was cleared or replaced
+    if (a_Archive.size() < m_NumIndexed)
+    {
+        Clear();
+    }
+
+    const unsigned int t_unindexed = a_Archive.size() - m_NumIndexed;
+    if (t_unindexed > MIN_UNINDEXED_BEHAVIORS + m_NumIndexed / UNINDEXED_BEHAVIORS_DIVISOR)
+    {
+        Build(a_Archive, a_Metric);
+    }
+}
+
+
+void BehaviorIndex::Build(std::vector<PhenotypeBehavior>& a_Archive, PhenotypeBehavior* a_Metric)
+{
+    m_Nodes.clear();
+    m_Nodes.reserve(a_Archive.size());
+
+    // (distance to the current vantage point, archive index)
+    std::vector< std::pair<double, unsigned int> > t_items(a_Archive.size());
+    for(unsigned int i=0; i<a_Archive.size(); i++)
+    {
+        t_items[i] = std::make_pair(0.0, i);
+    }
+
+    m_Root = BuildNode(a_Archive, a_Metric, t_items, 0, t_items.size());
+    m_NumIndexed = a_Archive.size();
+}
+
+
+int BehaviorIndex::BuildNode(std::vector<PhenotypeBehavior>& a_Archive, PhenotypeBehavior* a_Metric,
+                             std::vector< std::pair<double, unsigned int> >& a_Items,
+                             unsigned int a_Begin, unsigned int a_End)
+{
+    if (a_Begin >= a_End)
+    {
+        return -1;
+    }
+
+    // the first entry of the range is the vantage point
+    Node t_node;
+    t_node.m_Item = a_Items[a_Begin].second;
+    t_node.m_Radius = 0;
+    t_node.m_Inside = -1;
+    t_node.m_Outside = -1;
+
+    const int t_idx = m_Nodes.size();
+    m_Nodes.push_back(t_node);
+
+    const unsigned int t_begin = a_Begin + 1;
+    if (t_begin == a_End)
+    {
+        return t_idx;
+    }
+
+    // measure from the vantage point with the derived class' metric
+    PhenotypeBehavior& t_vantage = a_Archive[t_node.m_Item];
+    a_Metric->m_Data.swap(t_vantage.m_Data);
+    for(unsigned int i=t_begin; i<a_End; i++)
+    {
+        a_Items[i].first = a_Metric->Distance_To(&a_Archive[a_Items[i].second]);
+    }
+    a_Metric->m_Data.swap(t_vantage.m_Data);
+
+    // split the rest at the median distance
+    const unsigned int t_median = t_begin + (a_End - t_begin) / 2;
+    std::nth_element(a_Items.begin() + t_begin, a_Items.begin() + t_median, a_Items.begin() + a_End);
+    const double t_radius = a_Items[t_median].first;
+
+    const int t_inside = BuildNode(a_Archive, a_Metric, a_Items, t_begin, t_median);
+    const int t_outside = BuildNode(a_Archive, a_Metric, a_Items, t_median, a_End);
+
+    m_Nodes[t_idx].m_Radius = t_radius;
+    m_Nodes[t_idx].m_Inside = t_inside;
+    m_Nodes[t_idx].m_Outside = t_outside;
+
+    return t_idx;
+}
+
+
+// Pushes the distances to the nearest archive entries
+void BehaviorIndex::Nearest(PhenotypeBehavior* a_Behavior, std::vector<PhenotypeBehavior>& a_Archive,
+                            unsigned int a_K, std::priority_queue<double>& a_Nearest) const
+{
+    Search(m_Root, a_Behavior, a_Archive, a_K, a_Nearest);
+
+    // the entries appended since the tree was built
+    for(unsigned int i=m_NumIndexed; i<a_Archive.size(); i++)
+    {
+        PushNearest(a_Behavior->Distance_To(&a_Archive[i]), a_K, a_Nearest);
+    }
+}
+
+
+void BehaviorIndex::Search(int a_Node, PhenotypeBehavior* a_Behavior, std::vector<PhenotypeBehavior>& a_Archive,
+                           unsigned int a_K, std::priority_queue<double>& a_Nearest) const
+{
+    if (a_Node == -1)
+    {
+        return;
+    }
+
+    const Node& t_node = m_Nodes[a_Node];
+    const double t_distance = a_Behavior->Distance_To(&a_Archive[t_node.m_Item]);
+    PushNearest(t_distance, a_K, a_Nearest);
+
+    // Entries inside the radius are at least (distance - radius) away, entries
+    // outside at least (radius - distance). Ties are searched too so that equal
+    // distances are found whatever their position in the tree.
+    if (t_distance < t_node.m_Radius)
+    {
+        if ((a_Nearest.size() < a_K) || (t_distance - a_Nearest.top() <= t_node.m_Radius))
+            Search(t_node.m_Inside, a_Behavior, a_Archive, a_K, a_Nearest);
+        if ((a_Nearest.size() < a_K) || (t_distance + a_Nearest.top() >= t_node.m_Radius))
+            Search(t_node.m_Outside, a_Behavior, a_Archive, a_K, a_Nearest);
+    }
+    else
+    {
+        if ((a_Nearest.size() < a_K) || (t_distance + a_Nearest.top() >= t_node.m_Radius))
+            Search(t_node.m_Outside, a_Behavior, a_Archive, a_K, a_Nearest);
+        if ((a_Nearest.size() < a_K) || (t_distance - a_Nearest.top() <= t_node.m_Radius))
+            Search(t_node.m_Inside, a_Behavior, a_Archive, a_K, a_Nearest);
+    }
+}
+
+
+} // namespace NEAT
@@ -0,0 +1,131 @@
+#ifndef _BEHAVIOR_INDEX_H
+#define _BEHAVIOR_INDEX_H
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//    MultiNEAT - Python/C++ NeuroEvolution of Augmenting Topologies Library
+//
+//    Copyright (C) 2012 Peter Chervenski
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with this program.  If not, see < http://www.gnu.org/licenses/ >.
+//
+//    Contact info:
+//
+//    Peter Chervenski < spookey@abv.bg >
+//    Shane Ryan < shane.mcdonald.ryan@gmail.com >
+///////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+// File:        BehaviorIndex.h
+// Description: Vantage point tree over the novelty search behavior archive.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <vector>
+#include <queue>
+
+#include "PhenotypeBehavior.h"
+
+
+namespace NEAT
+{
+
+//////////////////////////////////////////////////////////////////
+// Vantage point tree over the behaviors of an archive, used to
+// find the nearest neighbours of a behavior without measuring the
+// distance to every entry. Only relies on Distance_To(), which must
+// be a metric (symmetric and satisfying the triangle inequality).
+//
+// The archive holds its behaviors as base class copies, so distances
+// between archive entries are measured by a behavior of the derived
+// class passed to Update(), temporarily given the data of one of them.
+//
+// The archive is only referenced by index, so it can keep growing:
+// entries appended since the tree was built are scanned linearly
+// until there are enough of them to make rebuilding worthwhile.
+//////////////////////////////////////////////////////////////////
+class BehaviorIndex
+{
+public:
+
+    BehaviorIndex();
+
+    // Removes all entries
+    void Clear();
+
+    // Brings the index up to date with the archive. Must be called after the
+    // archive changed and before querying, never concurrently with queries.
+    // a_Metric is any behavior of the class used by the population, its data
+    // is left unchanged.
+    void Update(std::vector<PhenotypeBehavior>& a_Archive, PhenotypeBehavior* a_Metric);
+
+    // Pushes on a_Nearest, a max-heap kept to at most a_K distances, the distances
+    // from a_Behavior to the archive entries nearest to it.
+    // Safe to call from several threads.
+    void Nearest(PhenotypeBehavior* a_Behavior, std::vector<PhenotypeBehavior>& a_Archive,
+                 unsigned int a_K, std::priority_queue<double>& a_Nearest) const;
+
+    // Number of archive entries in the tree
+    unsigned int NumIndexed() const
+    {
+        return m_NumIndexed;
+    }
+
+private:
+
+    struct Node
+    {
+        // index of the vantage point in the archive
+        unsigned int m_Item;
+
+        // median distance from the vantage point to the entries below it
+        double m_Radius;
+
+        // children holding the entries within and beyond the radius, -1 if none
+        int m_Inside, m_Outside;
+    };
+
+    std::vector<Node> m_Nodes;
+    int m_Root;
+
+    // number of archive entries in the tree, the following ones are not indexed yet
+    unsigned int m_NumIndexed;
+
+    void Build(std::vector<PhenotypeBehavior>& a_Archive, PhenotypeBehavior* a_Metric);
+
+    int BuildNode(std::vector<PhenotypeBehavior>& a_Archive, PhenotypeBehavior* a_Metric,
+                  std::vector< std::pair<double, unsigned int> >& a_Items,
+                  unsigned int a_Begin, unsigned int a_End);
+
+    void Search(int a_Node, PhenotypeBehavior* a_Behavior, std::vector<PhenotypeBehavior>& a_Archive,
+                unsigned int a_K, std::priority_queue<double>& a_Nearest) const;
+};
+
+
+// Pushes a distance on a max-heap of the a_K smallest ones
+inline void PushNearest(double a_Distance, unsigned int a_K, std::priority_queue<double>& a_Nearest)
+{
+    if (a_Nearest.size() < a_K)
+    {
+        a_Nearest.push(a_Distance);
+    }
+    else if ((a_K > 0) && (a_Distance < a_Nearest.top()))
+    {
+        a_Nearest.pop();
+        a_Nearest.push(a_Distance);
+    }
+}
+
+
+} // namespace NEAT
+
+#endif
@@ -0,0 +1,317 @@
+///////////////////////////////////////////////////////////////////////////////////////////
+//    MultiNEAT - Python/C++ NeuroEvolution of Augmenting Topologies Library
+//
+//    Copyright (C) 2012 Peter Chervenski
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with this program.  If not, see < http://www.gnu.org/licenses/ >.
+//
+//    Contact info:
+//
+//    Peter Chervenski < spookey@abv.bg >
+//    Shane Ryan < shane.mcdonald.ryan@gmail.com >
+///////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+// File:        Compatibility.cpp
+// Description: Implementation of the compact gene arrays and of the cached
+//              compatibility distances used for speciation.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <boost/functional/hash.hpp>
+
+#include "Compatibility.h"
+#include "Genome.h"
+#include "Parameters.h"
+
+
+namespace NEAT
+{
+
+
+GeneSignature::GeneSignature()
+{
+    m_ID = 0;
+    m_Hash = 0;
+}
+
+
+GeneSignature::GeneSignature(const Genome& a_Genome)
+{
+    m_ID = a_Genome.GetID();
+    m_Hash = 0;
+
+    const unsigned int t_num_links = a_Genome.NumLinks();
+    m_LinkInnovations.resize(t_num_links);
+    m_LinkWeights.resize(t_num_links);
+    for(unsigned int i=0; i<t_num_links; i++)
+    {
+        const LinkGene& t_link = a_Genome.GetLinkByIndex(i);
+        m_LinkInnovations[i] = t_link.InnovationID();
+        m_LinkWeights[i] = t_link.GetWeight();
+
+        boost::hash_combine(m_Hash, m_LinkInnovations[i]);
+        boost::hash_combine(m_Hash, m_LinkWeights[i]);
+    }
+
+    const unsigned int t_num_neurons = a_Genome.NumNeurons();
+    m_NeuronIDs.resize(t_num_neurons);
+    m_NeuronCompared.resize(t_num_neurons);
+    m_A.resize(t_num_neurons);
+    m_B.resize(t_num_neurons);
+    m_TimeConstant.resize(t_num_neurons);
+    m_Bias.resize(t_num_neurons);
+    m_ActFunction.resize(t_num_neurons);
+    m_NeuronIndex.resize(t_num_neurons);
+    for(unsigned int i=0; i<t_num_neurons; i++)
+    {
+        const NeuronGene& t_neuron = a_Genome.GetNeuronByIndex(i);
+        m_NeuronIDs[i] = t_neuron.ID();
+        m_NeuronCompared[i] = (t_neuron.Type() != INPUT) && (t_neuron.Type() != BIAS);
+        m_A[i] = t_neuron.m_A;
+        m_B[i] = t_neuron.m_B;
+        m_TimeConstant[i] = t_neuron.m_TimeConstant;
+        m_Bias[i] = t_neuron.m_Bias;
+        m_ActFunction[i] = static_cast<int>(t_neuron.m_ActFunction);
+        m_NeuronIndex[i] = std::make_pair(m_NeuronIDs[i], i);
+
+        boost::hash_combine(m_Hash, m_NeuronIDs[i]);
+        boost::hash_combine(m_Hash, static_cast<bool>(m_NeuronCompared[i]));
+        boost::hash_combine(m_Hash, m_A[i]);
+        boost::hash_combine(m_Hash, m_B[i]);
+        boost::hash_combine(m_Hash, m_TimeConstant[i]);
+        boost::hash_combine(m_Hash, m_Bias[i]);
+        boost::hash_combine(m_Hash, m_ActFunction[i]);
+    }
+
+    // ties are broken by position, so a lookup finds the first neuron
+    // with the ID like Genome::GetNeuronByID does
+    std::sort(m_NeuronIndex.begin(), m_NeuronIndex.end());
+}
+
+
+// Returns the position of the neuron with the given ID, -1 if not present
+int GeneSignature::FindNeuron(unsigned int a_ID) const
+{
+    std::vector< std::pair<unsigned int, unsigned int> >::const_iterator t_it =
+            std::lower_bound(m_NeuronIndex.begin(), m_NeuronIndex.end(), std::make_pair(a_ID, 0u));
+
+    if ((t_it == m_NeuronIndex.end()) || (t_it->first != a_ID))
+    {
+        return -1;
+    }
+    return static_cast<int>(t_it->second);
+}
+
+
+
+CompatibilityTerms::CompatibilityTerms()
+{
+    m_NumExcess = 0;
+    m_NumDisjoint = 0;
+    m_NumMatchingLinks = 0;
+    m_NumMatchingNeurons = 0;
+
+    m_TotalWeightDifference = 0.0;
+    m_TotalADifference = 0.0;
+    m_TotalBDifference = 0.0;
+    m_TotalTimeConstantDifference = 0.0;
+    m_TotalBiasDifference = 0.0;
+    m_TotalNumActivationDifference = 0.0;
+}
+
+
+CompatibilityTerms::CompatibilityTerms(const GeneSignature& a_G1, const GeneSignature& a_G2)
+{
+    m_NumExcess = 0;
+    m_NumDisjoint = 0;
+    m_NumMatchingLinks = 0;
+    m_NumMatchingNeurons = 0;
+
+    m_TotalWeightDifference = 0.0;
+    m_TotalADifference = 0.0;
+    m_TotalBDifference = 0.0;
+    m_TotalTimeConstantDifference = 0.0;
+    m_TotalBiasDifference = 0.0;
+    m_TotalNumActivationDifference = 0.0;
+
+    // Step through the link genes until both genomes end
+    const unsigned int t_size1 = a_G1.m_LinkInnovations.size();
+    const unsigned int t_size2 = a_G2.m_LinkInnovations.size();
+    unsigned int t_g1 = 0;
+    unsigned int t_g2 = 0;
+
+    while((t_g1 < t_size1) && (t_g2 < t_size2))
+    {
+        const unsigned int t_g1innov = a_G1.m_LinkInnovations[t_g1];
+        const unsigned int t_g2innov = a_G2.m_LinkInnovations[t_g2];
+
+        // matching genes?
+        if (t_g1innov == t_g2innov)
+        {
+            m_NumMatchingLinks++;
+
+            double t_wdiff = (a_G1.m_LinkWeights[t_g1] - a_G2.m_LinkWeights[t_g2]);
+            if (t_wdiff < 0) t_wdiff = -t_wdiff; // make sure it is positive
+
+            m_TotalWeightDifference += t_wdiff;
+            t_g1++;
+            t_g2++;
+        }
+        else if (t_g1innov < t_g2innov)
+        {
+            m_NumDisjoint++;
+            t_g1++;
+        }
+        else
+        {
+            m_NumDisjoint++;
+            t_g2++;
+        }
+    }
+
+    // whatever remains in either genome is excess
+    m_NumExcess += (t_size1 - t_g1) + (t_size2 - t_g2);
+
+    // find matching neuron IDs, no inputs considered for comparison
+    for(unsigned int i=0; i < a_G1.m_NeuronIDs.size(); i++)
+    {
+        if (!a_G1.m_NeuronCompared[i])
+        {
+            continue;
+        }
+
+        const int t_j = a_G2.FindNeuron(a_G1.m_NeuronIDs[i]);
+        if (t_j == -1)
+        {
+            continue;
+        }
+
+        // a match
+        m_NumMatchingNeurons++;
+
+        double t_A_difference = a_G1.m_A[i] - a_G2.m_A[t_j];
+        if (t_A_difference < 0.0f) t_A_difference = -t_A_difference;
+        m_TotalADifference += t_A_difference;
+
+        double t_B_difference = a_G1.m_B[i] - a_G2.m_B[t_j];
+        if (t_B_difference < 0.0f) t_B_difference = -t_B_difference;
+        m_TotalBDifference += t_B_difference;
+
+        double t_time_constant_difference = a_G1.m_TimeConstant[i] - a_G2.m_TimeConstant[t_j];
+        if (t_time_constant_difference < 0.0f) t_time_constant_difference = -t_time_constant_difference;
+        m_TotalTimeConstantDifference += t_time_constant_difference;
+
+        double t_bias_difference = a_G1.m_Bias[i] - a_G2.m_Bias[t_j];
+        if (t_bias_difference < 0.0f) t_bias_difference = -t_bias_difference;
+        m_TotalBiasDifference += t_bias_difference;
+
+        // Activation function type difference is found
+        if (a_G1.m_ActFunction[i] != a_G2.m_ActFunction[t_j])
+        {
+            m_TotalNumActivationDifference++;
+        }
+    }
+}
+
+
+// Returns the weighted distance
+double CompatibilityTerms::Distance(const Parameters& a_Parameters) const
+{
+    // choose between normalizing for genome size or not
+    double t_normalizer = 1.0;
+
+    // if there are no matching links, make it 1.0 to avoid divide error
+    double t_num_matching_links = m_NumMatchingLinks;
+    if (t_num_matching_links == 0)
+        t_num_matching_links = 1;
+
+    // if there are no matching neurons, make it 1.0 to avoid divide error
+    double t_num_matching_neurons = m_NumMatchingNeurons;
+    if (t_num_matching_neurons == 0)
+        t_num_matching_neurons = 1;
+
+    return
+        (a_Parameters.ExcessCoeff                 * (m_NumExcess   / t_normalizer)) +
+        (a_Parameters.DisjointCoeff               * (m_NumDisjoint / t_normalizer)) +
+        (a_Parameters.WeightDiffCoeff             * (m_TotalWeightDifference / t_num_matching_links)) +
+        (a_Parameters.ActivationADiffCoeff        * (m_TotalADifference / t_num_matching_neurons)) +
+        (a_Parameters.ActivationBDiffCoeff        * (m_TotalBDifference / t_num_matching_neurons)) +
+        (a_Parameters.TimeConstantDiffCoeff       * (m_TotalTimeConstantDifference / t_num_matching_neurons)) +
+        (a_Parameters.BiasDiffCoeff               * (m_TotalBiasDifference / t_num_matching_neurons)) +
+        (a_Parameters.ActivationFunctionDiffCoeff * (m_TotalNumActivationDifference / t_num_matching_neurons));
+}
+
+
+// Returns true if the two genomes belong in the same species
+bool IsCompatible(const GeneSignature& a_G1, const GeneSignature& a_G2,
+                  const CompatibilityTerms& a_Terms, const Parameters& a_Parameters)
+{
+    // full compatibility cases
+    if (a_G1.m_ID == a_G2.m_ID)
+        return true;
+
+    if ((a_G1.NumLinks() == 0) && (a_G2.NumLinks() == 0))
+        return true;
+
+    return (a_Terms.Distance(a_Parameters) <= a_Parameters.CompatTreshold);
+}
+
+
+
+bool CompatibilityCache::Find(const GeneSignature& a_G1, const GeneSignature& a_G2, CompatibilityTerms& a_Terms) const
+{
+    EntryMap::const_iterator t_it = m_Entries.find(MakeKey(a_G1, a_G2));
+    if (t_it == m_Entries.end())
+    {
+        return false;
+    }
+
+    a_Terms = t_it->second.m_Terms;
+    return true;
+}
+
+
+void CompatibilityCache::Store(const GeneSignature& a_G1, const GeneSignature& a_G2, const CompatibilityTerms& a_Terms, unsigned int a_Generation)
+{
+    Entry& t_entry = m_Entries[MakeKey(a_G1, a_G2)];
+    t_entry.m_Terms = a_Terms;
+    t_entry.m_LastUsed = a_Generation;
+}
+
+
+void CompatibilityCache::Prune(unsigned int a_Generation)
+{
+    EntryMap::iterator t_it = m_Entries.begin();
+    while(t_it != m_Entries.end())
+    {
+        if (t_it->second.m_LastUsed + 1 < a_Generation)
+        {
+            t_it = m_Entries.erase(t_it);
+        }
+        else
+        {
+            t_it++;
+        }
+    }
+}
+
+
+void CompatibilityCache::Clear()
+{
+    m_Entries.clear();
+}
+
+
+} // namespace NEAT
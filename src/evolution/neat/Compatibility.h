@@ -0,0 +1,185 @@
+#ifndef _COMPATIBILITY_H
+#define _COMPATIBILITY_H
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//    MultiNEAT - Python/C++ NeuroEvolution of Augmenting Topologies Library
+//
+//    Copyright (C) 2012 Peter Chervenski
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with this program.  If not, see < http://www.gnu.org/licenses/ >.
+//
+//    Contact info:
+//
+//    Peter Chervenski < spookey@abv.bg >
+//    Shane Ryan < shane.mcdonald.ryan@gmail.com >
+///////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+// File:        Compatibility.h
+// Description: Compact gene arrays and cached compatibility distances
+//              used for speciation.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <vector>
+#include <utility>
+#include <boost/unordered_map.hpp>
+
+
+namespace NEAT
+{
+
+// forward
+class Genome;
+class Parameters;
+
+
+//////////////////////////////////////////////////////////////////
+// Compact copy of the genes of a genome holding only what is
+// needed to compute compatibility distances, laid out as arrays
+//////////////////////////////////////////////////////////////////
+class GeneSignature
+{
+public:
+
+    // ID of the genome
+    unsigned int m_ID;
+
+    // Link genes in genome order
+    std::vector<unsigned int> m_LinkInnovations;
+    std::vector<double> m_LinkWeights;
+
+    // Neuron genes in genome order
+    std::vector<unsigned int> m_NeuronIDs;
+    std::vector<bool> m_NeuronCompared; // false for inputs and bias
+    std::vector<double> m_A, m_B;
+    std::vector<double> m_TimeConstant;
+    std::vector<double> m_Bias;
+    std::vector<int> m_ActFunction;
+
+    // (neuron ID, position in the arrays above) sorted by ID for lookups
+    std::vector< std::pair<unsigned int, unsigned int> > m_NeuronIndex;
+
+    // Hash of all the genes above, excluding the ID
+    std::size_t m_Hash;
+
+    ////////////////////////////
+    // Constructors
+    ////////////////////////////
+
+    GeneSignature();
+    explicit GeneSignature(const Genome& a_Genome);
+
+    ////////////////////////////
+    // Methods
+    ////////////////////////////
+
+    unsigned int NumLinks() const
+    {
+        return m_LinkInnovations.size();
+    }
+
+    // Returns the position of the neuron with the given ID, -1 if not present
+    int FindNeuron(unsigned int a_ID) const;
+};
+
+
+//////////////////////////////////////////////////////////////////
+// The terms of the compatibility distance between two genomes,
+// before they are weighted by the coefficients in the parameters
+//////////////////////////////////////////////////////////////////
+class CompatibilityTerms
+{
+public:
+
+    double m_NumExcess;
+    double m_NumDisjoint;
+    double m_NumMatchingLinks;
+    double m_NumMatchingNeurons;
+
+    double m_TotalWeightDifference;
+    double m_TotalADifference;
+    double m_TotalBDifference;
+    double m_TotalTimeConstantDifference;
+    double m_TotalBiasDifference;
+    double m_TotalNumActivationDifference;
+
+    CompatibilityTerms();
+
+    // Computes the terms between a_G1 and a_G2, the same way
+    // Genome::CompatibilityDistance always did
+    CompatibilityTerms(const GeneSignature& a_G1, const GeneSignature& a_G2);
+
+    // Returns the weighted distance
+    double Distance(const Parameters& a_Parameters) const;
+};
+
+
+// Returns true if the two genomes belong in the same species
+// Same rules as Genome::IsCompatibleWith
+bool IsCompatible(const GeneSignature& a_G1, const GeneSignature& a_G2,
+                  const CompatibilityTerms& a_Terms, const Parameters& a_Parameters);
+
+
+//////////////////////////////////////////////////////////////////
+// Caches the compatibility terms of pairs of genomes, keyed by the
+// IDs and the hashes of the genes of both, so that comparisons with
+// representatives that did not change are not repeated every epoch.
+// Genomes with different IDs never share an entry, even if the
+// hashes of their genes collide.
+//////////////////////////////////////////////////////////////////
+class CompatibilityCache
+{
+public:
+
+    // (ID, hash of the genes) of a genome
+    typedef std::pair<unsigned int, std::size_t> GenomeKey;
+    typedef std::pair<GenomeKey, GenomeKey> Key;
+
+    // Safe to call from several threads as long as nobody stores or prunes
+    bool Find(const GeneSignature& a_G1, const GeneSignature& a_G2, CompatibilityTerms& a_Terms) const;
+
+    // Stores the terms and marks the entry as used in a_Generation
+    void Store(const GeneSignature& a_G1, const GeneSignature& a_G2, const CompatibilityTerms& a_Terms, unsigned int a_Generation);
+
+    // Removes the entries that were not used in a_Generation or the one before
+    void Prune(unsigned int a_Generation);
+
+    void Clear();
+
+    unsigned int Size() const
+    {
+        return m_Entries.size();
+    }
+
+private:
+
+    struct Entry
+    {
+        CompatibilityTerms m_Terms;
+        unsigned int m_LastUsed;
+    };
+
+    static Key MakeKey(const GeneSignature& a_G1, const GeneSignature& a_G2)
+    {
+        return Key(GenomeKey(a_G1.m_ID, a_G1.m_Hash), GenomeKey(a_G2.m_ID, a_G2.m_Hash));
+    }
+
+    typedef boost::unordered_map<Key, Entry> EntryMap;
+    EntryMap m_Entries;
+};
+
+
+} // namespace NEAT
+
+#endif
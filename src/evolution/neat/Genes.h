@@ -101,6 +101,13 @@ class LinkGene
 
 private:
 
+    // The members are ordered by size so that the genes of a genome
+    // are packed without padding
+
+    // This variable is modified during evolution
+    // The weight of the connection
+    double m_Weight;
+
     // These variables are initialized once and cannot be changed
     // anymore
 
@@ -110,10 +117,6 @@ private:
     // The link's innovation ID
     unsigned int m_InnovationID;
 
-    // This variable is modified during evolution
-    // The weight of the connection
-    double m_Weight;
-
     // Is it recurrent?
     bool m_IsRecurrent;
 
@@ -149,26 +152,14 @@ public:
     // Constructors
     ////////////////
     LinkGene(unsigned int a_InID, unsigned int a_OutID, unsigned int a_InnovID, double a_Wgt, bool a_Recurrent = false):
-        m_FromNeuronID(a_InID), m_ToNeuronID(a_OutID), m_InnovationID(a_InnovID), m_Weight(a_Wgt), m_IsRecurrent(a_Recurrent)
+        m_Weight(a_Wgt), m_FromNeuronID(a_InID), m_ToNeuronID(a_OutID), m_InnovationID(a_InnovID), m_IsRecurrent(a_Recurrent)
     {}
 
     LinkGene()
     {}
 
-    // assigment operator
-    LinkGene& operator =(const LinkGene& a_g)
-    {
-        if (this != &a_g)
-        {
-            m_FromNeuronID = a_g.m_FromNeuronID;
-            m_ToNeuronID = a_g.m_ToNeuronID;
-            m_Weight = a_g.m_Weight;
-            m_IsRecurrent = a_g.m_IsRecurrent;
-            m_InnovationID = a_g.m_InnovationID;
-        }
-
-        return *this;
-    }
+    // The genes are copied member by member (with memcpy by std::vector),
+    // so they must not define their own copy operations
 
     //////////////
     // Destructor
@@ -191,6 +182,15 @@ public:
     {
         return m_InnovationID;
     }
+
+    // Renumbers the link once the innovations of its genome are merged
+    // into the population's innovation database
+    void Renumber(unsigned int a_FromNeuronID, unsigned int a_ToNeuronID, unsigned int a_InnovationID)
+    {
+        m_FromNeuronID = a_FromNeuronID;
+        m_ToNeuronID = a_ToNeuronID;
+        m_InnovationID = a_InnovationID;
+    }
     bool IsRecurrent() const
     {
         return m_IsRecurrent;
@@ -247,10 +247,14 @@ public:
     // These variables are modified during evolution
     // Safe to access directly
 
+    // The evolved parameters of a neuron are stored in single precision,
+    // which is plenty for values mutated by random perturbations and keeps
+    // the genes of the whole population small
+
     // useful for displaying the genome
     int x, y;
     // Position (depth) within the network
-    double m_SplitY;
+    float m_SplitY;
 
 
     /////////////////////////////////////////////////////////
@@ -276,15 +280,15 @@ public:
     // Sine    : using A    (frequency, phase)
     // Square  : using A, B (high phase lenght, low phase length)
     // Linear  : using B    (shift)
-    double m_A, m_B;
+    float m_A, m_B;
 
     // Time constant value used when
     // the neuron is activating in leaky integrator mode
-    double m_TimeConstant;
+    float m_TimeConstant;
 
     // Bias value used when the neuron is activating in
     // leaky integrator mode
-    double m_Bias;
+    float m_Bias;
 
     // The type of activation function the neuron has
     ActivationFunction m_ActFunction;
@@ -335,25 +339,7 @@ public:
         m_ActFunction = UNSIGNED_SIGMOID;
     }
 
-    // assigment operator
-    NeuronGene& operator =(const NeuronGene& a_g)
-    {
-        if (this != &a_g)
-        {
-            m_ID = a_g.m_ID;
-            m_Type = a_g.m_Type;
-            m_SplitY = a_g.m_SplitY;
-            x = a_g.x;
-            y = a_g.y;
-            m_A = a_g.m_A;
-            m_B = a_g.m_B;
-            m_TimeConstant = a_g.m_TimeConstant;
-            m_Bias = a_g.m_Bias;
-            m_ActFunction = a_g.m_ActFunction;
-        }
-
-        return *this;
-    }
+    // Copied member by member, like the link genes
 
 
     //////////////
@@ -378,6 +364,13 @@ public:
         return m_SplitY;
     }
 
+    // Renumbers the neuron once the innovations of its genome are merged
+    // into the population's innovation database
+    void Renumber(unsigned int a_ID)
+    {
+        m_ID = a_ID;
+    }
+
     // Initializing
     void Init(double a_A, double a_B, double a_TimeConstant, double a_Bias, ActivationFunction a_ActFunc)
     {
@@ -35,6 +35,7 @@
 #include <math.h>
 #include <utility>
 #include <boost/unordered_map.hpp>
+#include <boost/bind.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/accumulators/accumulators.hpp>
 //#include <boost/accumulators/statistics.hpp>
@@ -42,10 +43,12 @@
 #include <boost/accumulators/statistics/variance.hpp>
 
 #include "Genome.h"
+#include "Compatibility.h"
 #include "Random.h"
 #include "Utils.h"
 #include "Parameters.h"
 #include "Assert.h"
+#include "utils/ParallelFor.h"
 
 namespace NEAT
 {
@@ -79,48 +82,6 @@ Genome::Genome()
 }
 
 
-// Copy constructor
-Genome::Genome(const Genome& a_G)
-{
-    m_ID          = a_G.m_ID;
-    m_Depth       = a_G.m_Depth;
-    m_NeuronGenes = a_G.m_NeuronGenes;
-    m_LinkGenes   = a_G.m_LinkGenes;
-    m_Fitness     = a_G.m_Fitness;
-    m_NumInputs   = a_G.m_NumInputs;
-    m_NumOutputs  = a_G.m_NumOutputs;
-    m_AdjustedFitness = a_G.m_AdjustedFitness;
-    m_OffspringAmount = a_G.m_OffspringAmount;
-    m_Evaluated = a_G.m_Evaluated;
-    m_PhenotypeBehavior = a_G.m_PhenotypeBehavior;
-    Performance = a_G.Performance;
-    Length = a_G.Length;
-}
-
-// assignment operator
-Genome& Genome::operator =(const Genome& a_G)
-{
-    // self assignment guard
-    if (this != &a_G)
-    {
-        m_ID          = a_G.m_ID;
-        m_Depth       = a_G.m_Depth;
-        m_NeuronGenes = a_G.m_NeuronGenes;
-        m_LinkGenes   = a_G.m_LinkGenes;
-        m_Fitness     = a_G.m_Fitness;
-        m_AdjustedFitness = a_G.m_AdjustedFitness;
-        m_NumInputs   = a_G.m_NumInputs;
-        m_NumOutputs  = a_G.m_NumOutputs;
-        m_OffspringAmount = a_G.m_OffspringAmount;
-        m_Evaluated = a_G.m_Evaluated;
-        m_PhenotypeBehavior = a_G.m_PhenotypeBehavior;
-        Performance = a_G.Performance;
-        Length = a_G.Length;
-    }
-
-    return *this;
-}
-
 Genome::Genome(unsigned int a_ID,
                unsigned int a_NumInputs,
                unsigned int a_NumHidden, // ignored for seed type == 0, specifies number of hidden units if seed type == 1
@@ -1034,149 +995,92 @@ bool Genome::CompatCompare(Genome &ls, Genome &rs)
 // Returns the absolute distance between this genome and a_G
 double Genome::CompatibilityDistance(Genome &a_G, Parameters& a_Parameters)
 {
-    // iterators for moving through the genomes' genes
-    std::vector<LinkGene>::iterator t_g1;
-    std::vector<LinkGene>::iterator t_g2;
-
-    // this variable is the total distance between the genomes
-    // if it passes beyond the compatibility treshold, the function returns false
-    double t_total_distance = 0.0;
+    // Only two genomes are compared, so walk their genes directly instead of
+    // building compact copies. This adds up the same terms, in the same order,
+    // as CompatibilityTerms does for the signatures.
+    CompatibilityTerms t_terms;
 
-    double t_total_weight_difference = 0.0;
-    double t_total_timeconstant_difference = 0.0;
-    double t_total_bias_difference = 0.0;
-    double t_total_A_difference = 0.0;
-    double t_total_B_difference = 0.0;
-    double t_total_num_activation_difference = 0.0;
+    // iterators for moving through the genomes' genes
+    std::vector<LinkGene>::const_iterator t_g1 = m_LinkGenes.begin();
+    std::vector<LinkGene>::const_iterator t_g2 = a_G.m_LinkGenes.begin();
 
-    // count of matching genes
-    double t_num_excess   = 0;
-    double t_num_disjoint = 0;
-    double t_num_matching_links = 0;
-    double t_num_matching_neurons = 0;
+    // Step through the genes until one genome ends
+    while((t_g1 != m_LinkGenes.end()) && (t_g2 != a_G.m_LinkGenes.end()))
+    {
+        // extract the innovation numbers
+        int t_g1innov = t_g1->InnovationID();
+        int t_g2innov = t_g2->InnovationID();
 
-    // used for percentage of excess/disjoint genes calculation
-    //int t_max_genome_size = static_cast<int> (NumLinks()   < a_G.NumLinks())   ? (a_G.NumLinks())   : (NumLinks());
-    //int t_max_neurons     = static_cast<int> (NumNeurons() < a_G.NumNeurons()) ? (a_G.NumNeurons()) : (NumNeurons());
+        // matching genes?
+        if (t_g1innov == t_g2innov)
+        {
+            t_terms.m_NumMatchingLinks++;
 
-    t_g1 = m_LinkGenes.begin();
-    t_g2 = a_G.m_LinkGenes.begin();
+            double t_wdiff = (t_g1->GetWeight() - t_g2->GetWeight());
+            if (t_wdiff < 0) t_wdiff = -t_wdiff; // make sure it is positive
 
-    // Step through the genes until both genomes end
-    while( ! ((t_g1 == m_LinkGenes.end()) && ((t_g2 == a_G.m_LinkGenes.end()))) )
-    {
-        // end of first genome?
-        if (t_g1 == m_LinkGenes.end())
-        {
-            // add to the total distance
-            t_num_excess++;
+            t_terms.m_TotalWeightDifference += t_wdiff;
+            t_g1++;
             t_g2++;
         }
-        else if
-        // end of second genome?
-        (t_g2 == a_G.m_LinkGenes.end())
+        else if (t_g1innov < t_g2innov)
         {
-            // add to the total distance
-            t_num_excess++;
+            t_terms.m_NumDisjoint++;
             t_g1++;
         }
         else
         {
-            // extract the innovation numbers
-            int t_g1innov = t_g1->InnovationID();
-            int t_g2innov = t_g2->InnovationID();
-
-            // matching genes?
-            if (t_g1innov == t_g2innov)
-            {
-                t_num_matching_links++;
-
-                double t_wdiff = (t_g1->GetWeight() - t_g2->GetWeight());
-                if (t_wdiff < 0) t_wdiff = -t_wdiff; // make sure it is positive
-
-                t_total_weight_difference += t_wdiff;
-                t_g1++;
-                t_g2++;
-            }
-            else if
-            // disjoint
-            (t_g1innov < t_g2innov)
-            {
-                t_num_disjoint++;
-                t_g1++;
-            }
-            else if
-            // disjoint
-            (t_g1innov > t_g2innov)
-            {
-                t_num_disjoint++;
-                t_g2++;
-            }
+            t_terms.m_NumDisjoint++;
+            t_g2++;
         }
     }
 
-    // find matching neuron IDs
+    // whatever remains in either genome is excess
+    t_terms.m_NumExcess += (m_LinkGenes.end() - t_g1) + (a_G.m_LinkGenes.end() - t_g2);
+
+    // find matching neuron IDs, no inputs considered for comparison
     for(unsigned int i=0; i < NumNeurons(); i++)
     {
-        // no inputs considered for comparison
-        if ((m_NeuronGenes[i].Type() != INPUT) && (m_NeuronGenes[i].Type() != BIAS))
+        const NeuronGene& t_n1 = m_NeuronGenes[i];
+        if ((t_n1.Type() == INPUT) || (t_n1.Type() == BIAS))
         {
-            // a match
-            if (a_G.HasNeuronID( m_NeuronGenes[i].ID() ))
-            {
-                t_num_matching_neurons++;
-
-                double t_A_difference = m_NeuronGenes[i].m_A  - a_G.GetNeuronByID( m_NeuronGenes[i].ID()).m_A;
-                if (t_A_difference < 0.0f) t_A_difference = -t_A_difference;
-                t_total_A_difference += t_A_difference;
-
-                double t_B_difference = m_NeuronGenes[i].m_B  - a_G.GetNeuronByID( m_NeuronGenes[i].ID()).m_B;
-                if (t_B_difference < 0.0f) t_B_difference = -t_B_difference;
-                t_total_B_difference += t_B_difference;
-
-                double t_time_constant_difference = m_NeuronGenes[i].m_TimeConstant - a_G.GetNeuronByID( m_NeuronGenes[i].ID()).m_TimeConstant;
-                if (t_time_constant_difference < 0.0f) t_time_constant_difference = -t_time_constant_difference;
-                t_total_timeconstant_difference += t_time_constant_difference;
-
-                double t_bias_difference = m_NeuronGenes[i].m_Bias - a_G.GetNeuronByID( m_NeuronGenes[i].ID()).m_Bias;
-                if (t_bias_difference < 0.0f) t_bias_difference = -t_bias_difference;
-                t_total_bias_difference += t_bias_difference;
+            continue;
+        }
 
-                // Activation function type difference is found
-                if (m_NeuronGenes[i].m_ActFunction != a_G.GetNeuronByID( m_NeuronGenes[i].ID()).m_ActFunction)
-                {
-                    t_total_num_activation_difference++;
-                }
-            }
+        const int t_j = a_G.GetNeuronIndex(t_n1.ID());
+        if (t_j == -1)
+        {
+            continue;
         }
-    }
+        const NeuronGene& t_n2 = a_G.m_NeuronGenes[t_j];
 
+        // a match
+        t_terms.m_NumMatchingNeurons++;
 
-    // choose between normalizing for genome size or not
-    double t_normalizer = 1.0;//static_cast<double>(t_max_genome_size);
+        double t_A_difference = t_n1.m_A - t_n2.m_A;
+        if (t_A_difference < 0.0f) t_A_difference = -t_A_difference;
+        t_terms.m_TotalADifference += t_A_difference;
 
-    // if there are no matching links, make it 1.0 to avoid divide error
-    if (t_num_matching_links == 0)
-        t_num_matching_links = 1;
+        double t_B_difference = t_n1.m_B - t_n2.m_B;
+        if (t_B_difference < 0.0f) t_B_difference = -t_B_difference;
+        t_terms.m_TotalBDifference += t_B_difference;
 
-    // if there are no matching neurons, make it 1.0 to avoid divide error
-    if (t_num_matching_neurons == 0)
-        t_num_matching_neurons = 1;
+        double t_time_constant_difference = t_n1.m_TimeConstant - t_n2.m_TimeConstant;
+        if (t_time_constant_difference < 0.0f) t_time_constant_difference = -t_time_constant_difference;
+        t_terms.m_TotalTimeConstantDifference += t_time_constant_difference;
 
-    if (t_normalizer == 0)
-        t_normalizer = 1;
+        double t_bias_difference = t_n1.m_Bias - t_n2.m_Bias;
+        if (t_bias_difference < 0.0f) t_bias_difference = -t_bias_difference;
+        t_terms.m_TotalBiasDifference += t_bias_difference;
 
-    t_total_distance =
-        (a_Parameters.ExcessCoeff                 * (t_num_excess   / t_normalizer)) +
-        (a_Parameters.DisjointCoeff               * (t_num_disjoint / t_normalizer)) +
-        (a_Parameters.WeightDiffCoeff             * (t_total_weight_difference / t_num_matching_links)) +
-        (a_Parameters.ActivationADiffCoeff        * (t_total_A_difference / t_num_matching_neurons)) +
-        (a_Parameters.ActivationBDiffCoeff        * (t_total_B_difference / t_num_matching_neurons)) +
-        (a_Parameters.TimeConstantDiffCoeff       * (t_total_timeconstant_difference / t_num_matching_neurons)) +
-        (a_Parameters.BiasDiffCoeff               * (t_total_bias_difference / t_num_matching_neurons)) +
-        (a_Parameters.ActivationFunctionDiffCoeff * (t_total_num_activation_difference / t_num_matching_neurons));
+        // Activation function type difference is found
+        if (t_n1.m_ActFunction != t_n2.m_ActFunction)
+        {
+            t_terms.m_TotalNumActivationDifference++;
+        }
+    }
 
-    return t_total_distance;
+    return t_terms.Distance(a_Parameters);
 }
 
 // Returns true if this genome and a_G are compatible (belong in the same species)
@@ -2287,7 +2191,7 @@ void Genome::Mutate_NeuronBiases(Parameters& a_Parameters, RNG& a_RNG)
 // This is multipoint mating - genes inherited randomly
 // Disjoint and excess genes are inherited from the fittest parent
 // If fitness is equal, the smaller genome is assumed to be the better one
-Genome Genome::Mate(Genome& a_Dad, bool a_MateAverage, bool a_InterSpecies, RNG& a_RNG)
+Genome Genome::Mate(const Genome& a_Dad, bool a_MateAverage, bool a_InterSpecies, RNG& a_RNG) const
 {
     // Cannot mate with itself
     if (GetID() == a_Dad.GetID())
@@ -2304,8 +2208,8 @@ Genome Genome::Mate(Genome& a_Dad, bool a_MateAverage, bool a_InterSpecies, RNG&
 
     // create iterators so we can step through each parents genes and set
     // them to the first gene of each parent
-    std::vector<LinkGene>::iterator t_curMum = m_LinkGenes.begin();
-    std::vector<LinkGene>::iterator t_curDad = a_Dad.m_LinkGenes.begin();
+    std::vector<LinkGene>::const_iterator t_curMum = m_LinkGenes.begin();
+    std::vector<LinkGene>::const_iterator t_curDad = a_Dad.m_LinkGenes.begin();
 
     // this will hold a copy of the gene we wish to add at each step
     LinkGene t_selectedgene(0,0,-1,0,false);
@@ -2657,6 +2561,23 @@ void Genome::SortGenes()
     std::sort(m_LinkGenes.begin(), m_LinkGenes.end(), link_compare);
 }
 
+// Gives the genes the IDs their innovations got when merged
+void Genome::Renumber(const InnovationRemap& a_Remap)
+{
+    for(unsigned int i=0; i<m_NeuronGenes.size(); i++)
+    {
+        m_NeuronGenes[i].Renumber(a_Remap.NeuronID(m_NeuronGenes[i].ID()));
+    }
+    for(unsigned int i=0; i<m_LinkGenes.size(); i++)
+    {
+        m_LinkGenes[i].Renumber(a_Remap.NeuronID(m_LinkGenes[i].FromNeuronID()),
+                                a_Remap.NeuronID(m_LinkGenes[i].ToNeuronID()),
+                                a_Remap.InnovationNum(m_LinkGenes[i].InnovationID()));
+    }
+
+    SortGenes();
+}
+
 
 
 
@@ -2757,7 +2678,7 @@ Genome::Genome(const char* a_FileName)
 }
 
 // Builds the genome from an *opened* file
-Genome::Genome(std::ifstream& a_DataFile)
+Genome::Genome(std::istream& a_DataFile)
 {
     std::string t_Str;
 
@@ -2866,7 +2787,7 @@ void Genome::Save(FILE* a_file)
     for(unsigned int i=0; i<NumNeurons(); i++)
     {
         // Save neuron
-        fprintf(a_file, "Neuron %d %d %3.8f %d %3.8f %3.8f %3.8f %3.8f\n",
+        fprintf(a_file, "Neuron %d %d %.9g %d %.9g %.9g %.9g %.9g\n",
                 m_NeuronGenes[i].ID(), static_cast<int>(m_NeuronGenes[i].Type()), m_NeuronGenes[i].SplitY(),
                 static_cast<int>(m_NeuronGenes[i].m_ActFunction), m_NeuronGenes[i].m_A, m_NeuronGenes[i].m_B, m_NeuronGenes[i].m_TimeConstant, m_NeuronGenes[i].m_Bias);
     }
@@ -2874,12 +2795,44 @@ void Genome::Save(FILE* a_file)
     // loop over the connections and save each one
     for(unsigned int i=0; i<NumLinks(); i++)
     {
-        fprintf(a_file, "Link %d %d %d %d %3.8f\n", m_LinkGenes[i].FromNeuronID(), m_LinkGenes[i].ToNeuronID(), m_LinkGenes[i].InnovationID(), static_cast<int>(m_LinkGenes[i].IsRecurrent()), m_LinkGenes[i].GetWeight());
+        fprintf(a_file, "Link %d %d %d %d %.17g\n", m_LinkGenes[i].FromNeuronID(), m_LinkGenes[i].ToNeuronID(), m_LinkGenes[i].InnovationID(), static_cast<int>(m_LinkGenes[i].IsRecurrent()), m_LinkGenes[i].GetWeight());
     }
 
     fprintf(a_file, "GenomeEnd\n\n");
 }
 
+// Saves this genome and its state to an already opened file for writing
+void Genome::SaveState(FILE* a_file)
+{
+    fprintf(a_file, "GenomeState %.17g %.17g %.17g %u %d\n", m_Fitness, m_AdjustedFitness,
+            m_OffspringAmount, m_Depth, static_cast<int>(m_Evaluated));
+    Save(a_file);
+}
+
+// Restores a genome and its state from an opened stream
+void Genome::LoadState(std::istream& a_DataFile)
+{
+    std::string t_Str;
+    do
+    {
+        a_DataFile >> t_Str;
+    }
+    while (a_DataFile && (t_Str != "GenomeState"));
+
+    double t_fitness, t_adjfitness, t_offspring;
+    unsigned int t_depth;
+    int t_evaluated;
+    a_DataFile >> t_fitness >> t_adjfitness >> t_offspring >> t_depth >> t_evaluated;
+
+    *this = Genome(a_DataFile);
+
+    m_Fitness = t_fitness;
+    m_AdjustedFitness = t_adjfitness;
+    m_OffspringAmount = t_offspring;
+    m_Depth = t_depth;
+    m_Evaluated = static_cast<bool>(t_evaluated);
+}
+
 
 ////////////////////////////////////////////
 // Evovable Substrate Hyper NEAT.
@@ -2904,13 +2857,8 @@ void Genome::Build_ES_Phenotype(NeuralNetwork& net, Substrate& subst, Parameters
     unsigned int hidden_counter = 0;
     unsigned int maxNodes = (unsigned int) std::pow((double)4.0,(int) params.MaxDepth);
 
-    std::vector<TempConnection> TempConnections;
-    TempConnections.reserve(maxNodes + 1);
-
-    std::vector<double> point;
-    point.reserve(3);
-
-    boost::shared_ptr<QuadPoint> root;
+    // Connections found for each node
+    std::vector< std::vector<TempConnection> > TempConnections;
 
     boost::unordered_map< std::vector<double>, int > hidden_nodes;
     hidden_nodes.reserve(maxNodes);
@@ -2929,38 +2877,37 @@ void Genome::Build_ES_Phenotype(NeuralNetwork& net, Substrate& subst, Parameters
 
     NeuralNetwork t_temp_phenotype(true);
     BuildPhenotype(t_temp_phenotype);
+    // Compiled once here rather than by every copy the tasks make
+    t_temp_phenotype.Compile();
+
+    CalculateDepth();
+    unsigned int cppn_depth = GetDepth();
 
     // Find Inputs to Hidden connections.
+    ES_Connections(subst.m_input_coords, t_temp_phenotype, cppn_depth, params, true, TempConnections);
     for(unsigned int i = 0; i < input_count; i++)
     {
-        // Get the Quadtree and express the connections in it for this input
-        root = boost::shared_ptr<QuadPoint>(new QuadPoint(params.Qtree_X, params.Qtree_Y, params.Width, params.Height, 1));
-        DivideInitialize( subst.m_input_coords[i], root,t_temp_phenotype,  params, true, 0.0);
-        TempConnections.clear();
-        PruneExpress( subst.m_input_coords[i], root, t_temp_phenotype, params, TempConnections, true);
-        //root.reset();    // release root
-
-        for(unsigned int j = 0; j < TempConnections.size(); j++)
+        for(unsigned int j = 0; j < TempConnections[i].size(); j++)
         {
-        	if (std::abs(TempConnections[j].weight*subst.m_max_weight_and_bias) < 0.2/*subst.m_link_threshold*/) // TODO: fix this
+        	if (std::abs(TempConnections[i][j].weight*subst.m_max_weight_and_bias) < 0.2/*subst.m_link_threshold*/) // TODO: fix this
                 continue;
 
             // Find the hidden node in the hidden nodes. If it is not there add it.
-            if ( hidden_nodes.find(TempConnections[j].target) == hidden_nodes.end())
+            if ( hidden_nodes.find(TempConnections[i][j].target) == hidden_nodes.end())
             {
                 target_index = hidden_counter++;
-                hidden_nodes.insert(std::make_pair(TempConnections[j].target, target_index));
+                hidden_nodes.insert(std::make_pair(TempConnections[i][j].target, target_index));
             }
             // Add connection
             else
             {
-                target_index = hidden_nodes.find(TempConnections[j].target) -> second;
+                target_index = hidden_nodes.find(TempConnections[i][j].target) -> second;
             }
 
             Connection tc;
             tc.m_source_neuron_idx = i;
             tc.m_target_neuron_idx = target_index + hidden_index ;
-            tc.m_weight = TempConnections[j].weight*subst.m_max_weight_and_bias;
+            tc.m_weight = TempConnections[i][j].weight*subst.m_max_weight_and_bias;
             tc.m_recur_flag = false;
 
             net.m_connections.push_back(tc);
@@ -2970,36 +2917,41 @@ void Genome::Build_ES_Phenotype(NeuralNetwork& net, Substrate& subst, Parameters
     // Hidden to hidden.
     // Basically the same procedure as above repeated IterationLevel times (see the params)
     unexplored_nodes = hidden_nodes;
+    std::vector< std::vector<double> > t_unexplored_coords;
+    std::vector<int> t_unexplored_indices;
     for (unsigned int i = 0; i < params.IterationLevel; i++)
     {
+        t_unexplored_coords.clear();
+        t_unexplored_indices.clear();
         boost::unordered_map< std::vector<double>, int >::iterator itr_hid;
         for(itr_hid = unexplored_nodes.begin(); itr_hid != unexplored_nodes.end(); itr_hid++)
         {
-            root = boost::shared_ptr<QuadPoint>(new QuadPoint(params.Qtree_X, params.Qtree_Y, params.Width, params.Height, 1));
-            DivideInitialize( itr_hid -> first, root, t_temp_phenotype, params, true, 0.0);
-            TempConnections.clear();
-            PruneExpress(itr_hid -> first , root, t_temp_phenotype, params, TempConnections, true);
-            //root.reset();
+            t_unexplored_coords.push_back(itr_hid -> first);
+            t_unexplored_indices.push_back(itr_hid -> second);
+        }
 
-            for (unsigned int k = 0; k < TempConnections.size(); k++)
+        ES_Connections(t_unexplored_coords, t_temp_phenotype, cppn_depth, params, true, TempConnections);
+        for(unsigned int j = 0; j < t_unexplored_coords.size(); j++)
+        {
+            for (unsigned int k = 0; k < TempConnections[j].size(); k++)
             {
-            	if (std::abs(TempConnections[k].weight * subst.m_max_weight_and_bias) < 0.2/*subst.m_link_threshold*/) // TODO: fix this
+            	if (std::abs(TempConnections[j][k].weight * subst.m_max_weight_and_bias) < 0.2/*subst.m_link_threshold*/) // TODO: fix this
                     continue;
 
-                if (hidden_nodes.find(TempConnections[k].target) == hidden_nodes.end())
+                if (hidden_nodes.find(TempConnections[j][k].target) == hidden_nodes.end())
                 {
                     target_index = hidden_counter++;
-                    hidden_nodes.insert(std::make_pair(TempConnections[k].target, target_index));
+                    hidden_nodes.insert(std::make_pair(TempConnections[j][k].target, target_index));
                 }
                 else // TODO: This can be skipped if building a feed forwad network.
                 {
-                    target_index= hidden_nodes.find(TempConnections[k].target) -> second;
+                    target_index= hidden_nodes.find(TempConnections[j][k].target) -> second;
                 }
 
                 Connection tc;
-                tc.m_source_neuron_idx = itr_hid->second + hidden_index;  // NO!!!
+                tc.m_source_neuron_idx = t_unexplored_indices[j] + hidden_index;  // NO!!!
                 tc.m_target_neuron_idx = target_index + hidden_index;
-                tc.m_weight = TempConnections[k].weight*subst.m_max_weight_and_bias;
+                tc.m_weight = TempConnections[j][k].weight*subst.m_max_weight_and_bias;
                 tc.m_recur_flag = false;
 
                 net.m_connections.push_back(tc);
@@ -3020,28 +2972,24 @@ void Genome::Build_ES_Phenotype(NeuralNetwork& net, Substrate& subst, Parameters
 
     // Finally Output to Hidden. Note that unlike before, here we connect the outputs to
     // existing hidden nodes and no new nodes are added.
+    ES_Connections(subst.m_output_coords, t_temp_phenotype, cppn_depth, params, false, TempConnections);
     for(unsigned int i = 0; i < output_count; i++)
     {
-        root = boost::shared_ptr<QuadPoint>(new QuadPoint(params.Qtree_X, params.Qtree_Y, params.Width, params.Height, 1));
-        DivideInitialize(subst.m_output_coords[i], root, t_temp_phenotype, params, false, 0.0);
-        TempConnections.clear();
-        PruneExpress(subst.m_output_coords[i], root, t_temp_phenotype, params, TempConnections, false);
-
-        for(unsigned int j = 0; j < TempConnections.size(); j++)
+        for(unsigned int j = 0; j < TempConnections[i].size(); j++)
         {
             // Make sure the link weight is above the expected threshold.
-            if (std::abs(TempConnections[j].weight * subst.m_max_weight_and_bias) < 0.2 /*subst.m_link_threshold*/) // TODO: fix this
+            if (std::abs(TempConnections[i][j].weight * subst.m_max_weight_and_bias) < 0.2 /*subst.m_link_threshold*/) // TODO: fix this
                 continue;
 
-            if (hidden_nodes.find(TempConnections[j].source) != hidden_nodes.end())
+            if (hidden_nodes.find(TempConnections[i][j].source) != hidden_nodes.end())
             {
-                source_index = hidden_nodes.find(TempConnections[j].source) -> second;
+                source_index = hidden_nodes.find(TempConnections[i][j].source) -> second;
 
                 Connection tc;
                 tc.m_source_neuron_idx = source_index + hidden_index;
                 tc.m_target_neuron_idx = i + input_count;
 
-                tc.m_weight = TempConnections[j].weight*subst.m_max_weight_and_bias;
+                tc.m_weight = TempConnections[i][j].weight*subst.m_max_weight_and_bias;
                 tc.m_recur_flag = false;
 
                 net.m_connections.push_back(tc);
@@ -3100,82 +3048,100 @@ void Genome::Build_ES_Phenotype(NeuralNetwork& net, Substrate& subst, Parameters
     Clean_Net(net.m_connections, input_count, output_count, hidden_nodes.size());
 }
 
-// Used to determine the placement of hidden neurons in the Evolvable Substrate.
-void Genome::DivideInitialize(const std::vector<double>& node, boost::shared_ptr<QuadPoint>& root,  NeuralNetwork& cppn, Parameters& params, const bool& outgoing, const double& z_coord)
-{   // Have to check if this actually does something useful here
-    CalculateDepth();
-    int cppn_depth = GetDepth();
-    std::vector<double> t_inputs;
-    t_inputs.reserve(7); // 3 dimensions + bias. // TODO: get rid of the hardcoded value, make it support 2D/3D substrates
+// The CPPN inputs querying the connection between node and the point (x, y, z)
+static void ES_QueryInputs(const std::vector<double>& node, double x, double y, double z,
+                           bool outgoing, double bias, std::vector<double>& inputs)
+{
+    inputs.clear();
+    inputs.reserve(7); // 3 dimensions + bias. // TODO: get rid of the hardcoded value, make it support 2D/3D substrates
+
+    if (outgoing)
+    {
+        //node goes here
+        inputs = node;
 
-    // Standard Tree stuff. Create children, check their output with the CPPN
-    // and if they have higher variance add them to their parent. Repeat with the children
-    // until maxDepth has been reached or if the variance isn't high enough.
-    boost::shared_ptr<QuadPoint> p;
+        inputs.push_back(x);
+        inputs.push_back(y);
+        inputs.push_back(z);
+    }
 
-    std::queue<boost::shared_ptr<QuadPoint> > q;
-    q.push(root);
-    while (!q.empty())
+    else
     {
-        p = q.front();
-        // Add children
-        p -> children.push_back(boost::shared_ptr<QuadPoint>(new QuadPoint(p -> x - p -> width/2, p -> y - p -> height/2 , p -> width/2, p -> height/2, p -> level + 1)));
-        p -> children.push_back(boost::shared_ptr<QuadPoint>(new QuadPoint(p -> x - p -> width/2, p -> y + p ->height/2 , p -> width/2, p -> height/2, p -> level + 1)));
-        p -> children.push_back(boost::shared_ptr<QuadPoint>(new QuadPoint(p -> x + p -> width/2, p -> y + p ->height/2 , p -> width/2, p -> height/2, p -> level + 1)));
-        p -> children.push_back(boost::shared_ptr<QuadPoint>(new QuadPoint(p -> x + p -> width/2, p -> y - p ->height/2 , p -> width/2, p -> height/2, p -> level + 1)));
+        // QuadPoint goes first
+        inputs.push_back(x);
+        inputs.push_back(y);
+        inputs.push_back(z);
 
-        for(unsigned int i = 0; i < p-> children.size(); i++)
-        {
-            t_inputs.clear();
+        inputs.push_back(node[0]);
+        inputs.push_back(node[1]);
+        inputs.push_back(node[2]);
+    }
 
-            if (outgoing)
-            {
-                //node goes here
-                t_inputs = node;
+    //Bias
+    inputs.push_back(bias);
+}
 
-                t_inputs.push_back(p -> children[i] -> x);
-                t_inputs.push_back(p -> children[i] -> y);
-                t_inputs.push_back(p -> children[i] -> z);
-            }
+// Used to determine the placement of hidden neurons in the Evolvable Substrate.
+void Genome::DivideInitialize(const std::vector<double>& node, QuadTree& tree, NeuralNetwork& cppn, unsigned int cppn_depth,
+                              const Parameters& params, const bool& outgoing, const double& z_coord) const
+{
+    tree.clear();
+    tree.push_back(QuadPoint(params.Qtree_X, params.Qtree_Y, params.Width, params.Height, 1));
 
-            else
-            {
-                // QuadPoint goes first
-                t_inputs.push_back(p -> children[i] -> x);
-                t_inputs.push_back(p -> children[i] -> y);
-                t_inputs.push_back(p -> children[i] -> z);
-
-                t_inputs.push_back(node[0]);
-                t_inputs.push_back(node[1]);
-                t_inputs.push_back(node[2]);
-            }
+    // Standard Tree stuff, one level at a time. Create the children of the points
+    // to divide, check their output with the CPPN and divide in turn the children
+    // of the points whose children have a high enough variance. Repeat until
+    // maxDepth has been reached or if the variance isn't high enough.
+    std::vector<unsigned int> t_divide(1, 0);
+    std::vector<unsigned int> t_next;
+    std::vector< std::vector<double> > t_inputs;
+    std::vector< std::vector<double> > t_outputs;
+
+    while (!t_divide.empty())
+    {
+        // Add children
+        const unsigned int t_first = tree.size();
+        for (unsigned int i = 0; i < t_divide.size(); i++)
+        {
+            // copied, adding the children may reallocate the tree
+            const QuadPoint p = tree[t_divide[i]];
+            tree[t_divide[i]].first_child = tree.size();
 
-            //Bias
-            t_inputs.push_back(params.CPPN_Bias);
-            cppn.Flush();
-            cppn.Input(t_inputs);
+            tree.push_back(QuadPoint(p.x - p.width/2, p.y - p.height/2 , p.width/2, p.height/2, p.level + 1));
+            tree.push_back(QuadPoint(p.x - p.width/2, p.y + p.height/2 , p.width/2, p.height/2, p.level + 1));
+            tree.push_back(QuadPoint(p.x + p.width/2, p.y + p.height/2 , p.width/2, p.height/2, p.level + 1));
+            tree.push_back(QuadPoint(p.x + p.width/2, p.y - p.height/2 , p.width/2, p.height/2, p.level + 1));
+        }
 
-            for(int d=0; d<cppn_depth; d++)
-            {
-                cppn.Activate();
-            }
-            p -> children[i] -> weight = cppn.Output()[0];
+        // Query the CPPN for all the new children at once
+        t_inputs.resize(tree.size() - t_first);
+        for (unsigned int i = t_first; i < tree.size(); i++)
+        {
+            ES_QueryInputs(node, tree[i].x, tree[i].y, tree[i].z, outgoing, params.CPPN_Bias, t_inputs[i - t_first]);
+        }
+        cppn.ActivateBatch(t_inputs, cppn_depth, t_outputs);
+
+        for (unsigned int i = t_first; i < tree.size(); i++)
+        {
+            tree[i].weight = t_outputs[i - t_first][0];
             if (params.Leo)
             {
-                p -> children[i] -> leo = cppn.Output()[cppn.Output().size() - 1];
+                tree[i].leo = t_outputs[i - t_first][t_outputs[i - t_first].size() - 1];
             }
-            cppn.Flush();
-
         }
 
-        if ((p->level < params.InitialDepth) || ((p->level < params.MaxDepth) && Variance(p) > params.DivisionThreshold))
-        {   for (unsigned int i = 0; i < 4; i++)
-            {
-                q.push( p->children[i]);
+        t_next.clear();
+        for (unsigned int i = 0; i < t_divide.size(); i++)
+        {
+            const QuadPoint& p = tree[t_divide[i]];
+            if ((p.level < params.InitialDepth) || ((p.level < params.MaxDepth) && Variance(tree, t_divide[i]) > params.DivisionThreshold))
+            {   for (unsigned int c = 0; c < 4; c++)
+                {
+                    t_next.push_back(p.first_child + c);
+                }
             }
         }
-        q.pop();
-
+        t_divide.swap(t_next);
     }
 
     return;
@@ -3183,142 +3149,145 @@ void Genome::DivideInitialize(const std::vector<double>& node, boost::shared_ptr
 
 // We take the tree generated above and see which connections can be expressed on the basis of Variance threshold,
 // Band threshold and LEO.
-void Genome::PruneExpress( const std::vector<double>& node, boost::shared_ptr<QuadPoint> &root, NeuralNetwork& cppn, Parameters& params, std::vector<Genome::TempConnection>& connections, const bool& outgoing)
+void Genome::PruneExpress( const std::vector<double>& node, const QuadTree& tree, NeuralNetwork& cppn, unsigned int cppn_depth,
+                           const Parameters& params, std::vector<Genome::TempConnection>& connections, const bool& outgoing) const
 {
-    if(root -> children[0] == NULL)
+    if (tree.empty() || (tree[0].first_child < 0))
     {
         return;
     }
 
-    else
+    // Walk the tree depth first, children in order, descending into the
+    // points with a high variance. The others are candidates for expression.
+    // (point, parent) pairs.
+    std::vector< std::pair<unsigned int, unsigned int> > t_stack;
+    std::vector< std::pair<unsigned int, unsigned int> > t_candidates;
+    for (int i = 3; i >= 0; i--)
     {
-        for (unsigned int i = 0; i < 4; i++)
+        t_stack.push_back(std::make_pair(tree[0].first_child + i, 0));
+    }
+
+    while (!t_stack.empty())
+    {
+        const std::pair<unsigned int, unsigned int> t_item = t_stack.back();
+        t_stack.pop_back();
+        const QuadPoint& t_point = tree[t_item.first];
+
+        if (Variance(tree, t_item.first) > params.VarianceThreshold)
         {
-            if (Variance(root -> children[i]) > params.VarianceThreshold)
+            for (int i = 3; (i >= 0) && (t_point.first_child >= 0); i--)
             {
-                PruneExpress(node, root -> children[i], cppn, params, connections, outgoing);
+                t_stack.push_back(std::make_pair(t_point.first_child + i, t_item.first));
             }
+        }
 
-            // Band Pruning phase.
-            // If LEO is turned off this should always happen.
-            // If it is not it should only happen if the LEO output is greater than a specified threshold
-            else if (!params.Leo || (params.Leo && root -> children[i] -> leo > params.LeoThreshold))
-            {
-                CalculateDepth();
-                int cppn_depth = GetDepth();
-
-                double d_left, d_right, d_top, d_bottom;
-                std::vector<double> inputs;
-                inputs.reserve(7); // 3d + bias
-
-                int root_index = 0;
-
-                if (outgoing)
-                {
-                    inputs = node;
-                    inputs.push_back(root -> children[i] -> x);
-                    inputs.push_back(root -> children[i] -> y);
-                    inputs.push_back(root -> children[i] -> z);
-
-                    root_index = node.size();
-                }
-
-                else
-                {
-                    inputs.push_back(root -> children[i] -> x);
-                    inputs.push_back(root -> children[i] -> y);
-                    inputs.push_back(root -> children[i] -> z);
-                    inputs.push_back(node[0]);
-                    inputs.push_back(node[1]);
-                    inputs.push_back(node[2]);
-                }
-
-                // Left
-                inputs.push_back(params.CPPN_Bias);
-                inputs[root_index] -= root -> width;
-                cppn.Input(inputs);
-
-                for(int d=0; d<cppn_depth; d++)
-                {
-                    cppn.Activate();
-                }
-
-                d_left = Abs(root -> children[i] -> weight - cppn.Output()[0]);
-                cppn.Flush();
-
-                // Right
-                inputs[root_index] += 2* root -> width;
-                cppn.Input(inputs);
-
-                for(int d=0; d<cppn_depth; d++)
-                {
-                    cppn.Activate();
-                }
-
-                d_right = Abs(root -> children[i] -> weight - cppn.Output()[0]);
-                cppn.Flush();
+        // Band Pruning phase.
+        // If LEO is turned off this should always happen.
+        // If it is not it should only happen if the LEO output is greater than a specified threshold
+        else if (!params.Leo || (params.Leo && t_point.leo > params.LeoThreshold))
+        {
+            t_candidates.push_back(t_item);
+        }
+    }
 
-                // Top
-                inputs[root_index] -= root -> width;
-                inputs[root_index+1] -= root -> width;
-                cppn.Input(inputs);
+    // Query the CPPN at the left, right, top and bottom neighbours of all the candidates at once
+    std::vector< std::vector<double> > t_inputs(4 * t_candidates.size());
+    std::vector< std::vector<double> > t_outputs;
+    const unsigned int root_index = outgoing ? node.size() : 0;
+    for (unsigned int i = 0; i < t_candidates.size(); i++)
+    {
+        const QuadPoint& t_point = tree[t_candidates[i].first];
+        const double t_width = tree[t_candidates[i].second].width;
 
-                for(int d=0; d<cppn_depth; d++)
-                {
-                    cppn.Activate();
-                }
+        std::vector<double> inputs;
+        ES_QueryInputs(node, t_point.x, t_point.y, t_point.z, outgoing, params.CPPN_Bias, inputs);
 
-                d_top = Abs(root -> children[i] -> weight - cppn.Output()[0]);
-                cppn.Flush();
-                // Bottom
-                inputs[root_index+1] += 2*root -> width;
-                cppn.Input(inputs);
+        // Left
+        inputs[root_index] -= t_width;
+        t_inputs[4*i] = inputs;
+        // Right
+        inputs[root_index] += 2* t_width;
+        t_inputs[4*i + 1] = inputs;
+        // Top
+        inputs[root_index] -= t_width;
+        inputs[root_index+1] -= t_width;
+        t_inputs[4*i + 2] = inputs;
+        // Bottom
+        inputs[root_index+1] += 2*t_width;
+        t_inputs[4*i + 3] = inputs;
+    }
+    cppn.ActivateBatch(t_inputs, cppn_depth, t_outputs);
 
-                for(int d=0; d<cppn_depth; d++)
-                {
-                    cppn.Activate();
-                }
+    for (unsigned int i = 0; i < t_candidates.size(); i++)
+    {
+        const QuadPoint& t_point = tree[t_candidates[i].first];
 
-                d_bottom = Abs(root -> children[i] -> weight - cppn.Output()[0]);
-                cppn.Flush();
+        double d_left, d_right, d_top, d_bottom;
+        d_left = Abs(t_point.weight - t_outputs[4*i][0]);
+        d_right = Abs(t_point.weight - t_outputs[4*i + 1][0]);
+        d_top = Abs(t_point.weight - t_outputs[4*i + 2][0]);
+        d_bottom = Abs(t_point.weight - t_outputs[4*i + 3][0]);
 
-                if (std::max(std::min(d_top, d_bottom), std::min(d_left, d_right)) > params.BandThreshold)
-                {
-                    Genome::TempConnection tc;
-                    //Yeah its ugly
-                    if (outgoing)
-                    {
-                        tc.source = node;
+        if (std::max(std::min(d_top, d_bottom), std::min(d_left, d_right)) > params.BandThreshold)
+        {
+            Genome::TempConnection tc;
+            //Yeah its ugly
+            if (outgoing)
+            {
+                tc.source = node;
 
-                        tc.target.push_back(root -> children[i] -> x);
-                        tc.target.push_back(root -> children[i] -> y);
-                        tc.target.push_back(root -> children[i] -> z);
-                    }
+                tc.target.push_back(t_point.x);
+                tc.target.push_back(t_point.y);
+                tc.target.push_back(t_point.z);
+            }
 
-                    else
-                    {
-                        tc.source.push_back(root -> children[i] -> x);
-                        tc.source.push_back(root -> children[i] -> y);
-                        tc.source.push_back(root -> children[i] -> z);
+            else
+            {
+                tc.source.push_back(t_point.x);
+                tc.source.push_back(t_point.y);
+                tc.source.push_back(t_point.z);
 
-                        tc.target = node;
-                    }
-                    // Normalize
-                    // TODO: Put in Parameters
-                    tc.weight = root -> children[i] -> weight;
-                    connections.push_back(tc);
-                }
+                tc.target = node;
             }
+            // Normalize
+            // TODO: Put in Parameters
+            tc.weight = t_point.weight;
+            connections.push_back(tc);
         }
     }
     return;
 }
 
-// Calculates the variance of a given Quadpoint.
-// Maybe an alternative solution would be to add this in the Quadpoint const.
-double Genome::Variance(boost::shared_ptr<QuadPoint> &point)
+// Finds the connections expressed for each of the nodes, in parallel.
+void Genome::ES_Connections(const std::vector< std::vector<double> >& nodes, const NeuralNetwork& cppn,
+                            unsigned int cppn_depth, const Parameters& params, const bool& outgoing,
+                            std::vector< std::vector<Genome::TempConnection> >& connections) const
+{
+    connections.clear();
+    connections.resize(nodes.size());
+
+    robogen::parallelFor(nodes.size(), params.NumThreads,
+            boost::bind(&Genome::ES_ConnectionsTask, this, boost::cref(nodes), boost::cref(cppn),
+                    cppn_depth, boost::cref(params), outgoing, boost::ref(connections), _1));
+}
+
+// Gets the quadtree of nodes[i] and expresses the connections in it.
+// The CPPN keeps state while activated, so each task has its own copy.
+void Genome::ES_ConnectionsTask(const std::vector< std::vector<double> >& nodes, const NeuralNetwork& cppn,
+                                unsigned int cppn_depth, const Parameters& params, const bool& outgoing,
+                                std::vector< std::vector<Genome::TempConnection> >& connections,
+                                unsigned int i) const
 {
-    if (point -> children.size()  == 0)
+    NeuralNetwork t_cppn(cppn);
+    QuadTree t_tree;
+    DivideInitialize(nodes[i], t_tree, t_cppn, cppn_depth, params, outgoing, 0.0);
+    PruneExpress(nodes[i], t_tree, t_cppn, cppn_depth, params, connections[i], outgoing);
+}
+
+// Calculates the variance of the children of a given Quadpoint.
+double Genome::Variance(const QuadTree& tree, unsigned int point) const
+{
+    if (tree[point].first_child < 0)
     {
         return 0.0;
     }
@@ -3326,57 +3295,33 @@ double Genome::Variance(boost::shared_ptr<QuadPoint> &point)
     boost::accumulators::accumulator_set<double,  boost::accumulators::stats< boost::accumulators::tag::variance> > acc;
     for (unsigned int i = 0; i < 4; i++)
     {
-        acc(point -> children[i] -> weight);
+        acc(tree[tree[point].first_child + i].weight);
     }
-    /*
-    //Old approach. Traverses the entire tree. The new one checks just the children and seems to work just as well.
-    std::queue<boost::shared_ptr<QuadPoint> > q;
-    q.push(point);
-    while(!q.empty())
-        {
-            boost::shared_ptr<QuadPoint> c(q.front());
-            q.pop();
-        cout << "Depth " << c -> level << endl;
-            if (c -> children.size() > 0)
-                {
-                    for (unsigned int i =0; i < c -> children.size(); i++)
-                        {   //error is here
-    		  cout << "pushed" << endl;
-
-    		   q.push(c -> children[i]);
-    		   cout << "yep" << endl;
-                        }
-                }
-            else
-                {
-                    acc(c -> weight);
-
-                }
-        }*/
 
     return boost::accumulators::variance(acc);
 }
 
-// Helper method for Variance
-void Genome::CollectValues(std::vector<double>& vals, boost::shared_ptr<QuadPoint>& point)
+// Collects the weights of the leaves below a given Quadpoint, in depth first order.
+void Genome::CollectValues(std::vector<double>& vals, const QuadTree& tree, unsigned int point) const
 {
-    //In theory we shouldn't get here at all.
-    if (point == NULL)
+    std::vector<unsigned int> t_stack(1, point);
+    while (!t_stack.empty())
     {
-        return;
-    }
+        const QuadPoint& t_point = tree[t_stack.back()];
+        t_stack.pop_back();
 
-    if (point -> children.size() >0 )
-    {
-        for (unsigned int i = 0; i < 4; i++)
+        if (t_point.first_child >= 0)
         {
-            CollectValues(vals, point -> children[i]);
+            for (int i = 3; i >= 0; i--)
+            {
+                t_stack.push_back(t_point.first_child + i);
+            }
         }
-    }
 
-    else
-    {   // Here, Apparently it treats the point a if it is not initialized
-        vals.push_back(point-> weight);
+        else
+        {
+            vals.push_back(t_point.weight);
+        }
     }
 }
 
@@ -3394,10 +3339,11 @@ py::list Genome::GetPoints(py::tuple& t_node,Parameters& params, bool outgoing )
     BuildPhenotype(cppn);
     cppn.Flush();
 
-    boost::shared_ptr<QuadPoint> root  = boost::shared_ptr<QuadPoint>(new QuadPoint(params.Qtree_X, params.Qtree_Y, params.Width, params.Height, 1));
+    CalculateDepth();
+    QuadTree tree;
 
-    DivideInitialize(node, root, cppn, params, outgoing, 0.0);
-    PruneExpress(node, root, cppn, params, validpoints, outgoing);
+    DivideInitialize(node, tree, cppn, GetDepth(), params, outgoing, 0.0);
+    PruneExpress(node, tree, cppn, GetDepth(), params, validpoints, outgoing);
     py::list return_values;
 
     for (unsigned int i = 0; i < validpoints.size(); i++)
@@ -64,6 +64,7 @@ namespace NEAT
 // forward
 class Innovation;
 class InnovationDatabase;
+class InnovationRemap;
 class PhenotypeBehavior;
 
 extern ActivationFunction GetRandomActivation(Parameters& a_Parameters, RNG& a_RNG);
@@ -149,11 +150,9 @@ public:
 
     Genome();
 
-    // copy constructor
-    Genome(const Genome& a_g);
-
-    // assignment operator
-    Genome& operator=(const Genome& a_g);
+    // Genomes are copied and moved member by member. Moving one,
+    // as reproduction does with the offspring, moves its genes
+    // instead of copying them.
 
     // comparison operator (nessesary for boost::python)
     // todo: implement a better comparison technique
@@ -164,8 +163,8 @@ public:
     // Builds this genome from a file
     Genome(const char* a_filename);
 
-    // Builds this genome from an opened file
-    Genome(std::ifstream& a_DataFile);
+    // Builds this genome from an opened file or stream
+    Genome(std::istream& a_DataFile);
 
     // This creates a standart minimal genome - perceptron-like structure
     Genome(unsigned int a_ID,
@@ -353,6 +352,13 @@ public:
     // Saves this genome to an already opened file for writing
     void Save(FILE* a_fstream);
 
+    // Saves this genome along with its fitness scores and evaluation state,
+    // to be restored by LoadState()
+    void SaveState(FILE* a_fstream);
+
+    // Replaces this genome by one saved by SaveState() in an opened stream
+    void LoadState(std::istream& a_DataFile);
+
     // returns the max neuron ID
     unsigned int GetLastNeuronID() const;
 
@@ -363,6 +369,10 @@ public:
     // The neurons by IDs and the links by innovation numbers.
     void SortGenes();
 
+    // Gives the genes the IDs their innovations got when merged into
+    // the population's innovation database, then sorts them
+    void Renumber(const InnovationRemap& a_Remap);
+
     // overload '<' used for sorting. From fittest to poorest.
     friend bool operator<(const Genome& a_lhs, const Genome& a_rhs)
     {
@@ -434,7 +444,7 @@ public:
     // If the bool is true, then the genes are averaged
     // Disjoint and excess genes are inherited from the fittest parent
     // If fitness is equal, the smaller genome is assumed to be the better one
-    Genome Mate(Genome& a_dad, bool a_averagemating, bool a_interspecies, RNG& a_RNG);
+    Genome Mate(const Genome& a_dad, bool a_averagemating, bool a_interspecies, RNG& a_RNG) const;
 
 
     //////////
@@ -509,7 +519,9 @@ public:
     	}
     };
 
-    // A quadpoint in the HyperCube.
+    // A quadpoint in the HyperCube. The points of a quadtree are stored in
+    // a flat array, the root first and the four children of a point next
+    // to each other.
     struct QuadPoint
     {
     	double x;
@@ -518,19 +530,18 @@ public:
     	double width;
     	double weight;
     	double height;
-    	double variance;
     	unsigned int level;
     	// Do I use this?
     	double leo;
 
-
-    	std::vector<boost::shared_ptr<QuadPoint> > children;
+    	// index of the first of the four children in the tree, -1 if none
+    	int first_child;
 
     	QuadPoint()
     	{
-    		x = y = z = width = height = weight = variance = leo = 0;
+    		x = y = z = width = height = weight = leo = 0;
     		level = 0;
-    		children.reserve(4);
+    		first_child = -1;
     	}
 
     	QuadPoint(double t_x, double t_y, double t_width, double t_height, int t_level)
@@ -542,9 +553,7 @@ public:
     		level = t_level;
     		weight = 0.0;
     		leo = 0.0;
-    		variance = 0.0;
-    		children.reserve(4);
-    		children.clear();
+    		first_child = -1;
     	}
 
     	// Mind the Z
@@ -558,31 +567,42 @@ public:
     		height = t_height;
     		level = t_level;
     		weight = 0.0;
-    		variance = 0.0;
     		leo = 0.0;
-    		children.reserve(4);
-    		children.clear();
+    		first_child = -1;
     	}
-
-    	~QuadPoint()
-    	{
-    	};
     };
 
-    void Build_ES_Phenotype(NeuralNetwork& a_net, Substrate& subst, Parameters& params);
-    void DivideInitialize(const std::vector<double>& node,
-    		              boost::shared_ptr<QuadPoint>& root,
-						  NeuralNetwork& cppn, Parameters& params,
-						  const bool& outgoing, const double& z_coord);
+    typedef std::vector<QuadPoint> QuadTree;
 
-    void PruneExpress(const std::vector<double>& node,
-                      boost::shared_ptr<QuadPoint>& root, NeuralNetwork& cppn,
-                      Parameters& params, std::vector<Genome::TempConnection>& connections,
-                      const bool& outgoing);
-
-    void CollectValues(std::vector<double>& vals, boost::shared_ptr<QuadPoint>& point);
+    void Build_ES_Phenotype(NeuralNetwork& a_net, Substrate& subst, Parameters& params);
 
-    double Variance( boost::shared_ptr<QuadPoint> &point);
+    // Builds the quadtree around node, querying the CPPN for the children of
+    // a whole level at once. cppn is a phenotype of this genome and is
+    // activated cppn_depth times per query.
+    void DivideInitialize(const std::vector<double>& node, QuadTree& tree,
+    						  NeuralNetwork& cppn, unsigned int cppn_depth, const Parameters& params,
+    						  const bool& outgoing, const double& z_coord) const;
+
+    void PruneExpress(const std::vector<double>& node, const QuadTree& tree,
+                      NeuralNetwork& cppn, unsigned int cppn_depth, const Parameters& params,
+                      std::vector<Genome::TempConnection>& connections,
+                      const bool& outgoing) const;
+
+    // Finds the connections expressed for each of the nodes. The nodes are
+    // independent, so their quadtrees are built in parallel.
+    void ES_Connections(const std::vector< std::vector<double> >& nodes, const NeuralNetwork& cppn,
+                        unsigned int cppn_depth, const Parameters& params, const bool& outgoing,
+                        std::vector< std::vector<Genome::TempConnection> >& connections) const;
+
+    // Task finding the connections of nodes[i] with its own copy of the CPPN
+    void ES_ConnectionsTask(const std::vector< std::vector<double> >& nodes, const NeuralNetwork& cppn,
+                            unsigned int cppn_depth, const Parameters& params, const bool& outgoing,
+                            std::vector< std::vector<Genome::TempConnection> >& connections,
+                            unsigned int i) const;
+
+    void CollectValues(std::vector<double>& vals, const QuadTree& tree, unsigned int point) const;
+
+    double Variance(const QuadTree& tree, unsigned int point) const;
     void Clean_Net( std::vector<Connection>& connections, unsigned int input_count,
                     unsigned int output_count, unsigned int hidden_count);
 
@@ -30,6 +30,7 @@
 
 #include <fstream>
 #include <string>
+#include <algorithm>
 
 #include "Innovation.h"
 #include "Genes.h"
@@ -45,7 +46,8 @@ InnovationDatabase::InnovationDatabase()
 {
     m_NextInnovationNum = 1; // innovations start at 1
     m_NextNeuronID = 1;      // neuron IDs start at 1
-    m_Innovations.clear();
+    m_Base = NULL;
+    m_BaseSize = 0;
 }
 
 // Creates an empty database but this time sets the next innov number and neuron ID
@@ -55,7 +57,8 @@ InnovationDatabase::InnovationDatabase(int a_LastInnovationNum, int a_LastNeuron
 
     m_NextInnovationNum = a_LastInnovationNum;
     m_NextNeuronID = a_LastNeuronID;
-    m_Innovations.clear();
+    m_Base = NULL;
+    m_BaseSize = 0;
 }
 
 
@@ -72,11 +75,11 @@ void InnovationDatabase::Init(int a_LastInnovationNum, int a_LastNeuronID)
 // Initializes a database from a given genome
 void InnovationDatabase::Init(const Genome& a_Genome)
 {
-    m_Innovations.clear();
+    Flush();
     for(unsigned int i=0; i<a_Genome.NumLinks(); i++)
     {
         Innovation t_innov( a_Genome.GetLinkByIndex(i).InnovationID(), NEW_LINK, a_Genome.GetLinkByIndex(i).FromNeuronID(), a_Genome.GetLinkByIndex(i).ToNeuronID(), NONE, -1);
-        m_Innovations.push_back(t_innov);
+        Insert(t_innov);
     }
 
     m_NextNeuronID = a_Genome.GetLastNeuronID();
@@ -84,9 +87,9 @@ void InnovationDatabase::Init(const Genome& a_Genome)
 }
 
 
-void InnovationDatabase::Init(std::ifstream& a_DataFile)
+void InnovationDatabase::Init(std::istream& a_DataFile)
 {
-    m_Innovations.clear();
+    Flush();
     m_NextInnovationNum = 0;
     m_NextNeuronID = 0;
 
@@ -123,7 +126,7 @@ void InnovationDatabase::Init(std::ifstream& a_DataFile)
             a_DataFile >> t_neurontype;
             a_DataFile >> t_nid;
 
-            m_Innovations.push_back( Innovation(t_id, static_cast<InnovationType>(t_innovtype), t_from, t_to, static_cast<NeuronType>(t_neurontype), t_nid) );
+            Insert( Innovation(t_id, static_cast<InnovationType>(t_innovtype), t_from, t_to, static_cast<NeuronType>(t_neurontype), t_nid) );
         }
 
     }
@@ -148,6 +151,26 @@ void InnovationDatabase::Save(FILE *a_file)
 
 
 
+// Appends an innovation to the list and indexes it
+void InnovationDatabase::Insert(const Innovation& a_Innov)
+{
+    m_Index[InnovationKey(a_Innov.FromNeuronID(), a_Innov.ToNeuronID(), a_Innov.InnovType())].push_back(m_Innovations.size());
+    m_Innovations.push_back(a_Innov);
+}
+
+
+// Returns the indexes of the innovations matching the key, NULL if none
+const std::vector<int>* InnovationDatabase::Lookup(int a_In, int a_Out, InnovationType a_Type) const
+{
+    IndexMap::const_iterator t_it = m_Index.find(InnovationKey(a_In, a_Out, a_Type));
+    if (t_it == m_Index.end())
+    {
+        return NULL;
+    }
+    return &t_it->second;
+}
+
+
 // Checks the database if the innovation has already occured
 // Returns the innovation id if true or -1 if false
 // If it is a NEW_LINK innovation, in & out specify the neuron IDs being connected
@@ -157,18 +180,24 @@ int InnovationDatabase::CheckInnovation(int a_In, int a_Out, InnovationType a_Ty
     ASSERT((a_In > 0) && (a_Out > 0));
     ASSERT((a_Type == NEW_NEURON) || (a_Type == NEW_LINK));
 
-    // search the list for a match
-    for(unsigned int i=0; i < m_Innovations.size(); i++)
+    if (m_Base != NULL)
     {
-        if ((m_Innovations[i].FromNeuronID() == a_In) && (m_Innovations[i].ToNeuronID() == a_Out) && (m_Innovations[i].InnovType() == a_Type))
+        const int t_id = m_Base->CheckInnovation(a_In, a_Out, a_Type);
+        if (t_id != -1)
         {
-            // match found?
-            return m_Innovations[i].ID();
+            return t_id;
         }
     }
 
-    // not found
-    return -1;
+    const std::vector<int>* t_idxs = Lookup(a_In, a_Out, a_Type);
+    if (t_idxs == NULL)
+    {
+        // not found
+        return -1;
+    }
+
+    // the first match in the list
+    return m_Innovations[t_idxs->front()].ID();
 }
 
 
@@ -176,19 +205,15 @@ int InnovationDatabase::CheckLastInnovation(int a_In, int a_Out, InnovationType
 {
     ASSERT((a_In > 0) && (a_Out > 0));
     ASSERT((a_Type == NEW_NEURON) || (a_Type == NEW_LINK));
-    int t_ID = -1;
 
-    // search the list for a match
-    for(unsigned int i=0; i < m_Innovations.size(); i++)
+    const std::vector<int>* t_idxs = Lookup(a_In, a_Out, a_Type);
+    if (t_idxs == NULL)
     {
-        if ((m_Innovations[i].FromNeuronID() == a_In) && (m_Innovations[i].ToNeuronID() == a_Out) && (m_Innovations[i].InnovType() == a_Type))
-        {
-            // match found?
-            t_ID = m_Innovations[i].ID();
-        }
+        return (m_Base != NULL) ? m_Base->CheckLastInnovation(a_In, a_Out, a_Type) : -1;
     }
 
-    return t_ID;
+    // the last match in the list
+    return m_Innovations[t_idxs->back()].ID();
 }
 
 
@@ -198,20 +223,23 @@ std::vector<int> InnovationDatabase::CheckAllInnovations(int a_In, int a_Out, In
     ASSERT((a_In > 0) && (a_Out > 0));
     ASSERT((a_Type == NEW_NEURON) || (a_Type == NEW_LINK));
 
-    std::vector<int> t_idxs;
-    t_idxs.clear();
+    std::vector<int> t_all;
+    if (m_Base != NULL)
+    {
+        t_all = m_Base->CheckAllInnovations(a_In, a_Out, a_Type);
+    }
 
-    // search the list for a match
-    for(unsigned int i=0; i < m_Innovations.size(); i++)
+    const std::vector<int>* t_idxs = Lookup(a_In, a_Out, a_Type);
+    if (t_idxs != NULL)
     {
-        if ((m_Innovations[i].FromNeuronID() == a_In) && (m_Innovations[i].ToNeuronID() == a_Out) && (m_Innovations[i].InnovType() == a_Type))
+        // indexes past the base's innovations
+        for(unsigned int i=0; i<t_idxs->size(); i++)
         {
-            // match found?
-            t_idxs.push_back( i );
+            t_all.push_back(m_BaseSize + (*t_idxs)[i]);
         }
     }
 
-    return t_idxs;
+    return t_all;
 }
 
 
@@ -222,36 +250,36 @@ int InnovationDatabase::FindNeuronID(int a_In, int a_Out) const
 {
     ASSERT((a_In > 0) && (a_Out > 0));
 
-    // search the list for a match
-    for(unsigned int i=0; i < m_Innovations.size(); i++)
+    if (m_Base != NULL)
     {
-        if ((m_Innovations[i].FromNeuronID() == a_In) && (m_Innovations[i].ToNeuronID() == a_Out) && (m_Innovations[i].InnovType() == NEW_NEURON))
+        const int t_id = m_Base->FindNeuronID(a_In, a_Out);
+        if (t_id != -1)
         {
-            // match found?
-            return m_Innovations[i].NeuronID();
+            return t_id;
         }
     }
 
-    // Not found
-    return -1;
+    const std::vector<int>* t_idxs = Lookup(a_In, a_Out, NEW_NEURON);
+    if (t_idxs == NULL)
+    {
+        // Not found
+        return -1;
+    }
+
+    return m_Innovations[t_idxs->front()].NeuronID();
 }
 
 int InnovationDatabase::FindLastNeuronID(int a_In, int a_Out) const
 {
     ASSERT((a_In > 0) && (a_Out > 0));
-    int t_ID = -1;
 
-    // search the list for a match
-    for(unsigned int i=0; i < m_Innovations.size(); i++)
+    const std::vector<int>* t_idxs = Lookup(a_In, a_Out, NEW_NEURON);
+    if (t_idxs == NULL)
     {
-        if ((m_Innovations[i].FromNeuronID() == a_In) && (m_Innovations[i].ToNeuronID() == a_Out) && (m_Innovations[i].InnovType() == NEW_NEURON))
-        {
-            // match found?
-            t_ID = m_Innovations[i].NeuronID();
-        }
+        return (m_Base != NULL) ? m_Base->FindLastNeuronID(a_In, a_Out) : -1;
     }
 
-    return t_ID;
+    return m_Innovations[t_idxs->back()].NeuronID();
 }
 
 
@@ -261,7 +289,7 @@ int InnovationDatabase::AddLinkInnovation(int a_In, int a_Out)
 {
     ASSERT((a_In > 0) && (a_Out > 0));
 
-    m_Innovations.push_back( Innovation(m_NextInnovationNum, NEW_LINK, a_In, a_Out, NONE, -1) );
+    Insert( Innovation(m_NextInnovationNum, NEW_LINK, a_In, a_Out, NONE, -1) );
     m_NextInnovationNum++;
 
     return (m_NextInnovationNum - 1);
@@ -279,7 +307,7 @@ int InnovationDatabase::AddNeuronInnovation(int a_In, int a_Out, NeuronType a_NT
     ASSERT((a_In > 0) && (a_Out > 0));
     ASSERT(!((a_NType == INPUT) || (a_NType == BIAS) || (a_NType == OUTPUT)));
 
-    m_Innovations.push_back( Innovation(m_NextInnovationNum, NEW_NEURON, a_In, a_Out, a_NType, m_NextNeuronID) );
+    Insert( Innovation(m_NextInnovationNum, NEW_NEURON, a_In, a_Out, a_NType, m_NextNeuronID) );
     m_NextInnovationNum++;
     m_NextNeuronID++;
 
@@ -293,6 +321,126 @@ int InnovationDatabase::AddNeuronInnovation(int a_In, int a_Out, NeuronType a_NT
 void InnovationDatabase::Flush()
 {
     m_Innovations.clear();
+    m_Index.clear();
+    m_Base = NULL;
+    m_BaseSize = 0;
+}
+
+
+// Initializes an empty database recording the innovations made over a_Base
+void InnovationDatabase::Stage(const InnovationDatabase& a_Base)
+{
+    Flush();
+
+    m_Base = &a_Base;
+    m_BaseSize = a_Base.NumInnovations();
+    m_NextInnovationNum = a_Base.m_NextInnovationNum;
+    m_NextNeuronID = a_Base.m_NextNeuronID;
+}
+
+
+// Adds the innovations recorded by a database staged over this one
+void InnovationDatabase::Merge(const InnovationDatabase& a_Staged, InnovationRemap& a_Remap)
+{
+    ASSERT(a_Staged.m_Base == this);
+
+    // Every staged innovation took the next innovation number and
+    // every neuron innovation the next neuron ID
+    unsigned int t_num_neurons = 0;
+    for(unsigned int i=0; i<a_Staged.m_Innovations.size(); i++)
+    {
+        if (a_Staged.m_Innovations[i].InnovType() == NEW_NEURON)
+        {
+            t_num_neurons++;
+        }
+    }
+    a_Remap.m_FirstInnovationNum = a_Staged.m_NextInnovationNum - a_Staged.m_Innovations.size();
+    a_Remap.m_FirstNeuronID = a_Staged.m_NextNeuronID - t_num_neurons;
+    a_Remap.m_InnovationNums.assign(a_Staged.m_Innovations.size(), -1);
+    a_Remap.m_NeuronIDs.assign(t_num_neurons, -1);
+
+    // how many staged neuron innovations of each split were merged so far
+    boost::unordered_map<InnovationKey, unsigned int> t_splits;
+
+    // An innovation only refers to neurons that existed before it, so
+    // going in order the neurons it connects or splits are renumbered
+    for(unsigned int i=0; i<a_Staged.m_Innovations.size(); i++)
+    {
+        const Innovation& t_innov = a_Staged.m_Innovations[i];
+        const int t_from = a_Remap.NeuronID(t_innov.FromNeuronID());
+        const int t_to = a_Remap.NeuronID(t_innov.ToNeuronID());
+        ASSERT((t_from > 0) && (t_to > 0));
+
+        if (t_innov.InnovType() == NEW_LINK)
+        {
+            int t_num = CheckInnovation(t_from, t_to, NEW_LINK);
+            if (t_num == -1)
+            {
+                t_num = AddLinkInnovation(t_from, t_to);
+            }
+            a_Remap.m_InnovationNums[t_innov.ID() - a_Remap.m_FirstInnovationNum] = t_num;
+        }
+        else
+        {
+            // The n-th neuron innovation of a split takes the n-th one merged
+            // since the staging, so that a genome never gets the same neuron twice
+            unsigned int& t_count = t_splits[InnovationKey(t_from, t_to, NEW_NEURON)];
+
+            int t_num = -1;
+            int t_neuron = -1;
+            const std::vector<int>* t_idxs = Lookup(t_from, t_to, NEW_NEURON);
+            if (t_idxs != NULL)
+            {
+                std::vector<int>::const_iterator t_first =
+                        std::lower_bound(t_idxs->begin(), t_idxs->end(), static_cast<int>(a_Staged.m_BaseSize));
+                if (static_cast<unsigned int>(t_idxs->end() - t_first) > t_count)
+                {
+                    const Innovation& t_merged = m_Innovations[*(t_first + t_count)];
+                    t_num = t_merged.ID();
+                    t_neuron = t_merged.NeuronID();
+                }
+            }
+
+            if (t_num == -1)
+            {
+                t_neuron = AddNeuronInnovation(t_from, t_to, t_innov.GetNeuronType());
+                t_num = m_NextInnovationNum - 1;
+            }
+            t_count++;
+
+            a_Remap.m_InnovationNums[t_innov.ID() - a_Remap.m_FirstInnovationNum] = t_num;
+            a_Remap.m_NeuronIDs[t_innov.NeuronID() - a_Remap.m_FirstNeuronID] = t_neuron;
+        }
+    }
+}
+
+
+// True if no ID changes
+bool InnovationRemap::IsIdentity() const
+{
+    for(unsigned int i=0; i<m_NeuronIDs.size(); i++)
+    {
+        if (m_NeuronIDs[i] != m_FirstNeuronID + static_cast<int>(i))
+        {
+            return false;
+        }
+    }
+    for(unsigned int i=0; i<m_InnovationNums.size(); i++)
+    {
+        if (m_InnovationNums[i] != m_FirstInnovationNum + static_cast<int>(i))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+// Reserves room for the given number of innovations
+void InnovationDatabase::Reserve(unsigned int a_Size)
+{
+    m_Innovations.reserve(a_Size);
+    m_Index.reserve(a_Size);
 }
 
 
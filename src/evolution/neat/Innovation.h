@@ -32,6 +32,7 @@
 
 #include <vector>
 #include <fstream>
+#include <boost/unordered_map.hpp>
 
 #include "Genes.h"
 #include "Genome.h"
@@ -130,6 +131,68 @@ public:
 // forward
 class Genome;
 
+//////////////////////////////////////////////////////////////
+// Key under which innovations are indexed in the database
+//////////////////////////////////////////////////////////////
+struct InnovationKey
+{
+    int m_From, m_To;
+    InnovationType m_Type;
+
+    InnovationKey(int a_From, int a_To, InnovationType a_Type)
+    : m_From(a_From), m_To(a_To), m_Type(a_Type)
+    {
+    }
+
+    bool operator==(const InnovationKey& a_Other) const
+    {
+        return (m_From == a_Other.m_From) && (m_To == a_Other.m_To) && (m_Type == a_Other.m_Type);
+    }
+};
+
+inline std::size_t hash_value(const InnovationKey& a_Key)
+{
+    std::size_t t_seed = 0;
+    boost::hash_combine(t_seed, a_Key.m_From);
+    boost::hash_combine(t_seed, a_Key.m_To);
+    boost::hash_combine(t_seed, static_cast<int>(a_Key.m_Type));
+    return t_seed;
+}
+
+////////////////////////////////////////////////////////
+// Maps the IDs given by a staged database to the merged ones
+////////////////////////////////////////////////////////
+class InnovationRemap
+{
+public:
+
+    int m_FirstNeuronID;
+    int m_FirstInnovationNum;
+    std::vector<int> m_NeuronIDs;
+    std::vector<int> m_InnovationNums;
+
+    InnovationRemap()
+    {
+        m_FirstNeuronID = 0;
+        m_FirstInnovationNum = 0;
+    }
+
+    int NeuronID(int a_ID) const
+    {
+        const int t_idx = a_ID - m_FirstNeuronID;
+        return ((t_idx >= 0) && (t_idx < static_cast<int>(m_NeuronIDs.size()))) ? m_NeuronIDs[t_idx] : a_ID;
+    }
+
+    int InnovationNum(int a_Num) const
+    {
+        const int t_idx = a_Num - m_FirstInnovationNum;
+        return ((t_idx >= 0) && (t_idx < static_cast<int>(m_InnovationNums.size()))) ? m_InnovationNums[t_idx] : a_Num;
+    }
+
+    // True if no ID changes
+    bool IsIdentity() const;
+};
+
 ////////////////////////////////////////////////////////
 // This class defines the innovation database structure
 ////////////////////////////////////////////////////////
@@ -142,17 +205,33 @@ private:
     /////////////////////
 
     // The list of innovations
+    std::vector<Innovation> m_Innovations;
 
+    // Indexes in m_Innovations of the innovations sharing the same
+    // (from, to, type), in insertion order. Kept in sync with the list
+    // so that lookups don't have to scan the whole database.
+    typedef boost::unordered_map<InnovationKey, std::vector<int> > IndexMap;
+    IndexMap m_Index;
 
     int m_NextNeuronID;
     int m_NextInnovationNum;
 
+    // The database this one records new innovations over, NULL if none.
+    // Its innovations come first when looking up, as if they were in this one.
+    const InnovationDatabase* m_Base;
+    unsigned int m_BaseSize;
+
+    // Appends an innovation to the list and indexes it
+    void Insert(const Innovation& a_Innov);
+
+    // Returns the indexes of the innovations matching the key, NULL if none
+    const std::vector<int>* Lookup(int a_In, int a_Out, InnovationType a_Type) const;
+
 public:
 
     ////////////////////////////
     // Constructors
     ////////////////////////////
-    std::vector<Innovation> m_Innovations;
     // Creates an empty database
     InnovationDatabase();
 
@@ -175,7 +254,21 @@ public:
 
     // Initializes a database from saved data
     // File is assumed to be already opened!
-    void Init(std::ifstream& a_file);
+    void Init(std::istream& a_file);
+
+    // Initializes an empty database recording the innovations made over a_Base,
+    // which must not change until this one is merged back into it. Several
+    // databases staged over the same one can be used at once by different threads.
+    void Stage(const InnovationDatabase& a_Base);
+
+    // Adds the innovations recorded by a database staged over this one, merging
+    // each with an identical one this database already has if any, and tells in
+    // a_Remap the IDs they were given. Databases staged at the same time are
+    // merged one after the other, always in the same order to get the same IDs.
+    // A neuron innovation splitting a link that earlier merged ones split too
+    // takes the ID of the first of them, unless already taken by another
+    // neuron innovation of the same split in a_Staged.
+    void Merge(const InnovationDatabase& a_Staged, InnovationRemap& a_Remap);
 
     // Checks the database if the innovation has already occured
     // Returns the innovation id if true or -1 if false
@@ -205,9 +298,21 @@ public:
     // Clears all innovations in the database
     void Flush();
 
+    // Reserves room for the given number of innovations
+    void Reserve(unsigned int a_Size);
+
+    unsigned int NumInnovations() const
+    {
+        return m_BaseSize + m_Innovations.size();
+    }
+
     Innovation GetInnovationByIdx(int idx) const
     {
-        return m_Innovations[idx];
+        if (idx < static_cast<int>(m_BaseSize))
+        {
+            return m_Base->GetInnovationByIdx(idx);
+        }
+        return m_Innovations[idx - m_BaseSize];
     };
 
     // Saves the database to an already opened file
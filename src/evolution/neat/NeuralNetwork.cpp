@@ -35,6 +35,7 @@
 #include <sstream>
 #include <string>
 #include <iostream>
+#include <algorithm>
 #include "NeuralNetwork.h"
 #include "Assert.h"
 #include "Utils.h"
@@ -237,6 +238,7 @@ NeuralNetwork::NeuralNetwork(bool a_Minimal)
                     m_neurons[i].m_membrane_potential = 0;
         }
 
+        m_compiled = false;
         InitRTRLMatrix();
     }
     else
@@ -295,194 +297,407 @@ void NeuralNetwork::InitRTRLMatrix()
     }
 }
 
-void NeuralNetwork::ActivateFast()
+void NeuralNetwork::Compile()
 {
-    // Loop connections. Calculate each connection's output signal.
+    const unsigned int t_num_neurons = m_neurons.size();
+    const unsigned int t_first = std::min<unsigned int>(m_num_inputs, t_num_neurons);
+
+    // Level of each non-input neuron: one more than the highest level among the
+    // non-input neurons feeding it, inputs being at level 0. Found by removing
+    // the neurons whose sources are all placed; any left over lie on a cycle.
+    std::vector<unsigned int> t_level(t_num_neurons, 0);
+    std::vector<unsigned int> t_num_sources(t_num_neurons, 0);
+    std::vector< std::vector<unsigned int> > t_targets(t_num_neurons);
     for (unsigned int i = 0; i < m_connections.size(); i++)
     {
-        m_connections[i].m_signal =
-                m_neurons[m_connections[i].m_source_neuron_idx].m_activation
-                        * m_connections[i].m_weight;
+        unsigned int t_from = m_connections[i].m_source_neuron_idx;
+        unsigned int t_to = m_connections[i].m_target_neuron_idx;
+        if ((t_from >= t_first) && (t_to >= t_first))
+        {
+            t_num_sources[t_to]++;
+            t_targets[t_from].push_back(t_to);
+        }
     }
-    // Loop the connections again. This time add the signals to the target neurons.
-    // This will largely require out of order memory writes. This is the one loop where
-    // this will happen.
+
+    std::vector<unsigned int> t_ready;
+    for (unsigned int i = t_first; i < t_num_neurons; i++)
+    {
+        t_level[i] = 1;
+        if (t_num_sources[i] == 0)
+        {
+            t_ready.push_back(i);
+        }
+    }
+
+    unsigned int t_num_placed = 0;
+    m_depth = 0;
+    while (!t_ready.empty())
+    {
+        unsigned int t_n = t_ready.back();
+        t_ready.pop_back();
+        t_num_placed++;
+        m_depth = std::max(m_depth, t_level[t_n]);
+
+        for (unsigned int i = 0; i < t_targets[t_n].size(); i++)
+        {
+            unsigned int t_to = t_targets[t_n][i];
+            t_level[t_to] = std::max(t_level[t_to], t_level[t_n] + 1);
+            if (--t_num_sources[t_to] == 0)
+            {
+                t_ready.push_back(t_to);
+            }
+        }
+    }
+
+    m_acyclic = (t_num_placed == t_num_neurons - t_first);
+    if (!m_acyclic)
+    {
+        // a single level, only stepped synchronously
+        for (unsigned int i = t_first; i < t_num_neurons; i++)
+        {
+            t_level[i] = 1;
+        }
+        m_depth = (t_num_neurons > t_first) ? 1 : 0;
+    }
+
+    // group the non-input neurons by level, then by activation function, keeping their order
+    m_order.clear();
+    m_blocks.clear();
+    m_level_blocks.assign(1, 0);
+    for (unsigned int l = 1; l <= m_depth; l++)
+    {
+        for (int f = SIGNED_SIGMOID; f <= SOFTPLUS + 1; f++)
+        {
+            ActivationBlock t_block;
+            t_block.m_function = static_cast<ActivationFunction>(f);
+            t_block.m_begin = m_order.size();
+
+            for (unsigned int i = t_first; i < t_num_neurons; i++)
+            {
+                int t_function = m_neurons[i].m_activation_function_type;
+                // unknown functions are computed as unsigned sigmoids, last block
+                if ((t_function < SIGNED_SIGMOID) || (t_function > SOFTPLUS))
+                {
+                    t_function = SOFTPLUS + 1;
+                }
+                if ((t_level[i] == l) && (t_function == f))
+                {
+                    m_order.push_back(i);
+                }
+            }
+
+            t_block.m_end = m_order.size();
+            if (t_block.m_end > t_block.m_begin)
+            {
+                if (f > SOFTPLUS)
+                {
+                    t_block.m_function = UNSIGNED_SIGMOID;
+                }
+                m_blocks.push_back(t_block);
+            }
+        }
+        m_level_blocks.push_back(m_blocks.size());
+    }
+
+    // position of each neuron in m_order, -1 for inputs
+    std::vector<int> t_position(t_num_neurons, -1);
+    for (unsigned int i = 0; i < m_order.size(); i++)
+    {
+        t_position[m_order[i]] = i;
+    }
+
+    m_order_a.resize(m_order.size());
+    m_order_b.resize(m_order.size());
+    m_order_bias.resize(m_order.size());
+    m_order_sum.resize(m_order.size());
+    for (unsigned int i = 0; i < m_order.size(); i++)
+    {
+        m_order_a[i] = m_neurons[m_order[i]].m_a;
+        m_order_b[i] = m_neurons[m_order[i]].m_b;
+        m_order_bias[i] = m_neurons[m_order[i]].m_bias;
+    }
+
+    // count the incoming connections of each neuron, then place them in
+    // connection order so the sums are accumulated as before
+    m_row_start.assign(m_order.size() + 1, 0);
     for (unsigned int i = 0; i < m_connections.size(); i++)
     {
-        m_neurons[m_connections[i].m_target_neuron_idx].m_activesum +=
-                m_connections[i].m_signal;
+        int t_row = t_position[m_connections[i].m_target_neuron_idx];
+        if (t_row != -1)
+        {
+            m_row_start[t_row + 1]++;
+        }
     }
-    // Now loop nodes_activesums, pass the signals through the activation function
-    // and store the result back to nodes_activations
-    // also skip inputs since they do not get an activation
-    for (unsigned int i = m_num_inputs; i < m_neurons.size(); i++)
+    for (unsigned int i = 0; i < m_order.size(); i++)
     {
-        double x = m_neurons[i].m_activesum;
-        m_neurons[i].m_activesum = 0;
-        // Apply the activation function
-        double y = 0.0;
-        y = af_sigmoid_unsigned(x, m_neurons[i].m_a, m_neurons[i].m_b);
-        m_neurons[i].m_activation = y;
+        m_row_start[i + 1] += m_row_start[i];
     }
+
+    std::vector<unsigned int> t_next(m_row_start.begin(), m_row_start.end() - 1);
+    m_row_source.resize(m_row_start.back());
+    m_row_weight.resize(m_row_start.back());
+    for (unsigned int i = 0; i < m_connections.size(); i++)
+    {
+        int t_row = t_position[m_connections[i].m_target_neuron_idx];
+        if (t_row != -1)
+        {
+            m_row_source[t_next[t_row]] = m_connections[i].m_source_neuron_idx;
+            m_row_weight[t_next[t_row]] = m_connections[i].m_weight;
+            t_next[t_row]++;
+        }
+    }
+
+    m_flat_activation.resize(t_num_neurons);
+    m_compiled_connections = m_connections.size();
+    m_compiled = true;
 }
 
-void NeuralNetwork::Activate()
+// Applies one activation function to a block of neurons
+template <ActivationFunction F>
+inline double af_apply(double aX, double aA, double aB);
+
+template <> inline double af_apply<SIGNED_SIGMOID>(double aX, double aA, double aB) { return af_sigmoid_signed(aX, aA, aB); }
+template <> inline double af_apply<UNSIGNED_SIGMOID>(double aX, double aA, double aB) { return af_sigmoid_unsigned(aX, aA, aB); }
+template <> inline double af_apply<TANH>(double aX, double aA, double aB) { return af_tanh(aX, aA, aB); }
+template <> inline double af_apply<TANH_CUBIC>(double aX, double aA, double aB) { return af_tanh_cubic(aX, aA, aB); }
+template <> inline double af_apply<SIGNED_STEP>(double aX, double /*aA*/, double aB) { return af_step_signed(aX, aB); }
+template <> inline double af_apply<UNSIGNED_STEP>(double aX, double /*aA*/, double aB) { return af_step_unsigned(aX, aB); }
+template <> inline double af_apply<SIGNED_GAUSS>(double aX, double aA, double aB) { return af_gauss_signed(aX, aA, aB); }
+template <> inline double af_apply<UNSIGNED_GAUSS>(double aX, double aA, double aB) { return af_gauss_unsigned(aX, aA, aB); }
+template <> inline double af_apply<ABS>(double aX, double /*aA*/, double aB) { return af_abs(aX, aB); }
+template <> inline double af_apply<SIGNED_SINE>(double aX, double aA, double aB) { return af_sine_signed(aX, aA, aB); }
+template <> inline double af_apply<UNSIGNED_SINE>(double aX, double aA, double aB) { return af_sine_unsigned(aX, aA, aB); }
+template <> inline double af_apply<LINEAR>(double aX, double /*aA*/, double aB) { return af_linear(aX, aB); }
+template <> inline double af_apply<RELU>(double aX, double /*aA*/, double /*aB*/) { return af_relu(aX); }
+template <> inline double af_apply<SOFTPLUS>(double aX, double /*aA*/, double /*aB*/) { return af_softplus(aX); }
+
+template <ActivationFunction F>
+void af_block(unsigned int aBegin, unsigned int aEnd, const unsigned int* aOrder,
+              const double* aSum, const double* aA, const double* aB, double* aActivation)
 {
-    // Loop connections. Calculate each connection's output signal.
-    for (unsigned int i = 0; i < m_connections.size(); i++)
+    for (unsigned int i = aBegin; i < aEnd; i++)
     {
-        m_connections[i].m_signal =
-                m_neurons[m_connections[i].m_source_neuron_idx].m_activation
-                        * m_connections[i].m_weight;
+        aActivation[aOrder[i]] = af_apply<F>(aSum[i], aA[i], aB[i]);
     }
-    // Loop the connections again. This time add the signals to the target neurons.
-    // This will largely require out of order memory writes. This is the one loop where
-    // this will happen.
-    for (unsigned int i = 0; i < m_connections.size(); i++)
+}
+
+void NeuralNetwork::EnsureCompiled()
+{
+    if (!m_compiled || (m_flat_activation.size() != m_neurons.size())
+            || (m_compiled_connections != m_connections.size()))
     {
-        m_neurons[m_connections[i].m_target_neuron_idx].m_activesum +=
-                m_connections[i].m_signal;
+        Compile();
     }
-    // Now loop nodes_activesums, pass the signals through the activation function
-    // and store the result back to nodes_activations
-    // also skip inputs since they do not get an activation
-    for (unsigned int i = m_num_inputs; i < m_neurons.size(); i++)
+}
+
+void NeuralNetwork::SumRows(unsigned int a_Begin, unsigned int a_End, bool a_UseBias)
+{
+    if ((a_Begin >= a_End) || m_row_source.empty())
     {
-        double x = m_neurons[i].m_activesum;
-        m_neurons[i].m_activesum = 0;
-        // Apply the activation function
-        double y = 0.0;
-        switch (m_neurons[i].m_activation_function_type)
+        // no signals, only the bias
+        for (unsigned int i = a_Begin; i < a_End; i++)
         {
-        case SIGNED_SIGMOID:
-            y = af_sigmoid_signed(x, m_neurons[i].m_a, m_neurons[i].m_b);
-            break;
-        case UNSIGNED_SIGMOID:
-            y = af_sigmoid_unsigned(x, m_neurons[i].m_a, m_neurons[i].m_b);
-            break;
-        case TANH:
-            y = af_tanh(x, m_neurons[i].m_a, m_neurons[i].m_b);
-            break;
-        case TANH_CUBIC:
-            y = af_tanh_cubic(x, m_neurons[i].m_a, m_neurons[i].m_b);
-            break;
-        case SIGNED_STEP:
-            y = af_step_signed(x, m_neurons[i].m_b);
-            break;
-        case UNSIGNED_STEP:
-            y = af_step_unsigned(x, m_neurons[i].m_b);
-            break;
-        case SIGNED_GAUSS:
-            y = af_gauss_signed(x, m_neurons[i].m_a, m_neurons[i].m_b);
-            break;
-        case UNSIGNED_GAUSS:
-            y = af_gauss_unsigned(x, m_neurons[i].m_a, m_neurons[i].m_b);
-            break;
-        case ABS:
-            y = af_abs(x, m_neurons[i].m_b);
-            break;
-        case SIGNED_SINE:
-            y = af_sine_signed(x, m_neurons[i].m_a, m_neurons[i].m_b);
-            break;
-        case UNSIGNED_SINE:
-            y = af_sine_unsigned(x, m_neurons[i].m_a, m_neurons[i].m_b);
-            break;
-        case LINEAR:
-            y = af_linear(x, m_neurons[i].m_b);
-            break;
-        case RELU:
-            y = af_relu(x);
-            break;
-        case SOFTPLUS:
-            y = af_softplus(x);
-            break;
-        default:
-            y = af_sigmoid_unsigned(x, m_neurons[i].m_a, m_neurons[i].m_b);
-            break;
+            if (a_UseBias)
+            {
+                m_order_sum[i] += m_order_bias[i];
+            }
+        }
+        return;
+    }
 
+    const unsigned int* t_source = &m_row_source[0];
+    const double* t_weight = &m_row_weight[0];
+    const double* t_activation = &m_flat_activation[0];
+    for (unsigned int i = a_Begin; i < a_End; i++)
+    {
+        double t_sum = m_order_sum[i];
+        for (unsigned int j = m_row_start[i]; j < m_row_start[i + 1]; j++)
+        {
+            t_sum += t_activation[t_source[j]] * t_weight[j];
         }
-        m_neurons[i].m_activation = y;
+        if (a_UseBias)
+        {
+            t_sum += m_order_bias[i];
+        }
+        m_order_sum[i] = t_sum;
     }
+}
 
+void NeuralNetwork::ApplyBlock(unsigned int a_Block, bool a_UnsignedSigmoidOnly)
+{
+    const ActivationFunction t_function = a_UnsignedSigmoidOnly ? UNSIGNED_SIGMOID : m_blocks[a_Block].m_function;
+    const unsigned int t_begin = m_blocks[a_Block].m_begin;
+    const unsigned int t_end = m_blocks[a_Block].m_end;
+    const unsigned int* t_order = &m_order[0];
+    const double* t_sum = &m_order_sum[0];
+    const double* t_a = &m_order_a[0];
+    const double* t_b = &m_order_b[0];
+    double* t_out = &m_flat_activation[0];
+
+    switch (t_function)
+    {
+    case SIGNED_SIGMOID:
+        af_block<SIGNED_SIGMOID>(t_begin, t_end, t_order, t_sum, t_a, t_b, t_out);
+        break;
+    case UNSIGNED_SIGMOID:
+        af_block<UNSIGNED_SIGMOID>(t_begin, t_end, t_order, t_sum, t_a, t_b, t_out);
+        break;
+    case TANH:
+        af_block<TANH>(t_begin, t_end, t_order, t_sum, t_a, t_b, t_out);
+        break;
+    case TANH_CUBIC:
+        af_block<TANH_CUBIC>(t_begin, t_end, t_order, t_sum, t_a, t_b, t_out);
+        break;
+    case SIGNED_STEP:
+        af_block<SIGNED_STEP>(t_begin, t_end, t_order, t_sum, t_a, t_b, t_out);
+        break;
+    case UNSIGNED_STEP:
+        af_block<UNSIGNED_STEP>(t_begin, t_end, t_order, t_sum, t_a, t_b, t_out);
+        break;
+    case SIGNED_GAUSS:
+        af_block<SIGNED_GAUSS>(t_begin, t_end, t_order, t_sum, t_a, t_b, t_out);
+        break;
+    case UNSIGNED_GAUSS:
+        af_block<UNSIGNED_GAUSS>(t_begin, t_end, t_order, t_sum, t_a, t_b, t_out);
+        break;
+    case ABS:
+        af_block<ABS>(t_begin, t_end, t_order, t_sum, t_a, t_b, t_out);
+        break;
+    case SIGNED_SINE:
+        af_block<SIGNED_SINE>(t_begin, t_end, t_order, t_sum, t_a, t_b, t_out);
+        break;
+    case UNSIGNED_SINE:
+        af_block<UNSIGNED_SINE>(t_begin, t_end, t_order, t_sum, t_a, t_b, t_out);
+        break;
+    case LINEAR:
+        af_block<LINEAR>(t_begin, t_end, t_order, t_sum, t_a, t_b, t_out);
+        break;
+    case RELU:
+        af_block<RELU>(t_begin, t_end, t_order, t_sum, t_a, t_b, t_out);
+        break;
+    case SOFTPLUS:
+        af_block<SOFTPLUS>(t_begin, t_end, t_order, t_sum, t_a, t_b, t_out);
+        break;
+    default:
+        af_block<UNSIGNED_SIGMOID>(t_begin, t_end, t_order, t_sum, t_a, t_b, t_out);
+        break;
+    }
 }
 
-void NeuralNetwork::ActivateUseInternalBias()
+void NeuralNetwork::ActivateCompiled(bool a_UseBias, bool a_UnsignedSigmoidOnly)
 {
-    // Loop connections. Calculate each connection's output signal.
-    for (unsigned int i = 0; i < m_connections.size(); i++)
+    EnsureCompiled();
+
+    if (m_order.empty())
     {
-        m_connections[i].m_signal =
-                m_neurons[m_connections[i].m_source_neuron_idx].m_activation
-                        * m_connections[i].m_weight;
+        return;
     }
-    // Loop the connections again. This time add the signals to the target neurons.
-    // This will largely require out of order memory writes. This is the one loop where
-    // this will happen.
-    for (unsigned int i = 0; i < m_connections.size(); i++)
+
+    for (unsigned int i = 0; i < m_neurons.size(); i++)
     {
-        m_neurons[m_connections[i].m_target_neuron_idx].m_activesum +=
-                m_connections[i].m_signal;
+        m_flat_activation[i] = m_neurons[i].m_activation;
     }
-    // Now loop nodes_activesums, pass the signals through the activation function
-    // and store the result back to nodes_activations
-    // also skip inputs since they do not get an activation
-    for (unsigned int i = m_num_inputs; i < m_neurons.size(); i++)
+    for (unsigned int i = 0; i < m_order.size(); i++)
     {
-        double x = m_neurons[i].m_activesum + m_neurons[i].m_bias;
-        m_neurons[i].m_activesum = 0;
-        // Apply the activation function
-        double y = 0.0;
-        switch (m_neurons[i].m_activation_function_type)
+        m_order_sum[i] = m_neurons[m_order[i]].m_activesum;
+    }
+
+    // Gather each neuron's input signals from the previous activations.
+    // All sums are done before any activation changes.
+    SumRows(0, m_order.size(), a_UseBias);
+
+    // Pass the sums through the activation functions, one block at a time
+    for (unsigned int i = 0; i < m_blocks.size(); i++)
+    {
+        ApplyBlock(i, a_UnsignedSigmoidOnly);
+    }
+
+    // store the new activations back in the neurons
+    for (unsigned int i = 0; i < m_order.size(); i++)
+    {
+        Neuron& t_neuron = m_neurons[m_order[i]];
+        t_neuron.m_activation = m_flat_activation[m_order[i]];
+        t_neuron.m_activesum = 0;
+    }
+}
+
+void NeuralNetwork::ActivateBatch(const std::vector< std::vector<double> >& a_Inputs, unsigned int a_Steps,
+                                  std::vector< std::vector<double> >& a_Outputs)
+{
+    EnsureCompiled();
+
+    // After as many steps as there are levels every neuron of an acyclic
+    // network holds its final value, the same one a pass in level order gives
+    const bool t_in_order = m_acyclic && (a_Steps >= m_depth);
+
+    a_Outputs.resize(a_Inputs.size());
+    for (unsigned int r = 0; r < a_Inputs.size(); r++)
+    {
+        if (a_Inputs[r].size() != m_num_inputs)
+            throw std::exception();
+
+        // start from a flushed network
+        std::fill(m_flat_activation.begin(), m_flat_activation.end(), 0.0);
+        for (unsigned int i = 0; i < m_num_inputs; i++)
         {
-        case SIGNED_SIGMOID:
-            y = af_sigmoid_signed(x, m_neurons[i].m_a, m_neurons[i].m_b);
-            break;
-        case UNSIGNED_SIGMOID:
-            y = af_sigmoid_unsigned(x, m_neurons[i].m_a, m_neurons[i].m_b);
-            break;
-        case TANH:
-            y = af_tanh(x, m_neurons[i].m_a, m_neurons[i].m_b);
-            break;
-        case TANH_CUBIC:
-            y = af_tanh_cubic(x, m_neurons[i].m_a, m_neurons[i].m_b);
-            break;
-        case SIGNED_STEP:
-            y = af_step_signed(x, m_neurons[i].m_b);
-            break;
-        case UNSIGNED_STEP:
-            y = af_step_unsigned(x, m_neurons[i].m_b);
-            break;
-        case SIGNED_GAUSS:
-            y = af_gauss_signed(x, m_neurons[i].m_a, m_neurons[i].m_b);
-            break;
-        case UNSIGNED_GAUSS:
-            y = af_gauss_unsigned(x, m_neurons[i].m_a, m_neurons[i].m_b);
-            break;
-        case ABS:
-            y = af_abs(x, m_neurons[i].m_b);
-            break;
-        case SIGNED_SINE:
-            y = af_sine_signed(x, m_neurons[i].m_a, m_neurons[i].m_b);
-            break;
-        case UNSIGNED_SINE:
-            y = af_sine_unsigned(x, m_neurons[i].m_a, m_neurons[i].m_b);
-            break;
-        case LINEAR:
-            y = af_linear(x, m_neurons[i].m_b);
-            break;
-        case RELU:
-            y = af_relu(x);
-            break;
-        case SOFTPLUS:
-            y = af_softplus(x);
-            break;
-        default:
-            y = af_sigmoid_unsigned(x, m_neurons[i].m_a, m_neurons[i].m_b);
-            break;
+            m_flat_activation[i] = a_Inputs[r][i];
         }
-        m_neurons[i].m_activation = y;
+
+        if (t_in_order)
+        {
+            for (unsigned int l = 0; l + 1 < m_level_blocks.size(); l++)
+            {
+                const unsigned int t_first_block = m_level_blocks[l];
+                const unsigned int t_last_block = m_level_blocks[l + 1];
+                if (t_first_block == t_last_block)
+                {
+                    continue;
+                }
+
+                const unsigned int t_begin = m_blocks[t_first_block].m_begin;
+                const unsigned int t_end = m_blocks[t_last_block - 1].m_end;
+                std::fill(m_order_sum.begin() + t_begin, m_order_sum.begin() + t_end, 0.0);
+                SumRows(t_begin, t_end, false);
+                for (unsigned int b = t_first_block; b < t_last_block; b++)
+                {
+                    ApplyBlock(b, false);
+                }
+            }
+        }
+        else
+        {
+            for (unsigned int t = 0; t < a_Steps; t++)
+            {
+                std::fill(m_order_sum.begin(), m_order_sum.end(), 0.0);
+                SumRows(0, m_order.size(), false);
+                for (unsigned int b = 0; b < m_blocks.size(); b++)
+                {
+                    ApplyBlock(b, false);
+                }
+            }
+        }
+
+        a_Outputs[r].assign(m_flat_activation.begin() + m_num_inputs,
+                            m_flat_activation.begin() + m_num_inputs + m_num_outputs);
     }
 
+    Flush();
+}
+
+void NeuralNetwork::ActivateFast()
+{
+    // assumes unsigned sigmoids everywhere
+    ActivateCompiled(false, true);
+}
+
+void NeuralNetwork::Activate()
+{
+    ActivateCompiled(false, false);
+}
+
+void NeuralNetwork::ActivateUseInternalBias()
+{
+    ActivateCompiled(true, false);
 }
 
 void NeuralNetwork::ActivateLeaky(double a_dtime)
@@ -697,6 +912,9 @@ void NeuralNetwork::Adapt(Parameters& a_Parameters)
                 a_Parameters.MaxWeight);
     }
 
+    // the weights changed
+    m_compiled = false;
+
 }
 
 int NeuralNetwork::ConnectionExists(int a_to, int a_from)
@@ -800,6 +1018,9 @@ void NeuralNetwork::RTRL_update_weights()
         m_total_weight_change[i] = 0; // clear this out
     }
     m_total_error = 0;
+
+    // the weights changed
+    m_compiled = false;
 }
 
 void NeuralNetwork::Save(const char* a_filename)
@@ -125,6 +125,59 @@ class NeuralNetwork
     // returns the index if that connection exists or -1 otherwise
     int ConnectionExists(int a_to, int a_from);
 
+    /////////////////////
+    // Compiled form used by Activate(), ActivateFast() and ActivateUseInternalBias()
+    // Built on the first activation and again when neurons or connections are
+    // added, removed or loaded, or after the weights are adapted.
+    bool m_compiled;
+
+    // True if the connections between non-input neurons form no cycle. Then
+    // each neuron's level is one more than the highest level of the non-input
+    // neurons feeding it, and m_depth is the highest level.
+    bool m_acyclic;
+    unsigned int m_depth;
+
+    // The non-input neurons grouped by level, then by activation function,
+    // everything below is indexed by position in this order
+    std::vector<unsigned int> m_order;
+    std::vector<double> m_order_a, m_order_b, m_order_bias;
+    std::vector<double> m_order_sum;
+
+    // Incoming connections of m_order[i] are in [m_row_start[i], m_row_start[i+1])
+    std::vector<unsigned int> m_row_start;
+    std::vector<unsigned int> m_row_source;
+    std::vector<double> m_row_weight;
+
+    // Consecutive positions in m_order sharing an activation function
+    struct ActivationBlock
+    {
+        ActivationFunction m_function;
+        unsigned int m_begin, m_end;
+    };
+    std::vector<ActivationBlock> m_blocks;
+
+    // Blocks of level l+1 are [m_level_blocks[l], m_level_blocks[l+1])
+    std::vector<unsigned int> m_level_blocks;
+
+    // Activations by neuron index
+    std::vector<double> m_flat_activation;
+
+    // Number of connections when compiled, to notice direct changes of m_connections
+    unsigned int m_compiled_connections;
+
+    // Performs one activation step with the compiled form. Same results as the
+    // connection by connection loops, the signals of the connections are not stored.
+    void ActivateCompiled(bool a_UseBias, bool a_UnsignedSigmoidOnly);
+
+    void EnsureCompiled();
+
+    // Adds the incoming signals of the neurons at positions [a_Begin, a_End) to m_order_sum
+    void SumRows(unsigned int a_Begin, unsigned int a_End, bool a_UseBias);
+
+    // Passes the sums of a block through its activation function
+    void ApplyBlock(unsigned int a_Block, bool a_UnsignedSigmoidOnly);
+    /////////////////////
+
 public:
 
     unsigned short m_num_inputs, m_num_outputs;
@@ -137,11 +190,22 @@ public:
     void InitRTRLMatrix(); // initializes the sensitivity cube for RTRL learning.
     // assumes that neuron and connection data are already initialized
 
+    // Builds the compiled form used for activation. Done automatically, call it
+    // only after changing weights or neuron parameters in place between activations.
+    void Compile();
+
     void ActivateFast();          // assumes unsigned sigmoids everywhere.
     void Activate();              // any activation functions are supported
     void ActivateUseInternalBias(); // like Activate() but uses m_bias as well
     void ActivateLeaky(double step); // activates in leaky integrator mode
 
+    // Queries the network once per row of a_Inputs, each row giving the outputs
+    // Flush(), Input(), a_Steps times Activate() and Output() would give.
+    // Acyclic networks deep enough to settle within a_Steps are activated once
+    // in level order instead. The network is flushed afterwards.
+    void ActivateBatch(const std::vector< std::vector<double> >& a_Inputs, unsigned int a_Steps,
+                       std::vector< std::vector<double> >& a_Outputs);
+
     void RTRL_update_gradients();
     void RTRL_update_error(double a_target);
     void RTRL_update_weights();   // performs the backprop step
@@ -164,8 +228,8 @@ public:
     std::vector<double> Output();
 
     // accessor methods
-    void AddNeuron(const Neuron& a_n) { m_neurons.push_back( a_n ); }
-    void AddConnection(const Connection& a_c) { m_connections.push_back( a_c ); }
+    void AddNeuron(const Neuron& a_n) { m_neurons.push_back( a_n ); m_compiled = false; }
+    void AddConnection(const Connection& a_c) { m_connections.push_back( a_c ); m_compiled = false; }
     Connection GetConnectionByIndex(unsigned int a_idx) const
     {
         return m_connections[a_idx];
@@ -195,6 +259,7 @@ public:
         m_connections.clear();
         m_total_weight_change.clear();
         SetInputOutputDimentions(0, 0);
+        m_compiled = false;
     }
 
     double GetConnectionLenght(Neuron source, Neuron target)
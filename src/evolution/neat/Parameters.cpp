@@ -70,6 +70,9 @@ void Parameters::Reset()
     // search quickly, yet less efficient, leave this to true.
     AllowClones = true;
 
+    // Number of threads used for speciation and novelty search (0 means one per hardware thread)
+    NumThreads = 1;
+
 
 
 
@@ -418,7 +421,7 @@ Parameters::Parameters()
 }
 
 
-int Parameters::Load(std::ifstream& a_DataFile)
+int Parameters::Load(std::istream& a_DataFile)
 {
     std::string s,tf;
     do
@@ -467,6 +470,9 @@ int Parameters::Load(std::ifstream& a_DataFile)
                 AllowClones = false;
         }
 
+        if (s == "NumThreads")
+            a_DataFile >> NumThreads;
+
         if (s == "YoungAgeTreshold")
             a_DataFile >> YoungAgeTreshold;
 
@@ -825,8 +831,6 @@ int Parameters::Load(std::ifstream& a_DataFile)
             else
                 LeoSeed = false;
         }
-        if (s == "TournamentSize")
-            a_DataFile >> TournamentSize;
         if (s == "Elitism")
             a_DataFile >> Elitism;
     }
@@ -864,6 +868,7 @@ void Parameters::Save(FILE* a_fstream)
     fprintf(a_fstream, "MaxSpecies %d\n", MaxSpecies);
     fprintf(a_fstream, "InnovationsForever %s\n", InnovationsForever==true?"true":"false");
     fprintf(a_fstream, "AllowClones %s\n", AllowClones==true?"true":"false");
+    fprintf(a_fstream, "NumThreads %d\n", NumThreads);
     fprintf(a_fstream, "YoungAgeTreshold %d\n", YoungAgeTreshold);
     fprintf(a_fstream, "YoungAgeFitnessBoost %3.20f\n", YoungAgeFitnessBoost);
     fprintf(a_fstream, "SpeciesDropoffAge %d\n", SpeciesMaxStagnation);
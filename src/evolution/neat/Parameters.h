@@ -30,6 +30,9 @@
 // Description: Definition for the parameters class.
 ///////////////////////////////////////////////////////////////////////////////
 
+#include <stdio.h>
+#include <istream>
+
 #ifdef USE_BOOST_PYTHON
 
 #include <boost/python.hpp>
@@ -84,6 +87,9 @@ public:
     // search quickly, yet less efficient, leave this to true.
     bool AllowClones;
 
+    // Number of threads used for speciation and novelty search (0 means one per hardware thread)
+    unsigned int NumThreads;
+
    ////////////////////////////////
     // GA Parameters
     ////////////////////////////////
@@ -412,8 +418,8 @@ public:
     // Load the parameters from a file
     // returns 0 on success
     int Load(const char* filename);
-    // Load the parameters from an already opened file for reading
-    int Load(std::ifstream& a_DataFile);
+    // Load the parameters from an already opened file or stream for reading
+    int Load(std::istream& a_DataFile);
 
     void Save(const char* filename);
     // Saves the parameters to an already opened file for writing
@@ -436,6 +442,7 @@ public:
         ar & MaxSpecies;
         ar & InnovationsForever;
         ar & AllowClones;
+        ar & NumThreads;
         ar & YoungAgeTreshold;
         ar & YoungAgeFitnessBoost;
         ar & SpeciesMaxStagnation;
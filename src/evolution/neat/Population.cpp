@@ -31,6 +31,8 @@
 
 #include <algorithm>
 #include <fstream>
+#include <utility>
+#include <boost/bind.hpp>
 
 #include "Genome.h"
 #include "Species.h"
@@ -38,6 +40,7 @@
 #include "Parameters.h"
 #include "PhenotypeBehavior.h"
 #include "Population.h"
+#include "utils/ParallelFor.h"
 #include "Utils.h"
 #include "Assert.h"
 
@@ -113,7 +116,7 @@ Population::Population(const Genome& a_Seed, const Parameters& a_Parameters,
     m_BaseMPC = m_CurrentMPC;
     m_OldMPC = m_BaseMPC;
 
-    m_InnovationDatabase.m_Innovations.reserve(50000);
+    m_InnovationDatabase.Reserve(50000);
 }
 
 
@@ -202,6 +205,126 @@ void Population::Save(const char* a_FileName)
 }
 
 
+// Restores a population saved by SaveState()
+Population::Population(std::istream& a_DataFile)
+{
+    m_BehaviorArchive = NULL;
+
+    // Load the parameters
+    m_Parameters.Load(a_DataFile);
+
+    // Load the innovation database
+    m_InnovationDatabase.Init(a_DataFile);
+
+    std::string t_str;
+    do
+    {
+        a_DataFile >> t_str;
+    }
+    while (a_DataFile && (t_str != "PopulationStateStart"));
+
+    int t_searchmode;
+    a_DataFile >> t_str >> m_Generation;
+    a_DataFile >> t_str >> m_NextGenomeID;
+    a_DataFile >> t_str >> m_NextSpeciesID;
+    a_DataFile >> t_str >> t_searchmode;
+    a_DataFile >> t_str >> m_CurrentMPC;
+    a_DataFile >> t_str >> m_OldMPC;
+    a_DataFile >> t_str >> m_BaseMPC;
+    a_DataFile >> t_str >> m_BestFitnessEver;
+    a_DataFile >> t_str >> m_GensSinceBestFitnessLastChanged;
+    a_DataFile >> t_str >> m_GensSinceMPCLastChanged;
+    a_DataFile >> t_str >> m_NumEvaluations;
+    a_DataFile >> t_str >> m_GensSinceLastArchiving;
+    a_DataFile >> t_str >> m_QuickAddCounter;
+    m_SearchMode = static_cast<SearchMode>(t_searchmode);
+
+    m_RNG.Load(a_DataFile);
+
+    // the initial genomes
+    unsigned int t_num;
+    a_DataFile >> t_str >> t_num;
+    m_Genomes.resize(t_num);
+    for(unsigned int i=0; i<t_num; i++)
+    {
+        m_Genomes[i].LoadState(a_DataFile);
+    }
+
+    // the species with their individuals
+    a_DataFile >> t_str >> t_num;
+    m_Species.reserve(t_num);
+    for(unsigned int i=0; i<t_num; i++)
+    {
+        m_Species.push_back( Species(a_DataFile) );
+    }
+
+    m_BestGenome.LoadState(a_DataFile);
+    m_BestGenomeEver.LoadState(a_DataFile);
+
+    do
+    {
+        a_DataFile >> t_str;
+    }
+    while (a_DataFile && (t_str != "PopulationStateEnd"));
+
+    if (!a_DataFile)
+        throw std::exception();
+
+    m_InnovationDatabase.Reserve(50000);
+}
+
+
+// Save a whole population and the state of the search to a file
+void Population::SaveState(const char* a_FileName)
+{
+    FILE* t_file = fopen(a_FileName, "w");
+    SaveState(t_file);
+    fclose(t_file);
+}
+
+
+// Save a whole population and the state of the search to an already opened file
+void Population::SaveState(FILE* a_file)
+{
+    m_Parameters.Save(a_file);
+    m_InnovationDatabase.Save(a_file);
+
+    fprintf(a_file, "PopulationStateStart\n");
+    fprintf(a_file, "Generation %u\n", m_Generation);
+    fprintf(a_file, "NextGenomeID %u\n", m_NextGenomeID);
+    fprintf(a_file, "NextSpeciesID %u\n", m_NextSpeciesID);
+    fprintf(a_file, "SearchMode %d\n", static_cast<int>(m_SearchMode));
+    fprintf(a_file, "CurrentMPC %.17g\n", m_CurrentMPC);
+    fprintf(a_file, "OldMPC %.17g\n", m_OldMPC);
+    fprintf(a_file, "BaseMPC %.17g\n", m_BaseMPC);
+    fprintf(a_file, "BestFitnessEver %.17g\n", m_BestFitnessEver);
+    fprintf(a_file, "GensSinceBestFitnessLastChanged %u\n", m_GensSinceBestFitnessLastChanged);
+    fprintf(a_file, "GensSinceMPCLastChanged %u\n", m_GensSinceMPCLastChanged);
+    fprintf(a_file, "NumEvaluations %u\n", m_NumEvaluations);
+    fprintf(a_file, "GensSinceLastArchiving %u\n", m_GensSinceLastArchiving);
+    fprintf(a_file, "QuickAddCounter %u\n", m_QuickAddCounter);
+
+    m_RNG.Save(a_file);
+
+    fprintf(a_file, "Genomes %u\n", static_cast<unsigned int>(m_Genomes.size()));
+    for(unsigned int i=0; i<m_Genomes.size(); i++)
+    {
+        m_Genomes[i].SaveState(a_file);
+    }
+
+    fprintf(a_file, "Species %u\n", static_cast<unsigned int>(m_Species.size()));
+    for(unsigned int i=0; i<m_Species.size(); i++)
+    {
+        m_Species[i].Save(a_file);
+    }
+
+    m_BestGenome.SaveState(a_file);
+    m_BestGenomeEver.SaveState(a_file);
+
+    fprintf(a_file, "PopulationStateEnd\n");
+}
+
+
 // Calculates the current mean population complexity
 void Population::CalculateMPC()
 {
@@ -227,52 +350,57 @@ void Population::Speciate()
     // first clear out the species
     m_Species.clear();
 
-
-    bool t_added = false;
-
-    // NOTE: we are comparing the new generation's genomes to the representatives from the previous generation!
-    // Any new species that is created is assigned a representative from the new generation.
+    // compact copies of the genes, compared instead of the genomes
+    std::vector<const Genome*> t_genome_ptrs;
+    for(unsigned int i=0; i<m_Genomes.size(); i++)
+    {
+        t_genome_ptrs.push_back(&m_Genomes[i]);
+    }
+    std::vector<GeneSignature> t_signatures;
+    BuildSignatures(t_genome_ptrs, t_signatures);
+
+    // Each genome joins the first species it is compatible with or founds a new one.
+    // As all species are created here, every genome not placed yet is compatible
+    // with none of the existing species, so it only needs to be compared with the
+    // representative of the newest one. These comparisons are done all at once.
+    std::vector<unsigned int> t_remaining;
     for(unsigned int i=0; i<m_Genomes.size(); i++)
     {
-        t_added = false;
+        t_remaining.push_back(i);
+    }
 
-        // iterate through each species and check if compatible. If compatible, then add to the species.
-        // if not compatible, create a new species.
-        for(unsigned int j=0; j<m_Species.size(); j++)
+    while(!t_remaining.empty())
+    {
+        // didn't find compatible species, create new species
+        const unsigned int t_founder = t_remaining[0];
+        m_Species.push_back( Species(m_Genomes[t_founder], m_NextSpeciesID));
+        m_NextSpeciesID++;
+
+        std::vector<const GeneSignature*> t_genomes;
+        std::vector<const GeneSignature*> t_representative(1, &t_signatures[t_founder]);
+        for(unsigned int i=1; i<t_remaining.size(); i++)
         {
-            Genome tmp = m_Species[j].GetRepresentative();
-            if (m_Genomes[i].IsCompatibleWith( tmp, m_Parameters ))
-            {
-                // Compatible, add to species
-                m_Species[j].AddIndividual( m_Genomes[i] );
-                t_added = true;
-
-                break;
-            }
+            t_genomes.push_back(&t_signatures[t_remaining[i]]);
         }
 
-        if (!t_added)
-        {
-            // didn't find compatible species, create new species
-            m_Species.push_back( Species(m_Genomes[i], m_NextSpeciesID));
-            m_NextSpeciesID++;
-        }
-    }
+        // nothing to cache, all genomes are new
+        std::vector<int> t_species;
+        FindCompatibleSpecies(t_genomes, t_representative, t_species, 0);
 
-    // Remove all empty species (cleanup routine for every case..)
-    std::vector<Species>::iterator t_cs = m_Species.begin();
-    while(t_cs != m_Species.end())
-    {
-        if (t_cs->NumIndividuals() == 0)
+        std::vector<unsigned int> t_incompatible;
+        for(unsigned int i=1; i<t_remaining.size(); i++)
         {
-            // remove the dead species
-            t_cs = m_Species.erase( t_cs );
-
-            if (t_cs != m_Species.begin()) // in case the first species are dead
-                t_cs--;
+            if (t_species[i-1] == 0)
+            {
+                // Compatible, add to species
+                m_Species.back().AddIndividual( m_Genomes[t_remaining[i]] );
+            }
+            else
+            {
+                t_incompatible.push_back(t_remaining[i]);
+            }
         }
-
-        t_cs++;
+        t_remaining.swap(t_incompatible);
     }
 
 
@@ -314,6 +442,227 @@ void Population::Speciate()
 
 
 
+// Builds the compact genes of a_Genomes[a_Idx]
+static void BuildSignature(const std::vector<const Genome*>& a_Genomes, std::vector<GeneSignature>& a_Signatures, unsigned int a_Idx)
+{
+    a_Signatures[a_Idx] = GeneSignature(*a_Genomes[a_Idx]);
+}
+
+
+// Builds the compact genes of each genome
+void Population::BuildSignatures(const std::vector<const Genome*>& a_Genomes, std::vector<GeneSignature>& a_Signatures) const
+{
+    a_Signatures.clear();
+    a_Signatures.resize(a_Genomes.size());
+
+    robogen::parallelFor(a_Genomes.size(), m_Parameters.NumThreads,
+            boost::bind(&BuildSignature, boost::cref(a_Genomes), boost::ref(a_Signatures), _1));
+}
+
+
+// Finds for each genome the index of the first representative it is compatible with (-1 if none)
+void Population::FindCompatibleSpecies(const std::vector<const GeneSignature*>& a_Genomes,
+                                       const std::vector<const GeneSignature*>& a_Representatives,
+                                       std::vector<int>& a_Species, unsigned int a_FirstNewID)
+{
+    a_Species.assign(a_Genomes.size(), -1);
+    std::vector< std::vector<CompatibilityTerms> > t_terms(a_Genomes.size());
+
+    robogen::parallelFor(a_Genomes.size(), m_Parameters.NumThreads,
+            boost::bind(&Population::CompareWithRepresentatives, this,
+                    boost::cref(a_Genomes), boost::cref(a_Representatives),
+                    boost::ref(a_Species), boost::ref(t_terms), a_FirstNewID, _1));
+
+    // remember the comparisons for the next epochs
+    for(unsigned int i=0; i<a_Genomes.size(); i++)
+    {
+        if (a_Genomes[i]->m_ID >= a_FirstNewID)
+        {
+            continue;
+        }
+
+        for(unsigned int j=0; j<t_terms[i].size(); j++)
+        {
+            if (a_Representatives[j]->m_ID >= a_FirstNewID)
+            {
+                continue;
+            }
+            m_CompatibilityCache.Store(*a_Genomes[i], *a_Representatives[j], t_terms[i][j], m_Generation);
+        }
+    }
+}
+
+
+// Compares one genome with the representatives in order until a compatible one is found
+void Population::CompareWithRepresentatives(const std::vector<const GeneSignature*>& a_Genomes,
+                                            const std::vector<const GeneSignature*>& a_Representatives,
+                                            std::vector<int>& a_Species,
+                                            std::vector< std::vector<CompatibilityTerms> >& a_Terms,
+                                            unsigned int a_FirstNewID, unsigned int a_Idx) const
+{
+    const GeneSignature& t_genome = *a_Genomes[a_Idx];
+
+    for(unsigned int j=0; j<a_Representatives.size(); j++)
+    {
+        const bool t_cached = (t_genome.m_ID < a_FirstNewID) && (a_Representatives[j]->m_ID < a_FirstNewID);
+
+        CompatibilityTerms t_terms;
+        if (!t_cached || !m_CompatibilityCache.Find(t_genome, *a_Representatives[j], t_terms))
+        {
+            t_terms = CompatibilityTerms(t_genome, *a_Representatives[j]);
+        }
+        a_Terms[a_Idx].push_back(t_terms);
+
+        if (IsCompatible(t_genome, *a_Representatives[j], t_terms, m_Parameters))
+        {
+            a_Species[a_Idx] = j;
+            return;
+        }
+    }
+}
+
+
+// Puts the offspring of all species into the new species (m_TempSpecies)
+void Population::SpeciateOffspring(std::vector<Genome>& a_Offspring,
+                                   const std::vector<unsigned int>& a_Parents,
+                                   const std::vector<bool>& a_Champions,
+                                   unsigned int a_FirstNewID)
+{
+    ASSERT(a_Offspring.size() == a_Parents.size());
+    ASSERT(a_Offspring.size() == a_Champions.size());
+
+    // the species existing before reproduction
+    const unsigned int t_num_existing = m_TempSpecies.size();
+
+    std::vector<const Genome*> t_babies;
+    for(unsigned int i=0; i<a_Offspring.size(); i++)
+    {
+        t_babies.push_back(&a_Offspring[i]);
+    }
+    std::vector<GeneSignature> t_offspring;
+    BuildSignatures(t_babies, t_offspring);
+
+    std::vector<const Genome*> t_representatives;
+    for(unsigned int i=0; i<t_num_existing; i++)
+    {
+        t_representatives.push_back(&m_TempSpecies[i].GetRepresentative());
+    }
+    std::vector<GeneSignature> t_representative_signatures;
+    BuildSignatures(t_representatives, t_representative_signatures);
+
+    // first compare every baby with the representatives of the existing species
+    std::vector<const GeneSignature*> t_genomes;
+    for(unsigned int i=0; i<t_offspring.size(); i++)
+    {
+        t_genomes.push_back(&t_offspring[i]);
+    }
+    std::vector<const GeneSignature*> t_existing;
+    for(unsigned int i=0; i<t_num_existing; i++)
+    {
+        t_existing.push_back(&t_representative_signatures[i]);
+    }
+
+    std::vector<int> t_target;
+    FindCompatibleSpecies(t_genomes, t_existing, t_target, a_FirstNewID);
+
+    // The babies that fit in none of them found new species, in the order they were
+    // produced. The ones that come after a founder are compared with it.
+    std::vector<unsigned int> t_remaining;
+    for(unsigned int i=0; i<t_target.size(); i++)
+    {
+        if (t_target[i] == -1)
+        {
+            t_remaining.push_back(i);
+        }
+    }
+
+    unsigned int t_num_new = 0;
+    while(!t_remaining.empty())
+    {
+        const unsigned int t_founder = t_remaining[0];
+        t_target[t_founder] = t_num_existing + t_num_new;
+
+        t_genomes.clear();
+        std::vector<const GeneSignature*> t_representative(1, &t_offspring[t_founder]);
+        for(unsigned int i=1; i<t_remaining.size(); i++)
+        {
+            t_genomes.push_back(&t_offspring[t_remaining[i]]);
+        }
+
+        std::vector<int> t_species;
+        FindCompatibleSpecies(t_genomes, t_representative, t_species, a_FirstNewID);
+
+        std::vector<unsigned int> t_incompatible;
+        for(unsigned int i=1; i<t_remaining.size(); i++)
+        {
+            if (t_species[i-1] == 0)
+            {
+                t_target[t_remaining[i]] = t_target[t_founder];
+            }
+            else
+            {
+                t_incompatible.push_back(t_remaining[i]);
+            }
+        }
+        t_remaining.swap(t_incompatible);
+        t_num_new++;
+    }
+
+    // Now move the babies into their species, in the order they were produced
+    for(unsigned int i=0; i<a_Offspring.size(); i++)
+    {
+        const unsigned int t_species_idx = t_target[i];
+
+        if (t_species_idx == m_TempSpecies.size())
+        {
+            // this baby founds a new species
+#ifdef NEAT_DEBUG
+            std::cout << "\tno species found, creating new one!" << std::endl;
+#endif
+            m_TempSpecies.push_back( Species(a_Offspring[i], GetNextSpeciesID()));
+            IncrementNextSpeciesID();
+        }
+        else
+        {
+#ifdef NEAT_DEBUG
+            std::cout << "adding to species " << t_species_idx << " "
+                    << m_TempSpecies[t_species_idx].ID() << std::endl;
+#endif
+            m_TempSpecies[t_species_idx].AddIndividual(std::move(a_Offspring[i]));
+        }
+
+        // If the champion of the best species ended up in another species,
+        // that one becomes the best species
+        Species& t_parent = m_Species[a_Parents[i]];
+        if (a_Champions[i] && t_parent.IsBestSpecies() &&
+                (m_TempSpecies[t_species_idx].ID() != t_parent.ID()))
+        {
+            for (size_t j = 0; j<m_TempSpecies.size(); ++j)
+            {
+                if (m_TempSpecies[j].IsBestSpecies())
+                {
+                    if (m_TempSpecies[j].m_Individuals.empty())
+                    {
+#ifdef NEAT_DEBUG
+                        std::cout << j << " " << m_TempSpecies[j].ID() <<
+                                " NO LONGER BEST" << std::endl;
+#endif
+                        m_TempSpecies[j].SetBestSpecies(false);
+                    }
+                    break;
+                }
+            }
+            m_TempSpecies[t_species_idx].SetBestSpecies(true);
+#ifdef NEAT_DEBUG
+            std::cout << "NEW BEST SPECIES " << t_species_idx << " " <<
+                    m_TempSpecies[t_species_idx].ID() << std::endl;
+#endif
+        }
+    }
+}
+
+
+
 // Adjust the fitness of all species
 void Population::AdjustFitness()
 {
@@ -481,6 +830,17 @@ void Population::UpdateSpecies()
 
 
 
+// Task reproducing species i into a_Broods[i]
+void Population::ReproduceSpeciesTask(std::vector<Brood>& a_Broods, unsigned int i)
+{
+#ifdef NEAT_DEBUG
+    std::cout << std::endl << "********  reproducing species " << i << " " << m_Species[i].ID() << std::endl;
+#endif
+    m_Species[i].Reproduce(*this, m_Parameters, a_Broods[i].m_RNG, a_Broods[i].m_Innovations,
+                           a_Broods[i].m_Offspring, a_Broods[i].m_New);
+}
+
+
 // the epoch method - the heart of the GA
 void Population::Epoch()
 {   
@@ -721,20 +1081,84 @@ void Population::Epoch()
    // for(unsigned int i=0; i<m_Species.size(); i++) m_Species[i].KillWorst(m_Parameters);
 
     // Perform reproduction for each species
+    // The new species start as copies of the current ones without their
+    // individuals, which are only set aside while copying
     m_TempSpecies.clear();
-    m_TempSpecies = m_Species;
-    for(unsigned int i=0; i<m_TempSpecies.size(); i++)
-        m_TempSpecies[i].Clear();
+    m_TempSpecies.reserve(m_Species.size());
+    for(unsigned int i=0; i<m_Species.size(); i++)
+    {
+        std::vector<Genome> t_individuals;
+        t_individuals.swap(m_Species[i].m_Individuals);
+        m_TempSpecies.push_back(m_Species[i]);
+        m_Species[i].m_Individuals.swap(t_individuals);
+    }
 
+    // The species reproduce in parallel, each with its own random stream and
+    // recording its innovations apart. These are merged afterwards species by
+    // species, so the outcome doesn't depend on the number of threads.
+    const unsigned int t_seed = m_RNG.RandInt(0, std::numeric_limits<int>::max() - 1);
+    std::vector<Brood> t_broods(m_Species.size());
     for(unsigned int i=0; i<m_Species.size(); i++)
     {
-#ifdef NEAT_DEBUG
-    	std::cout << std::endl << "********  reproducing species " << i << " " << m_Species[i].ID() << std::endl;
+        t_broods[i].m_Innovations.Stage(m_InnovationDatabase);
+        t_broods[i].m_RNG.Seed(t_seed, m_Generation, i);
+    }
+
+#ifdef USE_BOOST_RANDOM
+    const unsigned int t_num_threads = m_Parameters.NumThreads;
+#else
+    // rand() is shared by all threads
+    const unsigned int t_num_threads = 1;
 #endif
-        m_Species[i].Reproduce(*this, m_Parameters, m_RNG);
+    robogen::parallelFor(m_Species.size(), t_num_threads,
+            boost::bind(&Population::ReproduceSpeciesTask, this, boost::ref(t_broods), _1));
+
+    const unsigned int t_first_new_id = GetNextGenomeID();
+    unsigned int t_num_offspring = 0;
+    for(unsigned int i=0; i<m_Species.size(); i++)
+    {
+        t_num_offspring += t_broods[i].m_Offspring.size();
+    }
+    std::vector<Genome> t_offspring;
+    t_offspring.reserve(t_num_offspring);
+    std::vector<unsigned int> t_parents;
+    std::vector<bool> t_champions;
+    for(unsigned int i=0; i<m_Species.size(); i++)
+    {
+        Brood& t_brood = t_broods[i];
+
+        InnovationRemap t_remap;
+        m_InnovationDatabase.Merge(t_brood.m_Innovations, t_remap);
+        const bool t_renumber = !t_remap.IsIdentity();
+
+        for(unsigned int j=0; j<t_brood.m_Offspring.size(); j++)
+        {
+            Genome& t_baby = t_brood.m_Offspring[j];
+            if (t_brood.m_New[j])
+            {
+                if (t_renumber)
+                {
+                    t_baby.Renumber(t_remap);
+                }
+
+                // give the offspring a new ID
+                t_baby.SetID(GetNextGenomeID());
+                IncrementNextGenomeID();
+            }
+
+            t_offspring.push_back(std::move(t_baby));
+            t_parents.push_back(i);
+            // the first baby of a species is its champion
+            t_champions.push_back(j == 0);
+        }
     }
 
-    m_Species = m_TempSpecies;
+    // put the babies into their species
+    SpeciateOffspring(t_offspring, t_parents, t_champions, t_first_new_id);
+
+    // the previous generation is freed with the old species
+    m_Species.swap(m_TempSpecies);
+    m_TempSpecies.clear();
 
 
     // Now we kill off the old parents
@@ -792,6 +1216,9 @@ void Population::Epoch()
 
 
 
+    // Forget the comparisons with representatives that are gone
+    m_CompatibilityCache.Prune(m_Generation);
+
     // Increase generation number
     m_Generation++;
 
@@ -874,6 +1301,22 @@ unsigned int Population::ChooseParentSpecies()
 // Takes a genome and assigns it to a different species (where it belongs)
 void Population::ReassignSpecies(unsigned int a_genome_idx)
 {
+    std::vector<const Genome*> t_representatives;
+    for(unsigned int i=0; i<m_Species.size(); i++)
+    {
+        t_representatives.push_back(&m_Species[i].GetRepresentative());
+    }
+    std::vector<GeneSignature> t_representative_signatures;
+    BuildSignatures(t_representatives, t_representative_signatures);
+
+    ReassignSpecies(a_genome_idx, t_representative_signatures);
+}
+
+
+// Takes a genome and assigns it to a different species, comparing it with the given representatives
+void Population::ReassignSpecies(unsigned int a_genome_idx, std::vector<GeneSignature>& a_Representatives)
+{
+    ASSERT(a_Representatives.size() == m_Species.size());
     ASSERT(a_genome_idx < m_Genomes.size());
 
     // first remember where is this genome exactly
@@ -920,6 +1363,7 @@ void Population::ReassignSpecies(unsigned int a_genome_idx)
     if (m_Species[t_species_idx].m_Individuals.size() == 0)
     {
         m_Species.erase(m_Species.begin() + t_species_idx);
+        a_Representatives.erase(a_Representatives.begin() + t_species_idx);
     }
 
     // Find a new species for this genome
@@ -932,30 +1376,28 @@ void Population::ReassignSpecies(unsigned int a_genome_idx)
         // create the first species and place the baby there
         m_Species.push_back( Species(t_genome, GetNextSpeciesID()));
         IncrementNextSpeciesID();
+        a_Representatives.push_back(GeneSignature(t_genome));
     }
     else
     {
         // try to find a compatible species
-        Genome t_to_compare = t_cur_species->GetRepresentative();
+        GeneSignature t_signature(t_genome);
+        std::vector<const GeneSignature*> t_genomes(1, &t_signature);
+        std::vector<const GeneSignature*> t_existing;
+        for(unsigned int i=0; i<a_Representatives.size(); i++)
+        {
+            t_existing.push_back(&a_Representatives[i]);
+        }
 
-        t_found = false;
-        while((t_cur_species != m_Species.end()) && (!t_found))
+        // in real-time mode any genome may be compared again later
+        std::vector<int> t_species;
+        FindCompatibleSpecies(t_genomes, t_existing, t_species, GetNextGenomeID());
+
+        if (t_species[0] != -1)
         {
-            if (t_genome.IsCompatibleWith( t_to_compare, m_Parameters ))
-            {
-                // found a compatible species
-                t_cur_species->AddIndividual(t_genome);
-                t_found = true; // the search is over
-            }
-            else
-            {
-                // keep searching for a matching species
-                t_cur_species++;
-                if (t_cur_species != m_Species.end())
-                {
-                    t_to_compare = t_cur_species->GetRepresentative();
-                }
-            }
+            // found a compatible species
+            m_Species[t_species[0]].AddIndividual(t_genome);
+            t_found = true;
         }
 
         // if couldn't find a match, make a new species
@@ -963,6 +1405,7 @@ void Population::ReassignSpecies(unsigned int a_genome_idx)
         {
             m_Species.push_back( Species(t_genome, GetNextSpeciesID()));
             IncrementNextSpeciesID();
+            a_Representatives.push_back(t_signature);
         }
     }
 }
@@ -1054,9 +1497,19 @@ Genome* Population::Tick(Genome& a_deleted_genome)
     // If the compatibility treshold was changed, reassign all individuals by species
     if (t_changed)
     {
+        // the representatives don't change during the pass, so their compact
+        // genes are built once
+        std::vector<const Genome*> t_representatives;
+        for(unsigned int i=0; i<m_Species.size(); i++)
+        {
+            t_representatives.push_back(&m_Species[i].GetRepresentative());
+        }
+        std::vector<GeneSignature> t_representative_signatures;
+        BuildSignatures(t_representatives, t_representative_signatures);
+
         for(unsigned int i=0; i<m_Genomes.size(); i++)
         {
-            ReassignSpecies(i);
+            ReassignSpecies(i, t_representative_signatures);
         }
     }
 
@@ -1202,6 +1655,7 @@ void Population::InitPhenotypeBehaviorData(std::vector< PhenotypeBehavior >* a_p
     a_population->resize(NumGenomes());
     m_BehaviorArchive = a_archive;
     m_BehaviorArchive->clear();
+    m_BehaviorIndex.Clear();
 
     ASSERT(a_population->size() == NumGenomes());
     int counter = 0;
@@ -1218,32 +1672,41 @@ void Population::InitPhenotypeBehaviorData(std::vector< PhenotypeBehavior >* a_p
 
 double Population::ComputeSparseness(Genome& genome)
 {
-    // this will hold the distances from our new behavior
-    std::vector< double > t_distances_list;
-    t_distances_list.clear();
+    m_BehaviorIndex.Update(*m_BehaviorArchive, genome.m_PhenotypeBehavior);
+    return Sparseness(genome.m_PhenotypeBehavior);
+}
+
+
+double Population::Sparseness(PhenotypeBehavior* a_Behavior) const
+{
+    // this will hold the K+1 smallest distances from our behavior,
+    // the smallest one being the distance to itself
+    const unsigned int t_num_nearest = m_Parameters.NoveltySearch_K + 1;
+    std::priority_queue<double> t_nearest;
 
-    // first add all distances from the population
+    // first add the distances from the population
     for(unsigned int i=0; i<m_Species.size(); i++)
     {
         for(unsigned int j=0; j<m_Species[i].m_Individuals.size(); j++)
         {
-            double distance = genome.m_PhenotypeBehavior->Distance_To( m_Species[i].m_Individuals[j].m_PhenotypeBehavior );
-            t_distances_list.push_back( distance );
+            PushNearest(a_Behavior->Distance_To( m_Species[i].m_Individuals[j].m_PhenotypeBehavior ), t_num_nearest, t_nearest);
         }
     }
 
-    // then add all distances from the archive
-    for(unsigned int i=0; i<m_BehaviorArchive->size(); i++)
-    {
-        t_distances_list.push_back( genome.m_PhenotypeBehavior->Distance_To( &((*m_BehaviorArchive)[i])));
-    }
+    // then the nearest ones from the archive
+    m_BehaviorIndex.Nearest(a_Behavior, *m_BehaviorArchive, t_num_nearest, t_nearest);
 
     // sort the list, smaller first
-    std::sort( t_distances_list.begin(), t_distances_list.end() );
+    std::vector< double > t_distances_list(t_nearest.size());
+    for(int i=t_nearest.size()-1; i>=0; i--)
+    {
+        t_distances_list[i] = t_nearest.top();
+        t_nearest.pop();
+    }
 
     // now compute the sparseness
     double t_sparseness = 0;
-    for(unsigned int i=1; i< (m_Parameters.NoveltySearch_K+1); i++)
+    for(unsigned int i=1; i<t_distances_list.size(); i++)
     {
         t_sparseness += t_distances_list[i];
     }
@@ -1253,6 +1716,12 @@ double Population::ComputeSparseness(Genome& genome)
 }
 
 
+void Population::ComputeSparsenessTask(const std::vector<Genome*>& a_Genomes, std::vector<double>& a_Sparseness, unsigned int i) const
+{
+    a_Sparseness[i] = Sparseness(a_Genomes[i]->m_PhenotypeBehavior);
+}
+
+
 // This is the main method performing novelty search.
 // Performs one reproduction and assigns novelty scores
 // based on the current population and the archive.
@@ -1265,11 +1734,28 @@ bool Population::NoveltySearchTick(Genome& a_SuccessfulGenome)
     // This will introduce the constant pressure to do something new
     if ((m_NumEvaluations % m_Parameters.NoveltySearch_Recompute_Sparseness_Each)==0)
     {
+        std::vector<Genome*> t_genomes;
         for(unsigned int i=0; i<m_Species.size(); i++)
         {
             for(unsigned int j=0; j<m_Species[i].m_Individuals.size(); j++)
             {
-                m_Species[i].m_Individuals[j].SetFitness(ComputeSparseness(m_Species[i].m_Individuals[j]));
+                t_genomes.push_back(&m_Species[i].m_Individuals[j]);
+            }
+        }
+
+        if (!t_genomes.empty())
+        {
+            m_BehaviorIndex.Update(*m_BehaviorArchive, t_genomes[0]->m_PhenotypeBehavior);
+
+            // the queries only read the population and the archive
+            std::vector<double> t_sparseness(t_genomes.size());
+            robogen::parallelFor(t_genomes.size(), m_Parameters.NumThreads,
+                    boost::bind(&Population::ComputeSparsenessTask, this,
+                            boost::cref(t_genomes), boost::ref(t_sparseness), _1));
+
+            for(unsigned int i=0; i<t_genomes.size(); i++)
+            {
+                t_genomes[i]->SetFitness(t_sparseness[i]);
             }
         }
     }
@@ -31,11 +31,14 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include <vector>
+#include <istream>
 #include <float.h>
 
 #include "Innovation.h"
 #include "Genome.h"
+#include "Compatibility.h"
 #include "PhenotypeBehavior.h"
+#include "BehaviorIndex.h"
 #include "Genes.h"
 #include "Species.h"
 #include "Parameters.h"
@@ -91,9 +94,67 @@ private:
     // The base MPC (for switching between complexifying/simplifying phase)
     double m_BaseMPC;
 
+    // Compatibility terms of the genome/representative pairs compared in the last epochs
+    CompatibilityCache m_CompatibilityCache;
+
     // Separates the population into species based on compatibility distance
     void Speciate();
 
+    // Nearest neighbour index over the novelty search archive
+    BehaviorIndex m_BehaviorIndex;
+
+    // Sparseness of a behavior, the index must be up to date.
+    // Safe to call from several threads.
+    double Sparseness(PhenotypeBehavior* a_Behavior) const;
+
+    // Task computing the sparseness of a_Genomes[i]
+    void ComputeSparsenessTask(const std::vector<Genome*>& a_Genomes, std::vector<double>& a_Sparseness, unsigned int i) const;
+
+    // Builds the compact genes of each genome
+    void BuildSignatures(const std::vector<const Genome*>& a_Genomes, std::vector<GeneSignature>& a_Signatures) const;
+
+    // Finds for each genome the index of the first representative it is compatible with
+    // (-1 if none). The genomes are compared in parallel. Comparisons between genomes
+    // and representatives with IDs below a_FirstNewID, i.e. that already existed in the
+    // previous epoch and may be compared again in the next one, are cached.
+    void FindCompatibleSpecies(const std::vector<const GeneSignature*>& a_Genomes,
+                               const std::vector<const GeneSignature*>& a_Representatives,
+                               std::vector<int>& a_Species, unsigned int a_FirstNewID);
+
+    // Compares one genome with the representatives in order until a compatible one is found
+    void CompareWithRepresentatives(const std::vector<const GeneSignature*>& a_Genomes,
+                                    const std::vector<const GeneSignature*>& a_Representatives,
+                                    std::vector<int>& a_Species,
+                                    std::vector< std::vector<CompatibilityTerms> >& a_Terms,
+                                    unsigned int a_FirstNewID, unsigned int a_Idx) const;
+
+    // The offspring of a species, reproduced at the same time as the other species
+    struct Brood
+    {
+        std::vector<Genome> m_Offspring;
+
+        // which babies are new individuals, to be given an ID
+        std::vector<bool> m_New;
+
+        // the innovations of the babies, staged over m_InnovationDatabase
+        InnovationDatabase m_Innovations;
+
+        // the species' own random stream
+        RNG m_RNG;
+    };
+
+    // Task reproducing species i into a_Broods[i]
+    void ReproduceSpeciesTask(std::vector<Brood>& a_Broods, unsigned int i);
+
+    // Puts the offspring of all species into the new species (m_TempSpecies)
+    // a_Parents holds the index of the species each baby comes from,
+    // a_Champions tells which babies are the champions of their species
+    // and a_FirstNewID is the ID of the first baby created in this epoch
+    void SpeciateOffspring(std::vector<Genome>& a_Offspring,
+                           const std::vector<unsigned int>& a_Parents,
+                           const std::vector<bool>& a_Champions,
+                           unsigned int a_FirstNewID);
+
     // Adjusts each species's fitness
     void AdjustFitness();
 
@@ -155,6 +216,10 @@ public:
     // Loads a population from a file.
     Population(const char* a_FileName);
 
+    // Restores a population saved by SaveState() from an opened stream,
+    // to continue the evolution exactly where it stopped
+    Population(std::istream& a_DataFile);
+
     ////////////////////////////
     // Destructor
     ////////////////////////////
@@ -229,6 +294,14 @@ public:
     // Saves the whole population to a file
     void Save(const char* a_FileName);
 
+    // Saves the whole population along with its species, the state of the
+    // search and of the random number generator. The novelty search archive
+    // is not saved.
+    void SaveState(const char* a_FileName);
+
+    // Same, to an already opened file for writing
+    void SaveState(FILE* a_file);
+
     //////////////////////
     // NEW STUFF
     std::vector<Species> m_TempSpecies; // useful in reproduction
@@ -261,6 +334,11 @@ public:
     // Useful in realtime when the compatibility treshold changes
     void ReassignSpecies(unsigned int a_genome_idx);
 
+    // Same, comparing with a_Representatives, the compact genes of the
+    // representatives of m_Species in order. Keeps them in step with
+    // m_Species, so that they can be reused for the next genome.
+    void ReassignSpecies(unsigned int a_genome_idx, std::vector<GeneSignature>& a_Representatives);
+
     unsigned int m_NumEvaluations;
 
 
@@ -31,8 +31,13 @@
 #include <stdlib.h>
 #include <math.h>
 #include <time.h>
+#include <sstream>
+#include <string>
 #include "Random.h"
 #include "Utils.h"
+#ifdef USE_BOOST_RANDOM
+#include "utils/RandomStreams.h"
+#endif
 
 namespace NEAT
 {
@@ -48,6 +53,17 @@ void RNG::Seed(int a_Seed)
 #endif
 }
 
+// Seeds the random number generator with one of the streams derived from a seed
+void RNG::Seed(unsigned int a_Seed, unsigned int a_Stream, unsigned int a_Substream)
+{
+#ifdef USE_BOOST_RANDOM
+    robogen::seedStream(gen, a_Seed, a_Stream, a_Substream);
+#else
+    // rand() has a single global state, the streams are not independent
+    srand(a_Seed ^ (a_Stream * 2654435761u) ^ (a_Substream * 40503u));
+#endif
+}
+
 void RNG::TimeSeed()
 {
     Seed(time(0));
@@ -165,5 +181,36 @@ int RNG::Roulette(std::vector<double>& a_probs)
 }
 
 
+// Saves the state of the generator
+void RNG::Save(FILE* a_file)
+{
+#ifdef USE_BOOST_RANDOM
+    std::ostringstream t_state;
+    t_state << gen;
+    fprintf(a_file, "RNG %s\n", t_state.str().c_str());
+#else
+    // the state of rand() can't be read back
+    fprintf(a_file, "RNG none\n");
+#endif
+}
+
+// Restores the state of the generator
+void RNG::Load(std::istream& a_DataFile)
+{
+    std::string t_str;
+    do
+    {
+        a_DataFile >> t_str;
+    }
+    while (a_DataFile && (t_str != "RNG"));
+
+#ifdef USE_BOOST_RANDOM
+    a_DataFile >> gen;
+#else
+    a_DataFile >> t_str;
+#endif
+}
+
+
 }
  // namespace NEAT
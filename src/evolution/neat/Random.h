@@ -38,6 +38,8 @@
 
 #include <vector>
 #include <limits>
+#include <istream>
+#include <stdio.h>
 
 namespace NEAT
 {
@@ -53,6 +55,10 @@ public:
     // Seeds the random number generator with this value
     void Seed(int seed);
 
+    // Seeds the random number generator with one of the independent
+    // streams derived from a seed, e.g. one per parallel task
+    void Seed(unsigned int seed, unsigned int stream, unsigned int substream);
+
     // Seeds the random number generator with time
     void TimeSeed();
 
@@ -72,6 +78,12 @@ public:
     // Returns a random number from a gaussian (normal) distribution in the range of [-1 .. 1]
     double RandGaussClamped();
 
+    // Saves the state of the generator to an already opened file for writing
+    void Save(FILE* a_file);
+
+    // Restores the state saved by Save() from an opened stream
+    void Load(std::istream& a_DataFile);
+
     // Returns an index given a vector of probabilities
     int Roulette(std::vector<double>& a_probs);
 };
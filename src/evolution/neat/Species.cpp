@@ -30,6 +30,8 @@
 
 
 #include <algorithm>
+#include <string>
+#include <utility>
 
 #include "Genome.h"
 #include "Species.h"
@@ -61,6 +63,8 @@ Species::Species(const Genome& a_Genome, int a_ID)
     m_OffspringRqd = 0;
     m_BestFitness = a_Genome.GetFitness();
     m_BestSpecies = true;
+    m_WorstSpecies = false;
+    m_AverageFitness = 0;
 
     // Choose a random color
     RNG rng;
@@ -70,36 +74,68 @@ Species::Species(const Genome& a_Genome, int a_ID)
     m_B = static_cast<int>(rng.RandFloat() * 255);
 }
 
-Species& Species::operator=(const Species& a_S)
+// adds a new member to the species and updates variables
+void Species::AddIndividual(Genome& a_Genome)
+{
+    m_Individuals.push_back( a_Genome );
+}
+
+void Species::AddIndividual(Genome&& a_Genome)
+{
+    m_Individuals.push_back( std::move(a_Genome) );
+}
+
+
+// Restores a species from an opened stream
+Species::Species(std::istream& a_DataFile)
 {
-    // self assignment guard
-    if (this != &a_S)
+    std::string t_str;
+    do
     {
-        m_ID                    = a_S.m_ID;
-        m_Representative        = a_S.m_Representative;
-        m_BestGenome            = a_S.m_BestGenome;
-        m_BestSpecies            = a_S.m_BestSpecies;
-        m_WorstSpecies            = a_S.m_WorstSpecies;
-        m_BestFitness            = a_S.m_BestFitness;
-        m_GensNoImprovement        = a_S.m_GensNoImprovement;
-        m_Age                    = a_S.m_Age;
-        m_OffspringRqd            = a_S.m_OffspringRqd;
-        m_R                        = a_S.m_R;
-        m_G                        = a_S.m_G;
-        m_B                        = a_S.m_B;
-
-        m_Individuals = a_S.m_Individuals;
+        a_DataFile >> t_str;
     }
+    while (a_DataFile && (t_str != "SpeciesStart"));
 
-    return *this;
-}
+    int t_best, t_worst;
+    unsigned int t_num;
+    a_DataFile >> m_ID >> m_Age >> m_GensNoImprovement >> m_BestFitness >> t_best >> t_worst
+               >> m_OffspringRqd >> m_AverageFitness >> m_R >> m_G >> m_B >> t_num;
+    m_BestSpecies = static_cast<bool>(t_best);
+    m_WorstSpecies = static_cast<bool>(t_worst);
 
+    m_Representative.LoadState(a_DataFile);
+    m_BestGenome.LoadState(a_DataFile);
 
+    m_Individuals.resize(t_num);
+    for(unsigned int i=0; i<t_num; i++)
+    {
+        m_Individuals[i].LoadState(a_DataFile);
+    }
 
-// adds a new member to the species and updates variables
-void Species::AddIndividual(Genome& a_Genome)
+    do
+    {
+        a_DataFile >> t_str;
+    }
+    while (a_DataFile && (t_str != "SpeciesEnd"));
+}
+
+
+// Saves the species to an already opened file
+void Species::Save(FILE* a_file)
 {
-    m_Individuals.push_back( a_Genome );
+    fprintf(a_file, "SpeciesStart %u %u %u %.17g %d %d %.17g %.17g %d %d %d %u\n", m_ID, m_Age,
+            m_GensNoImprovement, m_BestFitness, static_cast<int>(m_BestSpecies), static_cast<int>(m_WorstSpecies),
+            m_OffspringRqd, m_AverageFitness, m_R, m_G, m_B, static_cast<unsigned int>(m_Individuals.size()));
+
+    m_Representative.SaveState(a_file);
+    m_BestGenome.SaveState(a_file);
+
+    for(unsigned int i=0; i<m_Individuals.size(); i++)
+    {
+        m_Individuals[i].SaveState(a_file);
+    }
+
+    fprintf(a_file, "SpeciesEnd\n\n");
 }
 
 
@@ -110,27 +146,27 @@ void Species::AddIndividual(Genome& a_Genome)
 
 
 // returns an individual randomly selected from the best N%
-Genome Species::GetIndividual(Parameters& a_Parameters, RNG& a_RNG) const
+const Genome& Species::GetIndividual(Parameters& a_Parameters, RNG& a_RNG) const
 {
     ASSERT(m_Individuals.size() > 0);
 
     // Make a pool of only evaluated individuals!
-    std::vector<Genome> t_Evaluated;
+    std::vector<const Genome*> t_Evaluated;
     for(unsigned int i=0; i<m_Individuals.size(); i++)
     {
         if (m_Individuals[i].IsEvaluated())
-            t_Evaluated.push_back( m_Individuals[i] );
+            t_Evaluated.push_back( &m_Individuals[i] );
     }
 
     ASSERT(t_Evaluated.size() > 0);
 
     if (t_Evaluated.size() == 1)
     {
-        return (t_Evaluated[0]);
+        return *(t_Evaluated[0]);
     }
     else if (t_Evaluated.size() == 2)
     {
-        return (t_Evaluated[ Rounded(a_RNG.RandFloat()) ]);
+        return *(t_Evaluated[ Rounded(a_RNG.RandFloat()) ]);
     }
 
     // Warning!!!! The individuals must be sorted by best fitness for this to work
@@ -162,11 +198,11 @@ Genome Species::GetIndividual(Parameters& a_Parameters, RNG& a_RNG) const
         // roulette wheel selection
         std::vector<double> t_probs;
         for(unsigned int i=0; i<t_Evaluated.size(); i++)
-            t_probs.push_back( t_Evaluated[i].GetFitness() );
+            t_probs.push_back( t_Evaluated[i]->GetFitness() );
         t_chosen_one = a_RNG.Roulette(t_probs);
     }
 
-    return (t_Evaluated[t_chosen_one]);
+    return *(t_Evaluated[t_chosen_one]);
 }
 
 
@@ -214,7 +250,7 @@ Genome Species::GetLeader() const
 }
 
 
-Genome Species::GetRepresentative() const
+const Genome& Species::GetRepresentative() const
 {
     return m_Representative;
 }
@@ -349,10 +385,12 @@ SUMMARY OF THE EPOCH MECHANISM
 
 // Reproduce mates & mutates the individuals of the species
 // It may access the global species list in the population
-// because some babies may turn out to belong in another species
-// that have to be created.
-// Also calls Birth() for every new baby
-void Species::Reproduce(Population &a_Pop, Parameters& a_Parameters, RNG& a_RNG)
+// for interspecies crossover.
+// The babies are appended to a_Offspring, the champion first. As some of them
+// may turn out to belong in another species that has to be created, the
+// population puts them into species once all species have reproduced.
+void Species::Reproduce(const Population &a_Pop, Parameters& a_Parameters, RNG& a_RNG, InnovationDatabase& a_Innovs,
+                        std::vector<Genome>& a_Offspring, std::vector<bool>& a_New)
 {
     Genome t_baby; // temp genome for reproduction
 
@@ -371,6 +409,7 @@ void Species::Reproduce(Population &a_Pop, Parameters& a_Parameters, RNG& a_RNG)
         // maybe do something else?
         return;
     }
+    a_Offspring.reserve(a_Offspring.size() + t_offspring_count);
 
     //////////////////////////
     // Reproduction
@@ -379,18 +418,13 @@ void Species::Reproduce(Population &a_Pop, Parameters& a_Parameters, RNG& a_RNG)
     bool t_champ_chosen = false;
     bool t_baby_exists_in_pop = false;
 
-    int t_champ_new_species_id = ID();
-    int t_champ_new_species_idx = -1;
-
     while(t_offspring_count--)
     {
-    	bool t_on_champ = false;
 		bool t_new_individual = true;
         // if the champ was not chosen, do it now..
         
         if (!t_champ_chosen)
         { 
-        	t_on_champ = true;
             t_champ_chosen = true;
             t_baby = m_Individuals[0];
 			t_new_individual = false;
@@ -431,14 +465,14 @@ void Species::Reproduce(Population &a_Pop, Parameters& a_Parameters, RNG& a_RNG)
                 {
                     do // keep trying to mate until a good offspring is produced
                     {
-                        Genome t_mom = GetIndividual(a_Parameters, a_RNG);
+                        const Genome& t_mom = GetIndividual(a_Parameters, a_RNG);
 
                         // choose whether to mate at all
                         // Do not allow crossover when in simplifying phase
                         if ((a_RNG.RandFloat() < a_Parameters.CrossoverRate) && (a_Pop.GetSearchMode() != SIMPLIFYING))
                         {
                             // get the father
-                            Genome t_dad;
+                            const Genome* t_dad;
                             bool t_interspecies = false;
 
                             // There is a probability that the father may come from another species
@@ -446,29 +480,29 @@ void Species::Reproduce(Population &a_Pop, Parameters& a_Parameters, RNG& a_RNG)
                             {
                                 // Find different species (random one) // !!!!!!!!!!!!!!!!!
                                 int t_diffspec = a_RNG.RandInt(0, static_cast<int>(a_Pop.m_Species.size()-1));
-                                t_dad = a_Pop.m_Species[t_diffspec].GetIndividual(a_Parameters, a_RNG);
+                                t_dad = &a_Pop.m_Species[t_diffspec].GetIndividual(a_Parameters, a_RNG);
                                 t_interspecies = true;
                             }
                             else
                             {
                                 // Mate within species
-                                t_dad = GetIndividual(a_Parameters, a_RNG);
+                                t_dad = &GetIndividual(a_Parameters, a_RNG);
 
                                 // The other parent should be a different one
                                 // number of tries to find different parent
                                 int t_tries = 32;
                                 if (!a_Parameters.AllowClones)
                                 {
-                                    while(((t_mom.GetID() == t_dad.GetID()) /*|| (t_mom.CompatibilityDistance(t_dad, a_Parameters) < 0.00001)*/ ) && (t_tries--))
+                                    while(((t_mom.GetID() == t_dad->GetID()) /*|| (t_mom.CompatibilityDistance(*t_dad, a_Parameters) < 0.00001)*/ ) && (t_tries--))
                                     {
-                                        t_dad = GetIndividual(a_Parameters, a_RNG);
+                                        t_dad = &GetIndividual(a_Parameters, a_RNG);
                                     }
                                 }
                                 else
                                 {
-                                    while(((t_mom.GetID() == t_dad.GetID()) ) && (t_tries--))
+                                    while(((t_mom.GetID() == t_dad->GetID()) ) && (t_tries--))
                                     {
-                                        t_dad = GetIndividual(a_Parameters, a_RNG);
+                                        t_dad = &GetIndividual(a_Parameters, a_RNG);
                                     }
                                 }
                                 t_interspecies = false;
@@ -478,11 +512,11 @@ void Species::Reproduce(Population &a_Pop, Parameters& a_Parameters, RNG& a_RNG)
                             // Choose randomly one of two types of crossover
                             if (a_RNG.RandFloat() < a_Parameters.MultipointCrossoverRate)
                             {
-                                t_baby = t_mom.Mate( t_dad, false, t_interspecies, a_RNG);
+                                t_baby = t_mom.Mate( *t_dad, false, t_interspecies, a_RNG);
                             }
                             else
                             {
-                                t_baby = t_mom.Mate( t_dad, true, t_interspecies, a_RNG);
+                                t_baby = t_mom.Mate( *t_dad, true, t_interspecies, a_RNG);
                             }
 
                             t_mated = true;
@@ -503,7 +537,7 @@ void Species::Reproduce(Population &a_Pop, Parameters& a_Parameters, RNG& a_RNG)
                 // Mutate the baby
                 if ((!t_mated) || (a_RNG.RandFloat() < a_Parameters.OverallMutationRate))
                 {
-                    MutateGenome(t_baby_exists_in_pop, a_Pop, t_baby, a_Parameters, a_RNG);
+                    MutateGenome(t_baby_exists_in_pop, a_Pop, a_Innovs, t_baby, a_Parameters, a_RNG);
                 }
 
                 // Check if this baby is already present somewhere in the offspring
@@ -542,9 +576,7 @@ void Species::Reproduce(Population &a_Pop, Parameters& a_Parameters, RNG& a_RNG)
 
 		if (t_new_individual) {
 		    // We have a new offspring now
-		    // give the offspring a new ID
-		    t_baby.SetID(a_Pop.GetNextGenomeID());
-		    a_Pop.IncrementNextGenomeID();
+		    // the population gives it a new ID once all species have reproduced
 
 		    // sort the baby's genes
 		    t_baby.SortGenes();
@@ -560,119 +592,11 @@ void Species::Reproduce(Population &a_Pop, Parameters& a_Parameters, RNG& a_RNG)
 		}
 
 
-        //////////////////////////////////
-        // put the baby to its species  //
-        //////////////////////////////////
-
-        // before Reproduce() is invoked, it is assumed that a
-        // clone of the population exists with the name of m_TempSpecies
-        // we will store results there.
-        // after all reproduction completes, the original species will be replaced back
-
-        bool t_found = false;
-        //std::vector<Species>::iterator t_cur_species = a_Pop.m_TempSpecies.begin();
-
-        unsigned int t_cur_species_index = 0;
-
-        // No species yet?
-        if (t_cur_species_index == a_Pop.m_TempSpecies.size())
-        {
-            // create the first species and place the baby there
-            a_Pop.m_TempSpecies.push_back( Species(t_baby, a_Pop.GetNextSpeciesID()));
-            a_Pop.IncrementNextSpeciesID();
-        }
-        else
-        {
-            // try to find a compatible species
-            Genome t_to_compare = a_Pop.m_TempSpecies[t_cur_species_index
-                                                      ].GetRepresentative();
-
-#ifdef NEAT_DEBUG
-            std::cout << "compatability threshold: " << a_Parameters.CompatTreshold;
-            std::cout << ", dists: ";
-#endif
-
-            t_found = false;
-            while((t_cur_species_index != a_Pop.m_TempSpecies.size())
-            		&& (!t_found))
-            {
-#ifdef NEAT_DEBUG
-            	std::cout << "(" << t_cur_species_index << ", "
-            			<< t_baby.CompatibilityDistance(t_to_compare,
-            					a_Parameters) << ") ";
-#endif
-
-
-                if (t_baby.IsCompatibleWith( t_to_compare, a_Parameters))
-                {
-                    // found a compatible species
-#ifdef NEAT_DEBUG
-                	std::cout << "adding to species " << t_cur_species_index
-                			<< " "
-                			<< a_Pop.m_TempSpecies[t_cur_species_index].ID()
-                			<< std::endl;
-#endif
-                	a_Pop.m_TempSpecies[t_cur_species_index
-                	                    ].AddIndividual(t_baby);
-                    t_found = true; // the search is over
-                    if (t_on_champ) {
-                    	t_champ_new_species_id = a_Pop.m_TempSpecies[t_cur_species_index
-                    	                  	                    ].ID();
-                    	t_champ_new_species_idx = t_cur_species_index;
-                    }
-
-                }
-                else
-                {
-                    // keep searching for a matching species
-                    t_cur_species_index++;
-                    if (t_cur_species_index != a_Pop.m_TempSpecies.size())
-                    {
-                        t_to_compare = a_Pop.m_TempSpecies[t_cur_species_index
-                                   	                    ].GetRepresentative();
-                    }
-                }
-            }
-
-            // if couldn't find a match, make a new species
-            if (!t_found)
-            {
-#ifdef NEAT_DEBUG
-            	std::cout << "\tno species found, creating new one!" << std::endl;
-#endif
-                a_Pop.m_TempSpecies.push_back( Species(t_baby, a_Pop.GetNextSpeciesID()));
-                if (t_on_champ) {
-					t_champ_new_species_id = a_Pop.GetNextSpeciesID();
-					t_champ_new_species_idx = a_Pop.m_TempSpecies.size() - 1;
-				}
-                a_Pop.IncrementNextSpeciesID();
-
-            }
-
-			if (IsBestSpecies() && t_on_champ &&
-					(t_champ_new_species_id != ID())) {
-
-				for (size_t i = 0; i<a_Pop.m_TempSpecies.size(); ++i) {
-					if (a_Pop.m_TempSpecies[i].IsBestSpecies()) {
-						if(a_Pop.m_TempSpecies[i].m_Individuals.empty()) {
-#ifdef NEAT_DEBUG
-							std::cout << i << " " << a_Pop.m_TempSpecies[i].ID() <<
-									" NO LONGER BEST" << std::endl;
-#endif
-							a_Pop.m_TempSpecies[i].SetBestSpecies(false);
-
-						}
-						break;
-					}
-				}
-				a_Pop.m_TempSpecies[t_champ_new_species_idx].SetBestSpecies(true);
-#ifdef NEAT_DEBUG
-				std::cout << "NEW BEST SPECIES " << t_champ_new_species_idx << " " <<
-						t_champ_new_species_id << std::endl;
-#endif
-
-			}
-        }
+        // the babies are put into their species by the population
+        // once all species have reproduced, t_baby is assigned anew
+        // by the next iteration
+        a_Offspring.push_back(std::move(t_baby));
+        a_New.push_back(t_new_individual);
     }
 }
 
@@ -846,6 +770,12 @@ Genome Species::ReproduceOne(Population& a_Pop, Parameters& a_Parameters, RNG& a
 
 // Mutates a genome
 void Species::MutateGenome( bool t_baby_is_clone, Population &a_Pop, Genome &t_baby, Parameters& a_Parameters, RNG& a_RNG )
+{
+    MutateGenome(t_baby_is_clone, a_Pop, a_Pop.AccessInnovationDatabase(), t_baby, a_Parameters, a_RNG);
+}
+
+void Species::MutateGenome( bool t_baby_is_clone, const Population &a_Pop, InnovationDatabase &a_Innovs, Genome &t_baby,
+                            Parameters& a_Parameters, RNG& a_RNG )
 {
 #if 1
     // NEW version:
@@ -914,15 +844,15 @@ void Species::MutateGenome( bool t_baby_is_clone, Population &a_Pop, Genome &t_b
         switch(ChosenMutation)
         {
         case ADD_NODE:
-            t_mutation_success = t_baby.Mutate_AddNeuron(a_Pop.AccessInnovationDatabase(), a_Parameters, a_RNG);
+            t_mutation_success = t_baby.Mutate_AddNeuron(a_Innovs, a_Parameters, a_RNG);
             break;
 
         case ADD_LINK:
-            t_mutation_success = t_baby.Mutate_AddLink(a_Pop.AccessInnovationDatabase(), a_Parameters, a_RNG);
+            t_mutation_success = t_baby.Mutate_AddLink(a_Innovs, a_Parameters, a_RNG);
             break;
 
         case REMOVE_NODE:
-            t_mutation_success = t_baby.Mutate_RemoveSimpleNeuron(a_Pop.AccessInnovationDatabase(), a_RNG);
+            t_mutation_success = t_baby.Mutate_RemoveSimpleNeuron(a_Innovs, a_RNG);
             break;
 
         case REMOVE_LINK:
@@ -1015,10 +945,10 @@ void Species::MutateGenome( bool t_baby_is_clone, Population &a_Pop, Genome &t_b
     while (t_mutation_success == false)
     {
         if (a_RNG.RandFloat() < a_Parameters.MutateAddNeuronProb)
-            t_mutation_success = t_baby.Mutate_AddNeuron(a_Pop.AccessInnovationDatabase(), a_Parameters, a_RNG);
+            t_mutation_success = t_baby.Mutate_AddNeuron(a_Innovs, a_Parameters, a_RNG);
         else
         if (a_RNG.RandFloat() < a_Parameters.MutateAddLinkProb)
-            t_mutation_success = t_baby.Mutate_AddLink(a_Pop.AccessInnovationDatabase(), a_Parameters, a_RNG);
+            t_mutation_success = t_baby.Mutate_AddLink(a_Innovs, a_Parameters, a_RNG);
         else
         {
             /*if (a_RNG.RandFloat() < a_Parameters.MutateNeuronActivationTypeProb)
@@ -31,6 +31,8 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include <vector>
+#include <istream>
+#include <stdio.h>
 
 #include "Innovation.h"
 #include "Genome.h"
@@ -98,8 +100,11 @@ public:
     // initializes a species with a leader genome and an ID number
     Species(const Genome& a_Seed, int a_id);
 
-    // assignment operator
-    Species& operator=(const Species& a_g);
+    // restores a species saved by Save() from an opened stream
+    Species(std::istream& a_DataFile);
+
+    // Species are copied and moved member by member, moving one
+    // moves its individuals
 
     // comparison operator (nessesary for boost::python)
     // todo: implement a better comparison technique
@@ -137,13 +142,17 @@ public:
     // returns the leader (the member having the best fitness, representing the species)
     Genome GetLeader() const;
 
-    Genome GetRepresentative() const;
+    const Genome& GetRepresentative() const;
 
     // adds a new member to the species and updates variables
     void AddIndividual(Genome& a_New);
 
+    // same, moving the genome into the species
+    void AddIndividual(Genome&& a_New);
+
     // returns an individual randomly selected from the best N%
-    Genome GetIndividual(Parameters& a_Parameters, RNG& a_RNG) const;
+    // the reference is valid until the individuals change
+    const Genome& GetIndividual(Parameters& a_Parameters, RNG& a_RNG) const;
 
     // returns a completely random individual
     Genome GetRandomIndividual(RNG& a_RNG) const;
@@ -159,6 +168,9 @@ public:
     // Sorts the individuals
     void SortIndividuals();
 
+    // Saves the species, its individuals and its state to an already opened file
+    void Save(FILE* a_file);
+
 
 
 
@@ -168,11 +180,21 @@ public:
     // each species CONTAINS the individuals
     std::vector<Genome> m_Individuals;
 
-    // Reproduction.
-    void Reproduce(Population& a_Pop, Parameters& a_Parameters, RNG& a_RNG);
+    // Reproduction. The babies are appended to a_Offspring, the champion first,
+    // and a_New tells which of them are new individuals, to be given an ID.
+    // They are put into species by the population afterwards.
+    // The innovations are recorded in a_Innovs, a database staged over the
+    // population's one, and only the population is read, so that several
+    // species can reproduce at once, each with its own a_RNG.
+    void Reproduce(const Population& a_Pop, Parameters& a_Parameters, RNG& a_RNG, InnovationDatabase& a_Innovs,
+                   std::vector<Genome>& a_Offspring, std::vector<bool>& a_New);
 
     void MutateGenome( bool t_baby_is_clone, Population &a_Pop, Genome &t_baby, Parameters& a_Parameters, RNG& a_RNG);
 
+    // Same, recording the innovations in a_Innovs
+    void MutateGenome( bool t_baby_is_clone, const Population &a_Pop, InnovationDatabase &a_Innovs, Genome &t_baby,
+                       Parameters& a_Parameters, RNG& a_RNG);
+
     // Removes all individuals
     void Clear()
     {
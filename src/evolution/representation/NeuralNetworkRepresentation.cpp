@@ -85,6 +85,48 @@ NeuralNetworkRepresentation::NeuralNetworkRepresentation(
 	}
 }
 
+NeuralNetworkRepresentation::NeuralNetworkRepresentation(
+		const robogenMessage::Brain &brain) {
+	for (int i = 0; i < brain.neuron_size(); ++i) {
+		const robogenMessage::Neuron &neuron = brain.neuron(i);
+		unsigned int layer = NeuronRepresentation::HIDDEN;
+		if (neuron.layer() == "input") {
+			layer = NeuronRepresentation::INPUT;
+		} else if (neuron.layer() == "output") {
+			layer = NeuronRepresentation::OUTPUT;
+		}
+		unsigned int type = NeuronRepresentation::SIMPLE;
+		std::vector<double> params;
+		if (neuron.type() == "sigmoid") {
+			type = NeuronRepresentation::SIGMOID;
+			params.push_back(neuron.bias());
+		} else if (neuron.type() == "ctrnn_sigmoid") {
+			type = NeuronRepresentation::CTRNN_SIGMOID;
+			params.push_back(neuron.bias());
+			params.push_back(neuron.tau());
+		} else if (neuron.type() == "oscillator") {
+			type = NeuronRepresentation::OSCILLATOR;
+			params.push_back(neuron.period());
+			params.push_back(neuron.phaseoffset());
+			params.push_back(neuron.gain());
+		}
+		ioPair identification(neuron.bodypartid(), neuron.ioid());
+		boost::shared_ptr<NeuronRepresentation> representation(
+				new NeuronRepresentation(identification, layer, type));
+		if (!params.empty()) {
+			representation->setParams(params);
+		}
+		neurons_[identification] = representation;
+	}
+	// connections are serialized with their weights, including zero ones
+	for (int i = 0; i < brain.connection_size(); ++i) {
+		const robogenMessage::NeuralConnection &connection =
+				brain.connection(i);
+		weights_[StringPair(connection.src(), connection.dest())] =
+				connection.weight();
+	}
+}
+
 NeuralNetworkRepresentation::~NeuralNetworkRepresentation() {
 }
 
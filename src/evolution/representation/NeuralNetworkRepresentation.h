@@ -80,6 +80,14 @@ public:
 	NeuralNetworkRepresentation(std::map<std::string,int> &sensorParts,
 			std::map<std::string,int> &motorParts);
 
+	/**
+	 * Recreates the neural network representation serialized into a brain
+	 * message, with the same neurons and connections. Parameters are only
+	 * as precise as the message, see RobotRepresentation::serializeState().
+	 * @param brain brain message produced by serialize()
+	 */
+	NeuralNetworkRepresentation(const robogenMessage::Brain &brain);
+
 	// Copy constructor should be provided by the compiler. As there is no
 	// pointing going on, this should not cause any problems.
 
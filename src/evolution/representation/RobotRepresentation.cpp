@@ -567,6 +567,132 @@ bool RobotRepresentation::init(std::string robotTextFile) {
 	return true;
 }
 
+bool RobotRepresentation::init(const robogenMessage::RobotState &state) {
+
+	const robogenMessage::Body &body = state.robot().body();
+	idToPart_.clear();
+	bodyTree_.reset();
+
+	// body parts, with their exact parameters
+	std::vector<boost::shared_ptr<PartRepresentation> > parts;
+	int paramIndex = 0;
+	for (int i = 0; i < body.part_size(); ++i) {
+		const robogenMessage::BodyPart &partMessage = body.part(i);
+		if (INVERSE_PART_TYPE_MAP.count(partMessage.type()) == 0) {
+			std::cerr << "Unknown part type " << partMessage.type()
+					<< " in robot state" << std::endl;
+			return false;
+		}
+		int numParams = partMessage.evolvableparam_size();
+		if (paramIndex + numParams > state.bodyparam_size()) {
+			std::cerr << "Missing body parameters in robot state"
+					<< std::endl;
+			return false;
+		}
+		std::vector<double> params(
+				state.bodyparam().begin() + paramIndex,
+				state.bodyparam().begin() + paramIndex + numParams);
+		paramIndex += numParams;
+
+		boost::shared_ptr<PartRepresentation> part =
+				PartRepresentation::create(
+						INVERSE_PART_TYPE_MAP.at(partMessage.type()),
+						partMessage.id(), partMessage.orientation(), params);
+		if (!part) {
+			std::cerr << "Failed to create part " << partMessage.id()
+					<< " from robot state" << std::endl;
+			return false;
+		}
+		if (partMessage.root()) {
+			bodyTree_ = part;
+		}
+		idToPart_[partMessage.id()] = boost::weak_ptr<PartRepresentation>(
+				part);
+		// until connected, the parts are only held here
+		parts.push_back(part);
+	}
+	if (!bodyTree_) {
+		std::cerr << "Robot state has no root part" << std::endl;
+		return false;
+	}
+
+	// connections, the slots are numbered as in
+	// PartRepresentation::addSubtreeToBodyMessage
+	for (int i = 0; i < body.connection_size(); ++i) {
+		const robogenMessage::BodyConnection &connection = body.connection(i);
+		if (!idToPart_.count(connection.src()) ||
+				!idToPart_.count(connection.dest())) {
+			std::cerr << "Robot state connects unknown parts "
+					<< connection.src() << " and " << connection.dest()
+					<< std::endl;
+			return false;
+		}
+		boost::shared_ptr<PartRepresentation> parent =
+				idToPart_[connection.src()].lock();
+		unsigned int slot = isCore(parent->getType()) ?
+				connection.srcslot() : connection.srcslot() - 1;
+		if (!parent->setChild(slot, idToPart_[connection.dest()].lock())) {
+			std::cerr << "Failed to connect part " << connection.dest()
+					<< " to " << connection.src() << std::endl;
+			return false;
+		}
+	}
+
+	// brain, then its exact weights and parameters
+	neuralNetwork_.reset(
+			new NeuralNetworkRepresentation(state.robot().brain()));
+	std::vector<double*> weights, params;
+	std::vector<unsigned int> types;
+	neuralNetwork_->getGenome(weights, types, params);
+	if ((int) (weights.size() + params.size()) != state.brainparam_size()) {
+		std::cerr << "Robot state has " << state.brainparam_size()
+				<< " brain parameters, but its brain has "
+				<< weights.size() + params.size() << std::endl;
+		return false;
+	}
+	for (unsigned int i = 0; i < weights.size(); ++i) {
+		*weights[i] = state.brainparam(i);
+	}
+	for (unsigned int i = 0; i < params.size(); ++i) {
+		*params[i] = state.brainparam(weights.size() + i);
+	}
+
+	maxid_ = state.maxid();
+	evaluated_ = state.evaluated();
+	fitness_ = state.has_fitness() ? state.fitness() : 0;
+	return true;
+}
+
+robogenMessage::RobotState RobotRepresentation::serializeState() const {
+	robogenMessage::RobotState state;
+	*(state.mutable_robot()) = serialize();
+	state.set_maxid(maxid_);
+	// exact body parameters, in the order of the parts in the message
+	const robogenMessage::Body &body = state.robot().body();
+	for (int i = 0; i < body.part_size(); ++i) {
+		const std::vector<double> &params =
+				idToPart_.at(body.part(i).id()).lock()->getParams();
+		for (unsigned int j = 0; j < params.size(); ++j) {
+			state.add_bodyparam(params[j]);
+		}
+	}
+	// exact brain weights and parameters, in the order of getBrainGenome()
+	std::vector<double*> weights, params;
+	std::vector<unsigned int> types;
+	neuralNetwork_->getGenome(weights, types, params);
+	for (unsigned int i = 0; i < weights.size(); ++i) {
+		state.add_brainparam(*weights[i]);
+	}
+	for (unsigned int i = 0; i < params.size(); ++i) {
+		state.add_brainparam(*params[i]);
+	}
+	state.set_evaluated(evaluated_);
+	if (evaluated_) {
+		state.set_fitness(fitness_);
+	}
+	return state;
+}
+
 robogenMessage::Robot RobotRepresentation::serialize() const {
 	robogenMessage::Robot message;
 	// id - this can probably be removed
@@ -599,7 +725,8 @@ const std::string& RobotRepresentation::getBodyRootId() {
 }
 
 void RobotRepresentation::evaluate(Socket *socket,
-		boost::shared_ptr<RobogenConfig> robotConf) {
+		boost::shared_ptr<RobogenConfig> robotConf, unsigned int generation,
+		unsigned int individual) {
 
 	// 1. Prepare message to simulator
 	boost::shared_ptr<robogenMessage::EvaluationRequest> evalReq(
@@ -608,6 +735,10 @@ void RobotRepresentation::evaluate(Socket *socket,
 	robogenMessage::SimulatorConf* evalConf = evalReq->mutable_configuration();
 	*evalRobot = serialize();
 	*evalConf = robotConf->serialize();
+	if (generation > 0) {
+		evalReq->set_generation(generation);
+		evalReq->set_individual(individual);
+	}
 
 	ProtobufPacket<robogenMessage::EvaluationRequest> robotPacket(evalReq);
 	std::vector<unsigned char> forgedMessagePacket;
@@ -91,12 +91,28 @@ public:
 	 */
 	bool init(std::string robotTextFile);
 
+	/**
+	 * Restores a robot representation saved with serializeState(), exactly
+	 * as it was, including its evaluation state.
+	 * @param state robot state message
+	 * @return false if the message does not describe a valid robot
+	 */
+	bool init(const robogenMessage::RobotState &state);
+
 	/**
 	 * @return robot message of this robot to be transmitted to simulator
 	 * or stored as population checkpoint
 	 */
 	robogenMessage::Robot serialize() const;
 
+	/**
+	 * @return robot state message to be stored in an evolver checkpoint.
+	 * Holds the robot message along with the exact body and brain parameters,
+	 * which the robot message rounds to floats, the unique id counter and
+	 * the evaluation state.
+	 */
+	robogenMessage::RobotState serializeState() const;
+
 	/**
 	 * Provides weight and bias handles for a mutator.
 	 * @param weights reference to a vector to be filled with weight pointers
@@ -121,9 +137,13 @@ public:
 	 * Evaluate individual using given socket and given configuration file.
 	 * @param socket
 	 * @param robotConf
+	 * @param generation if not 0, sent to the simulator along with
+	 * individual to identify the evaluation
+	 * @param individual index of the individual in its generation
 	 */
 	void evaluate(Socket *socket,
-			boost::shared_ptr<RobogenConfig> robotConf);
+			boost::shared_ptr<RobogenConfig> robotConf,
+			unsigned int generation = 0, unsigned int individual = 0);
 
 	/**
 	 * @return fitness of individual
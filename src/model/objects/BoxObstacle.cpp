@@ -98,6 +98,20 @@ const osg::Quat BoxObstacle::getAttitude() {
 
 }
 
+void BoxObstacle::setPosition(const osg::Vec3& position) {
+	// also moves the body, if any
+	dGeomSetPosition(boxGeom_, position.x(), position.y(), position.z());
+}
+
+void BoxObstacle::setAttitude(const osg::Quat& attitude) {
+	dQuaternion quatOde;
+	quatOde[0] = attitude.w();
+	quatOde[1] = attitude.x();
+	quatOde[2] = attitude.y();
+	quatOde[3] = attitude.z();
+	dGeomSetQuaternion(boxGeom_, quatOde);
+}
+
 const osg::Vec3 BoxObstacle::getSize() {
 	return size_;
 }
@@ -65,6 +65,12 @@ public:
 	virtual const osg::Vec3 getPosition();
 	virtual const osg::Quat getAttitude();
 
+	/**
+	 * Moves the box, used to replay recorded simulations
+	 */
+	void setPosition(const osg::Vec3& position);
+	void setAttitude(const osg::Quat& attitude);
+
 	/**
 	 * @return the box size
 	 */
@@ -74,6 +74,11 @@ struct RayTrace {
 
 void IrSensor::collisionCallback(void *data, dGeomID o1, dGeomID o2){
 	RayTrace *r = (RayTrace*) data;
+	// look into the space of fixed obstacles
+	if (dGeomIsSpace(o1) || dGeomIsSpace(o2)) {
+		dSpaceCollide2(o1, o2, data, IrSensor::collisionCallback);
+		return;
+	}
 	// ignore what needs ignoring
 	if (std::find(r->ignoreGeoms.begin(),r->ignoreGeoms.end(),
 			o1) != r->ignoreGeoms.end() ||
@@ -26,6 +26,9 @@
  * @(#) $Id$
  */
 #include "render/Mesh.h"
+#include <map>
+#include <boost/thread/mutex.hpp>
+#include <osg/Material>
 #include <osgDB/ReadFile>
 #include <osg/Version>
 #if OSG_VERSION_GREATER_OR_EQUAL(3, 2, 0)
@@ -34,44 +37,90 @@
 
 namespace robogen {
 
-Mesh::Mesh() {
+namespace {
 
-}
+/**
+ * A mesh file, smoothed and translated to its center
+ */
+struct SharedMesh {
+	osg::ref_ptr<osg::Node> node;
+	float xLen;
+	float yLen;
+	float zLen;
+};
 
-Mesh::~Mesh() {
+boost::mutex meshesMutex;
 
-}
+/**
+ * Loaded meshes by file name, shared by all the render models of the process
+ */
+std::map<std::string, SharedMesh> meshes;
 
-bool Mesh::loadMesh(const std::string& mesh) {
+bool loadSharedMesh(const std::string& mesh, SharedMesh& sharedMesh) {
 
-	meshNode_ = osgDB::readNodeFile(mesh);
-	if (meshNode_ == NULL) {
+	boost::mutex::scoped_lock lock(meshesMutex);
+
+	std::map<std::string, SharedMesh>::iterator it = meshes.find(mesh);
+	if (it != meshes.end()) {
+		sharedMesh = it->second;
+		return true;
+	}
+
+	osg::ref_ptr<osg::Node> meshNode = osgDB::readNodeFile(mesh);
+	if (meshNode == NULL) {
 		return false;
 	}
 
 	// Translate mesh to center
 	osg::BoundingBox bb;
-	bb.expandBy(meshNode_->getBound());
-
-	meshPat_ = new osg::PositionAttitudeTransform();
+	bb.expandBy(meshNode->getBound());
 
-	osg::PositionAttitudeTransform* shiftToCenterPat =
+	osg::ref_ptr<osg::PositionAttitudeTransform> shiftToCenterPat =
 			new osg::PositionAttitudeTransform();
 	shiftToCenterPat->setPosition(-bb.center());
-	shiftToCenterPat->addChild(meshNode_);
+	shiftToCenterPat->addChild(meshNode);
 
-	meshPat_->addChild(shiftToCenterPat);
-
-	xLen_ = bb.xMax() - bb.xMin();
-	yLen_ = bb.yMax() - bb.yMin();
-	zLen_ = bb.zMax() - bb.zMin();
+	sharedMesh.node = shiftToCenterPat;
+	sharedMesh.xLen = bb.xMax() - bb.xMin();
+	sharedMesh.yLen = bb.yMax() - bb.yMin();
+	sharedMesh.zLen = bb.zMax() - bb.zMin();
 
 #if OSG_VERSION_GREATER_OR_EQUAL(3, 2, 0)
 	osgUtil::SmoothingVisitor sv;
 	sv.setCreaseAngle(0);
-	meshNode_->accept(sv);
+	meshNode->accept(sv);
 #endif
 
+	meshes[mesh] = sharedMesh;
+	return true;
+}
+
+}
+
+Mesh::Mesh() {
+
+}
+
+Mesh::~Mesh() {
+
+}
+
+bool Mesh::loadMesh(const std::string& mesh) {
+
+	SharedMesh sharedMesh;
+	if (!loadSharedMesh(mesh, sharedMesh)) {
+		return false;
+	}
+
+	// The geometry is shared, the instance only adds its pat
+	meshInstancePat_ = new osg::PositionAttitudeTransform();
+	meshInstancePat_->addChild(sharedMesh.node);
+	meshPat_ = meshInstancePat_;
+
+	xLen_ = sharedMesh.xLen;
+	yLen_ = sharedMesh.yLen;
+	zLen_ = sharedMesh.zLen;
+
 	return true;
 
 }
@@ -100,21 +149,15 @@ float Mesh::zLen() {
 }
 
 void Mesh::setColor(osg::Vec4 color) {
-#if OSG_VERSION_GREATER_OR_EQUAL(3, 2, 0)
-	osg::Geometry* geometry =
-	 meshNode_->asGroup()->getChild(0)->asGeode()->getDrawable(0)->asGeometry();
-	osg::Vec4Array* colors = new osg::Vec4Array;
-	colors->push_back(color);
-	colors->setBinding(osg::Array::BIND_OVERALL);
-	geometry->setColorArray(colors);
-#else
-	osg::Geometry* geometry =
-			this->meshNode_->asGeode()->getDrawable(0)->asGeometry();
-	osg::Vec4Array* colors = new osg::Vec4Array;
-	colors->push_back(color);
-	geometry->setColorArray(colors);
-	geometry->setColorBinding(osg::Geometry::BIND_PER_PRIMITIVE_SET);
-#endif
+	// The geometry is shared with the other instances of the mesh, so the
+	// color of this one overrides the material of its pat
+	osg::ref_ptr<osg::Material> material(new osg::Material());
+	material->setColorMode(osg::Material::OFF);
+	material->setAmbient(osg::Material::FRONT_AND_BACK, color);
+	material->setDiffuse(osg::Material::FRONT_AND_BACK, color);
+	meshInstancePat_->getOrCreateStateSet()->setAttributeAndModes(
+			material.get(), osg::StateAttribute::ON |
+			osg::StateAttribute::OVERRIDE);
 }
 
 }
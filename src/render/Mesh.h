@@ -41,6 +41,9 @@ public:
 
 	virtual ~Mesh();
 
+	/**
+	 * Loads a mesh file, or reuses its geometry if it was loaded before
+	 */
 	bool loadMesh(const std::string& mesh);
 	void rescaleMesh(float scaleX, float scaleY, float scaleZ);
 
@@ -54,8 +57,15 @@ public:
 
 private:
 
-	osg::ref_ptr<osg::Node> meshNode_;
+	/**
+	 * Parent of the mesh geometry, which is loaded once per file and shared
+	 * by all the Mesh instances
+	 */
+	osg::ref_ptr<osg::PositionAttitudeTransform> meshInstancePat_;
 
+	/**
+	 * meshInstancePat_ or the pat rescaling it
+	 */
 	osg::ref_ptr<osg::PositionAttitudeTransform> meshPat_;
 
 	float xLen_;
@@ -26,7 +26,6 @@
  * @(#) $Id$
  */
 #include <cmath>
-#include <osg/PositionAttitudeTransform>
 
 #include "model/components/actuated/ActiveCardanModel.h"
 #include "render/callback/ActiveCardanCrossCallback.h"
@@ -40,15 +39,12 @@ ActiveCardanCrossCallback::ActiveCardanCrossCallback(
 
 }
 
-void ActiveCardanCrossCallback::operator()(osg::Node* node,
-		osg::NodeVisitor* nv) {
+void ActiveCardanCrossCallback::getTransform(osg::Vec3& position,
+		osg::Quat& attitude) {
 
 	static const double CONNECTION_PART_OFFSET = fromOde(
 			ActiveCardanModel::CONNECTION_PART_OFFSET);
 
-	osg::ref_ptr<osg::PositionAttitudeTransform> pat =
-			node->asTransform()->asPositionAttitudeTransform();
-
 	osg::Quat attitudeConnectionA = model_->getBodyAttitude(
 			ActiveCardanModel::B_CONNECTION_A_ID);
 
@@ -58,8 +54,8 @@ void ActiveCardanCrossCallback::operator()(osg::Node* node,
 	osg::Vec3 posConnectionA = fromOde(
 			model_->getBodyPosition(ActiveCardanModel::B_CONNECTION_A_ID));
 
-	osg::Vec3 position(CONNECTION_PART_OFFSET, 0, 0);
-	position = attitudeConnectionA * position;
+	osg::Vec3 offset(CONNECTION_PART_OFFSET, 0, 0);
+	offset = attitudeConnectionA * offset;
 
 	// Z vector of connection A
 	osg::Vec3 zVectorConnectionA(0, 0, 1);
@@ -73,10 +69,8 @@ void ActiveCardanCrossCallback::operator()(osg::Node* node,
 	osg::Quat rotation = RobogenUtils::makeRotate(zVectorConnectionA,
 			zVectorConnectionB);
 
-	pat->setAttitude(attitudeConnectionA * rotation);
-	pat->setPosition(posConnectionA + position);
-
-	traverse(node, nv);
+	attitude = attitudeConnectionA * rotation;
+	position = posConnectionA + offset;
 
 }
 
@@ -29,20 +29,20 @@
 #define ROBOGEN_ACTIVE_CARDAN_CROSS_CALLBACK_H_
 
 #include <boost/shared_ptr.hpp>
-#include <osg/Node>
+#include "render/callback/TransformCallback.h"
 #include "Robogen.h"
 
 namespace robogen {
 
 class ActiveCardanModel;
 
-class ActiveCardanCrossCallback: public osg::NodeCallback {
+class ActiveCardanCrossCallback: public TransformCallback {
 
 public:
 
 	ActiveCardanCrossCallback(boost::shared_ptr<ActiveCardanModel> model);
 
-	virtual void operator()(osg::Node* node, osg::NodeVisitor* nv);
+	virtual void getTransform(osg::Vec3& position, osg::Quat& attitude);
 
 private:
 
@@ -26,8 +26,6 @@
  *
  * @(#) $Id$
  */
-#include <osg/PositionAttitudeTransform>
-
 #include "model/Model.h"
 #include "render/callback/BodyCallback.h"
 
@@ -39,15 +37,10 @@ BodyCallback::BodyCallback(boost::shared_ptr<Model> model, int bodyId) :
 
 }
 
-void BodyCallback::operator()(osg::Node* node, osg::NodeVisitor* nv) {
-
-   osg::ref_ptr<osg::PositionAttitudeTransform> pat =
-         node->asTransform()->asPositionAttitudeTransform();
-
-   pat->setAttitude(model_.lock()->getBodyAttitude(bodyId_));
-   pat->setPosition(fromOde(model_.lock()->getBodyPosition(bodyId_)));
+void BodyCallback::getTransform(osg::Vec3& position, osg::Quat& attitude) {
 
-   traverse(node, nv);
+   attitude = model_.lock()->getBodyAttitude(bodyId_);
+   position = fromOde(model_.lock()->getBodyPosition(bodyId_));
 }
 
 }
@@ -31,20 +31,20 @@
 
 #include <boost/shared_ptr.hpp>
 #include <boost/weak_ptr.hpp>
-#include <osg/Node>
+#include "render/callback/TransformCallback.h"
 #include "Robogen.h"
 
 namespace robogen {
 
 class Model;
 
-class BodyCallback: public osg::NodeCallback {
+class BodyCallback: public TransformCallback {
 
 public:
 
 	BodyCallback(boost::shared_ptr<Model> model, int bodyId);
 
-	virtual void operator()(osg::Node* node, osg::NodeVisitor* nv);
+	virtual void getTransform(osg::Vec3& position, osg::Quat& attitude);
 
 private:
 
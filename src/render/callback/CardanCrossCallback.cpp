@@ -26,7 +26,6 @@
  * @(#) $Id$
  */
 #include <cmath>
-#include <osg/PositionAttitudeTransform>
 
 #include "model/components/CardanModel.h"
 #include "render/callback/CardanCrossCallback.h"
@@ -39,16 +38,14 @@ CardanCrossCallback::CardanCrossCallback(boost::shared_ptr<CardanModel> model) :
 
 }
 
-void CardanCrossCallback::operator()(osg::Node* node, osg::NodeVisitor* nv) {
+void CardanCrossCallback::getTransform(osg::Vec3& position,
+		osg::Quat& attitude) {
 
 	static const double CONNECTION_PART_OFFSET = fromOde(
 			(CardanModel::CONNNECTION_PART_LENGTH / 2
 					- (CardanModel::CONNNECTION_PART_LENGTH
 							- CardanModel::CONNECTION_PART_OFFSET)));
 
-	osg::ref_ptr<osg::PositionAttitudeTransform> pat =
-			node->asTransform()->asPositionAttitudeTransform();
-
 	osg::Quat attitudeConnectionA = model_->getBodyAttitude(
 			CardanModel::B_CONNECTION_A_ID);
 
@@ -58,8 +55,8 @@ void CardanCrossCallback::operator()(osg::Node* node, osg::NodeVisitor* nv) {
 	osg::Vec3 posConnectionA = fromOde(
 			model_->getBodyPosition(CardanModel::B_CONNECTION_A_ID));
 
-	osg::Vec3 position(CONNECTION_PART_OFFSET, 0, 0);
-	position = attitudeConnectionA * position;
+	osg::Vec3 offset(CONNECTION_PART_OFFSET, 0, 0);
+	offset = attitudeConnectionA * offset;
 
 	// Z vector of connection A
 	osg::Vec3 zVectorConnectionA(0, 0, 1);
@@ -73,10 +70,8 @@ void CardanCrossCallback::operator()(osg::Node* node, osg::NodeVisitor* nv) {
 	osg::Quat rotation = RobogenUtils::makeRotate(zVectorConnectionA,
 			zVectorConnectionB);
 
-	pat->setAttitude(attitudeConnectionA * rotation);
-	pat->setPosition(posConnectionA + position);
-
-	traverse(node, nv);
+	attitude = attitudeConnectionA * rotation;
+	position = posConnectionA + offset;
 
 }
 
@@ -29,20 +29,20 @@
 #define ROBOGEN_CARDAN_CROSS_CALLBACK_H_
 
 #include <boost/shared_ptr.hpp>
-#include <osg/Node>
+#include "render/callback/TransformCallback.h"
 #include "Robogen.h"
 
 namespace robogen {
 
 class CardanModel;
 
-class CardanCrossCallback: public osg::NodeCallback {
+class CardanCrossCallback: public TransformCallback {
 
 public:
 
 	CardanCrossCallback(boost::shared_ptr<CardanModel> model);
 
-	virtual void operator()(osg::Node* node, osg::NodeVisitor* nv);
+	virtual void getTransform(osg::Vec3& position, osg::Quat& attitude);
 
 private:
 
@@ -25,8 +25,6 @@
  *
  * @(#) $Id$
  */
-#include <osg/PositionAttitudeTransform>
-
 #include "model/Model.h"
 #include "render/callback/PositionObservableCallback.h"
 
@@ -38,15 +36,11 @@ PositionObservableCallback::PositionObservableCallback(boost::shared_ptr<Positio
 
 }
 
-void PositionObservableCallback::operator()(osg::Node* node, osg::NodeVisitor* nv) {
-
-   osg::ref_ptr<osg::PositionAttitudeTransform> pat =
-         node->asTransform()->asPositionAttitudeTransform();
-
-   pat->setAttitude(model_->getAttitude());
-   pat->setPosition(fromOde(model_->getPosition()));
+void PositionObservableCallback::getTransform(osg::Vec3& position,
+		osg::Quat& attitude) {
 
-   traverse(node, nv);
+   attitude = model_->getAttitude();
+   position = fromOde(model_->getPosition());
 }
 
 }
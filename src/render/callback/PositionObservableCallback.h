@@ -29,7 +29,7 @@
 #define ROBOGEN_BODY_CALLBACK_H_
 
 #include <boost/shared_ptr.hpp>
-#include <osg/Node>
+#include "render/callback/TransformCallback.h"
 #include "model/PositionObservable.h"
 #include "Robogen.h"
 
@@ -37,13 +37,13 @@ namespace robogen {
 
 class Model;
 
-class PositionObservableCallback: public osg::NodeCallback {
+class PositionObservableCallback: public TransformCallback {
 
 public:
 
 	PositionObservableCallback(boost::shared_ptr<PositionObservable> model);
 
-	virtual void operator()(osg::Node* node, osg::NodeVisitor* nv);
+	virtual void getTransform(osg::Vec3& position, osg::Quat& attitude);
 
 private:
 
@@ -0,0 +1,46 @@
+/*
+ * @(#) TransformCallback.cpp   1.0   Oct 19, 2026
+ *
+ * The ROBOGEN Framework
+ * Copyright © 2013-2016
+ *
+ * Laboratory of Intelligent Systems, EPFL
+ *
+ * This file is part of the ROBOGEN Framework.
+ *
+ * The ROBOGEN Framework is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License (GPL)
+ * as published by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @(#) $Id$
+ */
+#include <osg/PositionAttitudeTransform>
+
+#include "render/callback/TransformCallback.h"
+
+namespace robogen {
+
+void TransformCallback::operator()(osg::Node* node, osg::NodeVisitor* nv) {
+
+	osg::ref_ptr<osg::PositionAttitudeTransform> pat =
+			node->asTransform()->asPositionAttitudeTransform();
+
+	osg::Vec3 position;
+	osg::Quat attitude;
+	getTransform(position, attitude);
+	pat->setAttitude(attitude);
+	pat->setPosition(position);
+
+	traverse(node, nv);
+}
+
+}
@@ -0,0 +1,59 @@
+/*
+ * @(#) TransformCallback.h   1.0   Oct 19, 2026
+ *
+ * The ROBOGEN Framework
+ * Copyright © 2013-2016
+ *
+ * Laboratory of Intelligent Systems, EPFL
+ *
+ * This file is part of the ROBOGEN Framework.
+ *
+ * The ROBOGEN Framework is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License (GPL)
+ * as published by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @(#) $Id$
+ */
+#ifndef ROBOGEN_TRANSFORM_CALLBACK_H_
+#define ROBOGEN_TRANSFORM_CALLBACK_H_
+
+#include <osg/Node>
+#include <osg/Quat>
+#include <osg/Vec3>
+
+namespace robogen {
+
+/**
+ * Update callback of a PositionAttitudeTransform following the physics.
+ *
+ * The transform is computed by getTransform, which reads the physics models
+ * and so must run on the simulation thread: the Viewer calls it when
+ * publishing the state of the simulation to its render thread, and the
+ * callback itself is only used when the scene is updated by the thread
+ * simulating.
+ */
+class TransformCallback: public osg::NodeCallback {
+
+public:
+
+	/**
+	 * Computes the position and attitude of the node
+	 */
+	virtual void getTransform(osg::Vec3& position, osg::Quat& attitude) = 0;
+
+	virtual void operator()(osg::Node* node, osg::NodeVisitor* nv);
+
+};
+
+}
+
+#endif /* ROBOGEN_TRANSFORM_CALLBACK_H_ */
@@ -26,14 +26,20 @@
  * @(#) $Id$
  */
 
+#include <algorithm>
+#include <cmath>
 #include "Environment.h"
+#include "utils/RobogenUtils.h"
+
+// deepest level of the quadtree of fixed obstacles
+#define STATIC_SPACE_MAX_DEPTH 8
 
 
 namespace robogen {
 
 Environment::Environment(dWorldID odeWorld, dSpaceID odeSpace,
 		boost::shared_ptr<RobogenConfig> robogenConfig) :
-				odeWorld_(odeWorld), odeSpace_(odeSpace),
+				odeWorld_(odeWorld), odeSpace_(odeSpace), staticSpace_(0),
 				robogenConfig_(robogenConfig),
 				timeElapsed_(0),
 				ambientLight_(DEFAULT_AMBIENT_LIGHT) {
@@ -46,7 +52,7 @@ Environment::~Environment() {
 	obstacles_.clear();
 }
 
-bool Environment::init() {
+bool Environment::init(unsigned int startPosition) {
 	// Setup terrain
 	boost::shared_ptr<TerrainConfig> terrainConfig =
 			robogenConfig_->getTerrainConfig();
@@ -60,15 +66,63 @@ bool Environment::init() {
 		}
 	}
 #ifndef DISABLE_HEIGHT_MAP
+	else if (terrainConfig->getType() == TerrainConfig::ROUGH &&
+			terrainConfig->getGenerator() != TerrainConfig::NO_GENERATOR) {
+		if(!terrain_->initGenerated(terrainConfig->getGenerator(),
+				terrainConfig->getSeed(startPosition),
+				terrainConfig->getResolution(),
+				terrainConfig->getFeatureSize(), terrainConfig->getLength(),
+				terrainConfig->getWidth(), terrainConfig->getHeight(),
+				terrainConfig->isTrimesh())) {
+			return false;
+		}
+	}
 	else if (terrainConfig->getType() == TerrainConfig::ROUGH) {
 		if(!terrain_->initRough(terrainConfig->getHeightFieldFileName(),
 				terrainConfig->getLength(), terrainConfig->getWidth(),
-				terrainConfig->getHeight())) {
+				terrainConfig->getHeight(), terrainConfig->isTrimesh())) {
 			return false;
 		}
 	}
 #endif
 
+	// Setup the space of fixed obstacles, covering all of them
+	boost::shared_ptr<ObstaclesConfig> obstacles =
+			robogenConfig_->getObstaclesConfig();
+	const std::vector<osg::Vec3>& coordinates = obstacles->getCoordinates();
+	const std::vector<osg::Vec3>& sizes = obstacles->getSizes();
+	const std::vector<float>& densities = obstacles->getDensities();
+
+	unsigned int numStatic = 0;
+	osg::Vec3 minimum, maximum;
+	for (unsigned int i = 0; i < coordinates.size(); ++i) {
+		if (densities[i] >= RobogenUtils::EPSILON_2) {
+			continue;
+		}
+		// whatever the rotation of the box
+		float radius = sizes[i].length() / 2;
+		for (unsigned int j = 0; j < 3; ++j) {
+			float low = coordinates[i][j] - radius;
+			float high = coordinates[i][j] + radius;
+			minimum[j] = (numStatic == 0) ? low : std::min(minimum[j], low);
+			maximum[j] = (numStatic == 0) ? high : std::max(maximum[j], high);
+		}
+		numStatic++;
+	}
+
+	if (numStatic > 0) {
+		dVector3 center, extents;
+		for (unsigned int j = 0; j < 3; ++j) {
+			center[j] = (minimum[j] + maximum[j]) / 2;
+			extents[j] = (maximum[j] - minimum[j]) / 2;
+		}
+		// about one obstacle per leaf
+		int depth = 1 + static_cast<int>(std::ceil(std::log(
+				static_cast<double>(numStatic)) / std::log(4.0)));
+		staticSpace_ = dQuadTreeSpaceCreate(odeSpace_, center, extents,
+				std::min(depth, STATIC_SPACE_MAX_DEPTH));
+	}
+
 	return true;
 }
 
@@ -50,7 +50,13 @@ public:
 	Environment(dWorldID odeWorld, dSpaceID odeSpace,
 			boost::shared_ptr<RobogenConfig> robogenConfig);
 
-	bool init();
+	/**
+	 * Sets up the terrain and obstacles
+	 *
+	 * @param startPosition index of the starting position of the trial,
+	 * which seeds a generated terrain that varies per trial
+	 */
+	bool init(unsigned int startPosition);
 
 	virtual ~Environment();
 
@@ -87,6 +93,14 @@ public:
 		return terrain_;
 	}
 
+	/**
+	 * @return the space of fixed obstacles, nested in the ODE collision
+	 * space, or 0 if there are none
+	 */
+	dSpaceID getStaticSpace() {
+		return staticSpace_;
+	}
+
 	std::vector<boost::shared_ptr<Obstacle> > getObstacles() {
 		return obstacles_;
 	}
@@ -102,6 +116,13 @@ private:
 	 */
 	dSpaceID odeSpace_;
 
+	/**
+	 * Space of the fixed obstacles, body-less geoms that never collide with
+	 * each other. A quadtree nested in odeSpace_, so that colliding the
+	 * space tests them against the other geoms only where they overlap.
+	 */
+	dSpaceID staticSpace_;
+
 	/**
 	 * Robogen config
 	 */
@@ -0,0 +1,409 @@
+/*
+ * @(#) HeightMap.cpp   1.0   Oct 19, 2026
+ *
+ * The ROBOGEN Framework
+ * Copyright © 2013-2016
+ *
+ * Laboratory of Intelligent Systems, EPFL
+ *
+ * This file is part of the ROBOGEN Framework.
+ *
+ * The ROBOGEN Framework is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License (GPL)
+ * as published by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @(#) $Id$
+ */
+#ifndef DISABLE_HEIGHT_MAP
+
+#include <algorithm>
+#include <cmath>
+#include <list>
+#include <map>
+#include <sstream>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_real_distribution.hpp>
+#include <boost/thread/mutex.hpp>
+#include <osg/Image>
+#include <osgDB/ReadFile>
+#include "scenario/HeightMap.h"
+
+namespace robogen {
+
+namespace {
+
+/**
+ * Most height maps kept cached. With a terrain per trial every seed gets its
+ * own, so the least recently used ones are dropped past this.
+ */
+const unsigned int MAX_CACHED_HEIGHT_MAPS = 16;
+
+boost::mutex heightMapsMutex;
+
+std::map<std::string, boost::shared_ptr<const HeightMap> > heightMaps;
+
+/**
+ * Keys of the cached height maps, from the least to the most recently used
+ */
+std::list<std::string> heightMapsUse;
+
+/**
+ * Gets a cached height map and marks it as the most recently used.
+ * Call with heightMapsMutex locked.
+ */
+boost::shared_ptr<const HeightMap> findHeightMap(const std::string &key) {
+	std::map<std::string, boost::shared_ptr<const HeightMap> >::iterator it =
+			heightMaps.find(key);
+	if (it == heightMaps.end()) {
+		return boost::shared_ptr<const HeightMap>();
+	}
+	heightMapsUse.remove(key);
+	heightMapsUse.push_back(key);
+	return it->second;
+}
+
+/**
+ * Caches a height map, dropping the least recently used ones past
+ * MAX_CACHED_HEIGHT_MAPS. Terrains still using them keep their own reference.
+ * Call with heightMapsMutex locked.
+ */
+void cacheHeightMap(const std::string &key,
+		boost::shared_ptr<const HeightMap> heightMap) {
+	while (heightMapsUse.size() >= MAX_CACHED_HEIGHT_MAPS) {
+		heightMaps.erase(heightMapsUse.front());
+		heightMapsUse.pop_front();
+	}
+	heightMaps[key] = heightMap;
+	heightMapsUse.push_back(key);
+}
+
+/**
+ * 2D Perlin gradient noise, in [-1, 1]
+ */
+class PerlinNoise {
+
+public:
+
+	PerlinNoise(boost::random::mt19937 &rng) {
+		for (unsigned int i = 0; i < 256; ++i) {
+			permutation_[i] = i;
+		}
+		for (unsigned int i = 255; i > 0; --i) {
+			std::swap(permutation_[i], permutation_[rng() % (i + 1)]);
+		}
+		for (unsigned int i = 0; i < 256; ++i) {
+			permutation_[256 + i] = permutation_[i];
+		}
+	}
+
+	double operator()(double x, double y) const {
+		int xi = static_cast<int>(std::floor(x)) & 255;
+		int yi = static_cast<int>(std::floor(y)) & 255;
+		x -= std::floor(x);
+		y -= std::floor(y);
+		double u = fade(x);
+		double v = fade(y);
+
+		int a = permutation_[xi] + yi;
+		int b = permutation_[xi + 1] + yi;
+
+		double bottom = lerp(u, gradient(permutation_[a], x, y),
+				gradient(permutation_[b], x - 1, y));
+		double top = lerp(u, gradient(permutation_[a + 1], x, y - 1),
+				gradient(permutation_[b + 1], x - 1, y - 1));
+		// the extrema of 2D Perlin noise are +/- sqrt(2) / 2
+		return lerp(v, bottom, top) * M_SQRT2;
+	}
+
+private:
+
+	static double fade(double t) {
+		return t * t * t * (t * (t * 6 - 15) + 10);
+	}
+
+	static double lerp(double t, double a, double b) {
+		return a + t * (b - a);
+	}
+
+	static double gradient(int hash, double x, double y) {
+		switch (hash & 7) {
+		case 0: return x + y;
+		case 1: return -x + y;
+		case 2: return x - y;
+		case 3: return -x - y;
+		case 4: return x;
+		case 5: return -x;
+		case 6: return y;
+		default: return -y;
+		}
+	}
+
+	int permutation_[512];
+
+};
+
+/**
+ * Fills heights, one per sample, in [0, 1]
+ */
+void generateHeights(TerrainConfig::TerrainGenerator generator,
+		unsigned int seed, unsigned int resolution, float featureSize,
+		float width, float depth, std::vector<double> &heights) {
+
+	boost::random::mt19937 rng(seed);
+	heights.assign(resolution * resolution, 0);
+
+	float spacingX = width / (resolution - 1);
+	float spacingY = depth / (resolution - 1);
+
+	switch (generator) {
+	case TerrainConfig::FRACTAL: {
+		// five octaves, each of half the wavelength and amplitude, shifted
+		// so that their lattices, where noise is 0, don't line up
+		PerlinNoise noise(rng);
+		boost::random::uniform_real_distribution<double> shift(0, 256);
+		double shifts[5][2];
+		for (unsigned int octave = 0; octave < 5; ++octave) {
+			shifts[octave][0] = shift(rng);
+			shifts[octave][1] = shift(rng);
+		}
+		for (unsigned int y = 0; y < resolution; ++y) {
+			for (unsigned int x = 0; x < resolution; ++x) {
+				double value = 0;
+				double frequency = 1.0 / featureSize;
+				double amplitude = 0.5;
+				for (unsigned int octave = 0; octave < 5; ++octave) {
+					value += amplitude * noise(
+							x * spacingX * frequency + shifts[octave][0],
+							y * spacingY * frequency + shifts[octave][1]);
+					frequency *= 2;
+					amplitude /= 2;
+				}
+				heights[x + resolution * y] = std::min(1.0,
+						std::max(0.0, 0.5 + value));
+			}
+		}
+		break;
+	}
+	case TerrainConfig::STEPS: {
+		unsigned int numSteps = static_cast<unsigned int>(
+				std::ceil(width / featureSize));
+		for (unsigned int y = 0; y < resolution; ++y) {
+			for (unsigned int x = 0; x < resolution; ++x) {
+				unsigned int step = std::min(numSteps - 1,
+						static_cast<unsigned int>(x * spacingX / featureSize));
+				heights[x + resolution * y] = (numSteps > 1) ?
+						static_cast<double>(step) / (numSteps - 1) : 0;
+			}
+		}
+		break;
+	}
+	case TerrainConfig::SLOPE:
+		for (unsigned int y = 0; y < resolution; ++y) {
+			for (unsigned int x = 0; x < resolution; ++x) {
+				heights[x + resolution * y] =
+						static_cast<double>(x) / (resolution - 1);
+			}
+		}
+		break;
+	case TerrainConfig::RUBBLE: {
+		// rounded rocks of 1/2 to 1 feature size, about one per square
+		// feature size, of 20% to 100% of the height
+		boost::random::uniform_real_distribution<double> unit(0, 1);
+		unsigned int numRocks = static_cast<unsigned int>(
+				width * depth / (featureSize * featureSize) + 0.5);
+		for (unsigned int i = 0; i < numRocks; ++i) {
+			double centerX = unit(rng) * width;
+			double centerY = unit(rng) * depth;
+			double radius = featureSize * (0.25 + 0.25 * unit(rng));
+			double rockHeight = 0.2 + 0.8 * unit(rng);
+
+			int minX = std::max(0, static_cast<int>(
+					std::ceil((centerX - radius) / spacingX)));
+			int maxX = std::min(static_cast<int>(resolution) - 1,
+					static_cast<int>((centerX + radius) / spacingX));
+			int minY = std::max(0, static_cast<int>(
+					std::ceil((centerY - radius) / spacingY)));
+			int maxY = std::min(static_cast<int>(resolution) - 1,
+					static_cast<int>((centerY + radius) / spacingY));
+			for (int y = minY; y <= maxY; ++y) {
+				for (int x = minX; x <= maxX; ++x) {
+					double dx = (x * spacingX - centerX) / radius;
+					double dy = (y * spacingY - centerY) / radius;
+					double d2 = dx * dx + dy * dy;
+					if (d2 < 1) {
+						double &height = heights[x + resolution * y];
+						height = std::max(height,
+								rockHeight * std::sqrt(1 - d2));
+					}
+				}
+			}
+		}
+		break;
+	}
+	case TerrainConfig::NO_GENERATOR:
+	default:
+		break;
+	}
+}
+
+}
+
+boost::shared_ptr<const HeightMap> HeightMap::get(const std::string& fileName,
+		float width, float depth, float height, bool trimesh) {
+
+	std::stringstream key;
+	key << "file " << fileName << "|" << width << "|" << depth << "|" << height << "|"
+			<< trimesh;
+
+	// loads under the lock, so that threads starting together load it once
+	boost::mutex::scoped_lock lock(heightMapsMutex);
+	boost::shared_ptr<const HeightMap> cached = findHeightMap(key.str());
+	if (cached) {
+		return cached;
+	}
+
+	osg::ref_ptr<osg::Image> image = osgDB::readImageFile(fileName);
+	if (image == NULL || image->s() < 2 || image->t() < 2) {
+		std::cout << "Cannot load the height map file '" << fileName
+				<< "' for the terrain. Quit." << std::endl;
+		return boost::shared_ptr<const HeightMap>();
+	}
+
+	boost::shared_ptr<const HeightMap> heightMap(new HeightMap(image, width,
+			depth, height, trimesh));
+	cacheHeightMap(key.str(), heightMap);
+	return heightMap;
+}
+
+boost::shared_ptr<const HeightMap> HeightMap::generate(
+		TerrainConfig::TerrainGenerator generator, unsigned int seed,
+		unsigned int resolution, float featureSize, float width, float depth,
+		float height, bool trimesh) {
+
+	if (generator == TerrainConfig::NO_GENERATOR || resolution < 2 ||
+			featureSize <= 0) {
+		std::cout << "Invalid parameters of the terrain generator. Quit."
+				<< std::endl;
+		return boost::shared_ptr<const HeightMap>();
+	}
+
+	std::stringstream key;
+	key << "generator " << generator << "|" << seed << "|" << resolution
+			<< "|" << featureSize << "|" << width << "|" << depth << "|"
+			<< height << "|" << trimesh;
+
+	boost::mutex::scoped_lock lock(heightMapsMutex);
+	boost::shared_ptr<const HeightMap> cached = findHeightMap(key.str());
+	if (cached) {
+		return cached;
+	}
+
+	std::vector<double> heights;
+	generateHeights(generator, seed, resolution, featureSize, width, depth,
+			heights);
+
+	// the same image as read from a height map file
+	osg::ref_ptr<osg::Image> image(new osg::Image());
+	image->allocateImage(resolution, resolution, 1, GL_LUMINANCE,
+			GL_UNSIGNED_BYTE);
+	for (unsigned int y = 0; y < resolution; ++y) {
+		for (unsigned int x = 0; x < resolution; ++x) {
+			*image->data(x, y) = static_cast<unsigned char>(
+					heights[x + resolution * y] * 255 + 0.5);
+		}
+	}
+
+	boost::shared_ptr<const HeightMap> heightMap(new HeightMap(image, width,
+			depth, height, trimesh));
+	cacheHeightMap(key.str(), heightMap);
+	return heightMap;
+}
+
+HeightMap::HeightMap(osg::ref_ptr<osg::Image> image, float width, float depth,
+		float height, bool trimesh) :
+		image_(image), xCount_(image->s()), yCount_(image->t()) {
+
+	samples_.resize(xCount_ * yCount_);
+	for (unsigned int y = 0; y < yCount_; ++y) {
+		for (unsigned int x = 0; x < xCount_; ++x) {
+			samples_[(yCount_ - 1 - y) * xCount_ + x] = *image->data(x, y);
+		}
+	}
+
+	if (!trimesh) {
+		return;
+	}
+
+	float startX = -width / 2;
+	float startY = -depth / 2;
+
+	float spacingX = width / (xCount_ - 1);
+	float spacingY = depth / (yCount_ - 1);
+
+	vertices_.resize(xCount_ * yCount_ * 3);
+	for (unsigned int x = 0; x < xCount_; ++x) {
+		for (unsigned int y = 0; y < yCount_; ++y) {
+
+			unsigned int j = x + xCount_ * y;
+
+			vertices_[3 * j] = startX + spacingX * x;
+			vertices_[3 * j + 1] = startY + spacingY * y;
+			vertices_[3 * j + 2] = (*image->data(x, y) / 255.0) * height;
+
+		}
+	}
+
+	indices_.reserve((xCount_ - 1) * (yCount_ - 1) * 6);
+	for (unsigned int y = 0; y < yCount_ - 1; ++y) {
+		for (unsigned int x = 0; x < xCount_ - 1; ++x) {
+			dTriIndex c = x + xCount_ * y;
+			indices_.push_back(c);
+			indices_.push_back(c + 1);
+			indices_.push_back(c + xCount_);
+			indices_.push_back(c + 1);
+			indices_.push_back(c + xCount_ + 1);
+			indices_.push_back(c + xCount_);
+		}
+	}
+}
+
+HeightMap::~HeightMap() {
+
+}
+
+osg::ref_ptr<osg::Image> HeightMap::getImage() const {
+	return image_;
+}
+
+unsigned int HeightMap::getXCount() const {
+	return xCount_;
+}
+
+unsigned int HeightMap::getYCount() const {
+	return yCount_;
+}
+
+const std::vector<unsigned char>& HeightMap::getSamples() const {
+	return samples_;
+}
+
+const std::vector<double>& HeightMap::getVertices() const {
+	return vertices_;
+}
+
+const std::vector<dTriIndex>& HeightMap::getIndices() const {
+	return indices_;
+}
+
+}
+
+#endif
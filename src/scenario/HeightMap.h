@@ -0,0 +1,149 @@
+/*
+ * @(#) HeightMap.h   1.0   Oct 19, 2026
+ *
+ * The ROBOGEN Framework
+ * Copyright © 2013-2016
+ *
+ * Laboratory of Intelligent Systems, EPFL
+ *
+ * This file is part of the ROBOGEN Framework.
+ *
+ * The ROBOGEN Framework is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License (GPL)
+ * as published by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @(#) $Id$
+ */
+#ifndef ROBOGEN_HEIGHT_MAP_H_
+#define ROBOGEN_HEIGHT_MAP_H_
+
+#include <string>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include <osg/ref_ptr>
+#include "Robogen.h"
+#include "config/TerrainConfig.h"
+
+namespace osg {
+class Image;
+}
+
+namespace robogen {
+
+/**
+ * Elevation data of a rough terrain, read from a height map image or
+ * generated in memory.
+ *
+ * Loading or generating the image and building the collision data is done
+ * once per set of parameters: the height maps are cached and shared,
+ * read-only, by the terrains of all simulations and threads. Only the most
+ * recently used ones stay cached.
+ */
+class HeightMap {
+
+public:
+
+	/**
+	 * Gets the height map of an image, loading it if it isn't cached yet.
+	 * Safe to call from several threads.
+	 *
+	 * @param fileName height map image, its byte values (0-255) give the
+	 * elevation, 0 for the lowest and 255 for height
+	 * @param width
+	 * @param depth
+	 * @param height
+	 * @param trimesh also build the vertices and triangles of a trimesh
+	 * @return the height map, or an empty pointer if the image can't be read
+	 */
+	static boost::shared_ptr<const HeightMap> get(const std::string& fileName,
+			float width, float depth, float height, bool trimesh);
+
+	/**
+	 * Gets a generated height map, generating it if it isn't cached yet.
+	 * Generators give the same height map for the same parameters and seed.
+	 * Safe to call from several threads.
+	 *
+	 * @param generator
+	 * @param seed
+	 * @param resolution number of samples along each side
+	 * @param featureSize noise wavelength, step length or rock diameter
+	 * @param width
+	 * @param depth
+	 * @param height
+	 * @param trimesh also build the vertices and triangles of a trimesh
+	 * @return the height map, or an empty pointer if the parameters are
+	 * invalid
+	 */
+	static boost::shared_ptr<const HeightMap> generate(
+			TerrainConfig::TerrainGenerator generator, unsigned int seed,
+			unsigned int resolution, float featureSize, float width,
+			float depth, float height, bool trimesh);
+
+	virtual ~HeightMap();
+
+	/**
+	 * @return the height map image
+	 */
+	osg::ref_ptr<osg::Image> getImage() const;
+
+	/**
+	 * @return number of samples along x (width)
+	 */
+	unsigned int getXCount() const;
+
+	/**
+	 * @return number of samples along y (depth)
+	 */
+	unsigned int getYCount() const;
+
+	/**
+	 * @return the samples in the layout of an ODE heightfield: one row of
+	 * getXCount() samples per y, from the largest y to the smallest
+	 */
+	const std::vector<unsigned char>& getSamples() const;
+
+	/**
+	 * @return x, y, z of each sample, the one at (x, y) of the image being
+	 * vertex x + getXCount() * y. Empty unless built for a trimesh.
+	 */
+	const std::vector<double>& getVertices() const;
+
+	/**
+	 * @return the two triangles of each grid cell, counterclockwise seen from
+	 * above. Empty unless built for a trimesh.
+	 */
+	const std::vector<dTriIndex>& getIndices() const;
+
+private:
+
+	HeightMap(osg::ref_ptr<osg::Image> image, float width, float depth,
+			float height, bool trimesh);
+
+	/**
+	 * Height map image
+	 */
+	osg::ref_ptr<osg::Image> image_;
+
+	unsigned int xCount_;
+	unsigned int yCount_;
+
+	std::vector<unsigned char> samples_;
+
+	std::vector<double> vertices_;
+
+	std::vector<dTriIndex> indices_;
+
+};
+
+}
+
+#endif /* ROBOGEN_HEIGHT_MAP_H_ */
@@ -29,7 +29,11 @@
 #ifdef QT5_ENABLED
 
 #include "QScriptScenario.h"
+#include <map>
+#include <sstream>
 #include <osg/Vec3>
+#include <boost/functional/hash.hpp>
+#include <boost/thread/tss.hpp>
 #include "config/RobogenConfig.h"
 #include "config/StartPositionConfig.h"
 #include "scenario/Environment.h"
@@ -44,12 +48,66 @@
 
 namespace robogen {
 
-QScriptScenario::QScriptScenario(boost::shared_ptr<RobogenConfig> config) :
-	Scenario(config), engine_(new QScriptEngine), curTrial_(0) {
+namespace {
 
-	engine_->globalObject().setProperty("qScriptScenario",
-			engine_->newQObject(this));
+/**
+ * Compiled script and the engine it runs in
+ */
+struct CachedScript {
+	std::string script;
+	QScriptProgram program;
+	boost::shared_ptr<QScriptEngine> engine;
+	bool inUse;
+	// value of ScriptCache::uses when a scenario last took the engine
+	unsigned long lastUse;
+};
+
+/**
+ * Scripts cached, by hash, for the following scenarios of a thread
+ */
+struct ScriptCache {
+	std::map<std::size_t, CachedScript> scripts;
+	// number of times an engine was taken, orders the entries by last use
+	unsigned long uses;
+
+	ScriptCache() : uses(0) {
+	}
+};
+
+// past this, the least recently used scripts whose engines are free are
+// dropped
+#define MAX_CACHED_SCRIPTS 4
+
+// engines belong to the thread that created them, hence a cache per thread
+boost::thread_specific_ptr<ScriptCache> scriptCache;
+
+/**
+ * Drops the least recently used scripts not in use until there is room for
+ * a new one, or all the remaining ones are in use
+ */
+void evictScripts(ScriptCache &cache) {
+	while (cache.scripts.size() >= MAX_CACHED_SCRIPTS) {
+		std::map<std::size_t, CachedScript>::iterator oldest =
+				cache.scripts.end();
+		for (std::map<std::size_t, CachedScript>::iterator it =
+				cache.scripts.begin(); it != cache.scripts.end(); ++it) {
+			if (!it->second.inUse && (oldest == cache.scripts.end() ||
+					it->second.lastUse < oldest->second.lastUse)) {
+				oldest = it;
+			}
+		}
+		if (oldest == cache.scripts.end()) {
+			return;
+		}
+		cache.scripts.erase(oldest);
+	}
+}
 
+/**
+ * Wraps the user provided script, which defines userScenario, so that its
+ * methods extend qScriptScenario
+ */
+QScriptProgram compileScript(std::string userCode) {
 	// add custom stuff to user provided script (no newlines so that
 	// errors will report proper line!)
 	std::stringstream ss;
@@ -61,8 +119,6 @@ QScriptScenario::QScriptScenario(boost::shared_ptr<RobogenConfig> config) :
 
 	ss << "var userScenario = ";
 
-	std::string userCode = config->getScenario();
-
 	const std::string from = "console.log";
 	const std::string to = "print";
 
@@ -82,8 +138,56 @@ QScriptScenario::QScriptScenario(boost::shared_ptr<RobogenConfig> config) :
 	// our instance of QScriptScenario
 	ss << "UserScenario.prototype = qScriptScenario;";
 	*/
-	// evaluate the script
-	QScriptProgram program(QString::fromStdString(ss.str()));
+	return QScriptProgram(QString::fromStdString(ss.str()));
+}
+
+}
+
+QScriptScenario::QScriptScenario(boost::shared_ptr<RobogenConfig> config) :
+	Scenario(config), scriptHash_(0), engineCached_(false), curTrial_(0),
+	afterSimulationStepInterval_(1), step_(0) {
+
+	const std::string &script = config->getScenario();
+	scriptHash_ = boost::hash<std::string>()(script);
+
+	if (scriptCache.get() == NULL) {
+		scriptCache.reset(new ScriptCache());
+	}
+	ScriptCache &cache = *scriptCache;
+
+	QScriptProgram program;
+	std::map<std::size_t, CachedScript>::iterator cached =
+			cache.scripts.find(scriptHash_);
+	if (cached != cache.scripts.end() && cached->second.script == script &&
+			!cached->second.inUse) {
+		engine_ = cached->second.engine;
+		program = cached->second.program;
+		cached->second.inUse = true;
+		cached->second.lastUse = ++cache.uses;
+		engineCached_ = true;
+	} else {
+		engine_.reset(new QScriptEngine);
+		program = compileScript(script);
+		// an engine in use by another scenario of this thread can't be shared
+		if (cached == cache.scripts.end() || !cached->second.inUse) {
+			if (cached == cache.scripts.end()) {
+				evictScripts(cache);
+			}
+			CachedScript &entry = cache.scripts[scriptHash_];
+			entry.script = script;
+			entry.program = program;
+			entry.engine = engine_;
+			entry.inUse = true;
+			entry.lastUse = ++cache.uses;
+			engineCached_ = true;
+		}
+	}
+
+	engine_->clearExceptions();
+	engine_->globalObject().setProperty("qScriptScenario",
+			engine_->newQObject(this));
+
+	// evaluate the script, which recreates the user's scenario
 	QScriptValue result = engine_->evaluate(program);
 
 	initSuccess_ = !result.isError();
@@ -119,45 +223,78 @@ QScriptScenario::QScriptScenario(boost::shared_ptr<RobogenConfig> config) :
 	}
 
 	// now check all (include getFitness, so user does not get confused
-	// 				  by its omission)
+	// 				  by its omission), keeping the functions to call them
 	std::string methods[] = {"setupSimulation", "afterSimulationStep",
 								"endSimulation", "getFitness" };
+	QScriptValue *functions[] = {&setupSimulation_, &afterSimulationStep_,
+								&endSimulation_, &getFitness_ };
 	size_t numMethods = 4;
 
 	for(size_t i = 0; i < numMethods; ++i) {
-		implementedMethods_[methods[i]] = isValidFunction(methods[i]);
-		if (implementedMethods_[methods[i]]) {
+		if (isValidFunction(methods[i])) {
+			*functions[i] = userScenario_.property(methods[i].c_str());
 			std::cout << "Using the provided " << methods[i] << " method"
 					<< std::endl;
 		}
 	}
 
+	QScriptValue interval = userScenario_.property(
+			"afterSimulationStepInterval");
+	if (interval.isNumber() && interval.toNumber() >= 1) {
+		afterSimulationStepInterval_ = interval.toUInt32();
+		std::cout << "Calling afterSimulationStep every "
+				<< afterSimulationStepInterval_ << " steps" << std::endl;
+	}
 
 }
 
 QScriptScenario::~QScriptScenario() {
+	engine_->globalObject().setProperty("qScriptScenario", QScriptValue());
+	if (!engineCached_ || scriptCache.get() == NULL) {
+		return;
+	}
+	std::map<std::size_t, CachedScript>::iterator cached =
+			scriptCache->scripts.find(scriptHash_);
+	if (cached != scriptCache->scripts.end() &&
+			cached->second.engine == engine_) {
+		cached->second.inUse = false;
+	}
+}
+
+bool QScriptScenario::call(QScriptValue &function, QScriptValue &result) {
+	result = function.call(userScenario_);
+	if(engine_->hasUncaughtException()) {
+		std::cerr << result.toString().toStdString() << std::endl;
+		return false;
+	}
+	return true;
 }
 
 bool QScriptScenario::setupSimulation() {
 	if(!initSuccess_)
 		return false;
 
-	// set up exposed stuff before user's setup
-	qRobot_ = engine_->newQObject(new qscript::QRobot(Scenario::getRobot()),
-			QScriptEngine::ScriptOwnership);
-	qEnvironment_ = engine_->newQObject(
-			new qscript::QEnvironment(Scenario::getEnvironment()),
-			QScriptEngine::ScriptOwnership);
-
-	if(implementedMethods_["setupSimulation"]) {
-		QScriptValue function = userScenario_.property("setupSimulation");
-		QScriptValue resultValue = function.call(userScenario_);
-		if(engine_->hasUncaughtException()) {
-			std::cerr << resultValue.toString().toStdString() << std::endl;
-			return false;
-		} else {
-			return resultValue.toBool();
-		}
+	step_ = 0;
+
+	// set up exposed stuff before user's setup, binding the wrappers of the
+	// previous trial to the new robot and environment
+	if (qRobot_.isValid()) {
+		qobject_cast<qscript::QRobot *>(qRobot_.toQObject())->setBasePtr(
+				Scenario::getRobot());
+		qobject_cast<qscript::QEnvironment *>(qEnvironment_.toQObject()
+				)->setBasePtr(Scenario::getEnvironment());
+	} else {
+		qRobot_ = engine_->newQObject(
+				new qscript::QRobot(Scenario::getRobot()),
+				QScriptEngine::ScriptOwnership);
+		qEnvironment_ = engine_->newQObject(
+				new qscript::QEnvironment(Scenario::getEnvironment()),
+				QScriptEngine::ScriptOwnership);
+	}
+
+	if(setupSimulation_.isValid()) {
+		QScriptValue resultValue;
+		return call(setupSimulation_, resultValue) && resultValue.toBool();
 	}
 
 
@@ -165,30 +302,20 @@ bool QScriptScenario::setupSimulation() {
 }
 
 bool QScriptScenario::afterSimulationStep() {
-	if(implementedMethods_["afterSimulationStep"]) {
-		QScriptValue function = userScenario_.property("afterSimulationStep");
-		QScriptValue resultValue = function.call(userScenario_);
-		if(engine_->hasUncaughtException()) {
-			std::cerr << resultValue.toString().toStdString() << std::endl;
-			return false;
-		} else {
-			return resultValue.toBool();
-		}
+	if(afterSimulationStep_.isValid() &&
+			++step_ % afterSimulationStepInterval_ == 0) {
+		QScriptValue resultValue;
+		return call(afterSimulationStep_, resultValue) &&
+				resultValue.toBool();
 	}
 	return true;
 }
 
 bool QScriptScenario::endSimulation() {
 	bool result = true;
-	if(implementedMethods_["endSimulation"]) {
-		QScriptValue function = userScenario_.property("endSimulation");
-		QScriptValue resultValue = function.call(userScenario_);
-		if(engine_->hasUncaughtException()) {
-			std::cerr << resultValue.toString().toStdString() << std::endl;
-			result = false;
-		} else {
-			result = resultValue.toBool();
-		}
+	if(endSimulation_.isValid()) {
+		QScriptValue resultValue;
+		result = call(endSimulation_, resultValue) && resultValue.toBool();
 	}
 
 	curTrial_++;
@@ -209,10 +336,8 @@ int QScriptScenario::getCurTrial() const {
 
 
 double QScriptScenario::getFitness() {
-	QScriptValue function = userScenario_.property("getFitness");
-	QScriptValue resultValue = function.call(userScenario_);
-	if(engine_->hasUncaughtException()) {
-		std::cerr << resultValue.toString().toStdString() << std::endl;
+	QScriptValue resultValue;
+	if(!call(getFitness_, resultValue)) {
 		return NAN;
 	} else {
 		return resultValue.toNumber();
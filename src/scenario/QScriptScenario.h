@@ -42,6 +42,16 @@ namespace robogen {
 
 
 
+/**
+ * Scenario written in JavaScript.
+ *
+ * The script is compiled once per thread and kept, with its engine, for the
+ * following scenarios running the same script: each of them re-evaluates the
+ * compiled program, which resets the user's scenario object.
+ *
+ * A script may set afterSimulationStepInterval to N to have its
+ * afterSimulationStep called every N steps only.
+ */
 class QScriptScenario :  public QObject, public Scenario {
 	Q_OBJECT
 
@@ -79,13 +89,29 @@ public slots:
 private:
 	bool isValidFunction(std::string name);
 
+	/**
+	 * Calls a method of the user's scenario
+	 * @return false if it threw
+	 */
+	bool call(QScriptValue &function, QScriptValue &result);
+
 
 	// keep shared ptr to QScriptEngine so it stays alive for life of scenario
 	boost::shared_ptr<QScriptEngine> engine_;
+	// hash of the script. If engine_ is cached, the destructor marks its
+	// entry of the per-thread script cache free for the next scenario; the
+	// least recently used free entries are evicted when the cache is full.
+	std::size_t scriptHash_;
+	bool engineCached_;
 	std::string id_;
 	unsigned int curTrial_;
 	QScriptValue userScenario_;
-	std::map<std::string, bool> implementedMethods_;
+
+	QScriptValue setupSimulation_, afterSimulationStep_, endSimulation_,
+		getFitness_;
+
+	unsigned int afterSimulationStepInterval_;
+	unsigned int step_;
 
 	QScriptValue qRobot_, qEnvironment_;
 
@@ -34,6 +34,7 @@
 #include "scenario/Terrain.h"
 #include "Robot.h"
 #include "Environment.h"
+#include "utils/RobogenUtils.h"
 
 namespace robogen {
 
@@ -53,7 +54,7 @@ bool Scenario::init(dWorldID odeWorld, dSpaceID odeSpace,
 	environment_ = boost::shared_ptr<Environment>(new
 			Environment(odeWorld, odeSpace, robogenConfig_));
 
-	if(!environment_->init()) {
+	if(!environment_->init(startPositionId_)) {
 		return false;
 	}
 
@@ -110,8 +111,14 @@ bool Scenario::init(dWorldID odeWorld, dSpaceID odeSpace,
 	double overlapMaxZ=minZ;
 
 	for (unsigned int i = 0; i < obstacleCoordinates.size(); ++i) {
+		// fixed obstacles go to the static space
+		dSpaceID obstacleSpace = odeSpace;
+		if (environment_->getStaticSpace() != 0 &&
+				d[i] < RobogenUtils::EPSILON_2) {
+			obstacleSpace = environment_->getStaticSpace();
+		}
 		boost::shared_ptr<BoxObstacle> obstacle(
-									new BoxObstacle(odeWorld, odeSpace,
+									new BoxObstacle(odeWorld, obstacleSpace,
 											obstacleCoordinates[i],
 											obstacleSizes[i], d[i], rotationAxis[i],
 											rotationAngles[i]));
@@ -32,6 +32,10 @@
 #include "scenario/ScenarioFactory.h"
 #include "scenario/RacingScenario.h"
 
+#ifndef EMSCRIPTEN
+#include "scenario/ScenarioPlugin.h"
+#endif
+
 #ifdef EMSCRIPTEN
 #include <emscripten/bind.h>
 #include <emscripten.h>
@@ -70,6 +74,10 @@ boost::shared_ptr<Scenario> ScenarioFactory::createScenario(boost::shared_ptr<Ro
 		return boost::shared_ptr<Scenario>(new RacingScenario(config));
 	} else if (config->getScenario() == "chasing") {
 		return boost::shared_ptr<Scenario>(new ChasingScenario(config));
+#ifndef EMSCRIPTEN
+	} else if (ScenarioPlugin::isPlugin(config->getScenario())) {
+		return ScenarioPlugin::createScenario(config->getScenario(), config);
+#endif
 	} else {
 		// we are getting scenario in js
 #ifdef EMSCRIPTEN
@@ -0,0 +1,144 @@
+/*
+ * @(#) ScenarioPlugin.cpp   1.0   Oct 19, 2026
+ *
+ * The ROBOGEN Framework
+ * Copyright © 2013-2016
+ *
+ * Laboratory of Intelligent Systems, EPFL
+ *
+ * This file is part of the ROBOGEN Framework.
+ *
+ * The ROBOGEN Framework is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License (GPL)
+ * as published by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @(#) $Id$
+ */
+#include <iostream>
+#include <map>
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/thread/mutex.hpp>
+#include "scenario/ScenarioPlugin.h"
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+namespace robogen {
+
+namespace {
+
+typedef unsigned int (*AbiVersionFunction)();
+typedef Scenario *(*CreateFunction)(const boost::shared_ptr<RobogenConfig> *);
+typedef void (*DestroyFunction)(Scenario *);
+
+struct Plugin {
+	CreateFunction create;
+	DestroyFunction destroy;
+};
+
+boost::mutex pluginsMutex;
+
+/**
+ * Loaded plugins by file name, NULL if loading failed
+ */
+std::map<std::string, Plugin *> plugins;
+
+void *findSymbol(void *library, const char *name) {
+#ifdef WIN32
+	return reinterpret_cast<void *>(GetProcAddress(
+			static_cast<HMODULE>(library), name));
+#else
+	return dlsym(library, name);
+#endif
+}
+
+Plugin *loadPlugin(const std::string& fileName) {
+#ifdef WIN32
+	void *library = LoadLibraryA(fileName.c_str());
+	if (library == NULL) {
+		std::cerr << "Cannot load scenario plugin '" << fileName << "'"
+				<< std::endl;
+		return NULL;
+	}
+#else
+	void *library = dlopen(fileName.c_str(), RTLD_NOW | RTLD_LOCAL);
+	if (library == NULL) {
+		std::cerr << "Cannot load scenario plugin '" << fileName << "': "
+				<< dlerror() << std::endl;
+		return NULL;
+	}
+#endif
+
+	AbiVersionFunction abiVersion = reinterpret_cast<AbiVersionFunction>(
+			findSymbol(library, "robogenScenarioPluginAbiVersion"));
+	CreateFunction create = reinterpret_cast<CreateFunction>(
+			findSymbol(library, "robogenCreateScenario"));
+	DestroyFunction destroy = reinterpret_cast<DestroyFunction>(
+			findSymbol(library, "robogenDestroyScenario"));
+	if (abiVersion == NULL || create == NULL || destroy == NULL) {
+		std::cerr << "'" << fileName << "' is not a scenario plugin, "
+				<< "it should use ROBOGEN_SCENARIO_PLUGIN" << std::endl;
+		return NULL;
+	}
+	if (abiVersion() != ROBOGEN_SCENARIO_PLUGIN_ABI_VERSION) {
+		std::cerr << "Scenario plugin '" << fileName << "' was built for "
+				<< "version " << abiVersion() << " of the plugin interface, "
+				<< "this is version " << ROBOGEN_SCENARIO_PLUGIN_ABI_VERSION
+				<< ". Rebuild it." << std::endl;
+		return NULL;
+	}
+
+	Plugin *plugin = new Plugin();
+	plugin->create = create;
+	plugin->destroy = destroy;
+	return plugin;
+}
+
+}
+
+bool ScenarioPlugin::isPlugin(const std::string& scenario) {
+	return boost::algorithm::iends_with(scenario, ".so") ||
+			boost::algorithm::iends_with(scenario, ".dylib") ||
+			boost::algorithm::iends_with(scenario, ".dll");
+}
+
+boost::shared_ptr<Scenario> ScenarioPlugin::createScenario(
+		const std::string& fileName,
+		boost::shared_ptr<RobogenConfig> config) {
+
+	Plugin *plugin;
+	{
+		boost::mutex::scoped_lock lock(pluginsMutex);
+		std::map<std::string, Plugin *>::iterator it = plugins.find(fileName);
+		if (it != plugins.end()) {
+			plugin = it->second;
+		} else {
+			plugin = loadPlugin(fileName);
+			plugins[fileName] = plugin;
+		}
+	}
+	if (plugin == NULL) {
+		return boost::shared_ptr<Scenario>();
+	}
+
+	Scenario *scenario = plugin->create(&config);
+	if (scenario == NULL) {
+		return boost::shared_ptr<Scenario>();
+	}
+	// deleted by the plugin, which allocated it
+	return boost::shared_ptr<Scenario>(scenario, plugin->destroy);
+}
+
+}
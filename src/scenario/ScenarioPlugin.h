@@ -0,0 +1,112 @@
+/*
+ * @(#) ScenarioPlugin.h   1.0   Oct 19, 2026
+ *
+ * The ROBOGEN Framework
+ * Copyright © 2013-2016
+ *
+ * Laboratory of Intelligent Systems, EPFL
+ *
+ * This file is part of the ROBOGEN Framework.
+ *
+ * The ROBOGEN Framework is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License (GPL)
+ * as published by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @(#) $Id$
+ */
+#ifndef ROBOGEN_SCENARIO_PLUGIN_H_
+#define ROBOGEN_SCENARIO_PLUGIN_H_
+
+#include <string>
+#include <boost/shared_ptr.hpp>
+#include "scenario/Scenario.h"
+
+/**
+ * Version of the interface between Robogen and scenario plugins. To be
+ * increased whenever Scenario, or anything a plugin may use, changes in a
+ * way that breaks compiled plugins.
+ */
+#define ROBOGEN_SCENARIO_PLUGIN_ABI_VERSION 1
+
+#ifdef WIN32
+#define ROBOGEN_SCENARIO_PLUGIN_EXPORT __declspec(dllexport)
+#else
+#define ROBOGEN_SCENARIO_PLUGIN_EXPORT __attribute__((visibility("default")))
+#endif
+
+/**
+ * Exports a Scenario subclass from a shared library. The class must have a
+ * constructor taking the boost::shared_ptr<RobogenConfig>, like
+ * RacingScenario. Used once in the plugin, for example:
+ *
+ *   ROBOGEN_SCENARIO_PLUGIN(MyScenario)
+ */
+#define ROBOGEN_SCENARIO_PLUGIN(ScenarioClass) \
+	extern "C" ROBOGEN_SCENARIO_PLUGIN_EXPORT \
+	unsigned int robogenScenarioPluginAbiVersion() { \
+		return ROBOGEN_SCENARIO_PLUGIN_ABI_VERSION; \
+	} \
+	extern "C" ROBOGEN_SCENARIO_PLUGIN_EXPORT \
+	robogen::Scenario *robogenCreateScenario( \
+			const boost::shared_ptr<robogen::RobogenConfig> *config) { \
+		return new ScenarioClass(*config); \
+	} \
+	extern "C" ROBOGEN_SCENARIO_PLUGIN_EXPORT \
+	void robogenDestroyScenario(robogen::Scenario *scenario) { \
+		delete scenario; \
+	}
+
+namespace robogen {
+
+/**
+ * Loads compiled scenarios from shared libraries (.so, .dylib or .dll)
+ * exporting them with ROBOGEN_SCENARIO_PLUGIN.
+ *
+ * A plugin is compiled against the Robogen headers and resolves the Robogen
+ * symbols it uses (Scenario, Robot, Environment, ...) in the executable that
+ * loads it. Libraries are loaded once and stay loaded.
+ */
+class ScenarioPlugin {
+
+public:
+
+	/**
+	 * @return true if the scenario names a shared library
+	 */
+	static bool isPlugin(const std::string& scenario);
+
+	/**
+	 * Creates the scenario of a plugin, loading the library if needed.
+	 * Safe to call from several threads.
+	 *
+	 * @param fileName the shared library
+	 * @param config
+	 * @return the scenario, or an empty pointer if the library can't be
+	 * loaded, doesn't export a scenario or was built for another
+	 * ROBOGEN_SCENARIO_PLUGIN_ABI_VERSION
+	 */
+	static boost::shared_ptr<Scenario> createScenario(
+			const std::string& fileName,
+			boost::shared_ptr<RobogenConfig> config);
+
+private:
+
+	/**
+	 * Disable instantiation
+	 */
+	ScenarioPlugin();
+
+};
+
+}
+
+#endif /* ROBOGEN_SCENARIO_PLUGIN_H_ */
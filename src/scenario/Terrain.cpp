@@ -25,19 +25,20 @@
  *
  * @(#) $Id$
  */
-#ifndef DISABLE_HEIGHT_MAP
-#include <osgDB/ReadFile>
-#endif
 #include <osg/Image>
+#include "scenario/HeightMap.h"
 #include "scenario/Terrain.h"
 
+// thickness of the heightfield below its lowest point
+#define HEIGHTFIELD_THICKNESS 1.0
+
 
 
 namespace robogen {
 
 Terrain::Terrain(dWorldID odeWorld, dSpaceID odeSpace) :
 		odeWorld_(odeWorld), odeSpace_(odeSpace), type_(TerrainConfig::EMPTY),
-		heightField_(NULL), odeGeometry_(NULL) {
+		heightField_(NULL), triMeshData_(NULL), odeGeometry_(NULL) {
 
 }
 
@@ -45,6 +46,9 @@ Terrain::~Terrain() {
 	if (this->heightField_ != NULL) {
 		dGeomHeightfieldDataDestroy(this->heightField_);
 	}
+	if (this->triMeshData_ != NULL) {
+		dGeomTriMeshDataDestroy(this->triMeshData_);
+	}
 }
 
 TerrainConfig::TerrainType Terrain::getType() {
@@ -55,6 +59,7 @@ bool Terrain::initFlat(float width, float depth) {
 
 	if (this->heightField_ != NULL) {
 		dGeomHeightfieldDataDestroy(this->heightField_);
+		this->heightField_ = NULL;
 	}
 
 	dCreatePlane(odeSpace_, 0.0, 0.0, 1.0, 0.0);
@@ -69,60 +74,64 @@ bool Terrain::initFlat(float width, float depth) {
 
 #ifndef DISABLE_HEIGHT_MAP
 bool Terrain::initRough(const std::string& heightMapFileName, float width,
-		float depth, float height) {
+		float depth, float height, bool trimesh) {
+
+	return initHeightMap(HeightMap::get(heightMapFileName, width, depth,
+			height, trimesh), width, depth, height, trimesh);
+
+}
+
+bool Terrain::initGenerated(TerrainConfig::TerrainGenerator generator,
+		unsigned int seed, unsigned int resolution, float featureSize,
+		float width, float depth, float height, bool trimesh) {
+
+	return initHeightMap(HeightMap::generate(generator, seed, resolution,
+			featureSize, width, depth, height, trimesh), width, depth, height,
+			trimesh);
+
+}
 
-	osg::ref_ptr<osg::Image> image = osgDB::readImageFile(heightMapFileName);
-	if (image == NULL) {
-		std::cout << "Cannot load the height map file '" << heightMapFileName
-				<< "' for the terrain. Quit." << std::endl;
+bool Terrain::initHeightMap(boost::shared_ptr<const HeightMap> heightMap,
+		float width, float depth, float height, bool trimesh) {
+
+	heightMap_ = heightMap;
+	if (!heightMap_) {
 		return false;
 	}
 
 	type_ = TerrainConfig::ROUGH;
 
-	// Try with trimesh!!
-	heightFieldData_ = image;
-
 	heightFieldWidth_ = width;
 	heightFieldDepth_ = depth;
 	heightFieldHeight_ = height;
 
-	int xCount = image->s();
-	int yCount = image->t();
-
-	float startX = -width / 2;
-	float startY = -depth / 2;
-
-	float spacingX = width / (xCount - 1);
-	float spacingY = depth / (yCount - 1);
-
-	double *mapData = new double[xCount * yCount * 3];
-	for (int x = 0; x < xCount; ++x) {
-		for (int y = 0; y < yCount; ++y) {
-
-			int j = x + xCount * y;
+	int xCount = heightMap_->getXCount();
+	int yCount = heightMap_->getYCount();
 
-			mapData[3 * j] = startX + spacingX * x;
-			mapData[3 * j + 1] = startY + spacingY * y;
-			mapData[3 * j + 2] = (*image->data(x, y) / 255.0) * height;
+	if (trimesh) {
+		// ODE only reads the vertices and indices of the shared height map
+		triMeshData_ = dGeomTriMeshDataCreate();
+		dGeomTriMeshDataBuildDouble(triMeshData_,
+				&heightMap_->getVertices()[0], 3 * sizeof(double),
+				xCount * yCount, &heightMap_->getIndices()[0],
+				heightMap_->getIndices().size(), 3 * sizeof(dTriIndex));
 
-		}
+		odeGeometry_ = dCreateTriMesh(odeSpace_, triMeshData_, 0, 0, 0);
+		return true;
 	}
 
-	dTriIndex *indices = new dTriIndex[xCount * yCount * 3];
-	int index = 0;
-	for (int c = 0; c < xCount * yCount; ++c) {
-		indices[index++] = c;
-		indices[index++] = c + xCount;
-		indices[index++] = c + 1;
-	}
+	// The samples aren't copied, they belong to the shared height map
+	heightField_ = dGeomHeightfieldDataCreate();
+	dGeomHeightfieldDataBuildByte(heightField_,
+			&heightMap_->getSamples()[0], 0, width, depth, xCount, yCount,
+			height / 255.0, 0, HEIGHTFIELD_THICKNESS, 0);
 
-	dTriMeshDataID trimesh = dGeomTriMeshDataCreate();
-	dGeomTriMeshDataBuildDouble(trimesh, &mapData[0], 3 * sizeof(double),
-			xCount * yCount, &indices[0], xCount * yCount * 3,
-			3 * sizeof(dTriIndex));
+	odeGeometry_ = dCreateHeightfield(odeSpace_, heightField_, 1);
 
-	odeGeometry_ = dCreateTriMesh(odeSpace_, trimesh, 0, 0, 0);
+	// ODE heightfields are along y, turn it to z
+	dMatrix3 rotation;
+	dRFromAxisAndAngle(rotation, 1, 0, 0, M_PI / 2);
+	dGeomSetRotation(odeGeometry_, rotation);
 
 	return true;
 
@@ -130,7 +139,12 @@ bool Terrain::initRough(const std::string& heightMapFileName, float width,
 #endif
 
 osg::ref_ptr<osg::Image> Terrain::getHeightFieldData() {
-	return heightFieldData_;
+#ifndef DISABLE_HEIGHT_MAP
+	if (heightMap_) {
+		return heightMap_->getImage();
+	}
+#endif
+	return osg::ref_ptr<osg::Image>();
 }
 
 float Terrain::getWidth() const {
@@ -30,6 +30,7 @@
 
 #include <osg/ref_ptr>
 #include <string>
+#include <boost/shared_ptr.hpp>
 #include "Robogen.h"
 #include "config/TerrainConfig.h"
 
@@ -39,6 +40,8 @@ class Image;
 
 namespace robogen {
 
+class HeightMap;
+
 /**
  * Terrain model. The terrain can be either a flat surface or defined by an height map
  * that is tiled infinitely or totally empty.
@@ -71,16 +74,36 @@ public:
 
 #ifndef DISABLE_HEIGHT_MAP
 	/**
-	 * Initializes a rough terrain
+	 * Initializes a rough terrain, an ODE heightfield or a trimesh. The
+	 * height map is loaded once, then shared with the other terrains.
 	 *
 	 * @param heightMapFileName the height map file defining terrain elevation contains a nxm matrix of byte values (0-255).
 	 *                          0 Corresponds to the lower elevation, 1 to the maximum elevation
 	 * @param width
 	 * @param depth
 	 * @param height
+	 * @param trimesh collide with a trimesh rather than a heightfield
 	 */
 	bool initRough(const std::string& heightMapFileName, float width,
-			float depth, float height);
+			float depth, float height, bool trimesh = false);
+
+	/**
+	 * Initializes a rough terrain generated in memory, an ODE heightfield or
+	 * a trimesh. The height map is generated once, then shared with the other
+	 * terrains.
+	 *
+	 * @param generator
+	 * @param seed
+	 * @param resolution number of height samples along each side
+	 * @param featureSize noise wavelength, step length or rock diameter
+	 * @param width
+	 * @param depth
+	 * @param height
+	 * @param trimesh collide with a trimesh rather than a heightfield
+	 */
+	bool initGenerated(TerrainConfig::TerrainGenerator generator,
+			unsigned int seed, unsigned int resolution, float featureSize,
+			float width, float depth, float height, bool trimesh = false);
 #endif
 
 	/**
@@ -111,6 +134,14 @@ public:
 
 private:
 
+#ifndef DISABLE_HEIGHT_MAP
+	/**
+	 * Creates the geometry of a rough terrain
+	 */
+	bool initHeightMap(boost::shared_ptr<const HeightMap> heightMap,
+			float width, float depth, float height, bool trimesh);
+#endif
+
 	/**
 	 * ODE World
 	 */
@@ -132,9 +163,14 @@ private:
 	dHeightfieldDataID heightField_;
 
 	/**
-	 * Height field data
+	 * The trimesh, if the rough terrain isn't an heightfield
+	 */
+	dTriMeshDataID triMeshData_;
+
+	/**
+	 * Height field data, shared with the other terrains
 	 */
-	osg::ref_ptr<osg::Image> heightFieldData_;
+	boost::shared_ptr<const HeightMap> heightMap_;
 
 	/**
 	 * Height field depth, width and height
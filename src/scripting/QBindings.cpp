@@ -36,11 +36,44 @@
 namespace robogen {
 namespace qscript {
 
+namespace {
+
+/**
+ * Binds the wrappers of an array already handed out to the script to the
+ * objects of the new trial, or drops the array if they don't match
+ */
+template<typename Wrapper, typename Base>
+void rebind(QScriptValue &array,
+		const std::vector<boost::shared_ptr<Base> > &objects) {
+	if (!array.isValid()) {
+		return;
+	}
+	if (array.property("length").toUInt32() != objects.size()) {
+		array = QScriptValue();
+		return;
+	}
+	for (size_t i = 0; i < objects.size(); ++i) {
+		Wrapper *wrapper = qobject_cast<Wrapper *>(
+				array.property(i).toQObject());
+		if (wrapper == NULL) {
+			array = QScriptValue();
+			return;
+		}
+		wrapper->setBasePtr(objects[i]);
+	}
+}
+
+}
 
 // QMotor
 
 QMotor::QMotor(boost::weak_ptr<Motor> basePtr) : basePtr_(basePtr) { }
 
+void QMotor::setBasePtr(boost::weak_ptr<Motor> basePtr) {
+	basePtr_ = basePtr;
+	id_ = QScriptValue();
+}
+
 QScriptValue QMotor::getId() {
 	if(!id_.isValid()) {
 		id_ = engine()->newObject();
@@ -65,6 +98,10 @@ QScriptValue QMotor::getTorque() {
 
 QSensor::QSensor(boost::weak_ptr<Sensor> basePtr) : basePtr_(basePtr) {}
 
+void QSensor::setBasePtr(boost::weak_ptr<Sensor> basePtr) {
+	basePtr_ = basePtr;
+}
+
 QScriptValue QSensor::getLabel() {
 	return QString::fromStdString(basePtr_.lock()->getLabel());
 }
@@ -83,6 +120,17 @@ QModel::QModel(boost::weak_ptr<Model> basePtr) : basePtr_(basePtr) {
 
 }
 
+void QModel::setBasePtr(boost::weak_ptr<Model> basePtr) {
+	basePtr_ = basePtr;
+	std::vector<boost::shared_ptr<Sensor> > sensors;
+	boost::shared_ptr<PerceptiveComponent> perceptive =
+			boost::dynamic_pointer_cast<PerceptiveComponent>(basePtr.lock());
+	if (perceptive) {
+		perceptive->getSensors(sensors);
+	}
+	rebind<QSensor>(sensors_, sensors);
+}
+
 QScriptValue QModel::getId() {
 	return QString::fromStdString(basePtr_.lock()->getId());
 }
@@ -126,6 +174,18 @@ QRobot::QRobot(boost::weak_ptr<Robot> basePtr) : basePtr_(basePtr) {
 
 }
 
+void QRobot::setBasePtr(boost::weak_ptr<Robot> basePtr) {
+	basePtr_ = basePtr;
+	boost::shared_ptr<Robot> robot = basePtr.lock();
+	if (coreComponent_.isValid()) {
+		qobject_cast<QModel *>(coreComponent_.toQObject())->setBasePtr(
+				robot->getCoreComponent());
+	}
+	rebind<QModel>(bodyParts_, robot->getBodyParts());
+	rebind<QMotor>(motors_, robot->getMotors());
+	rebind<QSensor>(sensors_, robot->getSensors());
+}
+
 QScriptValue QRobot::getCoreComponent() {
 	 if(!coreComponent_.isValid()) {
 		 coreComponent_ = engine()->newQObject(
@@ -136,9 +196,9 @@ QScriptValue QRobot::getCoreComponent() {
 }
 
 QScriptValue QRobot::getBodyParts() {
-	std::vector<boost::shared_ptr<Model> > bodyParts = basePtr_.lock()->getBodyParts();
-
 	if (!bodyParts_.isValid()) {
+		const std::vector<boost::shared_ptr<Model> >& bodyParts =
+				basePtr_.lock()->getBodyParts();
 		bodyParts_ = engine()->newArray(bodyParts.size());
 		for(size_t i = 0; i<bodyParts.size(); ++i) {
 			bodyParts_.setProperty(i,  engine()->newQObject(
@@ -150,9 +210,9 @@ QScriptValue QRobot::getBodyParts() {
 }
 
 QScriptValue QRobot::getMotors() {
-	std::vector<boost::shared_ptr<Motor> > motors = basePtr_.lock()->getMotors();
-
 	if (!motors_.isValid()) {
+		const std::vector<boost::shared_ptr<Motor> >& motors =
+				basePtr_.lock()->getMotors();
 		motors_ = engine()->newArray(motors.size());
 		for(size_t i = 0; i<motors.size(); ++i) {
 			QMotor* motor = new QMotor(motors[i]);
@@ -164,9 +224,9 @@ QScriptValue QRobot::getMotors() {
 }
 
 QScriptValue QRobot::getSensors() {
-	std::vector<boost::shared_ptr<Sensor> > sensors = basePtr_.lock()->getSensors();
-
 	if (!sensors_.isValid()) {
+		const std::vector<boost::shared_ptr<Sensor> >& sensors =
+				basePtr_.lock()->getSensors();
 		sensors_ = engine()->newArray(sensors.size());
 		for(size_t i = 0; i<sensors.size(); ++i) {
 			sensors_.setProperty(i,  engine()->newQObject(
@@ -195,10 +255,57 @@ QScriptValue QRobot::getAABB() {
 	return aabb;
 }
 
+QScriptValue QRobot::getBodyPositions() {
+	const std::vector<boost::shared_ptr<Model> >& bodyParts =
+			basePtr_.lock()->getBodyParts();
+	QScriptValue positions = engine()->newArray(bodyParts.size());
+	for (size_t i = 0; i < bodyParts.size(); ++i) {
+		positions.setProperty(i, valFromVec3(engine(),
+				bodyParts[i]->getRootPosition()));
+	}
+	return positions;
+}
+
+QScriptValue QRobot::getBodyAttitudes() {
+	const std::vector<boost::shared_ptr<Model> >& bodyParts =
+			basePtr_.lock()->getBodyParts();
+	QScriptValue attitudes = engine()->newArray(bodyParts.size());
+	for (size_t i = 0; i < bodyParts.size(); ++i) {
+		attitudes.setProperty(i, valFromQuat(engine(),
+				bodyParts[i]->getRootAttitude()));
+	}
+	return attitudes;
+}
+
+QScriptValue QRobot::getMotorPositions() {
+	const std::vector<boost::shared_ptr<Motor> >& motors =
+			basePtr_.lock()->getMotors();
+	QScriptValue positions = engine()->newArray(motors.size());
+	for (size_t i = 0; i < motors.size(); ++i) {
+		positions.setProperty(i, motors[i]->getPosition());
+	}
+	return positions;
+}
+
+QScriptValue QRobot::getSensorValues() {
+	const std::vector<boost::shared_ptr<Sensor> >& sensors =
+			basePtr_.lock()->getSensors();
+	QScriptValue values = engine()->newArray(sensors.size());
+	for (size_t i = 0; i < sensors.size(); ++i) {
+		values.setProperty(i, sensors[i]->read());
+	}
+	return values;
+}
+
 // QPositionObservable
 QPositionObservable::QPositionObservable(
 		boost::weak_ptr<PositionObservable> basePtr) : basePtr_(basePtr) {}
 
+void QPositionObservable::setBasePtr(
+		boost::weak_ptr<PositionObservable> basePtr) {
+	basePtr_ = basePtr;
+}
+
 
 QScriptValue QPositionObservable::getPosition() {
 	return valFromVec3(engine(), basePtr_.lock()->getPosition());
@@ -236,11 +343,38 @@ QScriptValue QBoxObstacle::getSize() {
 QEnvironment::QEnvironment(boost::weak_ptr<Environment> basePtr) :
 		basePtr_(basePtr) {}
 
-QScriptValue QEnvironment:: getLightSources() {
-	std::vector<boost::shared_ptr<LightSource> > lightSources =
-			basePtr_.lock()->getLightSources();
+void QEnvironment::setBasePtr(boost::weak_ptr<Environment> basePtr) {
+	basePtr_ = basePtr;
+	boost::shared_ptr<Environment> environment = basePtr.lock();
+	rebind<QLightSource>(lightSources_, environment->getLightSources());
 
+	if (!obstacles_.isValid()) {
+		return;
+	}
+	std::vector<boost::shared_ptr<Obstacle> > obstacles =
+			environment->getObstacles();
+	if (obstacles_.property("length").toUInt32() != obstacles.size()) {
+		obstacles_ = QScriptValue();
+		return;
+	}
+	for (size_t i = 0; i < obstacles.size(); ++i) {
+		QObstacle *obstacle = qobject_cast<QObstacle *>(
+				obstacles_.property(i).toQObject());
+		bool box = boost::dynamic_pointer_cast<BoxObstacle>(
+				obstacles[i]).get() != NULL;
+		if (obstacle == NULL ||
+				(qobject_cast<QBoxObstacle *>(obstacle) != NULL) != box) {
+			obstacles_ = QScriptValue();
+			return;
+		}
+		obstacle->setBasePtr(obstacles[i]);
+	}
+}
+
+QScriptValue QEnvironment:: getLightSources() {
 	if (!lightSources_.isValid()) {
+		const std::vector<boost::shared_ptr<LightSource> >& lightSources =
+				basePtr_.lock()->getLightSources();
 		lightSources_ = engine()->newArray(lightSources.size());
 		for(size_t i = 0; i<lightSources.size(); ++i) {
 			lightSources_.setProperty(i,  engine()->newQObject(
@@ -256,10 +390,9 @@ QScriptValue QEnvironment:: getAmbientLight() {
 }
 
 QScriptValue QEnvironment:: getObstacles() {
-	std::vector<boost::shared_ptr<Obstacle> > obstacles =
-			basePtr_.lock()->getObstacles();
-
 	if (!obstacles_.isValid()) {
+		std::vector<boost::shared_ptr<Obstacle> > obstacles =
+				basePtr_.lock()->getObstacles();
 		obstacles_ = engine()->newArray(obstacles.size());
 		for(size_t i = 0; i<obstacles.size(); ++i) {
 			boost::shared_ptr<BoxObstacle> box =
@@ -277,6 +410,28 @@ QScriptValue QEnvironment:: getObstacles() {
 	return obstacles_;
 }
 
+QScriptValue QEnvironment::getLightSourcePositions() {
+	const std::vector<boost::shared_ptr<LightSource> >& lightSources =
+			basePtr_.lock()->getLightSources();
+	QScriptValue positions = engine()->newArray(lightSources.size());
+	for (size_t i = 0; i < lightSources.size(); ++i) {
+		positions.setProperty(i, valFromVec3(engine(),
+				lightSources[i]->getPosition()));
+	}
+	return positions;
+}
+
+QScriptValue QEnvironment::getObstaclePositions() {
+	std::vector<boost::shared_ptr<Obstacle> > obstacles =
+			basePtr_.lock()->getObstacles();
+	QScriptValue positions = engine()->newArray(obstacles.size());
+	for (size_t i = 0; i < obstacles.size(); ++i) {
+		positions.setProperty(i, valFromVec3(engine(),
+				obstacles[i]->getPosition()));
+	}
+	return positions;
+}
+
 
 
 
@@ -44,6 +44,10 @@
 // note we keep weak pointers here, so that they don't keep objects alive
 // after the scenario has been pruned
 
+// the wrappers are kept from one trial to the next: setBasePtr binds them
+// (and the wrappers they have already handed out) to the objects of the new
+// trial, instead of allocating new ones
+
 
 namespace robogen {
 namespace qscript {
@@ -53,6 +57,7 @@ class QMotor : public QObject, public QScriptable {
 	Q_OBJECT
 public:
 	QMotor(boost::weak_ptr<Motor> basePtr);
+	void setBasePtr(boost::weak_ptr<Motor> basePtr);
 
 public slots:
 	QScriptValue getId();
@@ -69,6 +74,7 @@ class QSensor : public QObject, public QScriptable {
 	Q_OBJECT
 public:
 	QSensor(boost::weak_ptr<Sensor> basePtr);
+	void setBasePtr(boost::weak_ptr<Sensor> basePtr);
 public slots:
 	QScriptValue getLabel();
 	QScriptValue getType();
@@ -82,6 +88,7 @@ class QModel : public QObject, public QScriptable {
 	Q_OBJECT
 public:
 	QModel(boost::weak_ptr<Model> basePtr);
+	void setBasePtr(boost::weak_ptr<Model> basePtr);
 
 public slots:
 	QScriptValue getRootPosition();
@@ -99,6 +106,7 @@ class QRobot :  public QObject, public QScriptable {
 	Q_OBJECT
 public:
 	QRobot(boost::weak_ptr<Robot> basePtr);
+	void setBasePtr(boost::weak_ptr<Robot> basePtr);
 
 public slots:
 	//QScriptValue getPosition();
@@ -108,6 +116,13 @@ public slots:
 	QScriptValue getSensors();
 	QScriptValue getAABB();
 
+	// bulk accessors, in the order of getBodyParts, getMotors and getSensors,
+	// which save a call through each wrapper
+	QScriptValue getBodyPositions();
+	QScriptValue getBodyAttitudes();
+	QScriptValue getMotorPositions();
+	QScriptValue getSensorValues();
+
 
 private :
 	boost::weak_ptr<Robot> basePtr_;
@@ -122,6 +137,7 @@ class QPositionObservable :  public QObject, public QScriptable {
 	Q_OBJECT
 public:
 	QPositionObservable(boost::weak_ptr<PositionObservable> basePtr);
+	void setBasePtr(boost::weak_ptr<PositionObservable> basePtr);
 public slots:
 	virtual QScriptValue getPosition();
 	virtual QScriptValue getAttitude();
@@ -160,10 +176,15 @@ class QEnvironment : public QObject, public QScriptable {
 	Q_OBJECT
 public:
 	QEnvironment(boost::weak_ptr<Environment> basePtr);
+	void setBasePtr(boost::weak_ptr<Environment> basePtr);
 public slots:
 	QScriptValue getLightSources();
 	QScriptValue getAmbientLight();
 	QScriptValue getObstacles();
+
+	// bulk accessors, in the order of getLightSources and getObstacles
+	QScriptValue getLightSourcePositions();
+	QScriptValue getObstaclePositions();
 private:
 	boost::weak_ptr<Environment> basePtr_;
 	QScriptValue lightSources_;
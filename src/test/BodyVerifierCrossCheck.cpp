@@ -0,0 +1,179 @@
+/*
+ * BodyVerifierCrossCheck.cpp
+ *
+ * Grows random bodies part by part, as Mutator::growBodyRandomly does, and
+ * verifies each of them with the ODE verifier and with the geometric one,
+ * both on the whole body and incrementally from the layout of the body it
+ * was grown from. Fails if a geometric verdict or error code differs from
+ * the ODE one.
+ *
+ * Usage: BodyVerifierCrossCheck [SEED]
+ */
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <iterator>
+#include <cstdlib>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_int_distribution.hpp>
+#include <boost/random/uniform_01.hpp>
+#include "PartList.h"
+#include "evolution/engine/BodyLayout.h"
+#include "evolution/engine/BodyVerifier.h"
+#include "evolution/representation/RobotRepresentation.h"
+
+using namespace robogen;
+
+namespace {
+
+const unsigned int NUM_BODIES = 200;
+const unsigned int MAX_PARTS = 25;
+const unsigned int MAX_ATTEMPTS = 10;
+
+typedef std::vector<std::pair<std::string, std::string> > PartPairs;
+
+/**
+ * Inserts a random part at a random slot, as Mutator::insertNode
+ */
+bool insertRandomPart(RobotRepresentation &robot,
+		const std::vector<char> &types, boost::random::mt19937 &rng) {
+
+	const RobotRepresentation::IdPartMap &body = robot.getBody();
+	boost::random::uniform_int_distribution<> partDist(0, body.size() - 1);
+	RobotRepresentation::IdPartMap::const_iterator parent;
+	boost::shared_ptr<PartRepresentation> parentPart;
+	do {
+		parent = body.begin();
+		std::advance(parent, partDist(rng));
+		parentPart = parent->second.lock();
+	} while (parentPart->getArity() == 0);
+
+	boost::random::uniform_int_distribution<> slotDist(0,
+			parentPart->getArity() - 1);
+	unsigned int parentSlot = slotDist(rng);
+
+	boost::random::uniform_int_distribution<> typeDist(0, types.size() - 1);
+	char type = types[typeDist(rng)];
+
+	boost::random::uniform_int_distribution<> orientationDist(0, 3);
+	unsigned int orientation = orientationDist(rng);
+
+	std::vector<double> parameters;
+	boost::random::uniform_01<double> paramDist;
+	unsigned int nParams = PART_TYPE_PARAM_COUNT_MAP.at(PART_TYPE_MAP.at(type));
+	for (unsigned int i = 0; i < nParams; ++i) {
+		parameters.push_back(paramDist(rng));
+	}
+
+	boost::shared_ptr<PartRepresentation> newPart = PartRepresentation::create(
+			type, "", orientation, parameters);
+	unsigned int newPartSlot = 0;
+	if (newPart->getArity() > 0) {
+		boost::random::uniform_int_distribution<> newSlotDist(0,
+				newPart->getArity() - 1);
+		newPartSlot = newSlotDist(rng);
+	}
+
+	return robot.insertPart(parent->first, parentSlot, newPart, newPartSlot,
+			NeuronRepresentation::SIGMOID, false);
+}
+
+/**
+ * @return true if the geometric verdict and error code are the ODE ones
+ */
+bool agree(const std::string &name, bool odeResult, int odeErrorCode,
+		bool geometricResult, int geometricErrorCode) {
+	if (geometricResult != odeResult ||
+			(!odeResult && geometricErrorCode != odeErrorCode)) {
+		std::cerr << name << ": ODE says "
+				<< (odeResult ? "valid" : "invalid") << " (" << odeErrorCode
+				<< "), geometric says "
+				<< (geometricResult ? "valid" : "invalid") << " ("
+				<< geometricErrorCode << ")" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+}
+
+int main(int argc, char *argv[]) {
+
+	unsigned int seed = (argc > 1) ? std::atoi(argv[1]) : 1;
+	boost::random::mt19937 rng(seed);
+
+	std::vector<char> types;
+	for (std::map<char, std::string>::const_iterator it =
+			PART_TYPE_MAP.begin(); it != PART_TYPE_MAP.end(); ++it) {
+		if (!isCore(it->second)) {
+			types.push_back(it->first);
+		}
+	}
+
+	unsigned int numChecked = 0, numInvalid = 0, numLaidOut = 0;
+	unsigned int numMismatches = 0;
+	for (unsigned int i = 0; i < NUM_BODIES; ++i) {
+		RobotRepresentation robot;
+		robot.init();
+		BodyLayout reference;
+		reference.init(robot);
+
+		for (unsigned int j = 0; j < MAX_PARTS * MAX_ATTEMPTS; ++j) {
+			if (robot.getBody().size() >= MAX_PARTS) {
+				break;
+			}
+			RobotRepresentation grown(robot);
+			if (!insertRandomPart(grown, types, rng)) {
+				continue;
+			}
+
+			int odeErrorCode = -1, geometricErrorCode = -1,
+					incrementalErrorCode = -1;
+			PartPairs odeParts, geometricParts, incrementalParts;
+			BodyLayout layout;
+			bool odeResult = BodyVerifier::verify(grown, odeErrorCode,
+					odeParts, false, BodyVerifier::ODE_VERIFICATION);
+			bool geometricResult = BodyVerifier::verify(grown,
+					geometricErrorCode, geometricParts, false,
+					BodyVerifier::GEOMETRIC_VERIFICATION, NULL, &layout);
+			bool incrementalResult = BodyVerifier::verify(grown,
+					incrementalErrorCode, incrementalParts, false,
+					BodyVerifier::GEOMETRIC_VERIFICATION, &reference);
+
+			numChecked++;
+			if (!odeResult) {
+				numInvalid++;
+			}
+			if (!layout.getPlacements().empty()) {
+				numLaidOut++;
+			}
+
+			bool same = agree("whole body", odeResult, odeErrorCode,
+					geometricResult, geometricErrorCode);
+			same = agree("incremental", odeResult, odeErrorCode,
+					incrementalResult, incrementalErrorCode) && same;
+			if (!same) {
+				std::cerr << "Body " << i << " with seed " << seed << ":"
+						<< std::endl << grown.toString() << std::endl;
+				numMismatches++;
+			}
+
+			// keep growing from valid bodies only, as the mutator does
+			if (odeResult) {
+				robot = grown;
+				reference = layout;
+			}
+		}
+	}
+
+	if (numMismatches) {
+		std::cerr << numMismatches << " of " << numChecked
+				<< " bodies verified differently" << std::endl;
+		return EXIT_FAILURE;
+	}
+	std::cout << "All " << numChecked << " bodies (" << numInvalid
+			<< " invalid, " << numLaidOut << " laid out) verified the same"
+			<< " by the ODE and geometric verifiers" << std::endl;
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,453 @@
+/*
+ * EsHyperNeatParity.cpp
+ *
+ * Builds ES-HyperNEAT phenotypes of random CPPNs with
+ * Genome::Build_ES_Phenotype, whose quadtrees are flat arrays queried in
+ * batches, and checks that their neurons and connections are exactly those
+ * of the original implementation, reproduced below, whose quadtrees are
+ * graphs of nodes divided and pruned one CPPN query at a time. Covers LEO,
+ * deeper trees than the initial depth and several threads.
+ */
+#include <iostream>
+#include <vector>
+#include <queue>
+#include <cstdlib>
+#include <cmath>
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/accumulators/accumulators.hpp>
+#include <boost/accumulators/statistics/stats.hpp>
+#include <boost/accumulators/statistics/variance.hpp>
+#include "evolution/neat/Genome.h"
+#include "evolution/neat/Innovation.h"
+#include "evolution/neat/NeuralNetwork.h"
+#include "evolution/neat/Parameters.h"
+#include "evolution/neat/Random.h"
+#include "evolution/neat/Substrate.h"
+#include "evolution/neat/Utils.h"
+
+using namespace NEAT;
+
+namespace {
+
+const unsigned int NUM_GENOMES = 50;
+const unsigned int NUM_MUTATIONS = 30;
+
+typedef boost::unordered_map<std::vector<double>, int> NodeMap;
+
+// The original quadtree node, with its children allocated one by one
+struct ReferencePoint {
+	double x, y, z, width, height, weight, leo;
+	unsigned int level;
+	std::vector<boost::shared_ptr<ReferencePoint> > children;
+
+	ReferencePoint(double t_x, double t_y, double t_width, double t_height,
+			unsigned int t_level) :
+			x(t_x), y(t_y), z(0), width(t_width), height(t_height), weight(0),
+			leo(0), level(t_level) {
+	}
+};
+
+typedef boost::shared_ptr<ReferencePoint> ReferencePointPtr;
+
+double referenceVariance(const ReferencePointPtr &point) {
+	if (point->children.size() == 0) {
+		return 0.0;
+	}
+	boost::accumulators::accumulator_set<double, boost::accumulators::stats<
+			boost::accumulators::tag::variance> > acc;
+	for (unsigned int i = 0; i < 4; i++) {
+		acc(point->children[i]->weight);
+	}
+	return boost::accumulators::variance(acc);
+}
+
+// Queries the CPPN for a single connection, as the original did
+double query(NeuralNetwork &cppn, const std::vector<double> &inputs,
+		int cppnDepth, double *leo, const Parameters &params) {
+	cppn.Flush();
+	cppn.Input(const_cast<std::vector<double>&>(inputs));
+	for (int d = 0; d < cppnDepth; d++) {
+		cppn.Activate();
+	}
+	double weight = cppn.Output()[0];
+	if (leo != NULL && params.Leo) {
+		*leo = cppn.Output()[cppn.Output().size() - 1];
+	}
+	cppn.Flush();
+	return weight;
+}
+
+// The original DivideInitialize: breadth first, one query per child
+void referenceDivide(const std::vector<double> &node, ReferencePointPtr &root,
+		NeuralNetwork &cppn, int cppnDepth, const Parameters &params,
+		bool outgoing) {
+	std::queue<ReferencePointPtr> q;
+	q.push(root);
+	while (!q.empty()) {
+		ReferencePointPtr p = q.front();
+		double w = p->width / 2, h = p->height / 2;
+		p->children.push_back(ReferencePointPtr(new ReferencePoint(
+				p->x - w, p->y - h, w, h, p->level + 1)));
+		p->children.push_back(ReferencePointPtr(new ReferencePoint(
+				p->x - w, p->y + h, w, h, p->level + 1)));
+		p->children.push_back(ReferencePointPtr(new ReferencePoint(
+				p->x + w, p->y + h, w, h, p->level + 1)));
+		p->children.push_back(ReferencePointPtr(new ReferencePoint(
+				p->x + w, p->y - h, w, h, p->level + 1)));
+
+		for (unsigned int i = 0; i < p->children.size(); i++) {
+			ReferencePoint &c = *p->children[i];
+			std::vector<double> inputs;
+			if (outgoing) {
+				inputs = node;
+				inputs.push_back(c.x);
+				inputs.push_back(c.y);
+				inputs.push_back(c.z);
+			} else {
+				inputs.push_back(c.x);
+				inputs.push_back(c.y);
+				inputs.push_back(c.z);
+				inputs.push_back(node[0]);
+				inputs.push_back(node[1]);
+				inputs.push_back(node[2]);
+			}
+			inputs.push_back(params.CPPN_Bias);
+			c.weight = query(cppn, inputs, cppnDepth, &c.leo, params);
+		}
+
+		if ((p->level < params.InitialDepth) || ((p->level < params.MaxDepth)
+				&& referenceVariance(p) > params.DivisionThreshold)) {
+			for (unsigned int i = 0; i < 4; i++) {
+				q.push(p->children[i]);
+			}
+		}
+		q.pop();
+	}
+}
+
+// The original PruneExpress: recursive, four band pruning queries per point
+void referencePrune(const std::vector<double> &node,
+		const ReferencePointPtr &root, NeuralNetwork &cppn, int cppnDepth,
+		const Parameters &params,
+		std::vector<Genome::TempConnection> &connections, bool outgoing) {
+	if (root->children.empty()) {
+		return;
+	}
+	for (unsigned int i = 0; i < 4; i++) {
+		const ReferencePoint &c = *root->children[i];
+		if (referenceVariance(root->children[i]) > params.VarianceThreshold) {
+			referencePrune(node, root->children[i], cppn, cppnDepth, params,
+					connections, outgoing);
+		} else if (!params.Leo || c.leo > params.LeoThreshold) {
+			std::vector<double> inputs;
+			int rootIndex = 0;
+			if (outgoing) {
+				inputs = node;
+				inputs.push_back(c.x);
+				inputs.push_back(c.y);
+				inputs.push_back(c.z);
+				rootIndex = node.size();
+			} else {
+				inputs.push_back(c.x);
+				inputs.push_back(c.y);
+				inputs.push_back(c.z);
+				inputs.push_back(node[0]);
+				inputs.push_back(node[1]);
+				inputs.push_back(node[2]);
+			}
+			inputs.push_back(params.CPPN_Bias);
+
+			inputs[rootIndex] -= root->width;
+			double left = Abs(c.weight - query(cppn, inputs, cppnDepth, NULL,
+					params));
+			inputs[rootIndex] += 2 * root->width;
+			double right = Abs(c.weight - query(cppn, inputs, cppnDepth, NULL,
+					params));
+			inputs[rootIndex] -= root->width;
+			inputs[rootIndex + 1] -= root->width;
+			double top = Abs(c.weight - query(cppn, inputs, cppnDepth, NULL,
+					params));
+			inputs[rootIndex + 1] += 2 * root->width;
+			double bottom = Abs(c.weight - query(cppn, inputs, cppnDepth,
+					NULL, params));
+
+			if (std::max(std::min(top, bottom), std::min(left, right))
+					> params.BandThreshold) {
+				Genome::TempConnection tc;
+				std::vector<double> point;
+				point.push_back(c.x);
+				point.push_back(c.y);
+				point.push_back(c.z);
+				tc.source = outgoing ? node : point;
+				tc.target = outgoing ? point : node;
+				tc.weight = c.weight;
+				connections.push_back(tc);
+			}
+		}
+	}
+}
+
+void referenceConnections(const std::vector<double> &node, NeuralNetwork &cppn,
+		int cppnDepth, const Parameters &params, bool outgoing,
+		std::vector<Genome::TempConnection> &connections) {
+	ReferencePointPtr root(new ReferencePoint(params.Qtree_X, params.Qtree_Y,
+			params.Width, params.Height, 1));
+	referenceDivide(node, root, cppn, cppnDepth, params, outgoing);
+	connections.clear();
+	referencePrune(node, root, cppn, cppnDepth, params, connections, outgoing);
+}
+
+Connection connection(unsigned int source, unsigned int target, double weight) {
+	Connection tc;
+	tc.m_source_neuron_idx = source;
+	tc.m_target_neuron_idx = target;
+	tc.m_weight = weight;
+	tc.m_recur_flag = false;
+	return tc;
+}
+
+Neuron neuron(const std::vector<double> &coords, ActivationFunction function,
+		NeuronType type) {
+	Neuron n;
+	n.m_a = 1;
+	n.m_b = 0;
+	n.m_substrate_coords = coords;
+	n.m_activation_function_type = function;
+	n.m_type = type;
+	return n;
+}
+
+// The original Build_ES_Phenotype, expanding one node after the other
+void referenceBuild(Genome &genome, NeuralNetwork &net, Substrate &subst,
+		const Parameters &params) {
+	unsigned int inputCount = subst.m_input_coords.size();
+	unsigned int outputCount = subst.m_output_coords.size();
+	unsigned int hiddenIndex = inputCount + outputCount;
+	unsigned int hiddenCounter = 0;
+	double scale = subst.m_max_weight_and_bias;
+
+	// reserved as the original did: the hidden neurons are numbered in the
+	// iteration order of the maps, which depends on their bucket counts
+	unsigned int maxNodes = (unsigned int) std::pow(4.0, (int) params.MaxDepth);
+	NodeMap hiddenNodes, unexploredNodes, temp;
+	hiddenNodes.reserve(maxNodes);
+	unexploredNodes.reserve(maxNodes);
+	temp.reserve(maxNodes);
+	net.SetInputOutputDimentions(static_cast<unsigned short>(inputCount),
+			static_cast<unsigned short>(outputCount));
+
+	NeuralNetwork cppn(true);
+	genome.BuildPhenotype(cppn);
+	genome.CalculateDepth();
+	int cppnDepth = genome.GetDepth();
+
+	std::vector<Genome::TempConnection> found;
+	for (unsigned int i = 0; i < inputCount; i++) {
+		referenceConnections(subst.m_input_coords[i], cppn, cppnDepth, params,
+				true, found);
+		for (unsigned int j = 0; j < found.size(); j++) {
+			if (std::abs(found[j].weight * scale) < 0.2) {
+				continue;
+			}
+			NodeMap::iterator it = hiddenNodes.find(found[j].target);
+			unsigned int target;
+			if (it == hiddenNodes.end()) {
+				target = hiddenCounter++;
+				hiddenNodes.insert(std::make_pair(found[j].target, target));
+			} else {
+				target = it->second;
+			}
+			net.m_connections.push_back(connection(i, target + hiddenIndex,
+					found[j].weight * scale));
+		}
+	}
+
+	unexploredNodes = hiddenNodes;
+	for (unsigned int i = 0; i < params.IterationLevel; i++) {
+		for (NodeMap::iterator hid = unexploredNodes.begin();
+				hid != unexploredNodes.end(); hid++) {
+			referenceConnections(hid->first, cppn, cppnDepth, params, true,
+					found);
+			for (unsigned int k = 0; k < found.size(); k++) {
+				if (std::abs(found[k].weight * scale) < 0.2) {
+					continue;
+				}
+				NodeMap::iterator it = hiddenNodes.find(found[k].target);
+				unsigned int target;
+				if (it == hiddenNodes.end()) {
+					target = hiddenCounter++;
+					hiddenNodes.insert(std::make_pair(found[k].target, target));
+				} else {
+					target = it->second;
+				}
+				net.m_connections.push_back(connection(
+						hid->second + hiddenIndex, target + hiddenIndex,
+						found[k].weight * scale));
+			}
+		}
+		// as the original, every hidden node is explored again
+		for (NodeMap::iterator it = hiddenNodes.begin();
+				it != hiddenNodes.end(); it++) {
+			temp.insert(std::make_pair(it->first, it->second));
+		}
+		unexploredNodes = temp;
+	}
+
+	for (unsigned int i = 0; i < outputCount; i++) {
+		referenceConnections(subst.m_output_coords[i], cppn, cppnDepth, params,
+				false, found);
+		for (unsigned int j = 0; j < found.size(); j++) {
+			if (std::abs(found[j].weight * scale) < 0.2) {
+				continue;
+			}
+			NodeMap::iterator it = hiddenNodes.find(found[j].source);
+			if (it != hiddenNodes.end()) {
+				net.m_connections.push_back(connection(
+						it->second + hiddenIndex, i + inputCount,
+						found[j].weight * scale));
+			}
+		}
+	}
+
+	for (unsigned int i = 0; i < inputCount - 1; i++) {
+		net.m_neurons.push_back(neuron(subst.m_input_coords[i], LINEAR,
+				INPUT));
+	}
+	net.m_neurons.push_back(neuron(subst.m_input_coords[inputCount - 1],
+			LINEAR, BIAS));
+	for (unsigned int i = 0; i < outputCount; i++) {
+		net.m_neurons.push_back(neuron(subst.m_output_coords[i],
+				subst.m_output_nodes_activation, OUTPUT));
+	}
+	for (NodeMap::iterator it = hiddenNodes.begin(); it != hiddenNodes.end();
+			it++) {
+		net.m_neurons.push_back(neuron(it->first,
+				subst.m_hidden_nodes_activation, HIDDEN));
+	}
+
+	genome.Clean_Net(net.m_connections, inputCount, outputCount,
+			hiddenNodes.size());
+}
+
+// A CPPN taking the coordinates of both ends and a bias, with a weight and
+// a LEO output, grown by random mutations
+Genome randomCppn(Parameters &params, RNG &rng) {
+	Genome genome(0, 7, 0, 2, false, TANH, SIGNED_GAUSS, 0, params);
+	InnovationDatabase innovations;
+	innovations.Init(genome);
+	for (unsigned int i = 0; i < NUM_MUTATIONS; i++) {
+		switch (rng.RandInt(0, 3)) {
+		case 0:
+			genome.Mutate_AddNeuron(innovations, params, rng);
+			break;
+		case 1:
+			genome.Mutate_AddLink(innovations, params, rng);
+			break;
+		case 2:
+			genome.Mutate_NeuronActivation_Type(params, rng);
+			break;
+		default:
+			genome.Mutate_LinkWeights(params, rng);
+			break;
+		}
+	}
+	return genome;
+}
+
+Substrate substrate() {
+	Substrate subst;
+	// a row of inputs below, the bias last, and outputs above
+	for (int i = 0; i < 5; i++) {
+		std::vector<double> coords;
+		coords.push_back(-1 + 0.5 * i);
+		coords.push_back(-1);
+		coords.push_back(0);
+		subst.m_input_coords.push_back(coords);
+	}
+	for (int i = 0; i < 3; i++) {
+		std::vector<double> coords;
+		coords.push_back(-0.75 + 0.75 * i);
+		coords.push_back(1);
+		coords.push_back(0);
+		subst.m_output_coords.push_back(coords);
+	}
+	subst.m_hidden_nodes_activation = SIGNED_SIGMOID;
+	subst.m_output_nodes_activation = UNSIGNED_SIGMOID;
+	return subst;
+}
+
+bool same(const NeuralNetwork &a, const NeuralNetwork &b) {
+	if (a.m_neurons.size() != b.m_neurons.size() ||
+			a.m_connections.size() != b.m_connections.size()) {
+		return false;
+	}
+	for (unsigned int i = 0; i < a.m_neurons.size(); i++) {
+		const Neuron &n = a.m_neurons[i], &m = b.m_neurons[i];
+		if (n.m_type != m.m_type || n.m_substrate_coords != m.m_substrate_coords
+				|| n.m_activation_function_type
+						!= m.m_activation_function_type) {
+			return false;
+		}
+	}
+	for (unsigned int i = 0; i < a.m_connections.size(); i++) {
+		const Connection &c = a.m_connections[i], &d = b.m_connections[i];
+		if (c.m_source_neuron_idx != d.m_source_neuron_idx ||
+				c.m_target_neuron_idx != d.m_target_neuron_idx ||
+				c.m_weight != d.m_weight) {
+			return false;
+		}
+	}
+	return true;
+}
+
+}
+
+int main() {
+	Parameters params;
+	params.MutateNeuronActivationTypeProb = 1;
+	params.ActivationFunction_SignedGauss_Prob = 1;
+	params.ActivationFunction_SignedSine_Prob = 1;
+	params.ActivationFunction_Linear_Prob = 1;
+	params.InitialDepth = 2;
+	params.MaxDepth = 4;
+	params.IterationLevel = 1;
+
+	RNG rng;
+	rng.Seed(42);
+	Substrate subst = substrate();
+	unsigned int mismatches = 0, connections = 0;
+
+	for (unsigned int g = 0; g < NUM_GENOMES; g++) {
+		Genome genome = randomCppn(params, rng);
+		// LEO on every other genome, threads on half of each
+		params.Leo = (g % 2 == 1);
+		params.NumThreads = (g % 4 < 2) ? 1 : 4;
+
+		Genome reference = genome;
+		NeuralNetwork expected;
+		referenceBuild(reference, expected, subst, params);
+		NeuralNetwork actual;
+		genome.Build_ES_Phenotype(actual, subst, params);
+
+		connections += expected.m_connections.size();
+		if (!same(expected, actual)) {
+			std::cerr << "Genome " << g << ": expected "
+					<< expected.m_neurons.size() << " neurons and "
+					<< expected.m_connections.size() << " connections, got "
+					<< actual.m_neurons.size() << " and "
+					<< actual.m_connections.size() << " or other values"
+					<< std::endl;
+			mismatches++;
+		}
+	}
+
+	if (mismatches) {
+		std::cerr << mismatches << " of " << NUM_GENOMES
+				<< " phenotypes differ from the original" << std::endl;
+		return EXIT_FAILURE;
+	}
+	std::cout << "All " << NUM_GENOMES << " phenotypes (" << connections
+			<< " connections) match the original" << std::endl;
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,141 @@
+/*
+ * InnovationBenchmark.cpp
+ *
+ * Grows a NEAT innovation database to 100k entries the way add-link and
+ * add-neuron mutations do, checks a sample of the lookups against a linear
+ * scan of the database and reports the time spent in lookups as the
+ * database grows.
+ */
+#include <iostream>
+#include <vector>
+#include <ctime>
+#include <cstdlib>
+#include "evolution/neat/Innovation.h"
+
+using namespace NEAT;
+
+namespace {
+
+const unsigned int DATABASE_SIZE = 100000;
+const unsigned int LOOKUPS_PER_INNOVATION = 4;
+const unsigned int REPORT_EVERY = 10000;
+
+struct Entry {
+	int from, to;
+	InnovationType type;
+	int id, neuron;
+};
+
+// Reference implementation of CheckInnovation, scanning the whole list
+int scanInnovation(const std::vector<Entry> &entries, int from, int to,
+		InnovationType type) {
+	for (unsigned int i = 0; i < entries.size(); i++) {
+		if (entries[i].from == from && entries[i].to == to &&
+				entries[i].type == type) {
+			return entries[i].id;
+		}
+	}
+	return -1;
+}
+
+int scanNeuronID(const std::vector<Entry> &entries, int from, int to) {
+	for (unsigned int i = 0; i < entries.size(); i++) {
+		if (entries[i].from == from && entries[i].to == to &&
+				entries[i].type == NEW_NEURON) {
+			return entries[i].neuron;
+		}
+	}
+	return -1;
+}
+
+}
+
+int main() {
+	std::srand(42);
+
+	InnovationDatabase db(1, 1);
+	std::vector<Entry> reference;
+	// number of neurons created so far, used to draw plausible link ends
+	int numNeurons = 20;
+	unsigned int mismatches = 0;
+	unsigned int nextReport = REPORT_EVERY;
+	double indexedTime = 0, scanTime = 0;
+	volatile int sink = 0;
+
+	while (db.NumInnovations() < DATABASE_SIZE) {
+
+		// Mix of link and neuron innovations, with repeated queries for
+		// existing innovations as happens across a population
+		int from = 1 + std::rand() % numNeurons;
+		int to = 1 + std::rand() % numNeurons;
+		InnovationType type = (std::rand() % 4 == 0) ? NEW_NEURON : NEW_LINK;
+
+		if (db.CheckInnovation(from, to, type) == -1) {
+			Entry e;
+			e.from = from;
+			e.to = to;
+			e.type = type;
+			e.neuron = -1;
+			if (type == NEW_LINK) {
+				e.id = db.AddLinkInnovation(from, to);
+			} else {
+				e.neuron = db.AddNeuronInnovation(from, to, HIDDEN);
+				e.id = db.CheckInnovation(from, to, type);
+				numNeurons++;
+			}
+			reference.push_back(e);
+		}
+
+		// Time lookups of random (mostly existing) keys
+		std::vector<Entry> queries;
+		for (unsigned int i = 0; i < LOOKUPS_PER_INNOVATION; i++) {
+			Entry q = reference[std::rand() % reference.size()];
+			if (i % 2) {
+				q.to = 1 + std::rand() % numNeurons;
+			}
+			queries.push_back(q);
+		}
+
+		std::clock_t start = std::clock();
+		std::vector<int> indexed;
+		for (unsigned int i = 0; i < queries.size(); i++) {
+			indexed.push_back(db.CheckInnovation(queries[i].from,
+					queries[i].to, queries[i].type));
+			indexed.push_back(db.FindNeuronID(queries[i].from, queries[i].to));
+		}
+		indexedTime += double(std::clock() - start) / CLOCKS_PER_SEC;
+
+		if (db.NumInnovations() >= nextReport) {
+			nextReport += REPORT_EVERY;
+			std::cout << db.NumInnovations() << " innovations: indexed "
+					<< indexedTime << " s, linear scan (est.) " << scanTime
+					<< " s" << std::endl;
+		}
+
+		// The linear scans are quadratic over the run: only run them on
+		// 1% of the iterations and extrapolate
+		if (std::rand() % 100 != 0) {
+			continue;
+		}
+		start = std::clock();
+		for (unsigned int i = 0; i < queries.size(); i++) {
+			int id = scanInnovation(reference, queries[i].from, queries[i].to,
+					queries[i].type);
+			int neuron = scanNeuronID(reference, queries[i].from,
+					queries[i].to);
+			if (id != indexed[2 * i] || neuron != indexed[2 * i + 1]) {
+				mismatches++;
+			}
+			sink += id;
+		}
+		scanTime += 100 * double(std::clock() - start) / CLOCKS_PER_SEC;
+	}
+
+	if (mismatches) {
+		std::cerr << mismatches << " lookups differ from linear scan"
+				<< std::endl;
+		return EXIT_FAILURE;
+	}
+	std::cout << "All lookups match the linear scan" << std::endl;
+	return EXIT_SUCCESS;
+}
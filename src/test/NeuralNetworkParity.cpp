@@ -0,0 +1,299 @@
+/*
+ * NeuralNetworkParity.cpp
+ *
+ * Activates random NEAT networks (recurrent links, every activation function)
+ * with NeuralNetwork::Activate, ActivateFast and ActivateUseInternalBias and
+ * checks that the outputs are exactly those of the original connection by
+ * connection implementation, reproduced below. Checks that
+ * NeuralNetwork::ActivateBatch answers each query like Flush, Input, Activate
+ * and Output do, on recurrent and feed-forward networks. Also reports the time
+ * spent activating a large network with each.
+ */
+#include <iostream>
+#include <vector>
+#include <ctime>
+#include <cstdlib>
+#include <cmath>
+#include "evolution/neat/NeuralNetwork.h"
+
+using namespace NEAT;
+
+namespace {
+
+const unsigned int NUM_NETWORKS = 500;
+const unsigned int NUM_STEPS = 10;
+
+double uniform(double min, double max) {
+	return min + (max - min) * (std::rand() / (double) RAND_MAX);
+}
+
+// Activation functions as in NeuralNetwork.cpp
+double referenceActivation(int type, double x, double a, double b) {
+	switch (type) {
+	case SIGNED_SIGMOID:
+		return (1.0 / (1.0 + exp(-a * x - b)) - 0.5) * 2.0;
+	case UNSIGNED_SIGMOID:
+		return 1.0 / (1.0 + exp(-a * x - b));
+	case TANH:
+		return tanh(x * a);
+	case TANH_CUBIC:
+		return tanh(x * x * x * a);
+	case SIGNED_STEP:
+		return (x > b) ? 1.0 : -1.0;
+	case UNSIGNED_STEP:
+		return (x > (0.5 + b)) ? 1.0 : 0.0;
+	case SIGNED_GAUSS:
+		return (exp(-a * x * x + b) - 0.5) * 2.0;
+	case UNSIGNED_GAUSS:
+		return exp(-a * x * x + b);
+	case ABS:
+		return ((x + b) < 0.0) ? -(x + b) : (x + b);
+	case SIGNED_SINE:
+		return sin(x * 3.141592 + b);
+	case UNSIGNED_SINE:
+		return (sin((x * a + b)) + 1.0) / 2.0;
+	case LINEAR:
+		return x + b;
+	case RELU:
+		return (x > 0) ? x : 0;
+	case SOFTPLUS:
+		return log(1 + exp(x));
+	default:
+		return 1.0 / (1.0 + exp(-a * x - b));
+	}
+}
+
+// The original activation: computes every connection's signal, scatters
+// them to the target neurons, then applies the activation functions
+void referenceActivate(NeuralNetwork &net, bool useBias, bool fast) {
+	for (unsigned int i = 0; i < net.m_connections.size(); i++) {
+		net.m_connections[i].m_signal =
+				net.m_neurons[net.m_connections[i].m_source_neuron_idx].m_activation
+						* net.m_connections[i].m_weight;
+	}
+	for (unsigned int i = 0; i < net.m_connections.size(); i++) {
+		net.m_neurons[net.m_connections[i].m_target_neuron_idx].m_activesum +=
+				net.m_connections[i].m_signal;
+	}
+	for (unsigned int i = net.NumInputs(); i < net.m_neurons.size(); i++) {
+		Neuron &n = net.m_neurons[i];
+		double x = n.m_activesum + (useBias ? n.m_bias : 0.0);
+		n.m_activesum = 0;
+		n.m_activation = referenceActivation(
+				fast ? UNSIGNED_SIGMOID : n.m_activation_function_type, x,
+				n.m_a, n.m_b);
+	}
+}
+
+NeuralNetwork randomNetwork(unsigned int numInputs, unsigned int numOutputs,
+		unsigned int numHidden, unsigned int numConnections,
+		bool feedForward = false) {
+	NeuralNetwork net;
+	net.SetInputOutputDimentions(numInputs, numOutputs);
+	unsigned int numNeurons = numInputs + numOutputs + numHidden;
+	for (unsigned int i = 0; i < numNeurons; i++) {
+		Neuron n;
+		n.m_a = uniform(0.5, 5);
+		n.m_b = uniform(-1, 1);
+		n.m_bias = uniform(-1, 1);
+		n.m_timeconst = 1;
+		n.m_membrane_potential = 0;
+		n.m_activation_function_type = static_cast<ActivationFunction>(
+				std::rand() % (SOFTPLUS + 1));
+		n.m_type = (i < numInputs) ? INPUT : ((i < numInputs + numOutputs) ?
+				OUTPUT : HIDDEN);
+		n.m_split_y = 0;
+		net.AddNeuron(n);
+	}
+	for (unsigned int i = 0; i < numConnections; i++) {
+		// any source, including recurrent and self connections, unless
+		// feed-forward: then from inputs or hidden neurons to later ones
+		Connection c;
+		c.m_source_neuron_idx = std::rand() % numNeurons;
+		c.m_target_neuron_idx = numInputs + std::rand() % (numNeurons - numInputs);
+		if (feedForward) {
+			c.m_target_neuron_idx = numInputs + std::rand() % (numOutputs
+					+ numHidden);
+			unsigned int rank = (c.m_target_neuron_idx < numInputs + numOutputs)
+					? numNeurons : c.m_target_neuron_idx;
+			c.m_source_neuron_idx = std::rand() % rank;
+			if (c.m_source_neuron_idx >= numInputs && c.m_source_neuron_idx
+					< numInputs + numOutputs) {
+				c.m_source_neuron_idx = std::rand() % numInputs;
+			}
+		}
+		c.m_weight = uniform(-3, 3);
+		c.m_recur_flag = false;
+		c.m_hebb_rate = c.m_hebb_pre_rate = 0;
+		net.AddConnection(c);
+	}
+	net.Flush();
+	return net;
+}
+
+std::vector<double> randomInputs(unsigned int numInputs) {
+	std::vector<double> inputs;
+	for (unsigned int i = 0; i < numInputs; i++) {
+		inputs.push_back(uniform(-1, 1));
+	}
+	return inputs;
+}
+
+// Activates both networks the same way and counts differing neurons
+unsigned int compareSteps(NeuralNetwork &net, NeuralNetwork &reference,
+		int mode) {
+	unsigned int mismatches = 0;
+	for (unsigned int t = 0; t < NUM_STEPS; t++) {
+		if (mode == 0) {
+			net.Activate();
+		} else if (mode == 1) {
+			net.ActivateFast();
+		} else {
+			net.ActivateUseInternalBias();
+		}
+		referenceActivate(reference, mode == 2, mode == 1);
+		for (unsigned int i = 0; i < net.m_neurons.size(); i++) {
+			double a = net.m_neurons[i].m_activation;
+			double b = reference.m_neurons[i].m_activation;
+			// recurrent linear neurons may diverge to NaN in both
+			if (a != b && !(a != a && b != b)) {
+				mismatches++;
+			}
+		}
+	}
+	return mismatches;
+}
+
+// Runs the queries one at a time and as a batch and counts differing outputs
+unsigned int compareBatch(NeuralNetwork &net, unsigned int steps) {
+	std::vector<std::vector<double> > inputs;
+	for (unsigned int q = 0; q < 20; q++) {
+		inputs.push_back(randomInputs(net.NumInputs()));
+	}
+	std::vector<std::vector<double> > batchOutputs;
+	net.ActivateBatch(inputs, steps, batchOutputs);
+
+	unsigned int mismatches = 0;
+	for (unsigned int q = 0; q < inputs.size(); q++) {
+		net.Flush();
+		net.Input(inputs[q]);
+		for (unsigned int t = 0; t < steps; t++) {
+			net.Activate();
+		}
+		std::vector<double> outputs = net.Output();
+		for (unsigned int i = 0; i < outputs.size(); i++) {
+			double a = outputs[i];
+			double b = batchOutputs[q][i];
+			if (a != b && !(a != a && b != b)) {
+				mismatches++;
+			}
+		}
+	}
+	return mismatches;
+}
+
+}
+
+int main() {
+	std::srand(42);
+
+	unsigned int mismatches = 0;
+	for (unsigned int n = 0; n < NUM_NETWORKS; n++) {
+		NeuralNetwork net = randomNetwork(1 + std::rand() % 8,
+				1 + std::rand() % 4, std::rand() % 20, std::rand() % 120);
+		NeuralNetwork reference = net;
+		int mode = n % 3;
+
+		std::vector<double> inputs = randomInputs(net.NumInputs());
+		net.Input(inputs);
+		reference.Input(inputs);
+		mismatches += compareSteps(net, reference, mode);
+
+		// the compiled form must follow changes of the topology
+		Connection c;
+		c.m_recur_flag = false;
+		c.m_hebb_rate = c.m_hebb_pre_rate = 0;
+		c.m_source_neuron_idx = 0;
+		c.m_target_neuron_idx = net.m_neurons.size() - 1;
+		c.m_weight = uniform(-3, 3);
+		net.AddConnection(c);
+		reference.AddConnection(c);
+		inputs = randomInputs(net.NumInputs());
+		net.Input(inputs);
+		reference.Input(inputs);
+		mismatches += compareSteps(net, reference, mode);
+
+		net.Flush();
+		reference.Flush();
+		mismatches += compareSteps(net, reference, mode);
+	}
+
+	for (unsigned int n = 0; n < NUM_NETWORKS; n++) {
+		NeuralNetwork net = randomNetwork(1 + std::rand() % 8,
+				1 + std::rand() % 4, std::rand() % 20, std::rand() % 120,
+				n % 2 == 0);
+		mismatches += compareBatch(net, NUM_STEPS);
+		// too few steps for deep feed-forward networks to settle
+		mismatches += compareBatch(net, 2);
+	}
+
+	// CPPN sized network queried many times
+	NeuralNetwork net = randomNetwork(7, 4, 60, 600);
+	NeuralNetwork reference = net;
+	const unsigned int queries = 20000;
+	std::clock_t start = std::clock();
+	for (unsigned int q = 0; q < queries; q++) {
+		net.Flush();
+		std::vector<double> inputs(7, q / (double) queries);
+		net.Input(inputs);
+		for (unsigned int t = 0; t < NUM_STEPS; t++) {
+			net.Activate();
+		}
+	}
+	double compiledTime = double(std::clock() - start) / CLOCKS_PER_SEC;
+	start = std::clock();
+	for (unsigned int q = 0; q < queries; q++) {
+		reference.Flush();
+		std::vector<double> inputs(7, q / (double) queries);
+		reference.Input(inputs);
+		for (unsigned int t = 0; t < NUM_STEPS; t++) {
+			referenceActivate(reference, false, false);
+		}
+	}
+	double referenceTime = double(std::clock() - start) / CLOCKS_PER_SEC;
+	std::cout << queries << " queries: compiled " << compiledTime
+			<< " s, connection by connection " << referenceTime << " s"
+			<< std::endl;
+
+	// and as a batch, feed-forward
+	NeuralNetwork feedForward = randomNetwork(7, 5, 8, 60, true);
+	std::vector<std::vector<double> > batch;
+	for (unsigned int q = 0; q < queries; q++) {
+		batch.push_back(std::vector<double>(7, q / (double) queries));
+	}
+	std::vector<std::vector<double> > outputs;
+	start = std::clock();
+	feedForward.ActivateBatch(batch, NUM_STEPS, outputs);
+	double batchTime = double(std::clock() - start) / CLOCKS_PER_SEC;
+	start = std::clock();
+	for (unsigned int q = 0; q < queries; q++) {
+		feedForward.Flush();
+		feedForward.Input(batch[q]);
+		for (unsigned int t = 0; t < NUM_STEPS; t++) {
+			feedForward.Activate();
+		}
+		outputs[q] = feedForward.Output();
+	}
+	double stepTime = double(std::clock() - start) / CLOCKS_PER_SEC;
+	std::cout << queries << " feed-forward queries: batch " << batchTime
+			<< " s, one by one " << stepTime << " s" << std::endl;
+
+	if (mismatches) {
+		std::cerr << mismatches << " activations differ from the original "
+				<< "implementation" << std::endl;
+		return EXIT_FAILURE;
+	}
+	std::cout << "All activations match the original implementation"
+			<< std::endl;
+	return EXIT_SUCCESS;
+}
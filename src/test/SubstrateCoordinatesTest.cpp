@@ -0,0 +1,159 @@
+/*
+ * SubstrateCoordinatesTest.cpp
+ *
+ * Checks that the HyperNEAT substrate coordinates SubstrateCoordinates
+ * computes without ODE match the root positions of the parts of the robot
+ * built in an ODE world, as Robot::getRootPosition gives them, for the robot
+ * files given as arguments. When touch sensors or cardans are enabled, also
+ * checks a body with them, whose positions come from the ODE fallback.
+ *
+ * Usage: SubstrateCoordinatesTest <ROBOT_FILE.txt>...
+ */
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cmath>
+#include <ode/ode.h>
+#include "Robot.h"
+#include "evolution/representation/RobotRepresentation.h"
+#include "evolution/engine/neat/SubstrateCoordinates.h"
+
+using namespace robogen;
+
+namespace {
+
+const double TOLERANCE = 1e-5;
+
+#if defined(TOUCH_SENSORS_ENABLED) || defined(ALLOW_CARDANS)
+// A body with the parts BodyLayout has no geometry for
+const char *UNSUPPORTED_PARTS_ROBOT =
+		"0 CoreComponent Core 0\n"
+#ifdef ALLOW_CARDANS
+		"\t0 PassiveCardan Cardan1 0\n"
+		"\t\t0 FixedBrick Brick1 0\n"
+#endif
+#ifdef TOUCH_SENSORS_ENABLED
+		"\t1 TouchSensor Touch1 0\n"
+#endif
+		"\t2 ActiveHinge Hinge1 1\n"
+		"\t\t0 FixedBrick Brick2 0\n";
+#endif
+
+bool equal(double a, double b) {
+	return std::fabs(a - b) <= TOLERANCE;
+}
+
+/**
+ * @return the number of coordinates that differ from the live robot
+ */
+unsigned int check(const std::string &fileName,
+		SubstrateCoordinates &substrateCoordinates) {
+
+	RobotRepresentation robot;
+	if (!robot.init(fileName)) {
+		std::cerr << "Cannot read " << fileName << std::endl;
+		return 1;
+	}
+
+	SubstrateCoordinates::NeuronCoordinates coordinates;
+	boost::shared_ptr<const SubstrateCoordinates::PartPositions> positions =
+			substrateCoordinates.getPartPositions(robot);
+	if (!positions ||
+			!substrateCoordinates.getNeuronCoordinates(robot, coordinates)) {
+		std::cerr << fileName << ": no substrate coordinates" << std::endl;
+		return 1;
+	}
+
+	dInitODE();
+	dWorldID odeWorld = dWorldCreate();
+	dWorldSetGravity(odeWorld, 0, 0, 0);
+	dSpaceID odeSpace = dHashSpaceCreate(0);
+
+	unsigned int mismatches = 0;
+	{
+		boost::shared_ptr<Robot> odeRobot(new Robot);
+		if (!odeRobot->init(odeWorld, odeSpace, robot.serialize())) {
+			std::cerr << fileName << ": cannot build the robot" << std::endl;
+			mismatches++;
+		} else {
+			// part positions
+			const RobotRepresentation::IdPartMap &body = robot.getBody();
+			for (RobotRepresentation::IdPartMap::const_iterator it =
+					body.begin(); it != body.end(); ++it) {
+				osg::Vec3 expected =
+						odeRobot->getBodyPart(it->first)->getRootPosition();
+				SubstrateCoordinates::PartPositions::const_iterator actual =
+						positions->find(it->first);
+				if (actual == positions->end() ||
+						!equal(expected.x(), actual->second.x()) ||
+						!equal(expected.y(), actual->second.y()) ||
+						!equal(expected.z(), actual->second.z())) {
+					std::cerr << fileName << ": part " << it->first
+							<< " expected at " << expected.x() << " "
+							<< expected.y() << " " << expected.z()
+							<< std::endl;
+					mismatches++;
+				}
+			}
+
+			// neuron coordinates, scaled part x and y
+			for (unsigned int i = 0; i < coordinates.size(); ++i) {
+				osg::Vec3 expected = odeRobot->getBodyPart(
+						coordinates[i].first->getIoPair().first)
+						->getRootPosition();
+				const std::vector<double> &actual = coordinates[i].second;
+				if (!equal(expected.x() * 10.0, actual[0]) ||
+						!equal(expected.y() * 10.0, actual[1])) {
+					std::cerr << fileName << ": neuron "
+							<< coordinates[i].first->getId()
+							<< " at " << actual[0] << " " << actual[1]
+							<< std::endl;
+					mismatches++;
+				}
+			}
+		}
+	}
+
+	dSpaceDestroy(odeSpace);
+	dWorldDestroy(odeWorld);
+	dCloseODE();
+	return mismatches;
+}
+
+}
+
+int main(int argc, char *argv[]) {
+
+	std::vector<std::string> fileNames(argv + 1, argv + argc);
+
+#if defined(TOUCH_SENSORS_ENABLED) || defined(ALLOW_CARDANS)
+	std::string unsupported = "SubstrateCoordinatesTest.txt";
+	std::ofstream file(unsupported.c_str());
+	file << UNSUPPORTED_PARTS_ROBOT;
+	file.close();
+	fileNames.push_back(unsupported);
+#endif
+
+	if (fileNames.empty()) {
+		std::cerr << "Usage: " << argv[0] << " <ROBOT_FILE.txt>..."
+				<< std::endl;
+		return EXIT_FAILURE;
+	}
+
+	SubstrateCoordinates substrateCoordinates;
+	unsigned int mismatches = 0;
+	for (unsigned int i = 0; i < fileNames.size(); ++i) {
+		mismatches += check(fileNames[i], substrateCoordinates);
+	}
+
+	if (mismatches) {
+		std::cerr << mismatches << " coordinates differ from the robot"
+				<< std::endl;
+		return EXIT_FAILURE;
+	}
+	std::cout << "All coordinates of " << fileNames.size()
+			<< " robots match Robot::getRootPosition" << std::endl;
+	return EXIT_SUCCESS;
+}
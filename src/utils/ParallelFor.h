@@ -0,0 +1,108 @@
+/*
+ * @(#) ParallelFor.h   1.0   Oct 19, 2026
+ *
+ * The ROBOGEN Framework
+ * Copyright © 2013-2016
+ *
+ * Laboratory of Intelligent Systems, EPFL
+ *
+ * This file is part of the ROBOGEN Framework.
+ *
+ * The ROBOGEN Framework is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License (GPL)
+ * as published by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @(#) $Id$
+ */
+
+#ifndef ROBOGEN_PARALLEL_FOR_H_
+#define ROBOGEN_PARALLEL_FOR_H_
+
+#ifndef EMSCRIPTEN
+#include <boost/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#endif
+
+namespace robogen {
+
+/**
+ * @return the number of threads to use for a requested count, 0 meaning one
+ * per hardware thread
+ */
+inline unsigned int resolveThreadCount(unsigned int requested) {
+#ifdef EMSCRIPTEN
+	return 1;
+#else
+	if (requested == 0) {
+		requested = boost::thread::hardware_concurrency();
+	}
+	return (requested > 0) ? requested : 1;
+#endif
+}
+
+#ifndef EMSCRIPTEN
+/**
+ * Worker function: takes task indices from a shared counter until all
+ * tasks have been handed out
+ */
+template<typename Task>
+void parallelForWorker(unsigned int count, unsigned int &next,
+		boost::mutex &nextMutex, Task &task) {
+	while (true) {
+		unsigned int i;
+		{
+			boost::mutex::scoped_lock lock(nextMutex);
+			if (next >= count) {
+				return;
+			}
+			i = next++;
+		}
+		task(i);
+	}
+}
+#endif
+
+/**
+ * Calls task(i) for every i in [0, count) using up to numThreads threads
+ * (0: one per hardware thread) and returns once all calls are done.
+ * Tasks must only write to state owned by their index.
+ */
+template<typename Task>
+void parallelFor(unsigned int count, unsigned int numThreads, Task task) {
+
+	numThreads = resolveThreadCount(numThreads);
+	if (numThreads > count) {
+		numThreads = count;
+	}
+
+	if (numThreads <= 1) {
+		for (unsigned int i = 0; i < count; ++i) {
+			task(i);
+		}
+		return;
+	}
+
+#ifndef EMSCRIPTEN
+	unsigned int next = 0;
+	boost::mutex nextMutex;
+	boost::thread_group workers;
+	for (unsigned int t = 0; t < numThreads; ++t) {
+		workers.add_thread(new boost::thread(parallelForWorker<Task>, count,
+				boost::ref(next), boost::ref(nextMutex), boost::ref(task)));
+	}
+	workers.join_all();
+#endif
+}
+
+}
+
+#endif /* ROBOGEN_PARALLEL_FOR_H_ */
@@ -0,0 +1,50 @@
+/*
+ * @(#) RandomStreams.h   1.0   Oct 19, 2026
+ *
+ * The ROBOGEN Framework
+ * Copyright © 2013-2016
+ *
+ * Laboratory of Intelligent Systems, EPFL
+ *
+ * This file is part of the ROBOGEN Framework.
+ *
+ * The ROBOGEN Framework is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License (GPL)
+ * as published by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @(#) $Id$
+ */
+
+#ifndef ROBOGEN_RANDOM_STREAMS_H_
+#define ROBOGEN_RANDOM_STREAMS_H_
+
+#include <boost/cstdint.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/seed_seq.hpp>
+
+namespace robogen {
+
+/**
+ * Seeds rng with an independent stream identified by (seed, stream,
+ * substream), e.g. (run seed, generation, child index). Work distributed
+ * over threads stays reproducible when every task draws from its own stream.
+ */
+inline void seedStream(boost::random::mt19937 &rng, unsigned int seed,
+		unsigned int stream, unsigned int substream) {
+	boost::uint32_t key[] = { seed, stream, substream };
+	boost::random::seed_seq sequence(key, key + 3);
+	rng.seed(sequence);
+}
+
+}
+
+#endif /* ROBOGEN_RANDOM_STREAMS_H_ */
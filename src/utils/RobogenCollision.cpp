@@ -86,6 +86,13 @@ void odeCollisionCallback(void *data, dGeomID o1, dGeomID o2) {
 
 	CollisionData *collisionData = static_cast<CollisionData*>(data);
 
+	// The fixed obstacles are in a space nested in the collision space: only
+	// test them against what overlaps them
+	if (dGeomIsSpace(o1) || dGeomIsSpace(o2)) {
+		dSpaceCollide2(o1, o2, data, odeCollisionCallback);
+		return;
+	}
+
 	// Since we are now using complex bodies, just because two bodies
 	// are connected with a joint does not mean we should ignore their
 	// collision.  Instead we need to use the ignoreCollision method define
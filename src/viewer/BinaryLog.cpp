@@ -0,0 +1,234 @@
+/*
+ * @(#) BinaryLog.cpp   1.0   Oct 19, 2026
+ *
+ * The ROBOGEN Framework
+ * Copyright © 2013-2016
+ *
+ * Laboratory of Intelligent Systems, EPFL
+ *
+ * This file is part of the ROBOGEN Framework.
+ *
+ * The ROBOGEN Framework is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License (GPL)
+ * as published by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @(#) $Id$
+ */
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+
+#include "viewer/BinaryLog.h"
+
+#define BINARY_LOG_MAGIC "RGBLOG1"
+#define BINARY_LOG_MAGIC_SIZE 8
+#define BINARY_LOG_BUFFER_SIZE (1 << 20)
+
+namespace robogen {
+
+BinaryLog::BinaryLog() : headerWritten_(false) {
+	header_.encoding = FLOAT32;
+	header_.columns = 0;
+	header_.decimation = 1;
+}
+
+BinaryLog::~BinaryLog() {
+	close();
+}
+
+bool BinaryLog::open(const std::string &fileName, Encoding encoding,
+		unsigned int decimation) {
+	file_.open(fileName.c_str(),
+			std::ios::out | std::ios::trunc | std::ios::binary);
+	if (!file_.is_open()) {
+		return false;
+	}
+	header_.encoding = encoding;
+	header_.columns = 0;
+	header_.decimation = decimation;
+	headerWritten_ = false;
+	buffer_.clear();
+	buffer_.reserve(BINARY_LOG_BUFFER_SIZE);
+	return true;
+}
+
+void BinaryLog::writeHeader() {
+	char magic[BINARY_LOG_MAGIC_SIZE] = BINARY_LOG_MAGIC;
+	boost::uint32_t fields[3] = { header_.encoding, header_.columns,
+			header_.decimation };
+	buffer_.insert(buffer_.end(), magic, magic + BINARY_LOG_MAGIC_SIZE);
+	buffer_.insert(buffer_.end(), reinterpret_cast<char *>(fields),
+			reinterpret_cast<char *>(fields) + sizeof(fields));
+	headerWritten_ = true;
+}
+
+void BinaryLog::write(const float values[], unsigned int n) {
+	if (!headerWritten_) {
+		header_.columns = n;
+		writeHeader();
+	}
+
+	// rows have the length of the first one
+	for (unsigned int i = 0; i < header_.columns; ++i) {
+		float value = (i < n) ? values[i] : 0;
+		if (header_.encoding == FLOAT16) {
+			boost::uint16_t half = floatToHalf(value);
+			const char *bytes = reinterpret_cast<const char *>(&half);
+			buffer_.insert(buffer_.end(), bytes, bytes + sizeof(half));
+		} else {
+			const char *bytes = reinterpret_cast<const char *>(&value);
+			buffer_.insert(buffer_.end(), bytes, bytes + sizeof(value));
+		}
+	}
+
+	if (buffer_.size() >= BINARY_LOG_BUFFER_SIZE) {
+		flushBuffer();
+	}
+}
+
+void BinaryLog::flushBuffer() {
+	if (!buffer_.empty()) {
+		file_.write(&buffer_[0], buffer_.size());
+		buffer_.clear();
+	}
+}
+
+bool BinaryLog::close() {
+	if (!file_.is_open()) {
+		return true;
+	}
+	if (!headerWritten_) {
+		writeHeader();
+	}
+	flushBuffer();
+	file_.close();
+	if (file_.fail()) {
+		std::cerr << "Can't write binary log" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool BinaryLog::read(const std::string &fileName, Header &header,
+		std::vector<std::vector<float> > &rows) {
+	std::ifstream file(fileName.c_str(), std::ios::in | std::ios::binary);
+	if (!file.is_open()) {
+		std::cerr << "Can't open binary log " << fileName << std::endl;
+		return false;
+	}
+
+	char magic[BINARY_LOG_MAGIC_SIZE];
+	boost::uint32_t fields[3];
+	file.read(magic, BINARY_LOG_MAGIC_SIZE);
+	file.read(reinterpret_cast<char *>(fields), sizeof(fields));
+	if (!file || std::memcmp(magic, BINARY_LOG_MAGIC,
+			BINARY_LOG_MAGIC_SIZE) != 0 || fields[0] > FLOAT16) {
+		std::cerr << fileName << " is not a binary log" << std::endl;
+		return false;
+	}
+	header.encoding = static_cast<Encoding>(fields[0]);
+	header.columns = fields[1];
+	header.decimation = fields[2];
+
+	std::vector<char> data((std::istreambuf_iterator<char>(file)),
+			std::istreambuf_iterator<char>());
+	unsigned int valueSize = (header.encoding == FLOAT16) ?
+			sizeof(boost::uint16_t) : sizeof(float);
+	unsigned int rowSize = header.columns * valueSize;
+
+	rows.clear();
+	if (rowSize == 0) {
+		return true;
+	}
+	// a log whose writing was interrupted may end with a partial row
+	rows.resize(data.size() / rowSize, std::vector<float>(header.columns));
+	const char *value = data.empty() ? NULL : &data[0];
+	for (unsigned int i = 0; i < rows.size(); ++i) {
+		for (unsigned int j = 0; j < header.columns; ++j) {
+			if (header.encoding == FLOAT16) {
+				boost::uint16_t half;
+				std::memcpy(&half, value, sizeof(half));
+				rows[i][j] = halfToFloat(half);
+			} else {
+				std::memcpy(&rows[i][j], value, sizeof(float));
+			}
+			value += valueSize;
+		}
+	}
+	return true;
+}
+
+boost::uint16_t BinaryLog::floatToHalf(float value) {
+	boost::uint32_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+
+	boost::uint16_t sign = (bits >> 16) & 0x8000;
+	int exponent = static_cast<int>((bits >> 23) & 0xff);
+	boost::uint32_t mantissa = bits & 0x7fffff;
+
+	// infinity and NaN
+	if (exponent == 0xff) {
+		return sign | 0x7c00 | (mantissa ? 0x200 : 0);
+	}
+
+	exponent += 15 - 127;
+	if (exponent >= 0x1f) {
+		return sign | 0x7c00;
+	}
+
+	// rounds to nearest, ties to even, carrying into the exponent
+	if (exponent <= 0) {
+		if (exponent < -10) {
+			return sign;
+		}
+		mantissa |= 0x800000;
+		unsigned int shift = 14 - exponent;
+		boost::uint32_t half = mantissa >> shift;
+		boost::uint32_t rest = mantissa & ((1u << shift) - 1);
+		boost::uint32_t halfway = 1u << (shift - 1);
+		if (rest > halfway || (rest == halfway && (half & 1))) {
+			half++;
+		}
+		return sign | half;
+	}
+
+	boost::uint32_t half = (exponent << 10) | (mantissa >> 13);
+	boost::uint32_t rest = mantissa & 0x1fff;
+	if (rest > 0x1000 || (rest == 0x1000 && (half & 1))) {
+		half++;
+	}
+	return sign | half;
+}
+
+float BinaryLog::halfToFloat(boost::uint16_t value) {
+	boost::uint32_t sign = static_cast<boost::uint32_t>(value & 0x8000) << 16;
+	boost::uint32_t exponent = (value >> 10) & 0x1f;
+	boost::uint32_t mantissa = value & 0x3ff;
+
+	if (exponent == 0) {
+		float result = std::ldexp(static_cast<float>(mantissa), -24);
+		return sign ? -result : result;
+	}
+
+	boost::uint32_t bits;
+	if (exponent == 0x1f) {
+		bits = sign | 0x7f800000 | (mantissa << 13);
+	} else {
+		bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+	}
+	float result;
+	std::memcpy(&result, &bits, sizeof(result));
+	return result;
+}
+
+}
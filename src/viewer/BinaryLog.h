@@ -0,0 +1,117 @@
+/*
+ * @(#) BinaryLog.h   1.0   Oct 19, 2026
+ *
+ * The ROBOGEN Framework
+ * Copyright © 2013-2016
+ *
+ * Laboratory of Intelligent Systems, EPFL
+ *
+ * This file is part of the ROBOGEN Framework.
+ *
+ * The ROBOGEN Framework is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License (GPL)
+ * as published by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @(#) $Id$
+ */
+
+#ifndef BINARYLOG_H_
+#define BINARYLOG_H_
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <boost/cstdint.hpp>
+
+namespace robogen {
+
+/**
+ * \brief Binary log of one signal sampled at every simulation step
+ *
+ * The file starts with a header: the 8 bytes "RGBLOG1\0", the encoding of the
+ * values (uint32, 0 for float32, 1 for float16), the number of columns and
+ * the decimation (uint32 each, the log keeps one row out of this many). Then
+ * come the rows, all columns of a row one after the other. Numbers are in
+ * the byte order of the machine that wrote the log.
+ *
+ * Rows are accumulated in a large buffer, written once full.
+ */
+class BinaryLog {
+public:
+
+	enum Encoding {
+		FLOAT32 = 0,
+		FLOAT16 = 1
+	};
+
+	struct Header {
+		Encoding encoding;
+		unsigned int columns;
+		unsigned int decimation;
+	};
+
+	BinaryLog();
+
+	/**
+	 * Writes the rest of the buffer and closes the file
+	 */
+	~BinaryLog();
+
+	/**
+	 * Opens a log for writing. The number of columns is the length of the
+	 * first row.
+	 * @return true if successful
+	 */
+	bool open(const std::string &fileName, Encoding encoding,
+			unsigned int decimation);
+
+	/**
+	 * Appends a row
+	 */
+	void write(const float values[], unsigned int n);
+
+	/**
+	 * Writes the rest of the buffer and closes the file
+	 * @return false if writing failed
+	 */
+	bool close();
+
+	/**
+	 * Reads a whole log
+	 * @param rows read rows, each with header.columns values
+	 * @return true if successful
+	 */
+	static bool read(const std::string &fileName, Header &header,
+			std::vector<std::vector<float> > &rows);
+
+	static boost::uint16_t floatToHalf(float value);
+
+	static float halfToFloat(boost::uint16_t value);
+
+private:
+
+	void writeHeader();
+
+	void flushBuffer();
+
+	std::ofstream file_;
+
+	std::vector<char> buffer_;
+
+	Header header_;
+
+	bool headerWritten_;
+};
+
+}
+
+#endif /* BINARYLOG_H_ */
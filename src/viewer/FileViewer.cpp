@@ -27,6 +27,7 @@
  *
  * @(#) $Id$
  */
+#include <algorithm>
 #include <cstdlib>
 #include <fstream>
 #include <iostream>
@@ -169,6 +170,8 @@ std::string EMSCRIPTEN_KEEPALIVE simulationViewer(int tab, std::string robotFile
 
 
 #else
+#include "model/objects/BoxObstacle.h"
+#include "viewer/BinaryLog.h"
 #include "viewer/Viewer.h"
 #endif
 
@@ -214,7 +217,19 @@ void printUsage(char *argv[]) {
 			<< "          Starts the simulation paused." << std::endl
 			<< std::endl << "      --output <DIR, STRING>" << std::endl
 			<< "          Generates output files: sensor logs and "
-			<< "Arduino files." << std::endl << std::endl << "      --overwrite"
+			<< "Arduino files." << std::endl << std::endl
+			<< "      --binary-log" << std::endl
+			<< "          Write the trajectory, sensor and motor logs as "
+			<< "binary files (only" << std::endl
+			<< "          valid if --output is specified). "
+			<< "robogen-log-convert turns them into" << std::endl
+			<< "          the usual text files." << std::endl << std::endl
+			<< "      --log-decimation <N, INTEGER>" << std::endl
+			<< "          Only log every <N>th step (default is 1)."
+			<< std::endl << std::endl
+			<< "      --half-precision" << std::endl
+			<< "          Store the values of binary logs as 16 bit floats."
+			<< std::endl << std::endl << "      --overwrite"
 			<< std::endl
 			<< "          Overwrite existing output file directory if it "
 			<< "exists." << std::endl
@@ -226,6 +241,17 @@ void printUsage(char *argv[]) {
 			<< std::endl
 			<< "          Saves every <N>th simulation step in directory "
 			<< "<DIR>." << std::endl << std::endl
+			<< "      --record-pipe <N, INTEGER> <COMMAND, STRING>"
+			<< std::endl
+			<< "          Like --record, but pipe the frames as raw RGB "
+			<< "video (rgb24) to the" << std::endl
+			<< "          standard input of <COMMAND>, where %w and %h "
+			<< "are replaced by the" << std::endl
+			<< "          frame size, e.g. \"ffmpeg -f rawvideo -pix_fmt "
+			<< "rgb24 -s %wx%h -r 30" << std::endl
+			<< "          -i - video.mp4\". The video has "
+			<< "1 / (time step * <N>) frames per" << std::endl
+			<< "          second of simulation." << std::endl << std::endl
 			<< "      --seed <A, INTEGER> " << std::endl
 			<< "          Set the seed A for the random number generator "
 			<< "for noisy evaluations." << std::endl << std::endl
@@ -237,6 +263,21 @@ void printUsage(char *argv[]) {
 			<< "          Record json file for use with the WebGL "
 			<< "visualizer (only valid if --output is specified)." << std::endl
 			<< std::endl
+			<< "      --webgl-binary"
+			<< std::endl
+			<< "          Like --webgl, but record the compact binary replay "
+			<< "webGL.bin instead." << std::endl
+			<< "          robogen-log-convert turns it into webGL.json."
+			<< std::endl << std::endl
+			<< "      --replay <DIR, STRING>" << std::endl
+			<< "          Replay the state log recorded in <DIR> by a run "
+			<< "with --output and" << std::endl
+			<< "          --binary-log, for the same robot, configuration "
+			<< "and start position," << std::endl
+			<< "          without simulating again. Left/Right seek by one "
+			<< "second, ,/. step" << std::endl
+			<< "          by one frame, [/] halve/double the speed and Home "
+			<< "restarts." << std::endl << std::endl
 			<< "      Notes: " << std::endl
 			<< "        (a) Without visualization you cannot record frames,"
 			<< " and setting speed has no effect "
@@ -253,6 +294,128 @@ void printHelp() {
 	ConfigurationReader::parseConfigurationFile("help");
 }
 
+#ifndef EMSCRIPTEN
+/**
+ * Sets the robot and environment to a row of the state log
+ */
+void setState(const std::vector<float> &state,
+		boost::shared_ptr<Robot> robot,
+		boost::shared_ptr<Environment> environment) {
+	unsigned int index = 1;
+	const std::vector<boost::shared_ptr<Model> >& bodyParts =
+			robot->getBodyParts();
+	for (unsigned int i = 0; i < bodyParts.size(); ++i) {
+		std::vector<boost::shared_ptr<SimpleBody> > bodies =
+				bodyParts[i]->getBodies();
+		for (unsigned int j = 0; j < bodies.size(); ++j) {
+			bodies[j]->setPosition(osg::Vec3(state[index], state[index + 1],
+					state[index + 2]));
+			bodies[j]->setAttitude(osg::Quat(state[index + 3],
+					state[index + 4], state[index + 5], state[index + 6]));
+			index += 7;
+		}
+	}
+	std::vector<boost::shared_ptr<Obstacle> > obstacles =
+			environment->getObstacles();
+	for (unsigned int i = 0; i < obstacles.size(); ++i) {
+		boost::shared_ptr<BoxObstacle> box =
+				boost::dynamic_pointer_cast<BoxObstacle>(obstacles[i]);
+		if (box) {
+			box->setPosition(osg::Vec3(state[index], state[index + 1],
+					state[index + 2]));
+			box->setAttitude(osg::Quat(state[index + 3], state[index + 4],
+					state[index + 5], state[index + 6]));
+		}
+		index += 7;
+	}
+	const std::vector<boost::shared_ptr<LightSource> >& lightSources =
+			environment->getLightSources();
+	for (unsigned int i = 0; i < lightSources.size(); ++i) {
+		lightSources[i]->setPosition(osg::Vec3(state[index],
+				state[index + 1], state[index + 2]));
+		index += 3;
+	}
+}
+
+/**
+ * Shows the state log of a previous run instead of simulating: the robot and
+ * environment are built as for a simulation, then their bodies are moved to
+ * the recorded states, which the render models display.
+ * @param stopAtEnd quit once the last frame is shown, as when recording
+ * @return true if successful
+ */
+bool runReplay(boost::shared_ptr<Scenario> scenario,
+		boost::shared_ptr<RobogenConfig> configuration,
+		const robogenMessage::Robot &robotMessage, Viewer *viewer,
+		const std::string &replayDirectory, bool stopAtEnd) {
+
+	std::string stateLogPath = replayDirectory + "/" +
+			FileViewerLog::STATE_LOG_FILE;
+	BinaryLog::Header header;
+	std::vector<std::vector<float> > states;
+	if (!BinaryLog::read(stateLogPath, header, states)) {
+		return false;
+	}
+	if (states.empty()) {
+		std::cerr << "The state log " << stateLogPath << " is empty"
+				<< std::endl;
+		return false;
+	}
+
+	dInitODE();
+	odeWorld = dWorldCreate();
+	dSpaceID odeSpace = dSimpleSpaceCreate(0);
+	odeContactGroup = dJointGroupCreate(0);
+
+	bool success = true;
+	{
+		boost::shared_ptr<Robot> robot(new Robot);
+		if (!robot->init(odeWorld, odeSpace, robotMessage)) {
+			std::cout << "Problems decoding the robot. Quit." << std::endl;
+			success = false;
+		} else if (!scenario->init(odeWorld, odeSpace, robot)) {
+			std::cout << "Cannot initialize scenario. Quit." << std::endl;
+			success = false;
+		} else if (header.columns != FileViewerLog::getStateColumns(robot,
+				scenario->getEnvironment())) {
+			std::cerr << "The state log " << stateLogPath << " was not "
+					<< "recorded for this robot and configuration"
+					<< std::endl;
+			success = false;
+		} else if (!viewer->configureScene(robot->getBodyParts(),
+				scenario)) {
+			std::cout << "Cannot configure scene. Quit." << std::endl;
+			success = false;
+		}
+
+		if (success) {
+			double frameLength = header.decimation *
+					configuration->getTimeStepLength();
+			double duration = (states.size() - 1) * frameLength;
+			double time = 0;
+			while (!viewer->done()) {
+				unsigned int frame = std::min(
+						(unsigned int) (time / frameLength + 0.5),
+						(unsigned int) states.size() - 1);
+				setState(states[frame], robot, scenario->getEnvironment());
+				if (stopAtEnd && frame == states.size() - 1) {
+					break;
+				}
+				viewer->replayFrame(time, frameLength, duration);
+			}
+		}
+	}
+
+	scenario->prune();
+	dJointGroupDestroy(odeContactGroup);
+	dSpaceDestroy(odeSpace);
+	dWorldDestroy(odeWorld);
+	dCloseODE();
+
+	return success;
+}
+#endif
+
 /**
  * Decodes a robot saved on file and visualize it
  */
@@ -289,13 +452,21 @@ int main(int argc, char *argv[]) {
 	unsigned int recordFrequency = 0;
 	bool recording = false;
 	std::string recordDirectoryName = "";
+	std::string recordCommand = "";
 
 	bool writeLog = false;
 	char *outputDirectoryName;
 
 	bool writeWebGL = false;
+	bool webGLBinary = false;
 	bool overwrite = false;
 
+	std::string replayDirectory = "";
+
+	bool binaryLog = false;
+	unsigned int logDecimation = 1;
+	bool halfPrecision = false;
+
 	int currentArg = 3;
 	if (argc >= 4 && !boost::starts_with(argv[3], "--")) {
 		std::stringstream ss(argv[3]);
@@ -362,6 +533,25 @@ int main(int argc, char *argv[]) {
 				boost::filesystem::create_directories(recordDirectory);
 			}
 
+		} else if (std::string("--record-pipe").compare(argv[currentArg])
+				== 0) {
+			if (argc < (currentArg + 3)) {
+				std::cerr << "In order to pipe frames, must provide frame "
+						<< "frequency and encoder command."
+						<< std::endl;
+				exitRobogen(EXIT_FAILURE);
+			}
+			recording = true;
+			currentArg++;
+			std::stringstream ss(argv[currentArg]);
+			ss >> recordFrequency;
+			if (ss.fail()) {
+				std::cerr << "Specified record frequency \"" << argv[currentArg]
+						<< "\" is not an integer. Aborting..." << std::endl;
+				exitRobogen(EXIT_FAILURE);
+			}
+			currentArg++;
+			recordCommand = std::string(argv[currentArg]);
 		} else if (std::string("--output").compare(argv[currentArg]) == 0) {
 			if (argc < (currentArg + 2)) {
 				std::cerr << "In order to write output files, must provide "
@@ -401,12 +591,52 @@ int main(int argc, char *argv[]) {
 			ss >> seed;
 		} else if (std::string("--webgl").compare(argv[currentArg]) == 0) {
 			writeWebGL = true;
+		} else if (std::string("--webgl-binary").compare(argv[currentArg])
+				== 0) {
+			writeWebGL = true;
+			webGLBinary = true;
 		} else if (std::string("--overwrite").compare(argv[currentArg]) == 0) {
 			overwrite = true;
+		} else if (std::string("--binary-log").compare(argv[currentArg])
+				== 0) {
+			binaryLog = true;
+		} else if (std::string("--log-decimation").compare(argv[currentArg])
+				== 0) {
+			if (argc < (currentArg + 2)) {
+				std::cerr << "Must specify a decimation with option "
+						<< "--log-decimation." << std::endl;
+				exitRobogen(EXIT_FAILURE);
+			}
+			currentArg++;
+			std::stringstream ss(argv[currentArg]);
+			ss >> logDecimation;
+			if (ss.fail() || logDecimation == 0) {
+				std::cerr << "Specified log decimation \"" << argv[currentArg]
+						<< "\" is not a positive integer. Aborting..."
+						<< std::endl;
+				exitRobogen(EXIT_FAILURE);
+			}
+		} else if (std::string("--half-precision").compare(argv[currentArg])
+				== 0) {
+			halfPrecision = true;
+		} else if (std::string("--replay").compare(argv[currentArg]) == 0) {
+			if (argc < (currentArg + 2)) {
+				std::cerr << "Must specify a log directory with option "
+						<< "--replay." << std::endl;
+				exitRobogen(EXIT_FAILURE);
+			}
+			currentArg++;
+			replayDirectory = argv[currentArg];
 		}
 
 	}
 
+	if (!recordCommand.empty() && !recordDirectoryName.empty()) {
+		std::cerr << "Cannot both record frames to a directory and pipe them."
+				<< std::endl;
+		exitRobogen(EXIT_FAILURE);
+	}
+
 	if (recording && !visualize) {
 		std::cerr << "Cannot record without visualization enabled!" <<
 				std::endl;
@@ -425,6 +655,24 @@ int main(int argc, char *argv[]) {
 		exitRobogen(EXIT_FAILURE);
 	}
 
+	if ((binaryLog || logDecimation > 1) && (!writeLog)) {
+		std::cerr << "Cannot set up logs without specifying output "
+				<< "directory." << std::endl;
+		exitRobogen(EXIT_FAILURE);
+	}
+
+	if (halfPrecision && (!binaryLog)) {
+		std::cerr << "Half precision is only available for binary logs."
+				<< std::endl;
+		exitRobogen(EXIT_FAILURE);
+	}
+
+	if (!replayDirectory.empty() && (!visualize || writeLog)) {
+		std::cerr << "A replay is only visualized, it can't be run without "
+				<< "visualization or write output files." << std::endl;
+		exitRobogen(EXIT_FAILURE);
+	}
+
 	if (overwrite && (!writeLog)) {
 		std::cerr << "No output directory was specified, so there is " <<
 				"nothing to overwrite." << std::endl;
@@ -457,6 +705,18 @@ int main(int argc, char *argv[]) {
 	}
 	scenario->setStartingPosition(desiredStart);
 
+	if (!replayDirectory.empty()) {
+		bool success;
+		{
+			// the viewer writes the last recorded frames when destroyed
+			Viewer viewer(startPaused, debug, speed, recording,
+					recordFrequency, recordDirectoryName, recordCommand);
+			success = runReplay(scenario, configuration, robotMessage,
+					&viewer, replayDirectory, recording);
+		}
+		exitRobogen(success ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
+
 	// ---------------------------------------
 	// Set up log files
 	// ---------------------------------------
@@ -471,7 +731,8 @@ int main(int argc, char *argv[]) {
 						configuration->getLightSourceFile(),
 						configuration->getScenarioFile(),
 						std::string(outputDirectoryName), overwrite,
-						writeWebGL));
+						writeWebGL, binaryLog, logDecimation, halfPrecision,
+						webGLBinary));
 	}
 
 	// ---------------------------------------
@@ -481,7 +742,7 @@ int main(int argc, char *argv[]) {
 	if (visualize) {
 		viewer = new Viewer(startPaused, debug,
 				speed, recording, recordFrequency,
-				recordDirectoryName);
+				recordDirectoryName, recordCommand);
 	}
 
 	unsigned int simulationResult = runSimulations(scenario, configuration,
@@ -41,6 +41,8 @@
 #include "arduino/ArduinoNNCompiler.h"
 #include "printing/BodyCompiler.h"
 #include "model/sensors/Sensor.h"
+#include "model/SimpleBody.h"
+#include "scenario/Environment.h"
 
 #define LOG_DIRECTORY_PREFIX "results/FileViewer_"
 #define LOG_DIRECTORY_FACET "%Y%m%d-%H%M%S"
@@ -48,15 +50,21 @@
 #define SENSOR_LABEL_FILE "sensorLabels.txt"
 #define SENSOR_LOG_FILE "sensorLog.txt"
 #define MOTOR_LOG_FILE "motorLog.txt"
+#define TRAJECTORY_BINARY_LOG_FILE "trajectoryLog.bin"
+#define SENSOR_BINARY_LOG_FILE "sensorLog.bin"
+#define MOTOR_BINARY_LOG_FILE "motorLog.bin"
 #define TIME_LOG_FILE "timeLog.txt"
 #define ARDUINO_NN_FILE "NeuralNetwork.h"
 #define BODY_FILE "bodyRepresentation.txt"
 #define LOG_COL_WIDTH 12
 #define OCTAVE_SCRIPT "robogenPlot.m"
 #define WEBGL_FILE "webGL.json"
+#define WEBGL_BINARY_FILE "webGL.bin"
 
 namespace robogen{
 
+const char *FileViewerLog::STATE_LOG_FILE = "stateLog.bin";
+
 FileViewerLog::FileViewerLog(std::string robotFile,
 		std::string confFile,
 		std::string obstacleFile,
@@ -65,7 +73,15 @@ FileViewerLog::FileViewerLog(std::string robotFile,
 		std::string scenarioFile,
 		std::string logFolder,
 		bool overwrite,
-		bool writeWebGL) :
+		bool writeWebGL,
+		bool binaryLog,
+		unsigned int decimation,
+		bool halfPrecision,
+		bool webGLBinary) :
+			positionCount_(0),
+			sensorCount_(0),
+			motorCount_(0),
+			stateCount_(0),
 			robotFile_(robotFile),
 			confFile_(confFile),
 			obstacleFile_(obstacleFile),
@@ -74,56 +90,125 @@ FileViewerLog::FileViewerLog(std::string robotFile,
 			scenarioFile_(scenarioFile),
 			logFolder_(logFolder),
 			overwrite_(overwrite),
-			writeWebGL_(writeWebGL) {
+			writeWebGL_(writeWebGL),
+			webGLBinary_(webGLBinary),
+			binaryLog_(binaryLog),
+			decimation_(decimation > 0 ? decimation : 1),
+			halfPrecision_(halfPrecision),
+			stateOnly_(false),
+			lastSuffix_(0) {
+}
+
+FileViewerLog::FileViewerLog(std::string logFolder, unsigned int decimation) :
+			positionCount_(0),
+			sensorCount_(0),
+			motorCount_(0),
+			stateCount_(0),
+			logFolder_(logFolder),
+			overwrite_(false),
+			writeWebGL_(false),
+			webGLBinary_(false),
+			binaryLog_(true),
+			decimation_(decimation > 0 ? decimation : 1),
+			halfPrecision_(false),
+			stateOnly_(true),
+			lastSuffix_(0) {
 }
 
 bool FileViewerLog::init(boost::shared_ptr<Robot> robot,
 		boost::shared_ptr<RobogenConfig> config) {
 	std::string tempPath = logFolder_;
-	int curIndex = 0;
-
-	if (overwrite_) {
-		boost::filesystem::remove_all(tempPath);
-	} else {
-		while (boost::filesystem::is_directory(tempPath)) {
-			std::stringstream newPath;
-			newPath << logFolder_ << "_" << ++curIndex;
-			tempPath = newPath.str();
-		}
-	}
-
-	logPath_ = tempPath;
-	boost::filesystem::path logPath(logPath_);
 
 	try{
-		boost::filesystem::create_directories(logPath);
+		if (overwrite_) {
+			boost::filesystem::remove_all(tempPath);
+			boost::filesystem::create_directories(tempPath);
+		} else {
+			boost::filesystem::path parent =
+					boost::filesystem::path(logFolder_).parent_path();
+			if (!parent.empty()) {
+				boost::filesystem::create_directories(parent);
+			}
+			// create_directory fails if the directory exists, also when
+			// another process has just created it, so no two logs can end
+			// up in the same directory. The suffixes the previous trials
+			// took are not tried again.
+			while (!boost::filesystem::create_directory(tempPath)) {
+				std::stringstream newPath;
+				newPath << logFolder_ << "_" << ++lastSuffix_;
+				tempPath = newPath.str();
+			}
+		}
 	} catch(const boost::filesystem::filesystem_error &err){
 		std::cout << err.what() << std::endl << "Evolver log can't create log"\
 				" directory.\n" << std::endl;
 		return false;
 	}
 
+	logPath_ = tempPath;
 
-	// open trajectory log
-	std::string trajectoryLogPath = logPath_ + "/" + TRAJECTORY_LOG_FILE;
-	trajectoryLog_.open(trajectoryLogPath.c_str());
-	if (!trajectoryLog_.is_open()){
-		std::cout << "Can't open trajectory log file" << std::endl;
-		return false;
-	}
-	// open sensor log
-	std::string sensorLogPath = logPath_ + "/" + SENSOR_LOG_FILE;
-	sensorLog_.open(sensorLogPath.c_str());
-	if (!sensorLog_.is_open()){
-		std::cout << "Can't open sensor log file" << std::endl;
-		return false;
+
+	if (stateOnly_) {
+		// a log directory for each trial
+		stateBinaryLog_.close();
+		stateCount_ = 0;
+		if (!stateBinaryLog_.open(logPath_ + "/" + STATE_LOG_FILE,
+				BinaryLog::FLOAT32, decimation_)) {
+			std::cout << "Can't open state log file" << std::endl;
+			return false;
+		}
+		return true;
 	}
-	// open motor log
-	std::string motorLogPath = logPath_ + "/" + MOTOR_LOG_FILE;
-	motorLog_.open(motorLogPath.c_str());
-	if (!motorLog_.is_open()){
-		std::cout << "Can't open motor log file" << std::endl;
-		return false;
+
+	if (binaryLog_) {
+		BinaryLog::Encoding encoding = halfPrecision_ ? BinaryLog::FLOAT16 :
+				BinaryLog::FLOAT32;
+		// open trajectory log
+		if (!trajectoryBinaryLog_.open(logPath_ + "/" +
+				TRAJECTORY_BINARY_LOG_FILE, encoding, decimation_)) {
+			std::cout << "Can't open trajectory log file" << std::endl;
+			return false;
+		}
+		// open sensor log
+		if (!sensorBinaryLog_.open(logPath_ + "/" + SENSOR_BINARY_LOG_FILE,
+				encoding, decimation_)) {
+			std::cout << "Can't open sensor log file" << std::endl;
+			return false;
+		}
+		// open motor log
+		if (!motorBinaryLog_.open(logPath_ + "/" + MOTOR_BINARY_LOG_FILE,
+				encoding, decimation_)) {
+			std::cout << "Can't open motor log file" << std::endl;
+			return false;
+		}
+		// open state log, positions need more than half precision
+		if (!stateBinaryLog_.open(logPath_ + "/" + STATE_LOG_FILE,
+				BinaryLog::FLOAT32, decimation_)) {
+			std::cout << "Can't open state log file" << std::endl;
+			return false;
+		}
+	} else {
+		// open trajectory log
+		std::string trajectoryLogPath = logPath_ + "/" + TRAJECTORY_LOG_FILE;
+		trajectoryLog_.open(trajectoryLogPath.c_str());
+		if (!trajectoryLog_.is_open()){
+			std::cout << "Can't open trajectory log file" << std::endl;
+			return false;
+		}
+		// open sensor log
+		std::string sensorLogPath = logPath_ + "/" + SENSOR_LOG_FILE;
+		sensorLog_.open(sensorLogPath.c_str());
+		if (!sensorLog_.is_open()){
+			std::cout << "Can't open sensor log file" << std::endl;
+			return false;
+		}
+		// open motor log
+		std::string motorLogPath = logPath_ + "/" + MOTOR_LOG_FILE;
+		motorLog_.open(motorLogPath.c_str());
+		if (!motorLog_.is_open()){
+			std::cout << "Can't open motor log file" << std::endl;
+			return false;
+		}
 	}
 
 	// compile neural network representation for Arduino
@@ -271,25 +356,107 @@ bool FileViewerLog::init(boost::shared_ptr<Robot> robot,
 
 FileViewerLog::~FileViewerLog(){}
 
+// Lines end with '\n' rather than std::endl: flushing every step costs more
+// than the simulation itself
+
 void FileViewerLog::logPosition(osg::Vec3 pos){
+	if (stateOnly_ || (positionCount_++ % decimation_) != 0)
+		return;
+	if (binaryLog_) {
+		float position[2] = { pos.x(), pos.y() };
+		trajectoryBinaryLog_.write(position, 2);
+		return;
+	}
 	trajectoryLog_ << std::setw(LOG_COL_WIDTH) << pos.x() << " " << pos.y() <<
-			std::endl;
+			'\n';
 }
 
 void FileViewerLog::logSensors(float sensorValues[], int n){
+	if (stateOnly_ || (sensorCount_++ % decimation_) != 0)
+		return;
+	if (binaryLog_) {
+		sensorBinaryLog_.write(sensorValues, n);
+		return;
+	}
 	for (int i=0; i<n; i++)
 		sensorLog_ << std::setw(LOG_COL_WIDTH) << sensorValues[i] << " ";
-	sensorLog_ << std::endl;
+	sensorLog_ << '\n';
 }
 
 void FileViewerLog::logMotors(float motorValues[], int n){
+	if (stateOnly_ || (motorCount_++ % decimation_) != 0)
+		return;
+	if (binaryLog_) {
+		motorBinaryLog_.write(motorValues, n);
+		return;
+	}
 	for (int i=0; i<n; i++)
 		motorLog_ << std::setw(LOG_COL_WIDTH) << motorValues[i] << " ";
-	motorLog_ << std::endl;
+	motorLog_ << '\n';
+}
+
+void FileViewerLog::logState(double time, boost::shared_ptr<Robot> robot,
+		boost::shared_ptr<Environment> environment) {
+	if (!binaryLog_ || (stateCount_++ % decimation_) != 0)
+		return;
+
+	state_.clear();
+	state_.push_back(time);
+	const std::vector<boost::shared_ptr<Model> >& bodyParts =
+			robot->getBodyParts();
+	for (unsigned int i = 0; i < bodyParts.size(); ++i) {
+		std::vector<boost::shared_ptr<SimpleBody> > bodies =
+				bodyParts[i]->getBodies();
+		for (unsigned int j = 0; j < bodies.size(); ++j) {
+			osg::Vec3 position = bodies[j]->getPosition();
+			osg::Quat attitude = bodies[j]->getAttitude();
+			state_.push_back(position.x());
+			state_.push_back(position.y());
+			state_.push_back(position.z());
+			state_.push_back(attitude.x());
+			state_.push_back(attitude.y());
+			state_.push_back(attitude.z());
+			state_.push_back(attitude.w());
+		}
+	}
+	std::vector<boost::shared_ptr<Obstacle> > obstacles =
+			environment->getObstacles();
+	for (unsigned int i = 0; i < obstacles.size(); ++i) {
+		osg::Vec3 position = obstacles[i]->getPosition();
+		osg::Quat attitude = obstacles[i]->getAttitude();
+		state_.push_back(position.x());
+		state_.push_back(position.y());
+		state_.push_back(position.z());
+		state_.push_back(attitude.x());
+		state_.push_back(attitude.y());
+		state_.push_back(attitude.z());
+		state_.push_back(attitude.w());
+	}
+	const std::vector<boost::shared_ptr<LightSource> >& lightSources =
+			environment->getLightSources();
+	for (unsigned int i = 0; i < lightSources.size(); ++i) {
+		osg::Vec3 position = lightSources[i]->getPosition();
+		state_.push_back(position.x());
+		state_.push_back(position.y());
+		state_.push_back(position.z());
+	}
+	stateBinaryLog_.write(&state_[0], state_.size());
+}
+
+unsigned int FileViewerLog::getStateColumns(boost::shared_ptr<Robot> robot,
+		boost::shared_ptr<Environment> environment) {
+	unsigned int numBodies = 0;
+	const std::vector<boost::shared_ptr<Model> >& bodyParts =
+			robot->getBodyParts();
+	for (unsigned int i = 0; i < bodyParts.size(); ++i) {
+		numBodies += bodyParts[i]->getBodies().size();
+	}
+	return 1 + 7 * (numBodies + environment->getObstacles().size()) +
+			3 * environment->getLightSources().size();
 }
 
 std::string FileViewerLog::getWebGLFileName() {
-	return logPath_ + "/" + WEBGL_FILE;
+	return logPath_ + "/" + (webGLBinary_ ? WEBGL_BINARY_FILE : WEBGL_FILE);
 }
 
 }
@@ -39,9 +39,12 @@
 #include <boost/shared_ptr.hpp>
 #include "Robot.h"
 #include "config/RobogenConfig.h"
+#include "viewer/BinaryLog.h"
 
 namespace robogen{
 
+class Environment;
+
 /**
  * \brief Class for logging a robot's behavior
  *
@@ -51,6 +54,14 @@ namespace robogen{
  * i.e. a trajectory log and a log of the motor and sensor values.
  * Furthermore, the directory will contain all the inputs, so that the given
  * run can be repeated at any time.
+ *
+ * The trajectory, sensor and motor logs are either text files or binary logs,
+ * which robogen-log-convert turns into the text files.
+ *
+ * Binary logs come with the state log, which the file viewer replays without
+ * simulating again. Each of its rows holds the time, the position (x, y, z)
+ * and attitude (x, y, z, w) of each body of each body part, then of each
+ * obstacle, then the position of each light source, always as float32.
  */
 class FileViewerLog{
 public:
@@ -63,7 +74,17 @@ public:
 		std::string scenarioFile,
 		std::string logFolder,
 		bool overwrite = false,
-		bool writeWebGL = false);
+		bool writeWebGL = false,
+		bool binaryLog = false,
+		unsigned int decimation = 1,
+		bool halfPrecision = false,
+		bool webGLBinary = false);
+
+	/**
+	 * Only writes the state log, for instance to replay what a server
+	 * evaluated
+	 */
+	FileViewerLog(std::string logFolder, unsigned int decimation = 1);
 
 	/**
 	 * Initializes the directory, copies the inputs and opens the log files for
@@ -74,12 +95,13 @@ public:
 			boost::shared_ptr<RobogenConfig> config);
 
 	/**
-	 * Closes all open file streams
+	 * Closes all open file streams, writing the rest of the binary logs
 	 */
 	~FileViewerLog();
 
 	/**
 	 * Writes x and y of passed position to trajectory log file
+	 * Like the sensor and motor logs, only logs one call out of decimation.
 	 */
 	void logPosition(osg::Vec3);
 
@@ -93,14 +115,54 @@ public:
 	 */
 	void logMotors(float motorValues[], int n);
 
+	/**
+	 * Writes the state of the robot and environment to the state log, if
+	 * writing binary logs
+	 */
+	void logState(double time, boost::shared_ptr<Robot> robot,
+			boost::shared_ptr<Environment> environment);
+
+	/**
+	 * @return the number of columns of the state log
+	 */
+	static unsigned int getStateColumns(boost::shared_ptr<Robot> robot,
+			boost::shared_ptr<Environment> environment);
+
+	/**
+	 * Name of the state log in the log directory
+	 */
+	static const char *STATE_LOG_FILE;
+
 	inline bool isWriteWebGL() { return writeWebGL_; }
 
+	inline bool isWriteWebGLBinary() { return webGLBinary_; }
+
 	std::string getWebGLFileName();
 
 private:
 	std::ofstream trajectoryLog_;
 	std::ofstream sensorLog_;
 	std::ofstream motorLog_;
+
+	BinaryLog trajectoryBinaryLog_;
+	BinaryLog sensorBinaryLog_;
+	BinaryLog motorBinaryLog_;
+	BinaryLog stateBinaryLog_;
+
+	/**
+	 * Number of calls to logPosition, logSensors, logMotors and logState so
+	 * far
+	 */
+	unsigned int positionCount_;
+	unsigned int sensorCount_;
+	unsigned int motorCount_;
+	unsigned int stateCount_;
+
+	/**
+	 * Row of the state log
+	 */
+	std::vector<float> state_;
+
 	/**
 	 * Log directory
 	 */
@@ -117,6 +179,32 @@ private:
 	bool overwrite_;
 	bool writeWebGL_;
 
+	/**
+	 * Write the binary WebGL replay instead of the JSON one
+	 */
+	bool webGLBinary_;
+
+	/**
+	 * Write binary logs instead of text ones
+	 */
+	bool binaryLog_;
+	/**
+	 * Only log one step out of this many
+	 */
+	unsigned int decimation_;
+	/**
+	 * Store binary logs as float16
+	 */
+	bool halfPrecision_;
+	/**
+	 * Only write the state log, the inputs are not copied
+	 */
+	bool stateOnly_;
+	/**
+	 * Last suffix appended to logFolder_ to find a free directory
+	 */
+	unsigned int lastSuffix_;
+
 };
 
 }
@@ -0,0 +1,208 @@
+/*
+ * @(#) FrameRecorder.cpp   1.0   Oct 19, 2026
+ *
+ * The ROBOGEN Framework
+ * Copyright © 2013-2016
+ *
+ * Laboratory of Intelligent Systems, EPFL
+ *
+ * This file is part of the ROBOGEN Framework.
+ *
+ * The ROBOGEN Framework is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License (GPL)
+ * as published by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @(#) $Id$
+ */
+
+#include <iostream>
+#include <sstream>
+#include <boost/algorithm/string/replace.hpp>
+#include <boost/bind.hpp>
+#include <boost/format.hpp>
+#include <boost/lexical_cast.hpp>
+#include <osgDB/WriteFile>
+#include "viewer/FrameRecorder.h"
+
+#ifndef WIN32
+#include <csignal>
+#endif
+
+namespace robogen {
+
+FrameRecorder *FrameRecorder::toDirectory(const std::string &directory) {
+	// leave a core to the simulation and one to the rendering
+	unsigned int numWorkers = boost::thread::hardware_concurrency();
+	numWorkers = (numWorkers > 3) ? numWorkers - 2 : 1;
+	return new FrameRecorder(directory, "", numWorkers);
+}
+
+FrameRecorder *FrameRecorder::toCommand(const std::string &command) {
+	// the encoder gets the frames in order from a single worker, and does
+	// its own multithreading
+	return new FrameRecorder("", command, 1);
+}
+
+FrameRecorder::FrameRecorder(const std::string &directory,
+		const std::string &command, unsigned int numWorkers) :
+		directory_(directory), command_(command), pipe_(NULL), width_(0),
+		height_(0), frameCount_(0), closing_(false), closed_(false),
+		failed_(false) {
+	for (unsigned int i = 0; i < FRAME_RECORDER_BUFFERS; ++i) {
+		buffers_.push_back(new osg::Image);
+		freeBuffers_.push_back(buffers_.back().get());
+	}
+	for (unsigned int i = 0; i < numWorkers; ++i) {
+		workers_.create_thread(boost::bind(&FrameRecorder::work, this));
+	}
+}
+
+FrameRecorder::~FrameRecorder() {
+	close();
+}
+
+osg::Image *FrameRecorder::acquire() {
+	boost::mutex::scoped_lock lock(mutex_);
+	while (freeBuffers_.empty()) {
+		condition_.wait(lock);
+	}
+	osg::Image *image = freeBuffers_.front();
+	freeBuffers_.pop_front();
+	return image;
+}
+
+void FrameRecorder::submit(osg::Image *image) {
+	boost::mutex::scoped_lock lock(mutex_);
+	queue_.push_back(std::make_pair(image, frameCount_++));
+	condition_.notify_all();
+}
+
+bool FrameRecorder::close() {
+	{
+		boost::mutex::scoped_lock lock(mutex_);
+		if (closed_) {
+			return !failed_;
+		}
+		closing_ = true;
+		closed_ = true;
+		condition_.notify_all();
+	}
+	workers_.join_all();
+
+	if (pipe_ != NULL) {
+#ifdef WIN32
+		int status = _pclose(pipe_);
+#else
+		int status = pclose(pipe_);
+#endif
+		pipe_ = NULL;
+		if (status != 0) {
+			std::cerr << "The encoder command '" << command_ << "' failed"
+					<< std::endl;
+			failed_ = true;
+		}
+	}
+	return !failed_;
+}
+
+void FrameRecorder::work() {
+	while (true) {
+		std::pair<osg::Image *, unsigned int> frame;
+		{
+			boost::mutex::scoped_lock lock(mutex_);
+			while (queue_.empty() && !closing_) {
+				condition_.wait(lock);
+			}
+			if (queue_.empty()) {
+				return;
+			}
+			frame = queue_.front();
+			queue_.pop_front();
+		}
+
+		bool written = command_.empty() ?
+				writeFile(frame.first, frame.second) :
+				writePipe(frame.first);
+
+		boost::mutex::scoped_lock lock(mutex_);
+		if (!written) {
+			failed_ = true;
+		}
+		freeBuffers_.push_back(frame.first);
+		condition_.notify_all();
+	}
+}
+
+bool FrameRecorder::writeFile(osg::Image *image, unsigned int frameIndex) {
+	std::stringstream ss;
+	ss << directory_ << "/" << boost::format("%|04|") % frameIndex << ".jpg";
+	if (!osgDB::writeImageFile(*image, ss.str())) {
+		std::cerr << "Can't save screen image to `" << ss.str() << "`"
+				<< std::endl;
+		return false;
+	}
+	std::cout << "Saved screen image to `" << ss.str() << "`" << std::endl;
+	return true;
+}
+
+bool FrameRecorder::writePipe(osg::Image *image) {
+	// the single worker is the only writer of failed_
+	if (failed_) {
+		return false;
+	}
+
+	if (pipe_ == NULL) {
+		// the first frame gives the size of the stream
+		width_ = image->s();
+		height_ = image->t();
+		std::string command = command_;
+		boost::replace_all(command, "%w",
+				boost::lexical_cast<std::string>(width_));
+		boost::replace_all(command, "%h",
+				boost::lexical_cast<std::string>(height_));
+#ifdef WIN32
+		pipe_ = _popen(command.c_str(), "wb");
+#else
+		// a failing encoder makes fwrite fail instead of killing us
+		signal(SIGPIPE, SIG_IGN);
+		pipe_ = popen(command.c_str(), "w");
+#endif
+		if (pipe_ == NULL) {
+			std::cerr << "Cannot run the encoder command '" << command << "'"
+					<< std::endl;
+			return false;
+		}
+		std::cout << "Piping " << width_ << "x" << height_ << " frames to '"
+				<< command << "'" << std::endl;
+	}
+
+	if (image->s() != width_ || image->t() != height_) {
+		std::cerr << "Dropped a " << image->s() << "x" << image->t()
+				<< " frame, the encoder expects " << width_ << "x" << height_
+				<< ": the window must keep its size while recording"
+				<< std::endl;
+		return false;
+	}
+
+	// OpenGL reads the bottom row first, rows may be padded
+	unsigned int rowSize = width_ * image->getPixelSizeInBits() / 8;
+	for (int row = height_ - 1; row >= 0; --row) {
+		if (fwrite(image->data(0, row), 1, rowSize, pipe_) != rowSize) {
+			std::cerr << "Cannot write a frame to the encoder command '"
+					<< command_ << "'" << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+}
@@ -0,0 +1,137 @@
+/*
+ * @(#) FrameRecorder.h   1.0   Oct 19, 2026
+ *
+ * The ROBOGEN Framework
+ * Copyright © 2013-2016
+ *
+ * Laboratory of Intelligent Systems, EPFL
+ *
+ * This file is part of the ROBOGEN Framework.
+ *
+ * The ROBOGEN Framework is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License (GPL)
+ * as published by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @(#) $Id$
+ */
+
+#ifndef FRAMERECORDER_H_
+#define FRAMERECORDER_H_
+
+#include <cstdio>
+#include <deque>
+#include <string>
+#include <vector>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <osg/Image>
+
+// pixel buffers of frames waiting to be written
+#define FRAME_RECORDER_BUFFERS 8
+
+namespace robogen {
+
+/**
+ * \brief Writes recorded frames in the background
+ *
+ * Frames are read into one of a ring of FRAME_RECORDER_BUFFERS images, then
+ * written by worker threads, so the render thread only waits for a buffer if
+ * all of them are still being written.
+ *
+ * Frames are either encoded as numbered JPEGs (0000.jpg, 0001.jpg, ...) in a
+ * directory, by several workers, or piped in order to the standard input of
+ * an encoder command as one stream of raw RGB frames (rgb24, top row first).
+ * In the command, %w and %h are replaced by the width and height of the
+ * frames, for example
+ * "ffmpeg -f rawvideo -pix_fmt rgb24 -s %wx%h -r 30 -i - video.mp4".
+ */
+class FrameRecorder {
+public:
+
+	/**
+	 * Writes numbered JPEGs to a directory
+	 */
+	static FrameRecorder *toDirectory(const std::string &directory);
+
+	/**
+	 * Pipes raw frames to an encoder command
+	 */
+	static FrameRecorder *toCommand(const std::string &command);
+
+	/**
+	 * Writes the remaining frames
+	 */
+	~FrameRecorder();
+
+	/**
+	 * Returns a free pixel buffer, waiting for one if needed. To be filled
+	 * and handed back with submit.
+	 */
+	osg::Image *acquire();
+
+	/**
+	 * Queues a frame for writing
+	 */
+	void submit(osg::Image *image);
+
+	/**
+	 * Writes the remaining frames, then closes the pipe
+	 * @return false if a frame could not be written
+	 */
+	bool close();
+
+private:
+
+	FrameRecorder(const std::string &directory, const std::string &command,
+			unsigned int numWorkers);
+
+	void work();
+
+	bool writeFile(osg::Image *image, unsigned int frameIndex);
+
+	bool writePipe(osg::Image *image);
+
+	std::string directory_;
+
+	/**
+	 * Encoder command, empty when writing JPEGs
+	 */
+	std::string command_;
+
+	FILE *pipe_;
+	int width_;
+	int height_;
+
+	std::vector<osg::ref_ptr<osg::Image> > buffers_;
+
+	std::deque<osg::Image *> freeBuffers_;
+
+	/**
+	 * Frames to write with their index
+	 */
+	std::deque<std::pair<osg::Image *, unsigned int> > queue_;
+
+	unsigned int frameCount_;
+
+	bool closing_;
+	bool closed_;
+	bool failed_;
+
+	boost::mutex mutex_;
+	boost::condition_variable condition_;
+	boost::thread_group workers_;
+};
+
+}
+
+#endif /* FRAMERECORDER_H_ */
@@ -29,18 +29,24 @@
 #ifndef ROBOGEN_KEYBOARD_HANDLER_H_
 #define ROBOGEN_KEYBOARD_HANDLER_H_
 
+#include <boost/thread/mutex.hpp>
 #include <osgGA/GUIEventHandler>
 #include <osg/Version>
 
 namespace robogen {
 
+/**
+ * Keys are handled by the render thread of the viewer while the simulation
+ * thread reads the state, which is guarded by a mutex.
+ */
 class KeyboardHandler: public osgGA::GUIEventHandler {
 
 public:
 
 	KeyboardHandler(bool startPaused, bool geoms, bool meshes/*, bool transparent*/)
 		: osgGA::GUIEventHandler(), paused_(startPaused), geoms_(geoms),
-		  meshes_(meshes), /*transparent_(transparent),*/ quit_(false)  {
+		  meshes_(meshes), /*transparent_(transparent),*/ quit_(false),
+		  frameSteps_(0), seek_(0), speedSteps_(0), restart_(false) {
 
 	}
 
@@ -51,6 +57,8 @@ public:
 
 		if (eventType == osgGA::GUIEventAdapter::KEYDOWN) {
 
+			boost::mutex::scoped_lock lock(mutex_);
+
 			switch (ea.getKey()) {
 
 			// Toggle Pause Simulation
@@ -79,6 +87,44 @@ public:
 			//	return true;
 			//	break;
 
+			// Replay controls
+			case '.':
+				paused_ = true;
+				frameSteps_++;
+				return true;
+				break;
+
+			case ',':
+				paused_ = true;
+				frameSteps_--;
+				return true;
+				break;
+
+			case osgGA::GUIEventAdapter::KEY_Right:
+				seek_ += 1;
+				return true;
+				break;
+
+			case osgGA::GUIEventAdapter::KEY_Left:
+				seek_ -= 1;
+				return true;
+				break;
+
+			case ']':
+				speedSteps_++;
+				return true;
+				break;
+
+			case '[':
+				speedSteps_--;
+				return true;
+				break;
+
+			case osgGA::GUIEventAdapter::KEY_Home:
+				restart_ = true;
+				return true;
+				break;
+
 			default:
 				return false;
 
@@ -101,14 +147,17 @@ public:
 	 * Check if the pause button was pressed
 	 */
 	bool isPaused() {
+		boost::mutex::scoped_lock lock(mutex_);
 		return paused_;
 	}
 
 	bool showGeoms() {
+		boost::mutex::scoped_lock lock(mutex_);
 		return geoms_;
 	}
 
 	bool showMeshes() {
+		boost::mutex::scoped_lock lock(mutex_);
 		return meshes_;
 	}
 
@@ -121,9 +170,52 @@ public:
 	 * True if the quit button was pressed
 	 */
 	bool isQuit() {
+		boost::mutex::scoped_lock lock(mutex_);
 		return quit_;
 	}
 
+	/**
+	 * Frames to step forward (negative for backward) in a replay since the
+	 * last call
+	 */
+	int takeFrameSteps() {
+		boost::mutex::scoped_lock lock(mutex_);
+		int frameSteps = frameSteps_;
+		frameSteps_ = 0;
+		return frameSteps;
+	}
+
+	/**
+	 * Seconds to seek in a replay since the last call
+	 */
+	double takeSeek() {
+		boost::mutex::scoped_lock lock(mutex_);
+		double seek = seek_;
+		seek_ = 0;
+		return seek;
+	}
+
+	/**
+	 * Times the replay speed was doubled (negative for halved) since the last
+	 * call
+	 */
+	int takeSpeedSteps() {
+		boost::mutex::scoped_lock lock(mutex_);
+		int speedSteps = speedSteps_;
+		speedSteps_ = 0;
+		return speedSteps;
+	}
+
+	/**
+	 * True if the replay should restart, since the last call
+	 */
+	bool takeRestart() {
+		boost::mutex::scoped_lock lock(mutex_);
+		bool restart = restart_;
+		restart_ = false;
+		return restart;
+	}
+
 private:
 
 	bool paused_;
@@ -136,6 +228,16 @@ private:
 
 	bool quit_;
 
+	int frameSteps_;
+
+	double seek_;
+
+	int speedSteps_;
+
+	bool restart_;
+
+	boost::mutex mutex_;
+
 };
 
 }
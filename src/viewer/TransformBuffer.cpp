@@ -0,0 +1,125 @@
+/*
+ * @(#) TransformBuffer.cpp   1.0   Oct 19, 2026
+ *
+ * The ROBOGEN Framework
+ * Copyright © 2013-2016
+ *
+ * Laboratory of Intelligent Systems, EPFL
+ *
+ * This file is part of the ROBOGEN Framework.
+ *
+ * The ROBOGEN Framework is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License (GPL)
+ * as published by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @(#) $Id$
+ */
+
+#include <osg/NodeVisitor>
+#include "viewer/TransformBuffer.h"
+
+namespace robogen {
+
+namespace {
+
+/**
+ * Collects the transforms updated by a TransformCallback and removes the
+ * callbacks
+ */
+class TransformCallbackVisitor: public osg::NodeVisitor {
+public:
+
+	TransformCallbackVisitor(
+			std::vector<osg::ref_ptr<TransformCallback> > &callbacks,
+			std::vector<osg::ref_ptr<osg::PositionAttitudeTransform> > &nodes) :
+			osg::NodeVisitor(osg::NodeVisitor::TRAVERSE_ALL_CHILDREN),
+			callbacks_(callbacks), nodes_(nodes) {
+		// also visit hidden meshes and geoms
+		setNodeMaskOverride(0xffffffff);
+	}
+
+	virtual void apply(osg::Node &node) {
+		TransformCallback *callback = dynamic_cast<TransformCallback *>(
+				node.getUpdateCallback());
+		osg::PositionAttitudeTransform *pat =
+				dynamic_cast<osg::PositionAttitudeTransform *>(&node);
+		if (callback != NULL && pat != NULL) {
+			callbacks_.push_back(callback);
+			nodes_.push_back(pat);
+			node.setUpdateCallback(NULL);
+		}
+		traverse(node);
+	}
+
+private:
+
+	std::vector<osg::ref_ptr<TransformCallback> > &callbacks_;
+	std::vector<osg::ref_ptr<osg::PositionAttitudeTransform> > &nodes_;
+};
+
+}
+
+TransformBuffer::TransformBuffer() : fresh_(false) {
+}
+
+void TransformBuffer::attach(osg::ref_ptr<osg::Node> scene) {
+	callbacks_.clear();
+	nodes_.clear();
+	TransformCallbackVisitor visitor(callbacks_, nodes_);
+	scene->accept(visitor);
+
+	back_.resize(nodes_.size());
+	computeBack();
+
+	boost::mutex::scoped_lock lock(mutex_);
+	front_.swap(back_);
+	frontNodes_ = nodes_;
+	back_.resize(nodes_.size());
+	fresh_ = true;
+}
+
+void TransformBuffer::computeBack() {
+	for (unsigned int i = 0; i < callbacks_.size(); ++i) {
+		callbacks_[i]->getTransform(back_[i].position, back_[i].attitude);
+	}
+}
+
+bool TransformBuffer::publish(bool force) {
+	if (!force) {
+		// skip the step if the render thread has not caught up
+		boost::mutex::scoped_try_lock lock(mutex_);
+		if (!lock.owns_lock() || fresh_) {
+			return false;
+		}
+	}
+
+	computeBack();
+
+	boost::mutex::scoped_lock lock(mutex_);
+	front_.swap(back_);
+	fresh_ = true;
+	return true;
+}
+
+void TransformBuffer::apply() {
+	boost::mutex::scoped_lock lock(mutex_);
+	if (!fresh_) {
+		return;
+	}
+	for (unsigned int i = 0; i < frontNodes_.size(); ++i) {
+		frontNodes_[i]->setPosition(front_[i].position);
+		frontNodes_[i]->setAttitude(front_[i].attitude);
+	}
+	fresh_ = false;
+}
+
+}
@@ -0,0 +1,115 @@
+/*
+ * @(#) TransformBuffer.h   1.0   Oct 19, 2026
+ *
+ * The ROBOGEN Framework
+ * Copyright © 2013-2016
+ *
+ * Laboratory of Intelligent Systems, EPFL
+ *
+ * This file is part of the ROBOGEN Framework.
+ *
+ * The ROBOGEN Framework is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License (GPL)
+ * as published by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @(#) $Id$
+ */
+
+#ifndef TRANSFORMBUFFER_H_
+#define TRANSFORMBUFFER_H_
+
+#include <vector>
+#include <boost/thread/mutex.hpp>
+#include <osg/Node>
+#include <osg/PositionAttitudeTransform>
+#include "render/callback/TransformCallback.h"
+
+namespace robogen {
+
+/**
+ * \brief Double buffered transforms of a scene, from the simulation thread to
+ * the render thread
+ *
+ * attach takes the TransformCallbacks off the nodes of a scene. The
+ * simulation thread then computes the transforms of all nodes into the back
+ * buffer and swaps it with the front buffer (publish), which the render
+ * thread copies to the nodes before drawing a frame (apply). The render
+ * thread never reads the physics, and the simulation only waits for it while
+ * swapping the buffers.
+ */
+class TransformBuffer {
+public:
+
+	TransformBuffer();
+
+	/**
+	 * Follows the TransformCallbacks of a new scene, replacing the previous
+	 * one, and publishes its current transforms. To be called by the
+	 * simulation thread.
+	 */
+	void attach(osg::ref_ptr<osg::Node> scene);
+
+	/**
+	 * Publishes the current transforms. To be called by the simulation
+	 * thread.
+	 * @param force publish even if the render thread has not applied the
+	 * previous transforms yet, or is applying them
+	 * @return true if published
+	 */
+	bool publish(bool force);
+
+	/**
+	 * Copies the last published transforms to the nodes, if not done yet.
+	 * To be called by the render thread.
+	 */
+	void apply();
+
+private:
+
+	struct Transform {
+		osg::Vec3 position;
+		osg::Quat attitude;
+	};
+
+	void computeBack();
+
+	std::vector<osg::ref_ptr<TransformCallback> > callbacks_;
+
+	std::vector<osg::ref_ptr<osg::PositionAttitudeTransform> > nodes_;
+
+	/**
+	 * Written by the simulation thread only
+	 */
+	std::vector<Transform> back_;
+
+	std::vector<Transform> front_;
+
+	/**
+	 * Nodes the render thread has to update from front_, set when attaching
+	 * a new scene
+	 */
+	std::vector<osg::ref_ptr<osg::PositionAttitudeTransform> > frontNodes_;
+
+	/**
+	 * front_ was published and not applied yet
+	 */
+	bool fresh_;
+
+	/**
+	 * Guards front_, frontNodes_ and fresh_
+	 */
+	boost::mutex mutex_;
+};
+
+}
+
+#endif /* TRANSFORMBUFFER_H_ */
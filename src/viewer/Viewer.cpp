@@ -29,25 +29,26 @@
 #include "viewer/Viewer.h"
 #include "utils/RobogenUtils.h"
 
-#include <boost/format.hpp>
-#include <sstream>
-#include <osgDB/WriteFile>
+#include <boost/bind.hpp>
+#include <algorithm>
+#include <cmath>
 
 #include "model/objects/BoxObstacle.h"
 
 namespace robogen{
 
+/**
+ * Reads the next frame into a buffer of a FrameRecorder
+ */
 class SnapImageDrawCallback : public osg::Camera::DrawCallback {
 public:
 
-	SnapImageDrawCallback()
+	SnapImageDrawCallback(FrameRecorder *frameRecorder) :
+		_frameRecorder(frameRecorder)
 	{
 		_snapImageOnNextFrame = false;
 	}
 
-	void setFileName(const std::string& filename) { _filename = filename; }
-	const std::string& getFileName() const { return _filename; }
-
 	void setSnapImageOnNextFrame(bool flag) { _snapImageOnNextFrame = flag; }
 	bool getSnapImageOnNextFrame() const { return _snapImageOnNextFrame; }
 
@@ -61,20 +62,17 @@ public:
 		width = camera.getViewport()->width();
 		height = camera.getViewport()->height();
 
-		osg::ref_ptr<osg::Image> image = new osg::Image;
+		// encoding is left to the workers of the recorder
+		osg::Image *image = _frameRecorder->acquire();
 		image->readPixels(x,y,width,height,GL_RGB,GL_UNSIGNED_BYTE);
-
-		if (osgDB::writeImageFile(*image,_filename))
-		{
-		std::cout << "Saved screen image to `"<<_filename<<"`"<< std::endl;
-		}
+		_frameRecorder->submit(image);
 
 		_snapImageOnNextFrame = false;
 	}
 
 protected:
 
-	std::string _filename;
+	FrameRecorder *_frameRecorder;
 	mutable bool _snapImageOnNextFrame;
 
 
@@ -82,7 +80,7 @@ protected:
 
 void Viewer::init(bool startPaused, bool debugActive, double speedFactor,
 		bool recording, unsigned int recordFrequency,
-		std::string recordDirectoryName) {
+		std::string recordDirectoryName, std::string recordCommand) {
 
 	// ---------------------------------------
 	// OSG Initialization
@@ -106,51 +104,80 @@ void Viewer::init(bool startPaused, bool debugActive, double speedFactor,
 	this->speedFactor = speedFactor;
 	this->tick1 = boost::posix_time::microsec_clock::universal_time();
 	this->elapsedWallTime = 0.0;
-	this->timeSinceLastFrame = 0.0;
 	// Initialize recording (if recording == true)
 
 	this->recording = recording;
 	if (recording) {
-		this->frameCount = 0;
 		this->recordFrequency = recordFrequency;
+		if (recordCommand.empty()) {
+			this->frameRecorder.reset(
+					FrameRecorder::toDirectory(recordDirectoryName));
+		} else {
+			this->frameRecorder.reset(
+					FrameRecorder::toCommand(recordCommand));
+		}
 		osg::ref_ptr<SnapImageDrawCallback> snapImageDrawCallback = new
-													SnapImageDrawCallback();
+				SnapImageDrawCallback(this->frameRecorder.get());
 		this->viewer->getCamera()->setPostDrawCallback(
 				snapImageDrawCallback.get());
-		this->recordDirectoryName = recordDirectoryName;
 	}
 
 	this->debugActive = debugActive;
+
+	this->sceneChanged = false;
+	this->recordPending = false;
+	this->stopRendering = false;
+	this->renderingDone = false;
+	this->realized = false;
+	this->lastRenderTime = this->tick1;
 }
 
 Viewer::Viewer(bool startPaused) {
-	this->init(startPaused, false, 1.0, false, 0, "");
+	this->init(startPaused, false, 1.0, false, 0, "", "");
 }
 
 Viewer::Viewer(bool startPaused, bool debugActive) {
-	this->init(startPaused, debugActive, 1.0, false, 0, "");
+	this->init(startPaused, debugActive, 1.0, false, 0, "", "");
 }
 
 Viewer::Viewer(bool startPaused, bool debugActive, double speedFactor) {
-	this->init(startPaused, debugActive, speedFactor, false, 0, "");
+	this->init(startPaused, debugActive, speedFactor, false, 0, "", "");
 }
 
 Viewer::Viewer(bool startPaused, bool debugActive, double speedFactor,
 		bool recording, unsigned int recordFrequency,
 		std::string recordDirectoryName) {
 	this->init(startPaused, debugActive, speedFactor,
-			recording, recordFrequency, recordDirectoryName);
-
+			recording, recordFrequency, recordDirectoryName, "");
+}
 
+Viewer::Viewer(bool startPaused, bool debugActive, double speedFactor,
+		bool recording, unsigned int recordFrequency,
+		std::string recordDirectoryName, std::string recordCommand) {
+	this->init(startPaused, debugActive, speedFactor,
+			recording, recordFrequency, recordDirectoryName, recordCommand);
 }
 
 Viewer::~Viewer() {
+	{
+		boost::mutex::scoped_lock lock(renderMutex);
+		this->stopRendering = true;
+	}
+	if (this->renderThread.joinable()) {
+		this->renderThread.join();
+	}
 	delete this->viewer;
+	if (this->frameRecorder) {
+		this->frameRecorder->close();
+	}
 }
 
 bool Viewer::configureScene(std::vector<boost::shared_ptr<Model> > bodyParts,
 		boost::shared_ptr<Scenario> scenario) {
 
+	// the scene of a new simulation replaces the previous one
+	osg::ref_ptr<osg::Group> root(new osg::Group);
+	std::vector<boost::shared_ptr<RenderModel> > renderModels;
 
 	for (unsigned int i = 0; i < bodyParts.size(); ++i) {
 		boost::shared_ptr<RenderModel> renderModel =
@@ -173,13 +200,13 @@ bool Viewer::configureScene(std::vector<boost::shared_ptr<Model> > bodyParts,
 			return false;
 		}
 		renderModels.push_back(renderModel);
-		this->root->addChild(renderModels[i]->getRootNode());
+		root->addChild(renderModel->getRootNode());
 	}
 
 	// Terrain render model
 	boost::shared_ptr<TerrainRender> terrainRender(
 			new TerrainRender(scenario->getEnvironment()->getTerrain()));
-	this->root->addChild(terrainRender->getRootNode());
+	root->addChild(terrainRender->getRootNode());
 
 	// Obstacles render model
 	const std::vector<boost::shared_ptr<Obstacle> >& obstacles =
@@ -197,7 +224,7 @@ bool Viewer::configureScene(std::vector<boost::shared_ptr<Model> > bodyParts,
 
 		boost::shared_ptr<BoxObstacleRender> obstacleRender(
 				new BoxObstacleRender(boxObstacle));
-		this->root->addChild(obstacleRender->getRootNode());
+		root->addChild(obstacleRender->getRootNode());
 	}
 
 
@@ -223,20 +250,32 @@ bool Viewer::configureScene(std::vector<boost::shared_ptr<Model> > bodyParts,
 	}
 
 	// ---------------------------------------
-	// Setup OSG viewer
+	// Hand the scene over to the render thread
 	// ---------------------------------------
 
-	this->viewer->setSceneData(root.get());
+	// the transform callbacks are taken off the new scene before the render
+	// thread gets it, so it never runs them
+	this->transforms.attach(root);
+	{
+		boost::mutex::scoped_lock lock(renderMutex);
+		this->root = root;
+		this->renderModels.swap(renderModels);
+		this->sceneChanged = true;
+	}
 
-	this->viewer->realize();
+	// the simulated time starts again from 0
+	this->tick1 = boost::posix_time::microsec_clock::universal_time();
+	this->elapsedWallTime = 0.0;
 
-	if (!this->viewer->getCameraManipulator()
-			&& this->viewer->getCamera()->getAllowEventFocus()) {
-		this->viewer->setCameraManipulator(
-				new osgGA::TrackballManipulator());
+#ifdef VIEWER_RENDER_THREAD
+	if (!this->renderThread.joinable()) {
+		this->renderThread = boost::thread(boost::bind(&Viewer::render, this));
 	}
-
-	this->viewer->setReleaseContextAtEndOfFrameHint(false);
+#else
+	// opens the window
+	this->lastRenderTime = boost::posix_time::microsec_clock::universal_time();
+	this->renderFrame();
+#endif
 
 	if(this->debugActive) {
 		std::cout << "Press M to show/hide meshes." << std::endl;
@@ -251,80 +290,242 @@ bool Viewer::configureScene(std::vector<boost::shared_ptr<Model> > bodyParts,
 }
 
 bool Viewer::done() {
-	return (this->viewer->done() || this->keyboardEvent->isQuit());
+	{
+		boost::mutex::scoped_lock lock(renderMutex);
+		if (this->renderingDone) {
+			return true;
+		}
+	}
+	return this->keyboardEvent->isQuit();
 }
 
 bool Viewer::frame(double simulatedTime, unsigned int numTimeSteps) {
 	this->tick2 = boost::posix_time::microsec_clock::universal_time();
 	boost::posix_time::time_duration diff = this->tick2 - this->tick1;
-	if(!this->isPaused()) {
-		double frameTime = diff.total_milliseconds()/1000.0;
-		this->elapsedWallTime += frameTime;
-		this->timeSinceLastFrame += frameTime;
-	}
+	this->tick1 = this->tick2;
 
-	if(this->debugActive) {
-		for(unsigned int i=0; i<renderModels.size(); i++) {
-			renderModels[i]->togglePrimitives(keyboardEvent->showGeoms());
-			renderModels[i]->toggleMeshes(keyboardEvent->showMeshes());
-			//renderModels[i]->toggleTransparency(keyboardEvent->isTransparent());
-		}
+	// while paused, wait for the render thread to unpause
+	if(this->isPaused()) {
+		this->renderIfDue();
+		boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+		return false;
 	}
 
-
-	this->tick1 = boost::posix_time::microsec_clock::universal_time();
+	this->elapsedWallTime += diff.total_microseconds() / 1e6;
 
 	// --------------------
-	// decide whether to draw frame
-	// (a) if paused, always draw
-	// (b) if recording and on a frame to be captured, draw
-	// (c) if have simulated more time than has actually
-	//       passed scaled by speedFactor, draw
-	// (d) if have not drawn a frame in MAX_TIME_BETWEEN_FRAMES
+	// if have simulated more time than has actually passed scaled by
+	// speedFactor, wait (at most MAX_TIME_BETWEEN_FRAMES so that the
+	// keyboard is still checked)
 	// --------------------
 
-	if(this->isPaused() ||
-			(this->recording && (numTimeSteps % recordFrequency == 0)) ||
-			(simulatedTime > (elapsedWallTime * speedFactor) ) ||
-			(this->timeSinceLastFrame >= MAX_TIME_BETWEEN_FRAMES)
-			) {
+	double ahead = (simulatedTime - elapsedWallTime * speedFactor) /
+			speedFactor;
+	if(ahead > 0) {
+		this->renderIfDue();
+		boost::this_thread::sleep(boost::posix_time::microseconds(
+				(long) (std::min(ahead, MAX_TIME_BETWEEN_FRAMES) * 1e6)));
+		return false;
+	}
+
+	if (this->recording && (numTimeSteps % recordFrequency == 0)) {
+		this->transforms.publish(true);
+		this->record();
+	} else {
+		// the render thread picks the transforms up when drawing its next
+		// frame, until then publishing again is skipped
+		this->transforms.publish(false);
+		this->renderIfDue();
+	}
+
+	return true;
+}
 
-		this->viewer->frame();
 
-		this->timeSinceLastFrame = 0.0;
 
-		// loop back around in case paused
-		// or really want to go slow
-		if(this->isPaused() ||
-				(simulatedTime > (elapsedWallTime * speedFactor))) {
-			return false;
+void Viewer::replayFrame(double &time, double frameLength,
+		double duration) {
+	this->tick2 = boost::posix_time::microsec_clock::universal_time();
+	boost::posix_time::time_duration diff = this->tick2 - this->tick1;
+	this->tick1 = this->tick2;
+
+	this->transforms.publish(true);
+
+	unsigned int frameIndex = (unsigned int) (time / frameLength + 0.5);
+	if (this->recording && !this->isPaused() &&
+			(frameIndex % recordFrequency == 0)) {
+		this->record();
+	} else {
+		this->renderIfDue();
+		boost::this_thread::sleep(boost::posix_time::microseconds(
+				(long) (1e6 / RENDER_FRAME_RATE)));
+	}
+
+	int speedSteps = this->keyboardEvent->takeSpeedSteps();
+	if (speedSteps != 0) {
+		this->speedFactor *= std::pow(2.0, speedSteps);
+		std::cout << "Replay speed: " << this->speedFactor << std::endl;
+	}
+
+	if (!this->isPaused()) {
+		if (this->recording) {
+			time += frameLength;
+		} else {
+			time += diff.total_microseconds() / 1e6 * this->speedFactor;
 		}
 	}
 
-	if (this->recording && (numTimeSteps % recordFrequency == 0)) {
-		this->record();
+	int frameSteps = this->keyboardEvent->takeFrameSteps();
+	if (frameSteps != 0) {
+		time = ((int) frameIndex + frameSteps) * frameLength;
+	}
+	time += this->keyboardEvent->takeSeek();
+	if (this->keyboardEvent->takeRestart()) {
+		time = 0;
 	}
 
-	return true;
+	if (time < 0) {
+		time = 0;
+	} else if (time > duration) {
+		time = duration;
+	}
 }
 
+bool Viewer::renderFrame() {
 
+	bool capture;
+	{
+		boost::mutex::scoped_lock lock(renderMutex);
+		if (this->sceneChanged) {
+			this->viewer->setSceneData(this->root.get());
+			this->sceneChanged = false;
+		}
+		if(this->debugActive) {
+			for(unsigned int i=0; i<renderModels.size(); i++) {
+				renderModels[i]->togglePrimitives(
+						keyboardEvent->showGeoms());
+				renderModels[i]->toggleMeshes(keyboardEvent->showMeshes());
+			}
+		}
+		capture = this->recordPending;
+	}
 
-void Viewer::record() {
+	if (!this->realized) {
+		// the OpenGL context belongs to this thread
+		if (this->recording) {
+			// the frame has to be captured by the time frame() returns
+			this->viewer->setThreadingModel(
+					osgViewer::ViewerBase::SingleThreaded);
+		}
+		this->viewer->realize();
+		if (!this->viewer->getCameraManipulator()
+				&& this->viewer->getCamera()->getAllowEventFocus()) {
+			this->viewer->setCameraManipulator(
+					new osgGA::TrackballManipulator());
+		}
+		this->viewer->setReleaseContextAtEndOfFrameHint(false);
+		this->realized = true;
+	}
 
-	osg::ref_ptr<SnapImageDrawCallback> snapImageDrawCallback =
-			dynamic_cast<SnapImageDrawCallback*>
-			(viewer->getCamera()->getPostDrawCallback());
+	if (capture) {
+		osg::ref_ptr<SnapImageDrawCallback> snapImageDrawCallback =
+				dynamic_cast<SnapImageDrawCallback*>
+				(viewer->getCamera()->getPostDrawCallback());
+		if(snapImageDrawCallback.get()) {
+			snapImageDrawCallback->setSnapImageOnNextFrame(true);
+		}
+	}
 
-	if(snapImageDrawCallback.get()) {
-		std::stringstream ss;
-		ss << this->recordDirectoryName << "/" <<
-				boost::format("%|04|")%this->frameCount << ".jpg";
-		snapImageDrawCallback->setFileName(ss.str());
-		snapImageDrawCallback->setSnapImageOnNextFrame(true);
-		this->frameCount++;
+	this->transforms.apply();
+	this->viewer->frame();
+
+	bool done = this->viewer->done();
+	{
+		boost::mutex::scoped_lock lock(renderMutex);
+		if (capture) {
+			this->recordPending = false;
+		}
+		this->renderingDone = done;
 	}
+	if (capture || done) {
+		this->renderCondition.notify_all();
+	}
+	return done;
+}
 
+void Viewer::renderIfDue() {
+#ifndef VIEWER_RENDER_THREAD
+	boost::posix_time::ptime now =
+			boost::posix_time::microsec_clock::universal_time();
+	if ((now - this->lastRenderTime).total_microseconds() <
+			(long) (1e6 / RENDER_FRAME_RATE)) {
+		return;
+	}
+	this->lastRenderTime = now;
+	{
+		boost::mutex::scoped_lock lock(renderMutex);
+		if (this->renderingDone) {
+			return;
+		}
+	}
+	this->renderFrame();
+#endif
+}
+
+void Viewer::render() {
+
+	boost::posix_time::ptime frameStart;
+
+	while (true) {
+		frameStart = boost::posix_time::microsec_clock::universal_time();
+
+		{
+			boost::mutex::scoped_lock lock(renderMutex);
+			if (this->stopRendering) {
+				break;
+			}
+		}
+
+		if (this->renderFrame()) {
+			break;
+		}
+
+		// recorded frames are drawn as soon as they are published
+		boost::mutex::scoped_lock lock(renderMutex);
+		if (!this->recordPending && !this->stopRendering) {
+			boost::posix_time::time_duration elapsed =
+					boost::posix_time::microsec_clock::universal_time() -
+					frameStart;
+			long remaining = (long) (1e6 / RENDER_FRAME_RATE) -
+					elapsed.total_microseconds();
+			if (remaining > 0) {
+				this->renderCondition.timed_wait(lock,
+						boost::posix_time::microseconds(remaining));
+			}
+		}
+	}
+
+	boost::mutex::scoped_lock lock(renderMutex);
+	this->renderingDone = true;
+	this->renderCondition.notify_all();
+}
+
+void Viewer::record() {
+	boost::mutex::scoped_lock lock(renderMutex);
+	if (this->renderingDone) {
+		return;
+	}
+	this->recordPending = true;
+#ifdef VIEWER_RENDER_THREAD
+	this->renderCondition.notify_all();
+	while (this->recordPending && !this->renderingDone) {
+		this->renderCondition.wait(lock);
+	}
+#else
+	lock.unlock();
+	this->lastRenderTime = boost::posix_time::microsec_clock::universal_time();
+	this->renderFrame();
+#endif
 }
 
 bool Viewer::isPaused() {
@@ -32,7 +32,13 @@
 
 #include <osgGA/TrackballManipulator>
 #include <osgViewer/Viewer>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include "viewer/FrameRecorder.h"
 #include "viewer/KeyboardHandler.h"
+#include "viewer/TransformBuffer.h"
 #include "viewer/IViewer.h"
 #include "scenario/Scenario.h"
 #include "model/Model.h"
@@ -41,6 +47,15 @@
 
 #define MAX_TIME_BETWEEN_FRAMES 0.05
 
+// frames drawn per second by the render thread
+#define RENDER_FRAME_RATE 60.0
+
+// The Cocoa backend of osgViewer only works from the main thread, so on
+// Mac OS X the scene is drawn by the thread calling frame() and replayFrame()
+#ifndef __APPLE__
+#define VIEWER_RENDER_THREAD
+#endif
+
 namespace robogen{
 
 /**
@@ -52,6 +67,18 @@ namespace robogen{
  * Previously we had separate executables for Server, ServerViewer, and
  * FileViewer.  This involved a lot of duplicate code, so this class aims to be
  * a plugin to enable visualization or not.
+ *
+ * The scene is drawn by a render thread of the viewer, started by the first
+ * configureScene, which owns the OpenGL context and never reads the physics:
+ * the simulation thread publishes the transforms of the bodies through a
+ * TransformBuffer, and only waits for the render thread when a frame has to
+ * be recorded.
+ *
+ * On Mac OS X (without VIEWER_RENDER_THREAD) the window has to be created and
+ * served on the main thread, so there is no render thread: frame() and
+ * replayFrame() draw the published transforms themselves, at most
+ * RENDER_FRAME_RATE times per second, and the viewer must be used from the
+ * main thread. Drawing then slows the simulation down as it did before.
  */
 class Viewer : public robogen::IViewer{
 public:
@@ -61,6 +88,13 @@ public:
 	Viewer(bool startPaused, bool debugActive, double speedFactor,
 			bool recording,
 			unsigned int recordFrequency, std::string recordDirectoryName);
+	/**
+	 * Records frames to the standard input of recordCommand rather than in
+	 * recordDirectoryName, see FrameRecorder
+	 */
+	Viewer(bool startPaused, bool debugActive, double speedFactor,
+			bool recording, unsigned int recordFrequency,
+			std::string recordDirectoryName, std::string recordCommand);
 	~Viewer();
 	bool configureScene(std::vector<boost::shared_ptr<Model> > bodyParts,
 			boost::shared_ptr<Scenario> scenario);
@@ -72,36 +106,90 @@ public:
 	 * 		simulatedTime: the amount of time simulated so far (in seconds)
 	 * 		numTimeSteps: the number of time steps simulated so far
 	 * returns:
-	 * 		false if paused or going to fast
+	 * 		false if paused or going to fast, after sleeping for a while
 	 * 			(so simulator should continue without stepping physics)
 	 * 		true otherwise
 	 */
 
 	bool frame(double simulatedTime, unsigned int numTimeSteps);
 
+	/***
+	 * replayFrame:  draws a frame of a replay, then moves the replay time on
+	 * params:
+	 * 		time: the time of the replay (in seconds), advanced by the elapsed
+	 * 			wall time scaled by speedFactor, or by one frame per call when
+	 * 			recording, and moved by the keyboard controls
+	 * 		frameLength: the time between recorded frames (in seconds)
+	 * 		duration: the time of the last recorded frame (in seconds)
+	 */
+	void replayFrame(double &time, double frameLength, double duration);
+
 	bool isPaused();
 
 
 private:
 	void init(bool startPaused, bool debugActive, double speedFactor,
 			bool recording,
-			unsigned int recordFrequency, std::string recordDirectoryName);
+			unsigned int recordFrequency, std::string recordDirectoryName,
+			std::string recordCommand);
+
+	/**
+	 * Has the render thread capture its next frame, and waits for it
+	 */
 	void record();
 
+	/**
+	 * Main loop of the render thread
+	 */
+	void render();
+
+	/**
+	 * Draws one frame of the latest published transforms, capturing it if a
+	 * record is pending
+	 * @return true if the viewer window was closed
+	 */
+	bool renderFrame();
+
+	/**
+	 * Without the render thread, draws a frame if the last one is older than
+	 * 1 / RENDER_FRAME_RATE, so the window keeps responding while the
+	 * simulation waits. Does nothing with the render thread.
+	 */
+	void renderIfDue();
+
 	osgViewer::Viewer *viewer;
 	osg::ref_ptr<osg::Camera> camera;
 	osg::ref_ptr<osg::Group> root;
 	osg::ref_ptr<KeyboardHandler> keyboardEvent;
 
+	TransformBuffer transforms;
+
+	boost::thread renderThread;
+
+	/**
+	 * Used by the render thread only, or the thread drawing without it
+	 */
+	bool realized;
+	boost::posix_time::ptime lastRenderTime;
+
+	/**
+	 * Guards root, renderModels and the flags below, shared with the render
+	 * thread
+	 */
+	boost::mutex renderMutex;
+	boost::condition_variable renderCondition;
+	bool sceneChanged;
+	bool recordPending;
+	bool stopRendering;
+	bool renderingDone;
+
 	bool recording;
-	unsigned int frameCount;
-	std::string recordDirectoryName;
 	unsigned int recordFrequency;
+	boost::scoped_ptr<FrameRecorder> frameRecorder;
 
 	boost::posix_time::ptime tick1, tick2;
 	double elapsedWallTime;
 	double speedFactor;
-	double timeSinceLastFrame;
 
 	bool debugActive;
 
@@ -35,7 +35,6 @@
 #include <scenario/Terrain.h>
 #include <iostream>
 #include <jansson.h>
-#include <boost/lexical_cast.hpp>
 #include <osg/ShapeDrawable>
 #include <osg/Quat>
 #include <osg/Vec3>
@@ -64,7 +63,8 @@ const char *WebGLLogger::OBSTACLE_LOG_TAG = "log";
 const char *WebGLLogger::LIGHT_TAGS = "lights";
 
 WebGLLogger::WebGLLogger(std::string inFileName,
-		boost::shared_ptr<Scenario> in_scenario, double targetFrameRate) :
+		boost::shared_ptr<Scenario> in_scenario, double targetFrameRate,
+		bool binary) :
 		frameRate(targetFrameRate), lastFrame(-1000.0), robot(
 				in_scenario->getRobot()), scenario(in_scenario), fileName(
 				inFileName) {
@@ -82,6 +82,29 @@ WebGLLogger::WebGLLogger(std::string inFileName,
 	this->writeJSONHeaders();
 	this->writeRobotStructure();
 	this->generateMapInfo();
+
+	char *structure = json_dumps(this->jsonStructure, JSON_TAGS);
+	char *map = json_dumps(this->jsonMap, JSON_TAGS);
+	char *obstaclesDefinition = json_dumps(this->jsonObstaclesDefinition,
+			JSON_TAGS);
+	this->replayHeader.structureJSON = structure;
+	this->replayHeader.mapJSON = map;
+	this->replayHeader.obstaclesDefinitionJSON = obstaclesDefinition;
+	free(structure);
+	free(map);
+	free(obstaclesDefinition);
+	this->replayHeader.numBodies = this->bodies.size();
+	this->replayHeader.numObstacles =
+			this->scenario->getEnvironment()->getObstacles().size();
+	this->replayHeader.numLights =
+			this->scenario->getEnvironment()->getLightSources().size();
+
+	if (!this->fileName.empty() && !this->replay.open(this->fileName,
+			this->replayHeader,
+			binary ? WebGLReplay::BINARY : WebGLReplay::JSON)) {
+		std::cerr << "Can't open WebGL replay " << this->fileName
+				<< std::endl;
+	}
 }
 
 std::string WebGLLogger::getFormatedStringForCuboid(double width, double height,
@@ -172,7 +195,7 @@ void WebGLLogger::generateBodyCollection() {
 	}
 }
 WebGLLogger::~WebGLLogger() {
-	json_dump_file(this->jsonRoot, this->fileName.c_str(), JSON_TAGS);
+	this->replay.close();
 	json_decref(this->jsonRoot);
 }
 
@@ -333,29 +356,13 @@ std::string WebGLLogger::getObstaclesDefinitionJSON() {
 }
 
 std::string WebGLLogger::getLastLogJSON() {
-	std::string obKey = boost::lexical_cast<std::string>(this->lastFrame);
-	json_t* lastRobotLog = json_object_get(this->jsonLog, obKey.c_str());
-	json_t* lastObstaclesLog = json_object_get(this->jsonObstaclesLog,
-			obKey.c_str());
-	json_t* lastLightsLog = json_object_get(this->jsonLights,
-			obKey.c_str());
-	json_t* res = json_object();
-	json_object_set_new(res, "time", json_real(this->lastFrame));
-	if (lastRobotLog != NULL) {
-		json_object_set(res, "robot", lastRobotLog);
-	}
-	if (lastObstaclesLog) {
-		json_object_set(res, "obstacles", lastObstaclesLog);
+	if (this->lastValues.empty()) {
+		std::string result = "{\"time\":";
+		WebGLReplay::appendReal(result, this->lastFrame);
+		return result + "}";
 	}
-	if (lastLightsLog) {
-		json_object_set(res, "lights", lastLightsLog);
-	}
-
-	char * resChar = json_dumps(res, JSON_TAGS);
-	json_decref(res);
-	std::string result(resChar);
-	free(resChar);
-	return result;
+	return WebGLReplay::frameJSON(this->replayHeader, this->lastFrame,
+			this->lastValues);
 }
 
 std::string WebGLLogger::getLightsJSON() {
@@ -367,79 +374,59 @@ std::string WebGLLogger::getLightsJSON() {
 
 void WebGLLogger::log(double dt) {
 	if (dt - lastFrame >= 1.0 / frameRate) {
-		std::string obKey = boost::lexical_cast < std::string > (dt);
-		json_t* positions = json_array();
-		json_object_set_new(this->jsonLog, obKey.c_str(), positions);
+		// position (x, y, z) and attitude (x, y, z, w) of each body, then of
+		// each obstacle, then position of each light
+		std::vector<double> &values = this->lastValues;
+		values.assign(WebGLReplay::frameSize(this->replayHeader), 0);
+		unsigned int index = 0;
 
 		for (std::vector<struct BodyDescriptor>::iterator it =
 				this->bodies.begin(); it != this->bodies.end(); ++it) {
-			json_t* bodyLog = json_array();
-			json_t* attitude = json_array();
-			json_t* position = json_array();
-			json_array_append_new(bodyLog, attitude);
-			json_array_append_new(bodyLog, position);
-			json_array_append_new(positions, bodyLog);
-
 			osg::Vec3 currentPosition = it->model->getBodyPosition(it->bodyId);
 			osg::Quat currentAttitude = it->model->getBodyAttitude(it->bodyId);
 
-			json_array_append_new(position, json_real(currentPosition.x()));
-			json_array_append_new(position, json_real(currentPosition.y()));
-			json_array_append_new(position, json_real(currentPosition.z()));
-
-			json_array_append_new(attitude, json_real(currentAttitude.x()));
-			json_array_append_new(attitude, json_real(currentAttitude.y()));
-			json_array_append_new(attitude, json_real(currentAttitude.z()));
-			json_array_append_new(attitude, json_real(currentAttitude.w()));
-
+			values[index++] = currentPosition.x();
+			values[index++] = currentPosition.y();
+			values[index++] = currentPosition.z();
+			values[index++] = currentAttitude.x();
+			values[index++] = currentAttitude.y();
+			values[index++] = currentAttitude.z();
+			values[index++] = currentAttitude.w();
 		}
 
 		std::vector<boost::shared_ptr<Obstacle> > obstacles =
 				this->scenario->getEnvironment()->getObstacles();
-		json_t* obstacles_positions = json_array();
-		json_object_set_new(this->jsonObstaclesLog, obKey.c_str(),
-				obstacles_positions);
-		for (std::vector<boost::shared_ptr<Obstacle> >::iterator it =
-				obstacles.begin(); it != obstacles.end(); ++it) {
-			json_t* obstacleLog = json_array();
-			json_t* attitude = json_array();
-			json_t* position = json_array();
-			json_array_append_new(obstacleLog, attitude);
-			json_array_append_new(obstacleLog, position);
-			json_array_append_new(obstacles_positions, obstacleLog);
-
-			osg::Vec3 currentPosition = (*it)->getPosition();
-			osg::Quat currentAttitude = (*it)->getAttitude();
-
-			json_array_append_new(position, json_real(currentPosition.x()));
-			json_array_append_new(position, json_real(currentPosition.y()));
-			json_array_append_new(position, json_real(currentPosition.z()));
-
-			json_array_append_new(attitude, json_real(currentAttitude.x()));
-			json_array_append_new(attitude, json_real(currentAttitude.y()));
-			json_array_append_new(attitude, json_real(currentAttitude.z()));
-			json_array_append_new(attitude, json_real(currentAttitude.w()));
+		for (unsigned int i = 0; i < obstacles.size() &&
+				i < this->replayHeader.numObstacles; ++i) {
+			osg::Vec3 currentPosition = obstacles[i]->getPosition();
+			osg::Quat currentAttitude = obstacles[i]->getAttitude();
+
+			values[index++] = currentPosition.x();
+			values[index++] = currentPosition.y();
+			values[index++] = currentPosition.z();
+			values[index++] = currentAttitude.x();
+			values[index++] = currentAttitude.y();
+			values[index++] = currentAttitude.z();
+			values[index++] = currentAttitude.w();
 		}
+		index = 7 * (this->replayHeader.numBodies +
+				this->replayHeader.numObstacles);
 
 		lastFrame = dt;
 
 		std::vector < boost::shared_ptr<LightSource> > lights =
 				this->scenario->getEnvironment()->getLightSources();
-		json_t* jsonFrameLights = json_array();
-		json_object_set_new(this->jsonLights, obKey.c_str(), jsonFrameLights);
-
-		for (std::vector<boost::shared_ptr<LightSource> >::iterator light =
-				lights.begin(); light != lights.end(); ++light) {
-			json_t* jsonLightCoordinates = json_array();
-			json_array_append_new(jsonFrameLights, jsonLightCoordinates);
-			osg::Vec3 coordinates = (*light)->getPosition();
-
-			json_array_append_new(jsonLightCoordinates,
-					json_real(coordinates.x()));
-			json_array_append_new(jsonLightCoordinates,
-					json_real(coordinates.y()));
-			json_array_append_new(jsonLightCoordinates,
-					json_real(coordinates.z()));
+		for (unsigned int i = 0; i < lights.size() &&
+				i < this->replayHeader.numLights; ++i) {
+			osg::Vec3 coordinates = lights[i]->getPosition();
+
+			values[index++] = coordinates.x();
+			values[index++] = coordinates.y();
+			values[index++] = coordinates.z();
+		}
+
+		if (!this->fileName.empty()) {
+			this->replay.write(dt, values);
 		}
 	}
 }
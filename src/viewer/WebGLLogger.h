@@ -40,6 +40,7 @@
 #include <scenario/Scenario.h>
 #include <jansson.h>
 #include <model/components/ParametricBrickModel.h>
+#include "viewer/WebGLReplay.h"
 
 namespace robogen {
 
@@ -49,10 +50,18 @@ struct BodyDescriptor {
 	int bodyId;
 };
 
+/**
+ * Frames are streamed to the replay file as they are logged, only the last
+ * one is kept in memory. No file is written if the file name is empty.
+ */
 class WebGLLogger {
 public:
+	/**
+	 * @param binary write the compact binary replay of WebGLReplay instead of
+	 * JSON
+	 */
 	WebGLLogger(std::string inFileName, boost::shared_ptr<Scenario> in_scenario,
-			double targetFramerate = 120.0);
+			double targetFramerate = 120.0, bool binary = false);
 	void log(double dt);
 	~ WebGLLogger();
 	static const char* STRUCTURE_TAG;
@@ -92,6 +101,10 @@ private:
 
 	std::vector<struct BodyDescriptor> bodies;
 
+	WebGLReplay replay;
+	WebGLReplay::Header replayHeader;
+	std::vector<double> lastValues;
+
 	static std::string getFormatedStringForCuboid(double width, double height,
 			double thickness);
 	static std::string getFormatedStringForCylinder(double radius,
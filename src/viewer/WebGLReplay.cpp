@@ -0,0 +1,439 @@
+/*
+ * @(#) WebGLReplay.cpp   1.0   Oct 19, 2026
+ *
+ * The ROBOGEN Framework
+ * Copyright © 2013-2016
+ *
+ * Laboratory of Intelligent Systems, EPFL
+ *
+ * This file is part of the ROBOGEN Framework.
+ *
+ * The ROBOGEN Framework is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License (GPL)
+ * as published by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @(#) $Id$
+ */
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <boost/lexical_cast.hpp>
+#include <boost/math/special_functions/fpclassify.hpp>
+
+#include "viewer/WebGLReplay.h"
+
+#define WEBGL_REPLAY_MAGIC "RGWEBGL1"
+#define WEBGL_REPLAY_MAGIC_SIZE 8
+#define WEBGL_REPLAY_BUFFER_SIZE (1 << 20)
+#define WEBGL_REPLAY_OBSTACLES_SUFFIX ".obstacles"
+#define WEBGL_REPLAY_LIGHTS_SUFFIX ".lights"
+
+// values of a robot body or an obstacle, and of a light
+#define BODY_VALUES 7
+#define LIGHT_VALUES 3
+
+namespace robogen {
+
+const double WebGLReplay::POSITION_SCALE = 10000.0;
+const double WebGLReplay::ATTITUDE_SCALE = 32767.0;
+
+namespace {
+
+void appendVarint(std::string &out, boost::uint64_t value) {
+	while (value >= 0x80) {
+		out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+		value >>= 7;
+	}
+	out.push_back(static_cast<char>(value));
+}
+
+bool readVarint(const std::string &in, size_t &position,
+		boost::uint64_t &value) {
+	value = 0;
+	for (unsigned int shift = 0; shift < 64; shift += 7) {
+		if (position >= in.size()) {
+			return false;
+		}
+		unsigned char byte = in[position++];
+		value |= static_cast<boost::uint64_t>(byte & 0x7f) << shift;
+		if (!(byte & 0x80)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+boost::uint64_t zigzag(boost::int64_t value) {
+	return (static_cast<boost::uint64_t>(value) << 1) ^
+			static_cast<boost::uint64_t>(value >> 63);
+}
+
+boost::int64_t unzigzag(boost::uint64_t value) {
+	return static_cast<boost::int64_t>(value >> 1) ^
+			-static_cast<boost::int64_t>(value & 1);
+}
+
+void appendString(std::string &out, const std::string &value) {
+	boost::uint32_t size = value.size();
+	out.append(reinterpret_cast<char *>(&size), sizeof(size));
+	out.append(value);
+}
+
+bool readString(const std::string &in, size_t &position,
+		std::string &value) {
+	boost::uint32_t size;
+	if (position + sizeof(size) > in.size()) {
+		return false;
+	}
+	std::memcpy(&size, &in[position], sizeof(size));
+	position += sizeof(size);
+	if (position + size > in.size()) {
+		return false;
+	}
+	value = in.substr(position, size);
+	position += size;
+	return true;
+}
+
+bool appendFile(std::ofstream &out, const std::string &fileName) {
+	std::ifstream in(fileName.c_str(), std::ios::in | std::ios::binary);
+	if (!in.is_open()) {
+		return false;
+	}
+	if (in.peek() != std::ifstream::traits_type::eof()) {
+		out << in.rdbuf();
+	}
+	return true;
+}
+
+}
+
+unsigned int WebGLReplay::frameSize(const Header &header) {
+	return BODY_VALUES * (header.numBodies + header.numObstacles) +
+			LIGHT_VALUES * header.numLights;
+}
+
+bool WebGLReplay::isAttitude(const Header &header, unsigned int index) {
+	return index < BODY_VALUES * (header.numBodies + header.numObstacles) &&
+			(index % BODY_VALUES) >= 3;
+}
+
+WebGLReplay::WebGLReplay() : format_(JSON), numFrames_(0) {
+	header_.numBodies = 0;
+	header_.numObstacles = 0;
+	header_.numLights = 0;
+}
+
+WebGLReplay::~WebGLReplay() {
+	close();
+}
+
+bool WebGLReplay::open(const std::string &fileName, const Header &header,
+		Format format) {
+	format_ = format;
+	fileName_ = fileName;
+	header_ = header;
+	numFrames_ = 0;
+	previous_.assign(frameSize(header), 0);
+	buffer_.clear();
+	obstaclesBuffer_.clear();
+	lightsBuffer_.clear();
+
+	file_.open(fileName.c_str(),
+			std::ios::out | std::ios::trunc | std::ios::binary);
+	if (!file_.is_open()) {
+		return false;
+	}
+
+	if (format_ == JSON) {
+		std::string obstaclesFileName = fileName +
+				WEBGL_REPLAY_OBSTACLES_SUFFIX;
+		std::string lightsFileName = fileName + WEBGL_REPLAY_LIGHTS_SUFFIX;
+		obstaclesFile_.open(obstaclesFileName.c_str(),
+				std::ios::out | std::ios::trunc | std::ios::binary);
+		lightsFile_.open(lightsFileName.c_str(),
+				std::ios::out | std::ios::trunc | std::ios::binary);
+		if (!obstaclesFile_.is_open() || !lightsFile_.is_open()) {
+			return false;
+		}
+		buffer_ = "{\"log\":{";
+	} else {
+		boost::uint32_t counts[3] = { header.numBodies, header.numObstacles,
+				header.numLights };
+		buffer_.append(WEBGL_REPLAY_MAGIC, WEBGL_REPLAY_MAGIC_SIZE);
+		buffer_.append(reinterpret_cast<char *>(counts), sizeof(counts));
+		appendString(buffer_, header.structureJSON);
+		appendString(buffer_, header.mapJSON);
+		appendString(buffer_, header.obstaclesDefinitionJSON);
+	}
+	return true;
+}
+
+void WebGLReplay::write(double time, const std::vector<double> &values) {
+	if (format_ == JSON) {
+		writeJSON(time, values);
+	} else {
+		writeBinary(time, values);
+	}
+	numFrames_++;
+
+	if (buffer_.size() + obstaclesBuffer_.size() + lightsBuffer_.size() >=
+			WEBGL_REPLAY_BUFFER_SIZE) {
+		flushBuffers();
+	}
+}
+
+void WebGLReplay::writeJSON(double time, const std::vector<double> &values) {
+	std::string key = "\"" + boost::lexical_cast<std::string>(time) + "\":";
+	if (numFrames_ > 0) {
+		key = "," + key;
+	}
+
+	buffer_.append(key);
+	appendBodies(buffer_, values, 0, header_.numBodies);
+
+	obstaclesBuffer_.append(key);
+	appendBodies(obstaclesBuffer_, values, header_.numBodies,
+			header_.numObstacles);
+
+	lightsBuffer_.append(key);
+	appendLights(lightsBuffer_, values,
+			header_.numBodies + header_.numObstacles, header_.numLights);
+}
+
+void WebGLReplay::writeBinary(double time, const std::vector<double> &values) {
+	bool keyFrame = (numFrames_ % KEY_FRAME_INTERVAL) == 0;
+	buffer_.push_back(keyFrame ? 1 : 0);
+	buffer_.append(reinterpret_cast<const char *>(&time), sizeof(time));
+
+	for (unsigned int i = 0; i < previous_.size(); ++i) {
+		double scale = isAttitude(header_, i) ? ATTITUDE_SCALE :
+				POSITION_SCALE;
+		double scaled = (i < values.size()) ? values[i] * scale : 0;
+		// non finite values are lost
+		boost::int64_t quantized = (boost::math::isfinite(scaled) &&
+				std::fabs(scaled) < 1e15) ?
+				static_cast<boost::int64_t>(std::floor(scaled + 0.5)) : 0;
+		appendVarint(buffer_, zigzag(keyFrame ? quantized :
+				quantized - previous_[i]));
+		previous_[i] = quantized;
+	}
+}
+
+void WebGLReplay::flushBuffers() {
+	file_.write(buffer_.data(), buffer_.size());
+	buffer_.clear();
+	if (format_ == JSON) {
+		obstaclesFile_.write(obstaclesBuffer_.data(), obstaclesBuffer_.size());
+		obstaclesBuffer_.clear();
+		lightsFile_.write(lightsBuffer_.data(), lightsBuffer_.size());
+		lightsBuffer_.clear();
+	}
+}
+
+bool WebGLReplay::close() {
+	if (!file_.is_open()) {
+		return true;
+	}
+	flushBuffers();
+
+	bool success = true;
+	if (format_ == JSON) {
+		std::string obstaclesFileName = fileName_ +
+				WEBGL_REPLAY_OBSTACLES_SUFFIX;
+		std::string lightsFileName = fileName_ + WEBGL_REPLAY_LIGHTS_SUFFIX;
+		obstaclesFile_.close();
+		lightsFile_.close();
+		success = !obstaclesFile_.fail() && !lightsFile_.fail();
+
+		file_ << "},\"structure\":" << header_.structureJSON
+				<< ",\"map\":" << header_.mapJSON
+				<< ",\"obstacles\":{\"definition\":"
+				<< header_.obstaclesDefinitionJSON << ",\"log\":{";
+		success = appendFile(file_, obstaclesFileName) && success;
+		file_ << "}},\"lights\":{";
+		success = appendFile(file_, lightsFileName) && success;
+		file_ << "}}";
+
+		std::remove(obstaclesFileName.c_str());
+		std::remove(lightsFileName.c_str());
+	}
+
+	file_.close();
+	if (!success || file_.fail()) {
+		std::cerr << "Can't write WebGL replay " << fileName_ << std::endl;
+		return false;
+	}
+	return true;
+}
+
+std::string WebGLReplay::frameJSON(const Header &header, double time,
+		const std::vector<double> &values) {
+	std::string json = "{\"time\":";
+	appendReal(json, time);
+	json.append(",\"robot\":");
+	appendBodies(json, values, 0, header.numBodies);
+	json.append(",\"obstacles\":");
+	appendBodies(json, values, header.numBodies, header.numObstacles);
+	json.append(",\"lights\":");
+	appendLights(json, values, header.numBodies + header.numObstacles,
+			header.numLights);
+	json.append("}");
+	return json;
+}
+
+void WebGLReplay::appendReal(std::string &out, double value) {
+	// jansson has no representation of infinity and NaN either
+	if (!boost::math::isfinite(value)) {
+		out.append("null");
+		return;
+	}
+	char buffer[32];
+	int length = std::snprintf(buffer, sizeof(buffer), "%.17g", value);
+	// whatever the locale
+	char *comma = std::strchr(buffer, ',');
+	if (comma != NULL) {
+		*comma = '.';
+	}
+	// like jansson, drops the '+' and the leading zeros of the exponent
+	char *exponent = std::strchr(buffer, 'e');
+	if (exponent != NULL) {
+		char *digits = exponent + 1;
+		if (*digits == '-') {
+			digits++;
+		}
+		char *first = digits;
+		while (*first == '+' || (*first == '0' && first[1] != '\0')) {
+			first++;
+		}
+		std::memmove(digits, first, std::strlen(first) + 1);
+		length = std::strlen(buffer);
+	}
+	out.append(buffer, length);
+	if (std::strspn(buffer, "0123456789-") == static_cast<size_t>(length)) {
+		out.append(".0");
+	}
+}
+
+void WebGLReplay::appendBodies(std::string &out,
+		const std::vector<double> &values, unsigned int first,
+		unsigned int count) {
+	out.push_back('[');
+	for (unsigned int i = 0; i < count; ++i) {
+		const double *body = &values[BODY_VALUES * (first + i)];
+		out.append(i > 0 ? ",[[" : "[[");
+		for (unsigned int j = 3; j < BODY_VALUES; ++j) {
+			if (j > 3) {
+				out.push_back(',');
+			}
+			appendReal(out, body[j]);
+		}
+		out.append("],[");
+		for (unsigned int j = 0; j < 3; ++j) {
+			if (j > 0) {
+				out.push_back(',');
+			}
+			appendReal(out, body[j]);
+		}
+		out.append("]]");
+	}
+	out.push_back(']');
+}
+
+void WebGLReplay::appendLights(std::string &out,
+		const std::vector<double> &values, unsigned int first,
+		unsigned int count) {
+	out.push_back('[');
+	for (unsigned int i = 0; i < count; ++i) {
+		const double *light = &values[BODY_VALUES * first + LIGHT_VALUES * i];
+		out.append(i > 0 ? ",[" : "[");
+		for (unsigned int j = 0; j < LIGHT_VALUES; ++j) {
+			if (j > 0) {
+				out.push_back(',');
+			}
+			appendReal(out, light[j]);
+		}
+		out.push_back(']');
+	}
+	out.push_back(']');
+}
+
+bool WebGLReplay::convertToJSON(const std::string &fileName,
+		const std::string &jsonFileName) {
+	std::ifstream file(fileName.c_str(), std::ios::in | std::ios::binary);
+	if (!file.is_open()) {
+		std::cerr << "Can't open WebGL replay " << fileName << std::endl;
+		return false;
+	}
+	std::string data((std::istreambuf_iterator<char>(file)),
+			std::istreambuf_iterator<char>());
+
+	Header header;
+	boost::uint32_t counts[3];
+	size_t position = WEBGL_REPLAY_MAGIC_SIZE + sizeof(counts);
+	if (data.size() < position || data.compare(0, WEBGL_REPLAY_MAGIC_SIZE,
+			WEBGL_REPLAY_MAGIC) != 0) {
+		std::cerr << fileName << " is not a WebGL replay" << std::endl;
+		return false;
+	}
+	std::memcpy(counts, &data[WEBGL_REPLAY_MAGIC_SIZE], sizeof(counts));
+	header.numBodies = counts[0];
+	header.numObstacles = counts[1];
+	header.numLights = counts[2];
+	if (!readString(data, position, header.structureJSON) ||
+			!readString(data, position, header.mapJSON) ||
+			!readString(data, position, header.obstaclesDefinitionJSON)) {
+		std::cerr << "Can't read the header of WebGL replay " << fileName
+				<< std::endl;
+		return false;
+	}
+
+	WebGLReplay replay;
+	if (!replay.open(jsonFileName, header, JSON)) {
+		std::cerr << "Can't open WebGL replay " << jsonFileName << std::endl;
+		return false;
+	}
+
+	std::vector<boost::int64_t> quantized(frameSize(header), 0);
+	std::vector<double> values(frameSize(header));
+	while (position < data.size()) {
+		bool keyFrame = data[position++] != 0;
+		double time;
+		if (position + sizeof(time) > data.size()) {
+			break;
+		}
+		std::memcpy(&time, &data[position], sizeof(time));
+		position += sizeof(time);
+
+		bool complete = true;
+		for (unsigned int i = 0; i < quantized.size() && complete; ++i) {
+			boost::uint64_t value;
+			complete = readVarint(data, position, value);
+			quantized[i] = keyFrame ? unzigzag(value) :
+					quantized[i] + unzigzag(value);
+			values[i] = quantized[i] / (isAttitude(header, i) ?
+					ATTITUDE_SCALE : POSITION_SCALE);
+		}
+		// a replay whose writing was interrupted may end with a partial frame
+		if (!complete) {
+			break;
+		}
+		replay.write(time, values);
+	}
+
+	return replay.close();
+}
+
+}
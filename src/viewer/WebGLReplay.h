@@ -0,0 +1,181 @@
+/*
+ * @(#) WebGLReplay.h   1.0   Oct 19, 2026
+ *
+ * The ROBOGEN Framework
+ * Copyright © 2013-2016
+ *
+ * Laboratory of Intelligent Systems, EPFL
+ *
+ * This file is part of the ROBOGEN Framework.
+ *
+ * The ROBOGEN Framework is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License (GPL)
+ * as published by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @(#) $Id$
+ */
+
+#ifndef WEBGLREPLAY_H_
+#define WEBGLREPLAY_H_
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <boost/cstdint.hpp>
+
+namespace robogen {
+
+/**
+ * \brief Writer of WebGL replays, frame by frame
+ *
+ * In the JSON format, the robot frames are written to the replay as they come
+ * while the obstacle and light frames, which belong to other members of the
+ * replay, go to temporary files copied into it once the replay is closed.
+ *
+ * The binary format is more compact. The file starts with the 8 bytes
+ * "RGWEBGL1", the number of robot bodies, obstacles and lights of each frame
+ * (uint32 each), then the "structure", "map" and "obstacles" "definition" of
+ * the JSON replay, each as its size (uint32) followed by its JSON.
+ *
+ * Each frame holds its time (a double) and the position (x, y, z) and
+ * attitude (x, y, z, w) of each robot body, then of each obstacle, then the
+ * position of each light. Positions are quantized to 1/10 mm, attitudes to
+ * 1/32767. Each value is stored as a zigzag varint, either absolute (key
+ * frames, every KEY_FRAME_INTERVAL frames) or as the difference with the
+ * previous frame, which mostly fits in a byte.
+ */
+class WebGLReplay {
+public:
+
+	enum Format {
+		JSON,
+		BINARY
+	};
+
+	static const unsigned int KEY_FRAME_INTERVAL = 120;
+	static const double POSITION_SCALE;
+	static const double ATTITUDE_SCALE;
+
+	struct Header {
+		std::string structureJSON;
+		std::string mapJSON;
+		std::string obstaclesDefinitionJSON;
+		unsigned int numBodies;
+		unsigned int numObstacles;
+		unsigned int numLights;
+	};
+
+	/**
+	 * Number of values of a frame
+	 */
+	static unsigned int frameSize(const Header &header);
+
+	/**
+	 * Whether a value of a frame is an attitude component
+	 */
+	static bool isAttitude(const Header &header, unsigned int index);
+
+	WebGLReplay();
+
+	/**
+	 * Writes the rest of the frames and closes the file
+	 */
+	~WebGLReplay();
+
+	/**
+	 * Opens a replay for writing
+	 * @return true if successful
+	 */
+	bool open(const std::string &fileName, const Header &header,
+			Format format);
+
+	/**
+	 * Appends a frame of frameSize() values
+	 */
+	void write(double time, const std::vector<double> &values);
+
+	/**
+	 * Writes the rest of the frames and closes the file
+	 * @return false if writing failed
+	 */
+	bool close();
+
+	/**
+	 * Converts a binary replay to the JSON replay WebGLLogger writes
+	 * @return true if successful
+	 */
+	static bool convertToJSON(const std::string &fileName,
+			const std::string &jsonFileName);
+
+	/**
+	 * JSON of a frame, {"time": ..., "robot": ..., "obstacles": ...,
+	 * "lights": ...}
+	 */
+	static std::string frameJSON(const Header &header, double time,
+			const std::vector<double> &values);
+
+	/**
+	 * Appends a real formatted like JSON_REAL_PRECISION(10) of jansson
+	 */
+	static void appendReal(std::string &out, double value);
+
+private:
+
+	/**
+	 * Appends the [[attitude], [position]] of count bodies from first
+	 */
+	static void appendBodies(std::string &out,
+			const std::vector<double> &values, unsigned int first,
+			unsigned int count);
+
+	/**
+	 * Appends the [position] of count lights from first
+	 */
+	static void appendLights(std::string &out,
+			const std::vector<double> &values, unsigned int first,
+			unsigned int count);
+
+	void writeJSON(double time, const std::vector<double> &values);
+
+	void writeBinary(double time, const std::vector<double> &values);
+
+	void flushBuffers();
+
+	Format format_;
+
+	std::string fileName_;
+
+	std::ofstream file_;
+
+	std::string buffer_;
+
+	/**
+	 * Obstacle and light frames of JSON replays
+	 */
+	std::ofstream obstaclesFile_;
+	std::string obstaclesBuffer_;
+	std::ofstream lightsFile_;
+	std::string lightsBuffer_;
+
+	Header header_;
+
+	/**
+	 * Quantized values of the previous frame
+	 */
+	std::vector<boost::int64_t> previous_;
+
+	unsigned int numFrames_;
+};
+
+}
+
+#endif /* WEBGLREPLAY_H_ */